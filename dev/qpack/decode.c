@@ -35,6 +35,7 @@ struct buffer buf   = { .area = tmp_buf,   .data = 0, .size = sizeof(tmp_buf)
 #define DEBUG_QPACK
 #include "../src/hpack-huff.c"
 #include "../src/qpack-dec.c"
+#include "../src/qpack-enc.c"
 #include "../src/qpack-tbl.c"
 
 /* define to compile with BUG_ON/ABORT_NOW statements */
@@ -42,6 +43,38 @@ void ha_backtrace_to_stderr(void)
 {
 }
 
+void complain(int *counter, const char *msg, int taint)
+{
+	fputs(msg, stderr);
+}
+
+/* the encoder and the encoder/decoder streams are not used here */
+void create_pool_callback(struct pool_head **ptr, char *name, unsigned int size)
+{
+}
+
+void *__pool_alloc(struct pool_head *pool, unsigned int flags)
+{
+	return NULL;
+}
+
+void __pool_free(struct pool_head *pool, void *ptr)
+{
+}
+
+void qcc_set_error(struct qcc *qcc, int err, int app)
+{
+}
+
+struct buffer *get_trash_chunk(void)
+{
+	static char area[MAX_RQ_SIZE];
+	static struct buffer trash = { .area = area, .size = sizeof(area) };
+
+	trash.data = 0;
+	return &trash;
+}
+
 /* taken from dev/hpack/decode.c */
 int hex2bin(const char *hex, uint8_t *bin, int size)
 {
@@ -137,7 +170,12 @@ void debug_hexdump(FILE *out, const char *pfx, const char *buf,
 int main(int argc, char **argv)
 {
 	struct http_hdr hdrs[MAX_HDR_NUM];
+	struct qpack_dec dec;
 	int len, outlen, hdr_idx;
+	uint64_t ric;
+
+	/* only the static table is supported */
+	qpack_dec_init(&dec, 0, 0);
 
 	do {
 		if (!fgets(line, sizeof(line), stdin))
@@ -146,8 +184,8 @@ int main(int argc, char **argv)
 		if ((len = hex2bin(line, bin, MAX_RQ_SIZE)) < 0)
 			break;
 
-		outlen = qpack_decode_fs(bin, len, &buf, hdrs,
-		                         sizeof(hdrs) / sizeof(hdrs[0]));
+		outlen = qpack_decode_fs(&dec, bin, len, &buf, hdrs,
+		                         sizeof(hdrs) / sizeof(hdrs[0]), &ric);
 		if (outlen < 0) {
 			fprintf(stderr, "QPACK decoding failed: %d\n", outlen);
 			continue;
@@ -24,6 +24,7 @@
 
 #include <haproxy/api-t.h>
 #include <haproxy/freq_ctr-t.h>
+#include <haproxy/tinfo-t.h>
 
 /* bit fields for the "profiling" global variable */
 #define HA_PROF_TASKS_OFF   0x00000000     /* per-task CPU profiling forced disabled */
@@ -95,13 +96,17 @@ struct activity {
 
 	struct freq_ctr cpust_1s;  // avg amount of half-ms stolen over last second
 	struct freq_ctr cpust_15s; // avg amount of half-ms stolen over last 15s
+	struct freq_ctr acc_rate;  // connections handed to the accept handler over last second
 	unsigned int avg_loop_us;  // average run time per loop over last 1024 runs
 	unsigned int accepted;     // accepted incoming connections
 	unsigned int accq_pushed;  // accept queue connections pushed
 	unsigned int accq_full;    // accept queue connection not pushed because full
+	unsigned int accq_cpu;     // accept queue connections pushed to their incoming CPU's thread
+	unsigned int accq_wakeup;  // accept queue tasklet wakeups (one per batch of pushed connections)
 	unsigned int pool_fail;    // failed a pool allocation
 	unsigned int buf_wait;     // waited on a buffer allocation
 	unsigned int check_started;// number of times a check was started on this thread
+	unsigned int tl_lat_us[TL_CLASSES]; // per-class wakeup latency (us) over last SCHED_LAT_SAMPLES when profiling
 #if defined(DEBUG_DEV)
 	/* keep these ones at the end */
 	unsigned int ctr0;         // general purposee debug counter
@@ -112,6 +117,9 @@ struct activity {
 	char __end[0] __attribute__((aligned(64))); // align size to 64.
 };
 
+/* number of samples used to compute the per-class scheduling latency */
+#define SCHED_LAT_SAMPLES 64
+
 /* 256 entries for callers * callees should be highly sufficient (~45 seen usually) */
 #define SCHED_ACT_HASH_BITS 8
 #define SCHED_ACT_HASH_BUCKETS (1U << SCHED_ACT_HASH_BITS)
@@ -282,6 +282,12 @@ typedef struct { } empty_t;
 #define HA_HAVE_MALLINFO2
 #endif
 
+/* recvmmsg() appeared in glibc 2.12 and FreeBSD 11.0 */
+#if (defined(__GNU_LIBRARY__) && (__GLIBC__ > 2 || __GLIBC__ == 2 && __GLIBC_MINOR__ >= 12)) \
+ || (defined(__FreeBSD__) && __FreeBSD_version >= 1100000)
+#define HA_HAVE_RECVMMSG
+#endif
+
 /* FreeBSD also has malloc_usable_size() but it requires malloc_np.h */
 #if defined(USE_MEMORY_PROFILING) && defined(__FreeBSD__) && (__FreeBSD_version >= 700002)
 #include <malloc_np.h>
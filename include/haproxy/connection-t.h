@@ -24,6 +24,7 @@
 
 #include <stdlib.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in_systm.h>
 #include <netinet/ip.h>
 #include <netinet/ip6.h>
@@ -382,6 +383,8 @@ union conn_handle {
 struct xprt_ops {
 	size_t (*rcv_buf)(struct connection *conn, void *xprt_ctx, struct buffer *buf, size_t count, int flags); /* recv callback */
 	size_t (*snd_buf)(struct connection *conn, void *xprt_ctx, const struct buffer *buf, size_t count, int flags); /* send callback */
+	size_t (*snd_iov)(struct connection *conn, void *xprt_ctx, const struct iovec *iov, int iovcnt, int flags); /* vectored send callback, optional */
+	size_t (*snd_buf_zc)(struct connection *conn, void *xprt_ctx, struct buffer *buf, size_t count, int flags); /* zero-copy send callback consuming <buf>, optional */
 	int  (*rcv_pipe)(struct connection *conn, void *xprt_ctx, struct pipe *pipe, unsigned int count); /* recv-to-pipe callback */
 	int  (*snd_pipe)(struct connection *conn, void *xprt_ctx, struct pipe *pipe, unsigned int count); /* send-to-pipe callback */
 	void (*shutr)(struct connection *conn, void *xprt_ctx, int);    /* shutr function */
@@ -73,4 +73,14 @@ void parse_cpumap(char *cpumap_str, struct hap_cpuset *cpu_set);
  */
 int cpu_map_configured(void);
 
+/* Returns the only CPU thread <ltid> of group <tgrp> is bound to by cpu-map,
+ * or -1 if it is not bound to exactly one CPU.
+ */
+int cpu_map_thread_cpu(int tgrp, int ltid);
+
+/* Returns the local thread number among <mask> in group <tgrp> which is the
+ * only one bound to CPU <cpu> by cpu-map, or -1 if there is none or several.
+ */
+int cpu_map_cpu_thread(int tgrp, ulong mask, int cpu);
+
 #endif /* _HAPROXY_CPUSET_H */
@@ -66,7 +66,7 @@
 #define GTUNE_USE_SYSTEMD        (1<<10)
 
 #define GTUNE_BUSY_POLLING       (1<<11)
-/* (1<<12) unused */
+#define GTUNE_QUIC_SHARED_TICKET_KEYS (1<<12)
 #define GTUNE_SET_DUMPABLE       (1<<13)
 #define GTUNE_USE_EVPORTS        (1<<14)
 #define GTUNE_STRICT_LIMITS      (1<<15)
@@ -181,6 +181,7 @@ struct global {
 		int max_http_hdr;  /* max number of HTTP headers, use MAX_HTTP_HDR if zero */
 		int requri_len;    /* max len of request URI, use REQURI_LEN if zero */
 		int cookie_len;    /* max length of cookie captures */
+		int http_priorities; /* non-zero to schedule mux streams by RFC 9218 priorities */
 		int pattern_cache; /* max number of entries in the pattern cache. */
 		int sslcachesize;  /* SSL cache size in session, defaults to 20000 */
 		int comp_maxlevel;    /* max HTTP compression level */
@@ -205,6 +206,8 @@ struct global {
 		unsigned int quic_reorder_ratio;
 		unsigned int quic_max_frame_loss;
 		unsigned int quic_cubic_loss_tol;
+		unsigned int quic_pacing;        /* QUIC_PACING_* emission pacing mode */
+		unsigned int quic_pacing_burst;  /* max number of datagrams per paced burst */
 #endif /* USE_QUIC */
 	} tune;
 	struct {
@@ -83,6 +83,11 @@ enum h2_ft {
 	H2_FT_ENTRIES /* must be last */
 } __attribute__((packed));
 
+/* extension frame types, not part of the enum above so that they remain
+ * ignored by the generic frame checks.
+ */
+#define H2_FT_PRIORITY_UPDATE   0x10      // RFC9218 #7.1
+
 /* frame types, turned to bits or bit fields */
 enum {
 	/* one bit per frame type */
@@ -236,6 +241,7 @@ static inline const char *h2_ft_str(int type)
 	case H2_FT_PING          : return "PING";
 	case H2_FT_GOAWAY        : return "GOAWAY";
 	case H2_FT_WINDOW_UPDATE : return "WINDOW_UPDATE";
+	case H2_FT_PRIORITY_UPDATE : return "PRIORITY_UPDATE";
 	default                  : return "_UNKNOWN_";
 	}
 }
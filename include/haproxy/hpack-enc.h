@@ -34,8 +34,13 @@
 #include <haproxy/buf-t.h>
 #include <haproxy/http-t.h>
 
+struct hpack_dht;
+
 int hpack_encode_header(struct buffer *out, const struct ist n,
 			const struct ist v);
+int hpack_encode_header_dht(struct hpack_dht *dht, struct buffer *out,
+                            const struct ist n, const struct ist v);
+int hpack_encode_dtsu(struct hpack_dht *dht, struct buffer *out, uint32_t size);
 
 /* Returns the number of bytes required to encode the string length <len>. The
  * number of usable bits is an integral multiple of 7 plus 6 for the last byte.
@@ -79,6 +84,35 @@ static inline int hpack_encode_len(char *out, int pos, int len)
 	return pos;
 }
 
+/* Encodes integer <val> on an <n>-bit prefix (RFC7541#5.1) whose upper bits
+ * are set to <mask> into <out>+<pos>, without exceeding <size>. Returns the new
+ * position on success, or 0 if there is not enough room.
+ */
+static inline int hpack_encode_int(char *out, int pos, int size, uint8_t mask, int n, uint32_t val)
+{
+	uint32_t max = (1U << n) - 1;
+
+	if (pos >= size)
+		return 0;
+
+	if (val < max) {
+		out[pos++] = mask | val;
+		return pos;
+	}
+
+	out[pos++] = mask | max;
+	for (val -= max; val >= 128; val >>= 7) {
+		if (pos >= size)
+			return 0;
+		out[pos++] = val | 128;
+	}
+
+	if (pos >= size)
+		return 0;
+	out[pos++] = val;
+	return pos;
+}
+
 /* Tries to encode header field index <idx> with short value <val> into the
  * aligned buffer <out>. Returns non-zero on success, 0 on failure (buffer
  * full). The caller is responsible for ensuring that the length of <val> is
@@ -174,6 +174,19 @@ struct http_uri_parser {
 	enum http_uri_parser_format format; /* rfc 7230 5.3 HTTP URI format */
 };
 
+/* RFC 9218 extensible priorities of a request, as signaled by the "priority"
+ * header field or by PRIORITY_UPDATE frames. The urgency ranges from 0 (the
+ * most urgent) to 7, and incremental responses may be interleaved with other
+ * responses of the same urgency.
+ */
+#define HTTP_PRIO_URG_DFLT  3
+#define HTTP_PRIO_URG_MAX   7
+
+struct http_prio {
+	uint8_t urg;   /* urgency, 0..7, default 3 */
+	uint8_t inc;   /* non-zero if the response may be delivered incrementally */
+};
+
 #endif /* _HAPROXY_HTTP_T_H */
 
 /*
@@ -74,6 +74,7 @@ int http_compare_etags(struct ist etag1, struct ist etag2);
 
 struct ist http_trim_leading_spht(struct ist value);
 struct ist http_trim_trailing_spht(struct ist value);
+void http_parse_priority(const struct ist value, struct http_prio *prio);
 
 /*
  * Given a path string and its length, find the position of beginning of the
@@ -244,6 +245,33 @@ static inline int http_status_matches(const long *array, uint status)
 	return ha_bit_test(status - 100, array);
 }
 
+/* Initializes <prio> with the RFC 9218 default priority (u=3, not incremental) */
+static inline void http_prio_init(struct http_prio *prio)
+{
+	prio->urg = HTTP_PRIO_URG_DFLT;
+	prio->inc = 0;
+}
+
+/* Stream scheduling order based on RFC 9218 priorities, shared by the
+ * multiplexed muxes. Returns non-zero if a stream of priority <a> and ID <ida>
+ * must be served before an already queued stream of priority <b> and ID <idb>.
+ * Streams are ordered by urgency first. Within an urgency level, non-
+ * incremental streams are served first, one at a time in stream ID order,
+ * followed by incremental ones which are served in round-robin, so that a
+ * newly queued incremental stream goes after the other ones.
+ */
+static inline int http_prio_before(const struct http_prio *a, uint64_t ida,
+                                   const struct http_prio *b, uint64_t idb)
+{
+	if (a->urg != b->urg)
+		return a->urg < b->urg;
+
+	if (a->inc != b->inc)
+		return !a->inc;
+
+	return !a->inc && ida < idb;
+}
+
 #endif /* _HAPROXY_HTTP_H */
 
 /*
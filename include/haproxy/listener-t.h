@@ -114,6 +114,8 @@ enum li_status {
 #define BC_O_NOSTOP             0x00004000 /* keep the listeners active even after a soft stop */
 #define BC_O_REVERSE_HTTP       0x00008000 /* a reverse HTTP bind is used */
 #define BC_O_XPRT_MAXCONN       0x00010000 /* transport layer allocates its own resource prior to accept and is responsible to check maxconn limit */
+#define BC_O_INCOMING_CPU       0x00020000 /* dispatch connections to the thread bound to the CPU which received them */
+#define BC_O_QUIC_CID_STEER     0x00040000 /* steer QUIC datagrams to the socket of the thread owning their CID */
 
 
 /* flags used with bind_conf->ssl_options */
@@ -121,6 +123,7 @@ enum li_status {
 #define BC_SSL_O_NONE           0x0000
 #define BC_SSL_O_NO_TLS_TICKETS 0x0100	/* disable session resumption tickets */
 #define BC_SSL_O_PREF_CLIE_CIPH 0x0200  /* prefer client ciphers */
+#define BC_SSL_O_KTLS           0x0400  /* hand the TLS records processing to the kernel when possible */
 #endif
 
 struct tls_version_filter {
@@ -301,6 +304,9 @@ struct bind_kw_list {
 /* The per-thread accept queue ring, must be a power of two minus 1 */
 #define ACCEPT_QUEUE_SIZE ((1<<10) - 1)
 
+/* max number of connections pushed to accept queues before waking them up */
+#define ACCEPT_BATCH_MAX 64
+
 /* head and tail are both 16 bits so that idx can be accessed atomically */
 struct accept_queue_ring {
 	uint32_t idx;             /* (head << 16) | tail */
@@ -69,6 +69,8 @@
 
 #define H2_CF_ERR_PENDING       0x00800000  // A write error was detected (block sends but not reads)
 #define H2_CF_ERROR             0x01000000  //A read error was detected (handled has an abort)
+#define H2_CF_RTT_PING_WANT     0x02000000  // a PING must be sent to measure the RTT
+#define H2_CF_RTT_PING_SENT     0x04000000  // an RTT measurement PING was sent and not acked yet
 
 /* This function is used to report flags in debugging tools. Please reflect
  * below any single-bit flag addition above in the same order via the
@@ -87,7 +89,8 @@ static forceinline char *h2c_show_flags(char *buf, size_t len, const char *delim
 	_(H2_CF_GOAWAY_SENT, _(H2_CF_GOAWAY_FAILED, _(H2_CF_WAIT_FOR_HS, _(H2_CF_IS_BACK,
 	_(H2_CF_WINDOW_OPENED, _(H2_CF_RCVD_SHUT, _(H2_CF_END_REACHED,
 	_(H2_CF_RCVD_RFC8441, _(H2_CF_SHTS_UPDATED, _(H2_CF_DTSU_EMITTED,
-	_(H2_CF_ERR_PENDING, _(H2_CF_ERROR))))))))))))))))))))))));
+	_(H2_CF_ERR_PENDING, _(H2_CF_ERROR, _(H2_CF_RTT_PING_WANT,
+	_(H2_CF_RTT_PING_SENT))))))))))))))))))))))))));
 	/* epilogue */
 	_(~0U);
 	return buf;
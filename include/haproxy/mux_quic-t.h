@@ -11,6 +11,7 @@
 #include <haproxy/buf-t.h>
 #include <haproxy/connection-t.h>
 #include <haproxy/htx-t.h>
+#include <haproxy/http-t.h>
 #include <haproxy/list-t.h>
 #include <haproxy/ncbuf-t.h>
 #include <haproxy/quic_fctl-t.h>
@@ -60,6 +61,7 @@ struct qcc {
 	/* flow-control fields set by the peer which we must respect. */
 	struct {
 		uint64_t md; /* connection flow control limit updated on MAX_DATA frames reception */
+		uint64_t ms_bidi; /* max sub-ID of local bidi stream allowed by the peer */
 		uint64_t msd_bidi_l; /* initial max-stream-data from peer on local bidi streams */
 		uint64_t msd_bidi_r; /* initial max-stream-data from peer on remote bidi streams */
 		uint64_t msd_uni_l; /* initial max-stream-data from peer on local uni streams */
@@ -148,6 +150,7 @@ struct qcs {
 
 	struct list el; /* element of qcc.send_retry_list */
 	struct list el_send; /* element of qcc.send_list */
+	struct http_prio prio; /* RFC 9218 priority, used to order qcc.send_list */
 	struct list el_opening; /* element of qcc.opening_list */
 	struct list el_fctl; /* element of qcc.fctl_list */
 	struct list el_buf; /* element of qcc.buf_wait_list */
@@ -188,6 +191,9 @@ struct qcc_app_ops {
 	/* Convert HTX to HTTP payload for sending. */
 	size_t (*snd_buf)(struct qcs *qcs, struct buffer *b, size_t count);
 
+	/* Fast-forward received HTTP payload directly into <out> buffer. */
+	size_t (*rcv_ff)(struct qcs *qcs, struct buffer *b, struct buffer *out, size_t count, int fin);
+
 	/* Negotiate and commit fast-forward data from opposite MUX. */
 	size_t (*nego_ff)(struct qcs *qcs, size_t count);
 	size_t (*done_ff)(struct qcs *qcs);
@@ -216,6 +222,7 @@ struct qcc_app_ops {
 #define QC_CF_CONN_FULL 0x00000008 /* no stream buffers available on connection */
 #define QC_CF_APP_SHUT  0x00000010 /* Application layer shutdown done. */
 #define QC_CF_ERR_CONN  0x00000020 /* fatal error reported by transport layer */
+#define QC_CF_CONN_SHUT 0x00000040 /* peer refuses new streams (backend side only) */
 
 /* This function is used to report flags in debugging tools. Please reflect
  * below any single-bit flag addition above in the same order via the
@@ -231,7 +238,8 @@ static forceinline char *qcc_show_flags(char *buf, size_t len, const char *delim
 	_(QC_CF_ERRL_DONE,
 	_(QC_CF_CONN_FULL,
 	_(QC_CF_APP_SHUT,
-	_(QC_CF_ERR_CONN)))));
+	_(QC_CF_ERR_CONN,
+	_(QC_CF_CONN_SHUT))))));
 	/* epilogue */
 	_(~0U);
 	return buf;
@@ -243,7 +251,7 @@ static forceinline char *qcc_show_flags(char *buf, size_t len, const char *delim
 #define QC_SF_FIN_STREAM        0x00000002  /* FIN bit must be set for last frame of the stream */
 #define QC_SF_BLK_MROOM         0x00000004  /* app layer is blocked waiting for room in the qcs.tx.buf */
 #define QC_SF_DETACH            0x00000008  /* sc is detached but there is remaining data to send */
-/* unused 0x00000010 */
+#define QC_SF_RX_FASTFWD        0x00000010  /* received data left in Rx buffer for fast-forward */
 #define QC_SF_DEM_FULL          0x00000020  /* demux blocked on request channel buffer full */
 #define QC_SF_READ_ABORTED      0x00000040  /* Rx closed using STOP_SENDING*/
 #define QC_SF_TO_RESET          0x00000080  /* a RESET_STREAM must be sent */
@@ -266,13 +274,14 @@ static forceinline char *qcs_show_flags(char *buf, size_t len, const char *delim
 	_(QC_SF_FIN_STREAM,
 	_(QC_SF_BLK_MROOM,
 	_(QC_SF_DETACH,
+	_(QC_SF_RX_FASTFWD,
 	_(QC_SF_DEM_FULL,
 	_(QC_SF_READ_ABORTED,
 	_(QC_SF_TO_RESET,
 	_(QC_SF_HREQ_RECV,
 	_(QC_SF_TO_STOP_SENDING,
 	_(QC_SF_UNKNOWN_PL_LENGTH,
-	_(QC_SF_RECV_RESET)))))))))));
+	_(QC_SF_RECV_RESET))))))))))));
 	/* epilogue */
 	_(~0U);
 	return buf;
@@ -23,6 +23,9 @@
 #include <openssl/rand.h>
 #include <openssl/hmac.h>
 #include <openssl/rsa.h>
+#ifndef OPENSSL_NO_EC
+#include <openssl/ec.h>
+#endif
 #if (defined SSL_CTRL_SET_TLSEXT_STATUS_REQ_CB && !defined OPENSSL_NO_OCSP)
 #include <openssl/ocsp.h>
 #endif
@@ -516,5 +519,35 @@ static inline unsigned long ERR_peek_error_func(const char **func)
 	*(cb) = (void (*) (void))ctx->tlsext_status_cb
 #endif
 
+/* Kernel TLS: OpenSSL >= 3.0 built with KTLS support hands the negotiated
+ * keys to the BIO using BIO controls which are not part of the public API but
+ * which did not change since they were introduced. Only Linux is supported.
+ */
+#if defined(__linux__) && defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS) && \
+    defined(BIO_CTRL_GET_KTLS_SEND) && defined(BIO_CTRL_GET_KTLS_RECV) && \
+    !defined(OPENSSL_IS_BORINGSSL) && !defined(OPENSSL_IS_AWSLC) && !defined(USE_OPENSSL_WOLFSSL)
+#define HAVE_SSL_KTLS
+#ifndef BIO_CTRL_SET_KTLS
+#define BIO_CTRL_SET_KTLS                72
+#endif
+#ifndef BIO_CTRL_SET_KTLS_SEND_CTRL_MSG
+#define BIO_CTRL_SET_KTLS_SEND_CTRL_MSG  74
+#endif
+#ifndef BIO_CTRL_CLEAR_KTLS_CTRL_MSG
+#define BIO_CTRL_CLEAR_KTLS_CTRL_MSG     75
+#endif
+#endif
+
+/* Private key offloading relies on async jobs and on the legacy RSA_METHOD and
+ * EC_KEY_METHOD hooks, which are still honored by OpenSSL 3.x for keys using
+ * a non-default method. Only Linux is supported since it relies on eventfd.
+ */
+#if defined(__linux__) && defined(USE_THREAD) && defined(SSL_MODE_ASYNC) && !defined(OPENSSL_NO_ASYNC) && \
+    (HA_OPENSSL_VERSION_NUMBER >= 0x10100000L) && !defined(OPENSSL_NO_DEPRECATED_3_0) && \
+    !defined(OPENSSL_IS_BORINGSSL) && !defined(OPENSSL_IS_AWSLC) && !defined(USE_OPENSSL_WOLFSSL) && \
+    !defined(LIBRESSL_VERSION_NUMBER)
+#define HAVE_SSL_OFFLOAD
+#endif
+
 #endif /* USE_OPENSSL */
 #endif /* _HAPROXY_OPENSSL_COMPAT_H */
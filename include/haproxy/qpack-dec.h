@@ -22,9 +22,13 @@
 #define _HAPROXY_QPACK_DEC_H
 
 #include <inttypes.h>
+#include <sys/types.h>
 
 struct buffer;
 struct http_hdr;
+struct qcs;
+struct qpack_dht;
+struct qpack_enc;
 
 /* Internal QPACK processing errors.
  *Nothing to see with the RFC.
@@ -37,19 +41,31 @@ enum {
 	QPACK_RET_TRUNCATED, /* truncated stream */
 	QPACK_RET_HUFFMAN,   /* huffman decoding error */
 	QPACK_RET_TOO_LARGE, /* decoded request/response is too large */
+	QPACK_RET_BLOCKED,   /* references dynamic table entries not received yet */
 };
 
+/* QPACK decoder context, one per HTTP/3 connection */
 struct qpack_dec {
+	struct qpack_dht *dht; /* dynamic table, allocated on first non-null capacity */
+	uint64_t max_cap;      /* SETTINGS_QPACK_MAX_TABLE_CAPACITY advertised */
+	uint64_t max_blocked;  /* SETTINGS_QPACK_BLOCKED_STREAMS advertised */
+	uint64_t blocked;      /* number of streams currently blocked */
 	/* Insert count */
 	uint64_t ic;
 	/* Known received count */
 	uint64_t krc;
 };
 
-int qpack_decode_fs(const unsigned char *buf, uint64_t len, struct buffer *tmp,
-                    struct http_hdr *list, int list_size);
-int qpack_decode_enc(struct buffer *buf, int fin, void *ctx);
-int qpack_decode_dec(struct buffer *buf, int fin, void *ctx);
+void qpack_dec_init(struct qpack_dec *dec, uint64_t max_cap, uint64_t max_blocked);
+void qpack_dec_release(struct qpack_dec *dec);
+int qpack_decode_fs(struct qpack_dec *dec, const unsigned char *buf, uint64_t len,
+                    struct buffer *tmp, struct http_hdr *list, int list_size,
+                    uint64_t *ric);
+ssize_t qpack_decode_enc(struct qpack_dec *dec, struct buffer *buf, int fin, struct qcs *qcs);
+ssize_t qpack_decode_dec(struct qpack_enc *enc, struct buffer *buf, int fin, struct qcs *qcs);
+int qpack_dec_ack_section(struct qpack_dec *dec, struct buffer *out, uint64_t id, uint64_t ric);
+int qpack_dec_ack_inserts(struct qpack_dec *dec, struct buffer *out);
+int qpack_dec_cancel_stream(struct qpack_dec *dec, struct buffer *out, uint64_t id);
 
 int qpack_err_decode(const int value);
 
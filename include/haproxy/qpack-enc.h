@@ -1,12 +1,64 @@
 #ifndef QPACK_ENC_H_
 #define QPACK_ENC_H_
 
+#include <haproxy/http-t.h>
 #include <haproxy/istbuf.h>
+#include <haproxy/list-t.h>
 
 struct buffer;
+struct qpack_dht;
 
+/* Maximum number of unacknowledged field sections referencing the dynamic
+ * table per connection. Above this, new sections only use literals.
+ */
+#define QPACK_ENC_MAX_FS  256
+
+/* Room to reserve for an encoded field section prefix */
+#define QPACK_ENC_MAX_PFX 16
+
+/* Field section sent with references to the encoder dynamic table, waiting for
+ * its acknowledgment by the peer's decoder.
+ */
+struct qpack_enc_fs {
+	struct list list;  /* element of qpack_enc <fs_list> */
+	uint64_t id;       /* ID of the stream the section was sent on */
+	uint64_t ric;      /* Required Insert Count of the section */
+	uint64_t min_ref;  /* lowest absolute index referenced by the section */
+};
+
+/* QPACK encoder context, one per HTTP/3 connection */
+struct qpack_enc {
+	struct qpack_dht *dht;       /* encoder dynamic table, NULL if unused */
+	uint64_t max_entries;        /* peer's max table capacity / 32 */
+	uint64_t ic;                 /* Insert Count */
+	uint64_t krc;                /* Known Received Count */
+	struct list fs_list;         /* unacknowledged field sections, oldest first */
+	unsigned int fs_count;       /* number of elements in <fs_list> */
+	struct qpack_enc_fs *fs_cur; /* storage for the field section being encoded */
+	uint64_t fs_base;            /* Base of the field section being encoded */
+};
+
+int qpack_encode_prefix_integer(struct buffer *out, uint64_t i,
+                                int prefix_size, unsigned char before_prefix);
 int qpack_encode_field_section_line(struct buffer *out);
 int qpack_encode_int_status(struct buffer *out, unsigned int status);
+int qpack_encode_method(struct buffer *out, enum http_meth_t meth, struct ist other);
+int qpack_encode_scheme(struct buffer *out, const struct ist scheme);
+int qpack_encode_path(struct buffer *out, const struct ist path);
+int qpack_encode_auth(struct buffer *out, const struct ist auth);
 int qpack_encode_header(struct buffer *out, const struct ist n, const struct ist v);
 
+void qpack_enc_init(struct qpack_enc *enc);
+void qpack_enc_release(struct qpack_enc *enc);
+int qpack_enc_set_capacity(struct qpack_enc *enc, struct buffer *ins,
+                           uint64_t max_cap, uint32_t cap);
+void qpack_enc_fs_start(struct qpack_enc *enc);
+int qpack_enc_fs_prefix(struct qpack_enc *enc, struct buffer *out);
+void qpack_enc_fs_commit(struct qpack_enc *enc, uint64_t id);
+int qpack_encode_header_dht(struct qpack_enc *enc, struct buffer *ins, struct buffer *out,
+                            const struct ist n, const struct ist v);
+int qpack_enc_ack_section(struct qpack_enc *enc, uint64_t id);
+void qpack_enc_cancel_stream(struct qpack_enc *enc, uint64_t id);
+int qpack_enc_ack_inserts(struct qpack_enc *enc, uint64_t inc);
+
 #endif /* QPACK_ENC_H_ */
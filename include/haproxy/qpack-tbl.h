@@ -50,20 +50,26 @@ extern struct pool_head *pool_head_qpack_tbl;
 
 int __qpack_dht_make_room(struct qpack_dht *dht, unsigned int needed);
 int qpack_dht_insert(struct qpack_dht *dht, struct ist name, struct ist value);
+int qpack_dht_set_capacity(struct qpack_dht *dht, uint32_t size);
 
 #ifdef DEBUG_QPACK
 void qpack_dht_dump(FILE *out, const struct qpack_dht *dht);
 void qpack_dht_check_consistency(const struct qpack_dht *dht);
 #endif
 
-/* return a pointer to the entry designated by index <idx> (starting at 0) or
- * NULL if this index is not there.
+/* return a pointer to the entry designated by relative index <idx> (0 being
+ * the most recently inserted entry) or NULL if this index is not there.
  */
 static inline const struct qpack_dte *qpack_get_dte(const struct qpack_dht *dht, uint16_t idx)
 {
 	if (idx >= dht->used)
 		return NULL;
 
+	if (idx <= dht->head)
+		idx = dht->head - idx;
+	else
+		idx = dht->head - idx + dht->wrap;
+
 	return &dht->dte[idx];
 }
 
@@ -36,6 +36,7 @@
 
 extern struct quic_cc_algo quic_cc_algo_nr;
 extern struct quic_cc_algo quic_cc_algo_cubic;
+extern struct quic_cc_algo quic_cc_algo_bbr;
 extern struct quic_cc_algo *default_quic_cc_algo;
 
 /* Fake algorithm with its fixed window */
@@ -43,6 +44,18 @@ extern struct quic_cc_algo quic_cc_algo_nocc;
 
 extern unsigned long long last_ts;
 
+/* QUIC emission pacing modes (tune.quic.pacing) */
+enum quic_pacing_mode {
+	QUIC_PACING_OFF = 0, /* emit as much as the congestion window permits */
+	QUIC_PACING_TIMER,   /* hold emission until the next departure time */
+	QUIC_PACING_TXTIME,  /* stamp datagrams with their departure time (SO_TXTIME) */
+};
+
+/* Slack accepted when emission was delayed by the scheduler or the timers
+ * granularity, during which a paced sender may catch up (in ns).
+ */
+#define QUIC_PACING_SLACK_NS 1000000ULL
+
 enum quic_cc_algo_state_type {
 	/* Slow start. */
 	QUIC_CC_ST_SS,
@@ -81,6 +94,7 @@ struct quic_cc_event {
 enum quic_cc_algo_type {
 	QUIC_CC_ALGO_TP_NEWRENO,
 	QUIC_CC_ALGO_TP_CUBIC,
+	QUIC_CC_ALGO_TP_BBR,
 	QUIC_CC_ALGO_TP_NOCC,
 };
 
@@ -88,7 +102,36 @@ struct quic_cc {
 	/* <conn> is there only for debugging purpose. */
 	struct quic_conn *qc;
 	struct quic_cc_algo *algo;
-	uint32_t priv[20];
+	uint32_t priv[72];
+};
+
+/* Delivery rate sample, built upon ACK receipt from the most recently sent
+ * packet among the newly acknowledged ones. All the times are in microseconds.
+ */
+struct quic_cc_rs {
+	uint64_t delivered;       /* bytes delivered during <interval> */
+	uint64_t lost;            /* bytes declared lost during <interval> */
+	uint64_t prior_delivered; /* path delivered bytes when the packet was sent */
+	uint64_t prior_lost;      /* path lost bytes when the packet was sent */
+	uint64_t prior_time;      /* path delivered time when the packet was sent */
+	uint64_t tx_in_flight;    /* bytes in flight when the packet was sent */
+	uint64_t send_elapsed;    /* send phase duration of the sample */
+	uint64_t ack_elapsed;     /* ACK phase duration of the sample */
+	uint64_t interval;        /* max(send_elapsed, ack_elapsed), 0 if invalid */
+	uint64_t rtt;             /* RTT of the packet */
+	uint64_t newly_acked;     /* bytes acknowledged by the current ACK */
+	uint64_t newly_lost;      /* bytes declared lost since the previous ACK */
+	int is_app_limited;       /* the sample was taken while application limited */
+};
+
+/* Delivery rate sampling state of a path. All the times are in microseconds. */
+struct quic_cc_drs {
+	struct quic_cc_rs rs;     /* last rate sample */
+	uint64_t delivered;       /* total bytes delivered */
+	uint64_t lost;            /* total bytes declared lost */
+	uint64_t delivered_time;  /* time of the last delivery */
+	uint64_t first_sent_time; /* send time of the packet which ended the last sample */
+	uint64_t app_limited;     /* <delivered> value which ends the application limited phase, 0 if none */
 };
 
 struct quic_cc_path {
@@ -113,6 +156,10 @@ struct quic_cc_path {
 	uint64_t in_flight;
 	/* Number of in flight ack-eliciting packets. */
 	uint64_t ifae_pkts;
+	/* Earliest departure time of the next paced datagrams (ns). */
+	uint64_t pacing_next;
+	/* Delivery rate sampling. */
+	struct quic_cc_drs drs;
 };
 
 struct quic_cc_algo {
@@ -123,6 +170,12 @@ struct quic_cc_algo {
 	void (*state_trace)(struct buffer *buf, const struct quic_cc *cc);
 	void (*state_cli)(struct buffer *buf, const struct quic_cc_path *path);
 	void (*hystart_start_round)(struct quic_cc *cc, uint64_t pn);
+	/* Optional. Pacing rate in bytes per millisecond. */
+	uint64_t (*pacing_rate)(const struct quic_cc *cc);
+	/* Optional. Called once per ACK frame after the newly acknowledged
+	 * packets have been notified, with the delivery rate sample of <path>.
+	 */
+	void (*on_ack_rcvd)(struct quic_cc *cc, const struct quic_cc_rs *rs);
 };
 
 #endif /* USE_QUIC */
@@ -30,12 +30,16 @@
 #include <haproxy/buf.h>
 #include <haproxy/chunk.h>
 #include <haproxy/quic_cc-t.h>
+#include <haproxy/quic_cc_drs.h>
 #include <haproxy/quic_conn-t.h>
 #include <haproxy/quic_loss.h>
 
 void quic_cc_init(struct quic_cc *cc, struct quic_cc_algo *algo, struct quic_conn *qc);
 void quic_cc_event(struct quic_cc *cc, struct quic_cc_event *ev);
 void quic_cc_state_trace(struct buffer *buf, const struct quic_cc *cc);
+void quic_cc_ack_rcvd(struct quic_cc_path *path);
+uint64_t quic_cc_pacing_rate(const struct quic_cc_path *path);
+void quic_pacing_sent(struct quic_cc_path *path, size_t bytes, uint64_t now);
 
 static inline const char *quic_cc_state_str(enum quic_cc_algo_state_type state)
 {
@@ -92,6 +96,8 @@ static inline void quic_cc_path_init(struct quic_cc_path *path, int ipv4, unsign
 	path->prep_in_flight = 0;
 	path->in_flight = 0;
 	path->ifae_pkts = 0;
+	path->pacing_next = 0;
+	quic_cc_drs_init(&path->drs);
 	quic_cc_init(&path->cc, algo, qc);
 }
 
@@ -107,6 +113,23 @@ static inline size_t quic_cc_path_prep_data(struct quic_cc_path *path)
 	return path->cwnd - path->prep_in_flight;
 }
 
+/* Returns the rate in bytes per millisecond at which <path> emits <gain>
+ * percents of its congestion window per smoothed RTT.
+ */
+static inline uint64_t quic_cc_path_rate(const struct quic_cc_path *path, uint gain)
+{
+	return path->cwnd * gain / 100 / QUIC_MAX(path->loss.srtt, QUIC_TIMER_GRANULARITY);
+}
+
+/* Returns the delay in nanoseconds before datagrams may be emitted again on
+ * <path> at <now> (ns) when pacing is used, or 0 if they may be emitted
+ * right now. Note that <now> is null when no monotonic clock is available, in
+ * which case pacing is disabled.
+ */
+static inline uint64_t quic_pacing_delay(const struct quic_cc_path *path, uint64_t now)
+{
+	return now && path->pacing_next > now ? path->pacing_next - now : 0;
+}
 
 #endif /* USE_QUIC */
 #endif /* _PROTO_QUIC_CC_H */
@@ -0,0 +1,73 @@
+/*
+ * include/haproxy/quic_cc_drs.h
+ * This file contains prototypes for QUIC delivery rate sampling.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, version 2.1
+ * exclusively.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _HAPROXY_QUIC_CC_DRS_H
+#define _HAPROXY_QUIC_CC_DRS_H
+#ifdef USE_QUIC
+#ifndef USE_OPENSSL
+#error "Must define USE_OPENSSL"
+#endif
+
+#include <string.h>
+
+#include <haproxy/clock.h>
+#include <haproxy/quic_cc-t.h>
+#include <haproxy/quic_tx-t.h>
+
+void quic_cc_drs_on_pkt_sent(struct quic_cc_path *path, struct quic_tx_packet *pkt);
+void quic_cc_drs_on_pkt_acked(struct quic_cc_drs *drs, struct quic_tx_packet *pkt);
+void quic_cc_drs_on_pkt_lost(struct quic_cc_drs *drs, struct quic_tx_packet *pkt);
+void quic_cc_drs_on_ack_end(struct quic_cc_drs *drs, uint64_t min_rtt);
+void quic_cc_drs_on_app_limited(struct quic_cc_path *path);
+
+/* Returns the current date used for delivery rate sampling, in microseconds. */
+static inline uint64_t quic_cc_drs_now(void)
+{
+	return now_ns / 1000;
+}
+
+static inline void quic_cc_drs_init(struct quic_cc_drs *drs)
+{
+	memset(drs, 0, sizeof(*drs));
+}
+
+/* Reset the per ACK information of the rate sample of <drs> once it has been
+ * consumed by the congestion controller.
+ */
+static inline void quic_cc_drs_rs_reset(struct quic_cc_drs *drs)
+{
+	drs->rs.prior_time = 0;
+	drs->rs.interval = 0;
+	drs->rs.newly_acked = 0;
+	drs->rs.newly_lost = 0;
+}
+
+/* Returns the delivery rate in bytes per second of <rs> rate sample, or 0 if
+ * the sample is not valid.
+ */
+static inline uint64_t quic_cc_rs_rate(const struct quic_cc_rs *rs)
+{
+	if (!rs->interval)
+		return 0;
+
+	return rs->delivered * 1000000ULL / rs->interval;
+}
+
+#endif /* USE_QUIC */
+#endif /* _HAPROXY_QUIC_CC_DRS_H */
@@ -10,6 +10,7 @@
 
 #include <haproxy/buf-t.h>
 #include <haproxy/chunk.h>
+#include <haproxy/listener-t.h>
 #include <haproxy/quic_conn-t.h>
 #include <haproxy/quic_cid-t.h>
 #include <haproxy/quic_rx-t.h>
@@ -20,17 +21,20 @@ extern struct quic_cid_tree *quic_cid_trees;
 struct quic_connection_id *new_quic_cid(struct eb_root *root,
                                         struct quic_conn *qc,
                                         const struct quic_cid *orig,
-                                        const struct sockaddr_storage *addr);
+                                        const struct sockaddr_storage *addr,
+                                        const struct listener *li);
 
 int quic_cid_insert(struct quic_connection_id *conn_id, int *new_tid);
 int quic_cmp_cid_conn(const unsigned char *cid, size_t cid_len,
                       struct quic_conn *qc);
 int quic_get_cid_tid(const unsigned char *cid, size_t cid_len,
                      const struct sockaddr_storage *cli_addr,
+                     const struct listener *li,
                      unsigned char *pos, size_t len);
 
 struct quic_conn *retrieve_qc_conn_from_cid(struct quic_rx_packet *pkt,
                                             struct sockaddr_storage *saddr,
+                                            const struct listener *li,
                                             int *new_tid);
 int qc_build_new_connection_id_frm(struct quic_conn *qc,
                                    struct quic_connection_id *conn_id);
@@ -63,6 +67,17 @@ static inline void quic_cid_dump(struct buffer *buf,
 	chunk_appendf(buf, ")");
 }
 
+/* Stamp <cid> generated for a connection received on <li> listener with the
+ * reuseport index of its socket when CID steering is enabled on it, so that
+ * the datagrams carrying it are directly delivered to this socket. <li> may
+ * be NULL.
+ */
+static inline void quic_cid_steer(struct quic_cid *cid, const struct listener *li)
+{
+	if (li && (li->rx.flags & RX_F_QUIC_CID_STEER) && cid->len == QUIC_HAP_CID_LEN)
+		cid->data[QUIC_CID_STEER_OFS] = li->rx.quic_steer_idx;
+}
+
 /* Return tree index where <cid> is stored. */
 static inline uchar _quic_cid_tree_idx(const unsigned char *cid)
 {
@@ -62,6 +62,12 @@ typedef unsigned long long ull;
  */
 #define QUIC_HAP_CID_LEN               8
 
+/* Position in the CIDs generated by haproxy of the byte which carries the
+ * reuseport index of the socket of the owning thread when "quic-cid-steering"
+ * is used. The first byte is avoided as it selects the CID tree.
+ */
+#define QUIC_CID_STEER_OFS             (QUIC_HAP_CID_LEN - 1)
+
 /* Common definitions for short and long QUIC packet headers. */
 /* QUIC original destination connection ID minial length */
 #define QUIC_ODCID_MINLEN              8 /* bytes */
@@ -97,6 +103,8 @@ typedef unsigned long long ull;
 #define QUIC_DFLT_REORDER_RATIO        50 /* in percent */
 /* Default limit of loss detection on a single frame. If exceeded, connection is closed. */
 #define QUIC_DFLT_MAX_FRAME_LOSS       10
+/* Default maximum number of datagrams emitted at once when pacing */
+#define QUIC_DFLT_PACING_BURST          4
 /* Default congestion window size. 480 kB, equivalent to the legacy value which was 30*bufsize */
 #define QUIC_DFLT_MAX_WINDOW_SIZE  491520
 
@@ -404,6 +412,8 @@ struct quic_conn {
 	struct task *timer_task;
 	unsigned int timer;
 	unsigned int ack_expire;
+	/* Date at which paced emission may be resumed */
+	unsigned int pacing_expire;
 	/* Handshake expiration date */
 	unsigned int hs_expire;
 
@@ -85,6 +85,16 @@ static inline int qc_is_listener(struct quic_conn *qc)
 	return qc->flags & QUIC_FL_CONN_LISTENER;
 }
 
+/* Returns true if an upper layer still references <qc>, either its MUX, or
+ * the connection which is waiting for the handshake completion on the backend
+ * side. In this case, the quic-conn release is the upper layer responsibility.
+ */
+static inline int qc_has_upper_layer(struct quic_conn *qc)
+{
+	return qc->mux_state == QC_MUX_READY ||
+	       (!qc_is_listener(qc) && qc->mux_state == QC_MUX_NULL && qc->conn);
+}
+
 /* Free the CIDs attached to <conn> QUIC connection. */
 static inline void free_quic_conn_cids(struct quic_conn *conn)
 {
@@ -166,7 +176,9 @@ int qc_check_dcid(struct quic_conn *qc, unsigned char *dcid, size_t dcid_len);
 int qc_send_mux(struct quic_conn *qc, struct list *frms);
 
 void qc_notify_err(struct quic_conn *qc);
+void qc_notify_hs_done(struct quic_conn *qc);
 int qc_notify_send(struct quic_conn *qc);
+void qc_pacing_timer_arm(struct quic_conn *qc, uint64_t delay);
 
 void qc_check_close_on_released_mux(struct quic_conn *qc);
 
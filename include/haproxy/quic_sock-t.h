@@ -26,6 +26,9 @@ struct quic_receiver_buf {
 	struct mt_list rxbuf_el; /* list element into receiver.rxbuf_list. */
 };
 
+/* Maximum number of datagrams retrieved by a single receive syscall */
+#define QUIC_RX_BATCH_MAX			16
+
 #define QUIC_DGRAM_FL_REJECT			0x00000001
 #define QUIC_DGRAM_FL_SEND_RETRY		0x00000002
 
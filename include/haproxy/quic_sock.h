@@ -44,7 +44,9 @@ struct connection *quic_sock_accept_conn(struct listener *l, int *status);
 struct task *quic_lstnr_dghdlr(struct task *t, void *ctx, unsigned int state);
 void quic_lstnr_sock_fd_iocb(int fd);
 int qc_snd_buf(struct quic_conn *qc, const struct buffer *buf, size_t count,
-               int flags, uint16_t gso_size);
+               int flags, uint16_t gso_size, uint64_t txtime);
+int quic_sock_set_txtime(int fd);
+int quic_sock_set_cid_steering(int fd, const short *map, int nb);
 int qc_rcv_buf(struct quic_conn *qc);
 void quic_conn_sock_fd_iocb(int fd);
 
@@ -18,4 +18,13 @@
 
 extern struct pool_head *pool_head_quic_ssl_sock_ctx;
 
+/* 0-RTT anti-replay filter: the ClientHello of each accepted 0-RTT handshake
+ * is recorded into a bloom filter for at least QUIC_0RTT_FILTER_PERIOD
+ * seconds. This must cover the 10s ticket age tolerance of the TLS stack for
+ * early data, beyond which a replayed ClientHello is rejected anyway.
+ */
+#define QUIC_0RTT_FILTER_BITS    (1 << 20) /* bits per generation, power of 2 */
+#define QUIC_0RTT_FILTER_HASHES  4         /* number of bits set per ClientHello */
+#define QUIC_0RTT_FILTER_PERIOD  20        /* generation duration (seconds) */
+
 #endif /* _HAPROXY_QUIC_SSL_T_H */
@@ -31,10 +31,13 @@
 #include <haproxy/openssl-compat.h>
 #include <haproxy/pool.h>
 #include <haproxy/quic_ssl-t.h>
+#include <haproxy/server-t.h>
 #include <haproxy/ssl_sock-t.h>
 
 int ssl_quic_initial_ctx(struct bind_conf *bind_conf);
+int ssl_quic_srv_ctx_init(const struct server *srv, SSL_CTX *ctx);
 int qc_alloc_ssl_sock_ctx(struct quic_conn *qc);
+int qc_ssl_start_handshake(struct quic_conn *qc);
 int qc_ssl_provide_all_quic_data(struct quic_conn *qc, struct ssl_sock_ctx *ctx);
 
 static inline void qc_free_ssl_sock_ctx(struct ssl_sock_ctx **ctx)
@@ -25,6 +25,7 @@ enum {
 	QUIC_ST_HALF_OPEN_CONN,
 	QUIC_ST_HDSHK_FAIL,
 	QUIC_ST_STATELESS_RESET_SENT,
+	QUIC_ST_ZERO_RTT_REPLAYED,
 	/* Special events of interest */
 	QUIC_ST_CONN_MIGRATION_DONE,
 	/* Transport errors */
@@ -72,6 +73,7 @@ struct quic_counters {
 	long long half_open_conn;    /* current number of connections waiting for address validation */
 	long long hdshk_fail;        /* total number of handshake failures */
 	long long stateless_reset_sent; /* total number of handshake failures */
+	long long zero_rtt_replayed;  /* total number of 0-RTT refused by the anti-replay filter */
 	/* Special events of interest */
 	long long conn_migration_done; /* total number of connection migration handled */
 	/* Transport errors */
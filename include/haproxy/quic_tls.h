@@ -129,6 +129,8 @@ int quic_tls_hp_decrypt(unsigned char *out,
 int quic_tls_hp_encrypt(unsigned char *out,
                          const unsigned char *in, size_t inlen,
                          EVP_CIPHER_CTX *ctx, unsigned char *key);
+int quic_tls_hp_masks(unsigned char *masks, const unsigned char *samples,
+                      int count, EVP_CIPHER_CTX *ctx);
 
 int quic_tls_key_update(struct quic_conn *qc);
 void quic_tls_rotate_keys(struct quic_conn *qc);
@@ -198,11 +200,16 @@ static inline const EVP_CIPHER *tls_hp(const SSL_CIPHER *cipher)
 #else
 		return EVP_chacha20();
 #endif
+	/* AES header protection masks are the first bytes of the sample
+	 * encrypted with AES-ECB (RFC 9001 5.4.3). This mode does not require
+	 * any per packet initialization and allows to compute several masks at
+	 * once.
+	 */
 	case TLS1_3_CK_AES_128_CCM_SHA256:
 	case TLS1_3_CK_AES_128_GCM_SHA256:
-		return EVP_aes_128_ctr();
+		return EVP_aes_128_ecb();
 	case TLS1_3_CK_AES_256_GCM_SHA384:
-		return EVP_aes_256_ctr();
+		return EVP_aes_256_ecb();
 	default:
 		return NULL;
 	}
@@ -877,7 +884,7 @@ static inline int quic_initial_tls_ctx_init(struct quic_tls_ctx *ctx)
 	ctx->rx.aead = ctx->tx.aead = EVP_aes_128_gcm();
 #endif
 	ctx->rx.md   = ctx->tx.md   = EVP_sha256();
-	ctx->rx.hp   = ctx->tx.hp   = EVP_aes_128_ctr();
+	ctx->rx.hp   = ctx->tx.hp   = EVP_aes_128_ecb();
 
 	ctx->rx.iv   = NULL;
 	ctx->rx.ivlen = 0;
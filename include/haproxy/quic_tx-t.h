@@ -7,6 +7,7 @@
 
 #include <import/eb64tree.h>
 #include <haproxy/list-t.h>
+#include <haproxy/quic_tls-t.h>
 
 extern struct pool_head *pool_head_quic_tx_packet;
 extern struct pool_head *pool_head_quic_cc_buf;
@@ -53,6 +54,16 @@ struct quic_tx_packet {
 	struct quic_tx_packet *prev;
 	/* Largest acknowledged packet number if this packet contains an ACK frame */
 	int64_t largest_acked_pn;
+	/* Path delivery rate sampling state when this packet was sent (us). */
+	struct {
+		uint64_t delivered;
+		uint64_t lost;
+		uint64_t delivered_time;
+		uint64_t first_sent_time;
+		uint64_t time_sent;
+		uint64_t tx_in_flight;
+		int is_app_limited;
+	} rs;
 	unsigned char type;
 };
 
@@ -64,4 +75,22 @@ enum qc_build_pkt_err {
 	QC_BUILD_PKT_ERR_BUFROOM,  /* no more room in input buf or congestion window */
 };
 
+/* Maximum number of packets whose header protection may be applied at once */
+#define QUIC_HP_BATCH_MAX 32
+
+/* Packets built by qc_prep_pkts() waiting for their header protection. It is
+ * applied at once to consecutive packets sharing the same keys.
+ */
+struct quic_hp_batch {
+	struct quic_tls_ctx *tls_ctx;  /* keys of the pending packets */
+	int count;                     /* number of pending packets */
+	struct {
+		unsigned char *first_byte; /* first byte of the packet */
+		unsigned char *pn;         /* packet number field */
+		size_t pn_len;             /* packet number field length */
+	} pkts[QUIC_HP_BATCH_MAX];
+	/* samples of the pending packets, replaced by their masks */
+	unsigned char masks[QUIC_HP_BATCH_MAX * QUIC_TLS_HP_SAMPLE_LEN];
+};
+
 #endif /* _HAPROXY_TX_T_H */
@@ -38,6 +38,7 @@
 #define RX_F_MUST_DUP           0x00000008  /* this receiver's fd must be dup() from a reference; ignore socket-level ops here */
 #define RX_F_NON_SUSPENDABLE    0x00000010  /* this socket cannot be suspended hence must always be unbound */
 #define RX_F_PASS_PKTINFO       0x00000020  /* pass pktinfo in received messages */
+#define RX_F_QUIC_CID_STEER     0x00000040  /* QUIC CIDs carry <quic_steer_idx> for reuseport steering */
 
 /* Bit values for rx_settings->options */
 #define RX_O_FOREIGN            0x00000001  /* receives on foreign addresses */
@@ -85,6 +86,8 @@ struct receiver {
 	enum quic_sock_mode quic_mode;   /* QUIC socket allocation strategy */
 	unsigned int quic_curr_handshake; /* count of active QUIC handshakes */
 	unsigned int quic_curr_accept;   /* count of QUIC conns waiting for accept */
+	unsigned char quic_steer_idx;    /* steering index of the socket, encoded in CIDs */
+	unsigned char quic_steer_pos;    /* current slot of the socket in its reuseport group */
 #endif
 	struct {
 		struct task *task;  /* Task used to open connection for reverse. */
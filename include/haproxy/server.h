@@ -319,6 +319,19 @@ static inline int srv_is_transparent(const struct server *srv)
 	       (srv->flags & SRV_F_MAPPORTS);
 }
 
+/* Returns true if <srv> is a QUIC server, i.e. declared with a "quic4@" or
+ * "quic6@" address.
+ */
+static inline int srv_is_quic(const struct server *srv)
+{
+#ifdef USE_QUIC
+	return srv->addr_type.proto_type == PROTO_TYPE_DGRAM &&
+	       srv->addr_type.xprt_type == PROTO_TYPE_STREAM;
+#else
+	return 0;
+#endif
+}
+
 #endif /* _HAPROXY_SERVER_H */
 
 /*
@@ -0,0 +1,45 @@
+/*
+ * include/haproxy/ssl_offload.h
+ * Private key operations offloading to a pool of crypto threads.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, version 2.1
+ * exclusively.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _HAPROXY_SSL_OFFLOAD_H
+#define _HAPROXY_SSL_OFFLOAD_H
+
+#ifdef USE_OPENSSL
+
+#include <haproxy/openssl-compat.h>
+
+#ifdef HAVE_SSL_OFFLOAD
+
+extern int ssl_offload_nbthread;
+
+int ssl_offload_use_pkey(SSL_CTX *ctx, EVP_PKEY *pkey);
+
+#else
+
+#define ssl_offload_nbthread 0
+
+static inline int ssl_offload_use_pkey(SSL_CTX *ctx, EVP_PKEY *pkey)
+{
+	return SSL_CTX_use_PrivateKey(ctx, pkey);
+}
+
+#endif /* HAVE_SSL_OFFLOAD */
+
+#endif /* USE_OPENSSL */
+#endif /* _HAPROXY_SSL_OFFLOAD_H */
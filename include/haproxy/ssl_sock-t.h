@@ -50,6 +50,9 @@
 #define SSL_SOCK_SEND_UNLIMITED     0x00000004
 #define SSL_SOCK_RECV_HEARTBEAT     0x00000008
 #define SSL_SOCK_SEND_MORE          0x00000010  /* set MSG_MORE at lower levels */
+#define SSL_SOCK_KTLS_TX            0x00000020  /* the kernel encrypts outgoing records (kTLS) */
+#define SSL_SOCK_KTLS_RX            0x00000040  /* the kernel decrypts incoming records (kTLS) */
+#define SSL_SOCK_KTLS_CTRL_MSG      0x00000080  /* next kTLS write is a non-data record of type ktls_rec_type */
 
 /* bits 0xFFFFFF00 are reserved to store verify errors.
  * The CA en CRT error codes will be stored on 7 bits each
@@ -254,6 +257,9 @@ struct ssl_sock_ctx {
 	unsigned long error_code;     /* last error code of the error stack */
 	struct buffer early_buf;      /* buffer to store the early data received */
 	int sent_early_data;          /* Amount of early data we sent so far */
+#ifdef HAVE_SSL_KTLS
+	unsigned char ktls_rec_type;  /* record type of the next control message sent with kTLS */
+#endif
 
 #ifdef USE_QUIC
 	struct quic_conn *qc;
@@ -293,6 +299,8 @@ struct global_ssl {
 	struct tls_version_filter connect_default_sslmethods;
 
 	int private_cache; /* Force to use a private session cache even if nbproc > 1 */
+	int cache_shards; /* number of session cache shards, 0=one per thread group */
+	int cache_lru;    /* refresh the session cache entries on lookup */
 	unsigned int life_time;   /* SSL session lifetime in seconds */
 	unsigned int max_record; /* SSL max record size */
 	unsigned int hard_max_record; /* SSL max record size hard limit */
@@ -151,10 +151,10 @@ void ssl_sock_set_tmp_dh_from_pkey(SSL_CTX *ctx, EVP_PKEY *pkey);
 
 #define sh_ssl_sess_tree_delete(s)     ebmb_delete(&(s)->key);
 
-#define sh_ssl_sess_tree_insert(s)     (struct sh_ssl_sess_hdr *)ebmb_insert(sh_ssl_sess_tree, \
+#define sh_ssl_sess_tree_insert(r, s)  (struct sh_ssl_sess_hdr *)ebmb_insert((r), \
                                                                     &(s)->key, SSL_MAX_SSL_SESSION_ID_LENGTH);
 
-#define sh_ssl_sess_tree_lookup(k)     (struct sh_ssl_sess_hdr *)ebmb_lookup(sh_ssl_sess_tree, \
+#define sh_ssl_sess_tree_lookup(r, k)  (struct sh_ssl_sess_hdr *)ebmb_lookup((r), \
                                                                     (k), SSL_MAX_SSL_SESSION_ID_LENGTH);
 
 /* Registers the function <func> in order to be called on SSL/TLS protocol
@@ -27,6 +27,7 @@
 #include <import/ebtree-t.h>
 
 #include <haproxy/api-t.h>
+#include <haproxy/list-t.h>
 #include <haproxy/show_flags-t.h>
 #include <haproxy/thread-t.h>
 
@@ -147,7 +148,10 @@ struct task {
 	 * where rq starts and this works because both are exclusive. Never
 	 * ever reorder these fields without taking this into account!
 	 */
-	struct eb32_node wq;		/* ebtree node used to hold the task in the wait queue */
+	union {
+		struct eb32_node wq;	/* ebtree node used to hold the task in the wait queue */
+		struct list wq_list;	/* overlaid on wq.node.branches when in a timer wheel */
+	};
 	int expire;			/* next expiration date for this task, in ticks */
 	short nice;                     /* task prio from -1024 to +1024 */
 	/* 16-bit hole here */
@@ -164,6 +168,28 @@ struct tasklet {
 	 */
 };
 
+/* The per-thread timer wheel is made of TW_LEVELS levels of TW_SLOTS slots
+ * each. A slot of level <l> covers 2^(TW_BITS*l) ticks, so that the whole
+ * wheel covers 2^(TW_BITS*TW_LEVELS) ticks (~4.6 hours) ahead of its clock.
+ * Tasks are stored in the slot where their expiration date falls, using their
+ * wq_list element overlaid on the wait queue node's branches, whose leaf_p is set
+ * to TASK_WQ_WHEEL, bit to the level and pfx to the slot number. A slot is
+ * processed once the clock reaches its first tick, at which point its tasks
+ * are either woken up or moved to a finer-grained slot. Timers which are
+ * already expired or too far in the future remain in the wait queue tree.
+ */
+#define TW_BITS    6
+#define TW_SLOTS   (1U << TW_BITS)
+#define TW_LEVELS  4
+
+#define TASK_WQ_WHEEL ((eb_troot_t *)1) /* wq.node.leaf_p for tasks in the wheel */
+
+struct timer_wheel {
+	uint clk;                                /* last tick fully processed */
+	uint64_t map[TW_LEVELS];                 /* one bit per non-empty slot */
+	struct list slots[TW_LEVELS][TW_SLOTS];  /* tasks lists, by level then slot */
+};
+
 /* Note: subscribing to these events is only valid after the caller has really
  * attempted to perform the operation, and failed to proceed or complete.
  */
@@ -76,6 +76,12 @@
  *   - timer is the real expiration date (possibly infinite)
  *   - node->key is always before or equal to timer
  *
+ * When "tune.sched.timer-wheel" is set, thread-local timers are preferably
+ * stored in a per-thread timer wheel (see struct timer_wheel) which follows
+ * the same principles: the slot a task is in is always before or equal to its
+ * real expiration date, and misplaced tasks are moved when their slot is
+ * reached. Only expired or very distant timers still go to the tree.
+ *
  * The run queue works similarly to the wait queue except that the current date
  * is replaced by an insertion counter which can also wrap without any problem.
  */
@@ -257,7 +263,19 @@ static inline void task_drop_running(struct task *t, unsigned int f)
  */
 static inline struct task *__task_unlink_wq(struct task *t)
 {
-	eb32_delete(&t->wq);
+	if (t->wq.node.leaf_p == TASK_WQ_WHEEL) {
+		/* the task is in its thread's timer wheel */
+		struct timer_wheel *tw = ha_thread_ctx[t->tid].wheel;
+		uint lvl = t->wq.node.bit;
+		uint slot = t->wq.node.pfx;
+
+		LIST_DELETE(&t->wq_list);
+		if (LIST_ISEMPTY(&tw->slots[lvl][slot]))
+			tw->map[lvl] &= ~(1ULL << slot);
+		t->wq.node.leaf_p = NULL;
+	}
+	else
+		eb32_delete(&t->wq);
 	return t;
 }
 
@@ -30,6 +30,7 @@
 
 /* forward declarations for types used below */
 struct buffer;
+struct timer_wheel;
 
 /* Threads sets are known either by a set of absolute thread numbers, or by a
  * set of relative thread numbers within a group, for each group. The default
@@ -140,6 +141,7 @@ struct thread_ctx {
 	// 2 bytes hole here
 	unsigned int nb_rhttp_conns;        /* count of current conns used for active reverse HTTP */
 	struct sched_activity *sched_profile_entry; /* profile entry in use by the current task/tasklet, only if sched_wake_date>0 */
+	struct timer_wheel *wheel;          /* per-thread timer wheel if enabled, otherwise NULL */
 
 	ALWAYS_ALIGN(2*sizeof(void*));
 	struct list buffer_wq[DYNBUF_NBQ];  /* buffer waiters, 4 criticality-based queues */
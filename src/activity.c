@@ -1163,9 +1163,16 @@ static int cli_io_handler_show_activity(struct appctx *appctx)
 		case __LINE__: SHOW_VAL("cpust_ms_15s:", read_freq_ctr_period(&activity[thr].cpust_15s, 15000) / 2, _tot); break;
 		case __LINE__: SHOW_VAL("avg_cpu_pct:",  (100 - ha_thread_ctx[thr].idle_pct), (_tot + _nbt/2) / _nbt); break;
 		case __LINE__: SHOW_VAL("avg_loop_us:",  swrate_avg(activity[thr].avg_loop_us, TIME_STATS_SAMPLES), (_tot + _nbt/2) / _nbt); break;
+		case __LINE__: SHOW_VAL("lat_urg_us:",   swrate_avg(activity[thr].tl_lat_us[TL_URGENT], SCHED_LAT_SAMPLES), (_tot + _nbt/2) / _nbt); break;
+		case __LINE__: SHOW_VAL("lat_nrm_us:",   swrate_avg(activity[thr].tl_lat_us[TL_NORMAL], SCHED_LAT_SAMPLES), (_tot + _nbt/2) / _nbt); break;
+		case __LINE__: SHOW_VAL("lat_blk_us:",   swrate_avg(activity[thr].tl_lat_us[TL_BULK],   SCHED_LAT_SAMPLES), (_tot + _nbt/2) / _nbt); break;
+		case __LINE__: SHOW_VAL("lat_hvy_us:",   swrate_avg(activity[thr].tl_lat_us[TL_HEAVY],  SCHED_LAT_SAMPLES), (_tot + _nbt/2) / _nbt); break;
 		case __LINE__: SHOW_VAL("accepted:",     activity[thr].accepted, _tot); break;
+		case __LINE__: SHOW_VAL("acc_rate:",     read_freq_ctr(&activity[thr].acc_rate), _tot); break;
 		case __LINE__: SHOW_VAL("accq_pushed:",  activity[thr].accq_pushed, _tot); break;
 		case __LINE__: SHOW_VAL("accq_full:",    activity[thr].accq_full, _tot); break;
+		case __LINE__: SHOW_VAL("accq_cpu:",     activity[thr].accq_cpu, _tot); break;
+		case __LINE__: SHOW_VAL("accq_wakeup:",  activity[thr].accq_wakeup, _tot); break;
 #ifdef USE_THREAD
 		case __LINE__: SHOW_VAL("accq_ring:",    accept_queue_ring_len(&accept_queue_rings[thr]), _tot); break;
 		case __LINE__: SHOW_VAL("fd_takeover:",  activity[thr].fd_takeover, _tot); break;
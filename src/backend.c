@@ -1236,7 +1236,7 @@ struct connection *conn_backend_get(struct stream *s, struct server *srv, int is
 	 */
 	if (srv->curr_idle_conns < srv->low_idle_conns &&
 	    ha_used_fds < global.tune.pool_low_count) {
-		const struct protocol *srv_proto = protocol_lookup(srv->addr.ss_family, PROTO_TYPE_STREAM, 0);
+		const struct protocol *srv_proto = protocol_lookup(srv->addr.ss_family, srv->addr_type.proto_type, srv->addr_type.xprt_type == PROTO_TYPE_DGRAM);
 
 		if (srv_proto && srv_proto->connect)
 			goto done;
@@ -1691,7 +1691,11 @@ int connect_server(struct stream *s)
 	if (!srv_conn->xprt) {
 		/* set the correct protocol on the output stream connector */
 		if (srv) {
-			if (conn_prepare(srv_conn, protocol_lookup(srv_conn->dst->ss_family, PROTO_TYPE_STREAM, 0), srv->xprt)) {
+			const struct protocol *proto;
+
+			proto = protocol_lookup(srv_conn->dst->ss_family, srv->addr_type.proto_type,
+			                        srv->addr_type.xprt_type == PROTO_TYPE_DGRAM);
+			if (conn_prepare(srv_conn, proto, srv->xprt)) {
 				conn_free(srv_conn);
 				return SF_ERR_INTERNAL;
 			}
@@ -1723,6 +1727,12 @@ int connect_server(struct stream *s)
 #endif
 			init_mux = 1;
 
+		/* QUIC MUX is installed by the transport layer on handshake
+		 * completion.
+		 */
+		if (srv && srv_is_quic(srv))
+			init_mux = 0;
+
 		/* process the case where the server requires the PROXY protocol to be sent */
 		srv_conn->send_proxy_ofs = 0;
 
@@ -1370,6 +1370,21 @@ static int cfg_parse_global_tune_opts(char **args, int section_type,
 
 		return 0;
 	}
+	else if (strcmp(args[0], "tune.http.priorities") == 0) {
+		if (too_many_args(1, args, err, NULL))
+			return -1;
+
+		if (strcmp(args[1], "on") == 0)
+			global.tune.http_priorities = 1;
+		else if (strcmp(args[1], "off") == 0)
+			global.tune.http_priorities = 0;
+		else {
+			memprintf(err, "'%s' expects 'on' or 'off'.", args[0]);
+			return -1;
+		}
+
+		return 0;
+	}
 	else if (strcmp(args[0], "tune.http.maxhdr") == 0) {
 		if (*(args[1]) == 0) {
 			memprintf(err, "'%s' expects an integer argument.", args[0]);
@@ -1492,6 +1507,7 @@ static struct cfg_kw_list cfg_kws = {ILH, {
 	{ CFG_GLOBAL, "tune.http.cookielen", cfg_parse_global_tune_opts },
 	{ CFG_GLOBAL, "tune.http.logurilen", cfg_parse_global_tune_opts },
 	{ CFG_GLOBAL, "tune.http.maxhdr", cfg_parse_global_tune_opts },
+	{ CFG_GLOBAL, "tune.http.priorities", cfg_parse_global_tune_opts },
 	{ CFG_GLOBAL, "tune.comp.maxlevel", cfg_parse_global_tune_opts },
 	{ CFG_GLOBAL, "tune.pattern.cache-size", cfg_parse_global_tune_opts },
 	{ CFG_GLOBAL, "tune.disable-fast-forward", cfg_parse_global_tune_forward_opts },
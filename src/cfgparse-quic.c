@@ -17,6 +17,7 @@
 
 #define QUIC_CC_NEWRENO_STR "newreno"
 #define QUIC_CC_CUBIC_STR   "cubic"
+#define QUIC_CC_BBR_STR     "bbr"
 #define QUIC_CC_NO_CC_STR   "nocc"
 
 static int bind_parse_quic_force_retry(char **args, int cur_arg, struct proxy *px, struct bind_conf *conf, char **err)
@@ -25,6 +26,15 @@ static int bind_parse_quic_force_retry(char **args, int cur_arg, struct proxy *p
 	return 0;
 }
 
+/* parse "quic-cid-steering" bind keyword */
+static int bind_parse_quic_cid_steering(char **args, int cur_arg, struct proxy *px, struct bind_conf *conf, char **err)
+{
+	conf->options |= BC_O_QUIC_CID_STEER;
+	/* one socket per thread is required */
+	conf->settings.shards = -1;
+	return 0;
+}
+
 /* Parse <value> as a window size integer argument to keyword <kw>. By
  * default, value is explained as bytes. Suffixes 'k', 'm' and 'g' are valid as
  * multipliers. <end_opt> will point to the next unparsed character.
@@ -93,6 +103,12 @@ static int bind_parse_quic_cc_algo(char **args, int cur_arg, struct proxy *px,
 		cc_algo = &quic_cc_algo_cubic;
 		arg += strlen(QUIC_CC_CUBIC_STR);
 	}
+	else if (strncmp(arg, QUIC_CC_BBR_STR, strlen(QUIC_CC_BBR_STR)) == 0) {
+		/* bbr */
+		algo = QUIC_CC_BBR_STR;
+		cc_algo = &quic_cc_algo_bbr;
+		arg += strlen(QUIC_CC_BBR_STR);
+	}
 	else if (strncmp(arg, QUIC_CC_NO_CC_STR, strlen(QUIC_CC_NO_CC_STR)) == 0) {
 		/* nocc */
 		if (!experimental_directives_allowed) {
@@ -160,6 +176,7 @@ static int bind_parse_quic_socket(char **args, int cur_arg, struct proxy *px,
 static struct bind_kw_list bind_kws = { "QUIC", { }, {
 	{ "quic-force-retry", bind_parse_quic_force_retry, 0 },
 	{ "quic-cc-algo", bind_parse_quic_cc_algo, 1 },
+	{ "quic-cid-steering", bind_parse_quic_cid_steering, 0 },
 	{ "quic-socket", bind_parse_quic_socket, 1 },
 	{ NULL, NULL, 0 },
 }};
@@ -189,6 +206,29 @@ static int cfg_parse_quic_tune_socket_owner(char **args, int section_type,
 	return 0;
 }
 
+/* parse "tune.quic.pacing", accepts "off", "on" or "txtime" */
+static int cfg_parse_quic_tune_pacing(char **args, int section_type,
+                                      struct proxy *curpx,
+                                      const struct proxy *defpx,
+                                      const char *file, int line, char **err)
+{
+	if (too_many_args(1, args, err, NULL))
+		return -1;
+
+	if (strcmp(args[1], "off") == 0)
+		global.tune.quic_pacing = QUIC_PACING_OFF;
+	else if (strcmp(args[1], "on") == 0)
+		global.tune.quic_pacing = QUIC_PACING_TIMER;
+	else if (strcmp(args[1], "txtime") == 0)
+		global.tune.quic_pacing = QUIC_PACING_TXTIME;
+	else {
+		memprintf(err, "'%s' expects either 'off', 'on' or 'txtime' but got '%s'.", args[0], args[1]);
+		return -1;
+	}
+
+	return 0;
+}
+
 /* Must be used to parse tune.quic.* setting which requires a time
  * as value.
  * Return -1 on alert, or 0 if succeeded.
@@ -287,6 +327,15 @@ static int cfg_parse_quic_tune_setting(char **args, int section_type,
 	}
 	else if (strcmp(suffix, "max-frame-loss") == 0)
 		global.tune.quic_max_frame_loss = arg;
+	else if (strcmp(suffix, "pacing-burst") == 0) {
+		/* UDP GSO cannot emit more than 64 datagrams at once */
+		if (arg > 64) {
+			memprintf(err, "'%s' expects an integer argument between 1 and 64.", args[0]);
+			return -1;
+		}
+
+		global.tune.quic_pacing_burst = arg;
+	}
 	else if (strcmp(suffix, "reorder-ratio") == 0) {
 		if (arg > 100) {
 			memprintf(err, "'%s' expects an integer argument between 0 and 100.", args[0]);
@@ -350,7 +399,13 @@ static int cfg_parse_quic_tune_on_off(char **args, int section_type, struct prox
 	}
 
 	suffix = args[0] + prefix_len;
-	if (strcmp(suffix, "zero-copy-fwd-send") == 0 ) {
+	if (strcmp(suffix, "zero-copy-fwd-recv") == 0 ) {
+		if (on)
+			global.tune.no_zero_copy_fwd &= ~NO_ZERO_COPY_FWD_QUIC_RCV;
+		else
+			global.tune.no_zero_copy_fwd |= NO_ZERO_COPY_FWD_QUIC_RCV;
+	}
+	else if (strcmp(suffix, "zero-copy-fwd-send") == 0 ) {
 		if (on)
 			global.tune.no_zero_copy_fwd &= ~NO_ZERO_COPY_FWD_QUIC_SND;
 		else
@@ -362,6 +417,12 @@ static int cfg_parse_quic_tune_on_off(char **args, int section_type, struct prox
 		else
 			global.tune.options &= ~GTUNE_QUIC_CC_HYSTART;
 	}
+	else if (strcmp(suffix, "shared-ticket-keys") == 0) {
+		if (on)
+			global.tune.options |= GTUNE_QUIC_SHARED_TICKET_KEYS;
+		else
+			global.tune.options &= ~GTUNE_QUIC_SHARED_TICKET_KEYS;
+	}
 
 	return 0;
 }
@@ -377,9 +438,13 @@ static struct cfg_kw_list cfg_kws = {ILH, {
 	{ CFG_GLOBAL, "tune.quic.frontend.max-idle-timeout", cfg_parse_quic_time },
 	{ CFG_GLOBAL, "tune.quic.frontend.max-window-size", cfg_parse_quic_tune_setting },
 	{ CFG_GLOBAL, "tune.quic.max-frame-loss", cfg_parse_quic_tune_setting },
+	{ CFG_GLOBAL, "tune.quic.pacing", cfg_parse_quic_tune_pacing },
+	{ CFG_GLOBAL, "tune.quic.pacing-burst", cfg_parse_quic_tune_setting },
 	{ CFG_GLOBAL, "tune.quic.reorder-ratio", cfg_parse_quic_tune_setting },
 	{ CFG_GLOBAL, "tune.quic.retry-threshold", cfg_parse_quic_tune_setting },
+	{ CFG_GLOBAL, "tune.quic.shared-ticket-keys", cfg_parse_quic_tune_on_off },
 	{ CFG_GLOBAL, "tune.quic.disable-udp-gso", cfg_parse_quic_tune_setting0 },
+	{ CFG_GLOBAL, "tune.quic.zero-copy-fwd-recv", cfg_parse_quic_tune_on_off },
 	{ CFG_GLOBAL, "tune.quic.zero-copy-fwd-send", cfg_parse_quic_tune_on_off },
 	{ 0, NULL, NULL }
 }};
@@ -41,6 +41,7 @@
 #include <haproxy/tools.h>
 #include <haproxy/ssl_ckch.h>
 #include <haproxy/ssl_ocsp.h>
+#include <haproxy/ssl_offload.h>
 
 
 /****************** Global Section Parsing ********************************************/
@@ -130,7 +131,7 @@ static int ssl_parse_global_ssl_async(char **args, int section_type, struct prox
 {
 #ifdef SSL_MODE_ASYNC
 	global_ssl.async = 1;
-	global.ssl_used_async_engines = nb_engines;
+	global.ssl_used_async_engines = nb_engines + !!ssl_offload_nbthread;
 	return 0;
 #else
 	memprintf(err, "'%s': openssl library does not support async mode", args[0]);
@@ -386,6 +387,8 @@ static int ssl_parse_global_int(char **args, int section_type, struct proxy *cur
 
 	if (strcmp(args[0], "tune.ssl.cachesize") == 0)
 		target = &global.tune.sslcachesize;
+	else if (strcmp(args[0], "tune.ssl.cache-shards") == 0)
+		target = &global_ssl.cache_shards;
 	else if (strcmp(args[0], "tune.ssl.maxrecord") == 0)
 		target = (int *)&global_ssl.max_record;
 	else if (strcmp(args[0], "tune.ssl.hard-maxrecord") == 0)
@@ -445,6 +448,27 @@ static int ssl_parse_global_capture_buffer(char **args, int section_type, struct
 	return 0;
 }
 
+/* parse the "tune.ssl.cache-eviction" keyword in global section.
+ * Returns <0 on alert, >0 on warning, 0 on success.
+ */
+static int ssl_parse_global_cache_eviction(char **args, int section_type, struct proxy *curpx,
+                                           const struct proxy *defpx, const char *file, int line,
+                                           char **err)
+{
+	if (too_many_args(1, args, err, NULL))
+		return -1;
+
+	if (strcmp(args[1], "fifo") == 0)
+		global_ssl.cache_lru = 0;
+	else if (strcmp(args[1], "lru") == 0)
+		global_ssl.cache_lru = 1;
+	else {
+		memprintf(err, "'%s' expects either 'fifo' or 'lru' but got '%s'.", args[0], args[1]);
+		return -1;
+	}
+	return 0;
+}
+
 /* init the SSLKEYLOGFILE pool */
 #ifdef HAVE_SSL_KEYLOG
 static int ssl_parse_global_keylog(char **args, int section_type, struct proxy *curpx,
@@ -1090,6 +1114,25 @@ static int srv_parse_tls_method_minmax(char **args, int *cur_arg, struct proxy *
 	return parse_tls_method_minmax(args, *cur_arg, &newsrv->ssl_ctx.methods, err);
 }
 
+/* parse the "ktls" bind keyword */
+static int bind_parse_ktls(char **args, int cur_arg, struct proxy *px, struct bind_conf *conf, char **err)
+{
+#ifdef HAVE_SSL_KTLS
+	if (!experimental_directives_allowed) {
+		memprintf(err, "'%s' is experimental, must be allowed via a global 'expose-experimental-directives'",
+		          args[cur_arg]);
+		return ERR_ALERT | ERR_FATAL;
+	}
+	mark_tainted(TAINTED_CONFIG_EXP_KW_DECLARED);
+
+	conf->ssl_options |= BC_SSL_O_KTLS;
+	return 0;
+#else
+	memprintf(err, "'%s' : library does not support kernel TLS", args[cur_arg]);
+	return ERR_ALERT | ERR_FATAL;
+#endif
+}
+
 /* parse the "no-tls-tickets" bind keyword */
 static int bind_parse_no_tls_tickets(char **args, int cur_arg, struct proxy *px, struct bind_conf *conf, char **err)
 {
@@ -1865,6 +1908,32 @@ static int srv_parse_allow_0rtt(char **args, int *cur_arg, struct proxy *px, str
 	return 0;
 }
 
+/* parse the "ktls" server keyword */
+static int srv_parse_ktls(char **args, int *cur_arg, struct proxy *px, struct server *newsrv, char **err)
+{
+#ifdef HAVE_SSL_KTLS
+	if (!experimental_directives_allowed) {
+		memprintf(err, "'%s' is experimental, must be allowed via a global 'expose-experimental-directives'",
+		          args[*cur_arg]);
+		return ERR_ALERT | ERR_FATAL;
+	}
+	mark_tainted(TAINTED_CONFIG_EXP_KW_DECLARED);
+
+	newsrv->ssl_ctx.options |= SRV_SSL_O_KTLS;
+	return 0;
+#else
+	memprintf(err, "'%s' : library does not support kernel TLS", args[*cur_arg]);
+	return ERR_ALERT | ERR_FATAL;
+#endif
+}
+
+/* parse the "no-ktls" server keyword */
+static int srv_parse_no_ktls(char **args, int *cur_arg, struct proxy *px, struct server *newsrv, char **err)
+{
+	newsrv->ssl_ctx.options &= ~SRV_SSL_O_KTLS;
+	return 0;
+}
+
 /* parse the "no-ssl-reuse" server keyword */
 static int srv_parse_no_ssl_reuse(char **args, int *cur_arg, struct proxy *px, struct server *newsrv, char **err)
 {
@@ -2023,6 +2092,17 @@ static int ssl_parse_default_bind_options(char **args, int section_type, struct
 	while (*(args[i])) {
 		if (strcmp(args[i], "no-tls-tickets") == 0)
 			global_ssl.listen_default_ssloptions |= BC_SSL_O_NO_TLS_TICKETS;
+#ifdef HAVE_SSL_KTLS
+		else if (strcmp(args[i], "ktls") == 0) {
+			if (!experimental_directives_allowed) {
+				memprintf(err, "option '%s' on global statement '%s' is experimental, must be allowed via a global 'expose-experimental-directives'",
+				          args[i], args[0]);
+				return -1;
+			}
+			mark_tainted(TAINTED_CONFIG_EXP_KW_DECLARED);
+			global_ssl.listen_default_ssloptions |= BC_SSL_O_KTLS;
+		}
+#endif
 		else if (strcmp(args[i], "prefer-client-ciphers") == 0)
 			global_ssl.listen_default_ssloptions |= BC_SSL_O_PREF_CLIE_CIPH;
 		else if (strcmp(args[i], "ssl-min-ver") == 0 || strcmp(args[i], "ssl-max-ver") == 0) {
@@ -2055,6 +2135,17 @@ static int ssl_parse_default_server_options(char **args, int section_type, struc
 	while (*(args[i])) {
 		if (strcmp(args[i], "no-tls-tickets") == 0)
 			global_ssl.connect_default_ssloptions |= SRV_SSL_O_NO_TLS_TICKETS;
+#ifdef HAVE_SSL_KTLS
+		else if (strcmp(args[i], "ktls") == 0) {
+			if (!experimental_directives_allowed) {
+				memprintf(err, "option '%s' on global statement '%s' is experimental, must be allowed via a global 'expose-experimental-directives'",
+				          args[i], args[0]);
+				return -1;
+			}
+			mark_tainted(TAINTED_CONFIG_EXP_KW_DECLARED);
+			global_ssl.connect_default_ssloptions |= SRV_SSL_O_KTLS;
+		}
+#endif
 		else if (strcmp(args[i], "ssl-min-ver") == 0 || strcmp(args[i], "ssl-max-ver") == 0) {
 			if (!parse_tls_method_minmax(args, i, &global_ssl.connect_default_sslmethods, err))
 				i++;
@@ -2218,6 +2309,7 @@ static struct bind_kw_list bind_kws = { "SSL", { }, {
 	{ "force-tlsv12",          bind_parse_tls_method_options, 0 }, /* force TLSv12 */
 	{ "force-tlsv13",          bind_parse_tls_method_options, 0 }, /* force TLSv13 */
 	{ "generate-certificates", bind_parse_generate_certs,     0 }, /* enable the server certificates generation */
+	{ "ktls",                  bind_parse_ktls,               0 }, /* let the kernel process the TLS records */
 	{ "no-alpn",               bind_parse_no_alpn,            0 }, /* disable sending ALPN */
 	{ "no-ca-names",           bind_parse_no_ca_names,        0 }, /* do not send ca names to clients (ca_file related) */
 	{ "no-sslv3",              bind_parse_tls_method_options, 0 }, /* disable SSLv3 */
@@ -2265,7 +2357,9 @@ static struct srv_kw_list srv_kws = { "SSL", { }, {
 	{ "force-tlsv11",            srv_parse_tls_method_options, 0, 1, 1 }, /* force TLSv11 */
 	{ "force-tlsv12",            srv_parse_tls_method_options, 0, 1, 1 }, /* force TLSv12 */
 	{ "force-tlsv13",            srv_parse_tls_method_options, 0, 1, 1 }, /* force TLSv13 */
+	{ "ktls",                    srv_parse_ktls,               0, 1, 1 }, /* let the kernel process the TLS records */
 	{ "no-check-ssl",            srv_parse_no_check_ssl,       0, 1, 0 }, /* disable SSL for health checks */
+	{ "no-ktls",                 srv_parse_no_ktls,            0, 1, 0 }, /* let OpenSSL process the TLS records */
 	{ "no-send-proxy-v2-ssl",    srv_parse_no_send_proxy_ssl,  0, 1, 0 }, /* do not send PROXY protocol header v2 with SSL info */
 	{ "no-send-proxy-v2-ssl-cn", srv_parse_no_send_proxy_cn,   0, 1, 0 }, /* do not send PROXY protocol header v2 with CN */
 	{ "no-ssl",                  srv_parse_no_ssl,             0, 1, 0 }, /* disable SSL processing */
@@ -2316,6 +2410,8 @@ static struct cfg_kw_list cfg_kws = {ILH, {
 	{ CFG_GLOBAL, "ssl-security-level", ssl_parse_security_level },
 	{ CFG_GLOBAL, "ssl-skip-self-issued-ca", ssl_parse_skip_self_issued_ca },
 	{ CFG_GLOBAL, "tune.ssl.cachesize", ssl_parse_global_int },
+	{ CFG_GLOBAL, "tune.ssl.cache-eviction", ssl_parse_global_cache_eviction },
+	{ CFG_GLOBAL, "tune.ssl.cache-shards", ssl_parse_global_int },
 	{ CFG_GLOBAL, "tune.ssl.default-dh-param", ssl_parse_global_default_dh },
 	{ CFG_GLOBAL, "tune.ssl.force-private-cache",  ssl_parse_global_private_cache },
 	{ CFG_GLOBAL, "tune.ssl.lifetime", ssl_parse_global_lifetime },
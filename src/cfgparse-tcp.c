@@ -69,6 +69,15 @@ static int bind_parse_defer_accept(char **args, int cur_arg, struct proxy *px, s
 }
 #endif
 
+#if defined(SO_INCOMING_CPU) && defined(USE_CPU_AFFINITY)
+/* parse the "incoming-cpu" bind keyword */
+static int bind_parse_incoming_cpu(char **args, int cur_arg, struct proxy *px, struct bind_conf *conf, char **err)
+{
+	conf->options |= BC_O_INCOMING_CPU;
+	return 0;
+}
+#endif
+
 #ifdef TCP_FASTOPEN
 /* parse the "tfo" bind keyword */
 static int bind_parse_tfo(char **args, int cur_arg, struct proxy *px, struct bind_conf *conf, char **err)
@@ -226,6 +235,9 @@ static struct bind_kw_list bind_kws = { "TCP", { }, {
 #if defined(TCP_DEFER_ACCEPT) || defined(SO_ACCEPTFILTER)
 	{ "defer-accept",  bind_parse_defer_accept, 0 }, /* wait for some data for 1 second max before doing accept */
 #endif
+#if defined(SO_INCOMING_CPU) && defined(USE_CPU_AFFINITY)
+	{ "incoming-cpu",  bind_parse_incoming_cpu, 0 }, /* dispatch connections to the thread bound to their CPU */
+#endif
 #ifdef SO_BINDTODEVICE
 	{ "interface",     bind_parse_interface,    1 }, /* specifically bind to this interface */
 #endif
@@ -250,6 +262,7 @@ static struct bind_kw_list bind_kws = { "TCP", { }, {
 #endif
 	/* the versions with the NULL parse function*/
 	{ "defer-accept",  NULL,  0 },
+	{ "incoming-cpu",  NULL,  0 },
 	{ "interface",     NULL,  1 },
 	{ "mss",           NULL,  1 },
 	{ "transparent",   NULL,  0 },
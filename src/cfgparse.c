@@ -4169,6 +4169,23 @@ int check_config_validity()
 					 newsrv->mux_proto->token.ptr,
 					 newsrv->id, newsrv->conf.file, newsrv->conf.line);
 				cfgerr++;
+			} else {
+				if ((mux_ent->mux->flags & MX_FL_FRAMED) && !srv_is_quic(newsrv)) {
+					ha_alert("%s '%s' : frame-based MUX protocol '%.*s' is incompatible with stream transport used by server '%s' at [%s:%d].\n",
+						 proxy_type_str(curproxy), curproxy->id,
+						 (int)newsrv->mux_proto->token.len,
+						 newsrv->mux_proto->token.ptr,
+						 newsrv->id, newsrv->conf.file, newsrv->conf.line);
+					cfgerr++;
+				}
+				else if (!(mux_ent->mux->flags & MX_FL_FRAMED) && srv_is_quic(newsrv)) {
+					ha_alert("%s '%s' : stream-based MUX protocol '%.*s' is incompatible with framed transport used by server '%s' at [%s:%d].\n",
+						 proxy_type_str(curproxy), curproxy->id,
+						 (int)newsrv->mux_proto->token.len,
+						 newsrv->mux_proto->token.ptr,
+						 newsrv->id, newsrv->conf.file, newsrv->conf.line);
+					cfgerr++;
+				}
 			}
 
 			/* update the mux */
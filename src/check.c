@@ -1803,7 +1803,8 @@ int init_srv_check(struct server *srv)
 		if (!srv->check.port && !is_addr(&srv->check.addr)) {
 			if (!srv->check.use_ssl && srv->use_ssl != -1) {
 				srv->check.use_ssl = srv->use_ssl;
-				srv->check.xprt    = srv->xprt;
+				/* QUIC servers are checked over TLS/TCP */
+				srv->check.xprt    = srv_is_quic(srv) ? xprt_get(XPRT_SSL) : srv->xprt;
 			}
 			else if (srv->check.use_ssl == 1)
 				srv->check.xprt = xprt_get(XPRT_SSL);
@@ -1825,6 +1826,7 @@ int init_srv_check(struct server *srv)
 	 * the check
 	 */
 	if (srv->mux_proto && !srv->check.mux_proto &&
+	    !(srv->mux_proto->mux->flags & MX_FL_FRAMED) &&
 	    ((srv->mux_proto->mode == PROTO_MODE_HTTP && check_type == TCPCHK_RULES_HTTP_CHK) ||
 	     (srv->mux_proto->mode == PROTO_MODE_SPOP && check_type == TCPCHK_RULES_SPOP_CHK) ||
 	     (srv->mux_proto->mode == PROTO_MODE_TCP && check_type != TCPCHK_RULES_HTTP_CHK))) {
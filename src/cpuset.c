@@ -274,6 +274,41 @@ int cpu_map_configured(void)
 	return 0;
 }
 
+/* Returns the only CPU thread <ltid> (starting at 0) of thread group <tgrp>
+ * (starting at 1) is bound to by a cpu-map directive, or -1 if the thread is
+ * either not bound or bound to more than one CPU.
+ */
+int cpu_map_thread_cpu(int tgrp, int ltid)
+{
+	const struct hap_cpuset *set = &cpu_map[tgrp - 1].thread[ltid];
+
+	if (ha_cpuset_count(set) != 1)
+		return -1;
+	return ha_cpuset_ffs(set) - 1;
+}
+
+/* Looks up among the threads of group <tgrp> (starting at 1) enabled in
+ * <mask> the one whose cpu-map contains CPU <cpu>. The local thread number is
+ * returned on success. -1 is returned if no such thread exists, or if several
+ * of them may run on this CPU since there would be no way to decide which one
+ * is the most appropriate.
+ */
+int cpu_map_cpu_thread(int tgrp, ulong mask, int cpu)
+{
+	int thr, found = -1;
+
+	while (mask) {
+		thr = my_ffsl(mask) - 1;
+		mask &= mask - 1;
+		if (!ha_cpuset_isset(&cpu_map[tgrp - 1].thread[thr], cpu))
+			continue;
+		if (found >= 0)
+			return -1;
+		found = thr;
+	}
+	return found;
+}
+
 /* Allocates everything needed to store CPU information at boot.
  * Returns non-zero on success, zero on failure.
  */
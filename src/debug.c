@@ -279,6 +279,12 @@ void ha_thread_dump_one(int thr, int from_signal)
 	unsigned long long p = ha_thread_ctx[thr].prev_cpu_time;
 	unsigned long long n = now_cpu_time_thread(thr);
 	int stuck = !!(ha_thread_ctx[thr].flags & TH_FL_STUCK);
+	int wq = !eb_is_empty(&ha_thread_ctx[thr].timers);
+	int lvl;
+
+	/* timers may also be queued in the thread's timer wheel */
+	for (lvl = 0; !wq && ha_thread_ctx[thr].wheel && lvl < TW_LEVELS; lvl++)
+		wq = !!ha_thread_ctx[thr].wheel->map[lvl];
 
 	chunk_appendf(buf,
 	              "%c%cThread %-2u: id=0x%llx act=%d glob=%d wq=%d rq=%d tl=%d tlsz=%d rqsz=%d\n"
@@ -287,7 +293,7 @@ void ha_thread_dump_one(int thr, int from_signal)
 		      ha_get_pthread_id(thr),
 		      thread_has_tasks(),
 	              !eb_is_empty(&ha_thread_ctx[thr].rqueue_shared),
-	              !eb_is_empty(&ha_thread_ctx[thr].timers),
+	              wq,
 	              !eb_is_empty(&ha_thread_ctx[thr].rqueue),
 	              !(LIST_ISEMPTY(&ha_thread_ctx[thr].tasklets[TL_URGENT]) &&
 			LIST_ISEMPTY(&ha_thread_ctx[thr].tasklets[TL_NORMAL]) &&
@@ -16,13 +16,16 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <import/eb64tree.h>
 #include <import/ist.h>
 
 #include <haproxy/api.h>
 #include <haproxy/buf.h>
+#include <haproxy/cfgparse.h>
 #include <haproxy/chunk.h>
 #include <haproxy/connection.h>
 #include <haproxy/dynbuf.h>
+#include <haproxy/errors.h>
 #include <haproxy/h3.h>
 #include <haproxy/h3_stats.h>
 #include <haproxy/http.h>
@@ -34,8 +37,10 @@
 #include <haproxy/mux_quic.h>
 #include <haproxy/pool.h>
 #include <haproxy/qmux_http.h>
+#include <haproxy/qpack-t.h>
 #include <haproxy/qpack-dec.h>
 #include <haproxy/qpack-enc.h>
+#include <haproxy/qpack-tbl.h>
 #include <haproxy/quic_enc.h>
 #include <haproxy/quic_fctl.h>
 #include <haproxy/quic_frame.h>
@@ -124,13 +129,16 @@ INITCALL1(STG_REGISTER, trace_register_source, TRACE_SOURCE);
 #define H3_CF_GOAWAY_SENT       0x00000020  /* GOAWAY sent on local control stream */
 
 /* Default settings */
-static uint64_t h3_settings_qpack_max_table_capacity = 0;
+static uint64_t h3_settings_qpack_max_table_capacity = 0; /* tune.h3.qpack.max-table-capacity */
 static uint64_t h3_settings_qpack_blocked_streams = 4096;
+static uint64_t h3_qpack_encoder_table_size = 0; /* tune.h3.qpack.encoder-table-size */
 static uint64_t h3_settings_max_field_section_size = QUIC_VARINT_8_BYTE_MAX; /* Unlimited */
 
 struct h3c {
 	struct qcc *qcc;
 	struct qcs *ctrl_strm; /* Control stream */
+	struct qcs *qpack_enc_strm; /* Local QPACK encoder stream */
+	struct qcs *qpack_dec_strm; /* Local QPACK decoder stream */
 	int err;
 	uint32_t flags;
 
@@ -141,6 +149,9 @@ struct h3c {
 
 	uint64_t id_goaway; /* stream ID used for a GOAWAY frame */
 
+	struct qpack_enc qpack_enc; /* QPACK encoder context for sent field sections */
+	struct qpack_dec qpack_dec; /* QPACK decoder context for received field sections */
+
 	struct buffer_wait buf_wait; /* wait list for buffer allocations */
 	/* Stats counters */
 	struct h3_counters *prx_counters;
@@ -151,6 +162,8 @@ DECLARE_STATIC_POOL(pool_head_h3c, "h3c", sizeof(struct h3c));
 #define H3_SF_UNI_INIT  0x00000001  /* stream type not parsed for unidirectional stream */
 #define H3_SF_UNI_NO_H3 0x00000002  /* unidirectional stream does not carry H3 frames */
 #define H3_SF_HAVE_CLEN 0x00000004  /* content-length header is present */
+#define H3_SF_QPACK_BLOCKED 0x00000008  /* field section waiting for QPACK encoder stream insertions */
+#define H3_SF_RESP_NO_BODY  0x00000010  /* backend stream: response to a HEAD request */
 
 struct h3s {
 	struct h3c *h3c;
@@ -169,6 +182,154 @@ struct h3s {
 
 DECLARE_STATIC_POOL(pool_head_h3s, "h3s", sizeof(struct h3s));
 
+/* Prepares <ins> to receive instructions for the local QPACK encoder or decoder
+ * stream <qcs>. They are written directly at the end of its Tx buffer, within
+ * the limits of the flow control. <ins> is left without room if the stream is
+ * not opened or if no buffer is available.
+ */
+static void h3_qpack_ins_prepare(struct qcs *qcs, struct buffer *ins)
+{
+	struct buffer *res;
+	uint64_t cap;
+	int err;
+
+	*ins = BUF_NULL;
+	if (!qcs)
+		return;
+
+	/* QPACK streams use unlimited buffers, see qcs_send_metadata(). */
+	res = qcc_get_stream_txbuf(qcs, &err, 0);
+	if (res && !b_contig_space(res) && !qcc_release_stream_txbuf(qcs))
+		res = qcc_get_stream_txbuf(qcs, &err, 0);
+	if (!res)
+		return;
+
+	cap = MIN(qfctl_rcap(&qcs->tx.fc), qfctl_rcap(&qcs->qcc->tx.fc));
+	*ins = b_make(b_tail(res), MIN(b_contig_space(res), cap), 0, 0);
+}
+
+/* Commits the instructions written into <ins> prepared for <qcs> QPACK stream
+ * by h3_qpack_ins_prepare() and schedules their emission.
+ */
+static void h3_qpack_ins_send(struct qcs *qcs, struct buffer *ins)
+{
+	struct buffer *res;
+	int err;
+
+	if (!b_data(ins))
+		return;
+
+	res = qcc_get_stream_txbuf(qcs, &err, 0);
+	BUG_ON(!res || b_tail(res) != b_orig(ins));
+	b_add(res, b_data(ins));
+	qcc_send_stream(qcs, 1, b_data(ins));
+	qcc_wakeup(qcs->qcc);
+}
+
+/* Opens a local QPACK stream of type <type> for <h3c> connection.
+ *
+ * Returns the stream instance or NULL on error.
+ */
+static struct qcs *h3_qpack_open_stream(struct h3c *h3c, uint64_t type)
+{
+	struct qcs *qcs;
+	struct buffer *res;
+	int err;
+
+	qcs = qcc_init_stream_local(h3c->qcc, 0);
+	if (!qcs)
+		return NULL;
+
+	qcs_send_metadata(qcs);
+	res = qcc_get_stream_txbuf(qcs, &err, 0);
+	if (!res || qfctl_sblocked(&qcs->tx.fc) || qfctl_sblocked(&h3c->qcc->tx.fc))
+		return NULL;
+
+	b_quic_enc_int(res, type, 0);
+	qcc_send_stream(qcs, 1, b_data(res));
+	return qcs;
+}
+
+/* Opens the local QPACK encoder stream of <h3c> and enables its dynamic table
+ * once the peer SETTINGS are known, if both the peer and the local
+ * configuration allow it.
+ */
+static void h3_qpack_enc_start(struct h3c *h3c)
+{
+	struct buffer ins;
+	uint64_t cap;
+
+	cap = MIN(h3c->qpack_max_table_capacity, h3_qpack_encoder_table_size);
+	if (!cap || h3c->qpack_enc_strm)
+		return;
+
+	h3c->qpack_enc_strm = h3_qpack_open_stream(h3c, H3_UNI_S_T_QPACK_ENC);
+	if (!h3c->qpack_enc_strm) {
+		TRACE_ERROR("cannot open QPACK encoder stream", H3_EV_RX_FRAME|H3_EV_RX_SETTINGS, h3c->qcc->conn);
+		return;
+	}
+
+	h3_qpack_ins_prepare(h3c->qpack_enc_strm, &ins);
+	if (!qpack_enc_set_capacity(&h3c->qpack_enc, &ins, h3c->qpack_max_table_capacity, cap))
+		h3_qpack_ins_send(h3c->qpack_enc_strm, &ins);
+}
+
+/* Notifies the QPACK encoder of the peer that the field section just decoded
+ * on <qcs> with Required Insert Count <ric> was processed, and releases its
+ * blocked state.
+ */
+static void h3_qpack_fs_decoded(struct qcs *qcs, uint64_t ric)
+{
+	struct h3s *h3s = qcs->ctx;
+	struct h3c *h3c = h3s->h3c;
+	struct buffer ins;
+
+	if (h3s->flags & H3_SF_QPACK_BLOCKED) {
+		h3s->flags &= ~H3_SF_QPACK_BLOCKED;
+		h3c->qpack_dec.blocked--;
+	}
+
+	if (!ric)
+		return;
+
+	/* RFC 9204 4.4.1. Section Acknowledgment
+	 *
+	 * After processing an encoded field section whose declared Required
+	 * Insert Count is not zero, the decoder emits a Section Acknowledgment
+	 * instruction.
+	 */
+	h3_qpack_ins_prepare(h3c->qpack_dec_strm, &ins);
+	qpack_dec_ack_section(&h3c->qpack_dec, &ins, qcs->id, ric);
+	h3_qpack_ins_send(h3c->qpack_dec_strm, &ins);
+}
+
+/* Marks <qcs> as blocked waiting for QPACK encoder stream insertions.
+ *
+ * Returns 0 on success else non-zero if the peer exceeds the announced
+ * SETTINGS_QPACK_BLOCKED_STREAMS limit.
+ */
+static int h3_qpack_fs_blocked(struct qcs *qcs)
+{
+	struct h3s *h3s = qcs->ctx;
+	struct h3c *h3c = h3s->h3c;
+
+	if (h3s->flags & H3_SF_QPACK_BLOCKED)
+		return 0;
+
+	/* RFC 9204 2.1.2. Blocked Streams
+	 *
+	 * If a decoder encounters more blocked streams than it promised to
+	 * support, it MUST treat this as a connection error of type
+	 * QPACK_DECOMPRESSION_FAILED.
+	 */
+	if (h3c->qpack_dec.blocked >= h3c->qpack_dec.max_blocked)
+		return 1;
+
+	h3s->flags |= H3_SF_QPACK_BLOCKED;
+	h3c->qpack_dec.blocked++;
+	return 0;
+}
+
 /* Initialize an uni-stream <qcs> by reading its type from <b>.
  *
  * Returns the count of consumed bytes or a negative error code.
@@ -265,18 +426,34 @@ static ssize_t h3_init_uni_stream(struct h3c *h3c, struct qcs *qcs,
 static ssize_t h3_parse_uni_stream_no_h3(struct qcs *qcs, struct buffer *b, int fin)
 {
 	struct h3s *h3s = qcs->ctx;
+	struct h3c *h3c = h3s->h3c;
+	struct buffer ins;
+	ssize_t ret;
 
 	/* Function reserved to non-HTTP/3 unidirectional streams. */
 	BUG_ON(!quic_stream_is_uni(qcs->id) || !(h3s->flags & H3_SF_UNI_NO_H3));
 
 	switch (h3s->type) {
 	case H3S_T_QPACK_DEC:
-		if (qpack_decode_dec(b, fin, qcs))
-			return -1;
+		ret = qpack_decode_dec(&h3c->qpack_enc, b, fin, qcs);
 		break;
 	case H3S_T_QPACK_ENC:
-		if (qpack_decode_enc(b, fin, qcs))
-			return -1;
+		ret = qpack_decode_enc(&h3c->qpack_dec, b, fin, qcs);
+		if (ret > 0 && h3c->qpack_dec.ic != h3c->qpack_dec.krc) {
+			/* RFC 9204 4.4.3. Insert Count Increment
+			 *
+			 * The decoder sends an Insert Count Increment
+			 * instruction to acknowledge insertions so that the
+			 * encoder may reference them without blocking.
+			 */
+			h3_qpack_ins_prepare(h3c->qpack_dec_strm, &ins);
+			qpack_dec_ack_inserts(&h3c->qpack_dec, &ins);
+			h3_qpack_ins_send(h3c->qpack_dec_strm, &ins);
+
+			/* blocked streams are decoded again from the MUX I/O handler */
+			if (h3c->qpack_dec.blocked)
+				qcc_wakeup(qcs->qcc);
+		}
 		break;
 	case H3S_T_UNKNOWN:
 	default:
@@ -284,8 +461,7 @@ static ssize_t h3_parse_uni_stream_no_h3(struct qcs *qcs, struct buffer *b, int
 		ABORT_NOW();
 	}
 
-	/* TODO adjust return code */
-	return 0;
+	return ret;
 }
 
 /* Decode a H3 frame header from <rxbuf> buffer. The frame type is stored in
@@ -384,6 +560,21 @@ static int h3_check_frame_valid(struct h3c *h3c, struct qcs *qcs, uint64_t ftype
 			ret = H3_ERR_MISSING_SETTINGS;
 		break;
 
+	case H3_FT_PRIORITY_UPDATE_REQ:
+	case H3_FT_PRIORITY_UPDATE_PUSH:
+		/* RFC 9218 7.2. HTTP/3 PRIORITY_UPDATE Frame
+		 *
+		 * The PRIORITY_UPDATE frame MUST be sent on the client control
+		 * stream. Receiving a PRIORITY_UPDATE frame on a stream other
+		 * than the client control stream MUST be treated as a connection
+		 * error of type H3_FRAME_UNEXPECTED.
+		 */
+		if (h3s->type != H3S_T_CTRL)
+			ret = H3_ERR_FRAME_UNEXPECTED;
+		else if (!(h3c->flags & H3_CF_SETTINGS_RECV))
+			ret = H3_ERR_MISSING_SETTINGS;
+		break;
+
 	case H3_FT_SETTINGS:
 		/* RFC 9114 7.2.4. SETTINGS
 		 *
@@ -457,11 +648,12 @@ static int h3_check_body_size(struct qcs *qcs, int fin)
 	 * malformed if the value of the Content-Length header field does not
 	 * equal the sum of the DATA frame lengths received.
 	 *
-	 * TODO for backend support
 	 * A response that is
 	 * defined as never having content, even when a Content-Length is
 	 * present, can have a non-zero Content-Length header field even though
 	 * no content is included in DATA frames.
+	 *
+	 * H3_SF_HAVE_CLEN is never set for such responses.
 	 */
 	if (h3s->data_len > h3s->body_len ||
 	    (fin && h3s->data_len < h3s->body_len)) {
@@ -534,6 +726,7 @@ static ssize_t h3_headers_to_htx(struct qcs *qcs, const struct buffer *buf,
 	const char *ctl;
 	int relaxed = !!(h3c->qcc->proxy->options2 & PR_O2_REQBUG_OK);
 	int qpack_err;
+	uint64_t ric;
 
 	/* RFC 9114 4.1.2. Malformed Requests and Responses
 	 *
@@ -561,9 +754,22 @@ static ssize_t h3_headers_to_htx(struct qcs *qcs, const struct buffer *buf,
 
 	/* TODO support buffer wrapping */
 	BUG_ON(b_head(buf) + len >= b_wrap(buf));
-	ret = qpack_decode_fs((const unsigned char *)b_head(buf), len, tmp,
-	                    list, sizeof(list) / sizeof(list[0]));
-	if (ret < 0) {
+	ret = qpack_decode_fs(&h3c->qpack_dec, (const unsigned char *)b_head(buf), len, tmp,
+	                      list, sizeof(list) / sizeof(list[0]), &ric);
+	if (ret == -QPACK_RET_BLOCKED) {
+		if (h3_qpack_fs_blocked(qcs)) {
+			TRACE_ERROR("too many QPACK blocked streams", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+			h3c->err = QPACK_ERR_DECOMPRESSION_FAILED;
+			qcc_report_glitch(qcs->qcc, 1);
+			len = -1;
+			goto out;
+		}
+
+		TRACE_STATE("field section blocked on QPACK encoder stream", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+		len = 0;
+		goto out;
+	}
+	else if (ret < 0) {
 		TRACE_ERROR("QPACK decoding error", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
 		if ((qpack_err = qpack_err_decode(ret)) >= 0) {
 			h3c->err = qpack_err;
@@ -573,6 +779,8 @@ static ssize_t h3_headers_to_htx(struct qcs *qcs, const struct buffer *buf,
 		goto out;
 	}
 
+	h3_qpack_fs_decoded(qcs, ric);
+
 	if (!b_alloc(&htx_buf, DB_SE_RX)) {
 		TRACE_ERROR("HTX buffer alloc failure", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
 		len = -1;
@@ -868,6 +1076,10 @@ static ssize_t h3_headers_to_htx(struct qcs *qcs, const struct buffer *buf,
 			len = -1;
 			goto out;
 		}
+		else if (isteq(list[hdr_idx].n, ist("priority"))) {
+			/* RFC 9218 5. The Priority HTTP Header Field */
+			http_parse_priority(list[hdr_idx].v, &qcs->prio);
+		}
 
 		if (!htx_add_header(htx, list[hdr_idx].n, list[hdr_idx].v)) {
 			len = -1;
@@ -944,6 +1156,204 @@ static ssize_t h3_headers_to_htx(struct qcs *qcs, const struct buffer *buf,
 	return len;
 }
 
+/* Parse from buffer <buf> a H3 HEADERS frame of length <len> carrying a
+ * response on a backend stream. Data are copied in <qcs> HTX buffer already
+ * attached to the stream connector. <fin> must be set if this is the last data
+ * to transfer from this stream. Interim responses leave the stream in
+ * H3S_ST_REQ_BEFORE state, waiting for the final response.
+ *
+ * Returns the number of consumed bytes or a negative error code. On error
+ * either the connection should be closed or the stream reset using codes
+ * provided in h3c.err / h3s.err.
+ */
+static ssize_t h3_resp_headers_to_htx(struct qcs *qcs, const struct buffer *buf,
+                                      uint64_t len, char fin)
+{
+	struct h3s *h3s = qcs->ctx;
+	struct h3c *h3c = h3s->h3c;
+	struct buffer *tmp = get_trash_chunk();
+	struct buffer *appbuf = NULL;
+	struct htx *htx = NULL;
+	struct htx_sl *sl;
+	struct http_hdr list[global.tune.max_http_hdr];
+	unsigned int flags = HTX_SL_F_IS_RESP;
+	struct ist status = IST_NULL;
+	int hdr_idx, ret, code, i, no_body;
+	const char *ctl;
+	int qpack_err;
+	uint64_t ric;
+
+	TRACE_ENTER(H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+
+	/* TODO support buffer wrapping */
+	BUG_ON(b_head(buf) + len >= b_wrap(buf));
+	ret = qpack_decode_fs(&h3c->qpack_dec, (const unsigned char *)b_head(buf), len, tmp,
+	                      list, sizeof(list) / sizeof(list[0]), &ric);
+	if (ret == -QPACK_RET_BLOCKED) {
+		if (h3_qpack_fs_blocked(qcs)) {
+			TRACE_ERROR("too many QPACK blocked streams", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+			h3c->err = QPACK_ERR_DECOMPRESSION_FAILED;
+			len = -1;
+			goto out;
+		}
+
+		TRACE_STATE("field section blocked on QPACK encoder stream", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+		len = 0;
+		goto out;
+	}
+	else if (ret < 0) {
+		TRACE_ERROR("QPACK decoding error", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+		if ((qpack_err = qpack_err_decode(ret)) >= 0)
+			h3c->err = qpack_err;
+		len = -1;
+		goto out;
+	}
+
+	h3_qpack_fs_decoded(qcs, ric);
+
+	/* RFC 9114 4.3.2. Response Pseudo-Header Fields
+	 *
+	 * For responses, a single ":status" pseudo-header field is defined
+	 * that carries the HTTP status code; see Section 15 of [HTTP]. This
+	 * pseudo-header field MUST be included in all responses; otherwise,
+	 * the response is malformed (see Section 4.1.2).
+	 */
+	for (hdr_idx = 0; istmatch(list[hdr_idx].n, ist(":")); ++hdr_idx) {
+		if (!isteq(list[hdr_idx].n, ist(":status")) || isttest(status)) {
+			TRACE_ERROR("invalid response pseudo-header", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+			h3s->err = H3_ERR_MESSAGE_ERROR;
+			len = -1;
+			goto out;
+		}
+		status = list[hdr_idx].v;
+	}
+
+	if (istlen(status) != 3 || !isdigit((unsigned char)status.ptr[0]) ||
+	    !isdigit((unsigned char)status.ptr[1]) || !isdigit((unsigned char)status.ptr[2])) {
+		TRACE_ERROR("missing or invalid status pseudo-header", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+		h3s->err = H3_ERR_MESSAGE_ERROR;
+		len = -1;
+		goto out;
+	}
+	code = strl2ui(status.ptr, status.len);
+	if (code < 100) {
+		TRACE_ERROR("invalid status code", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+		h3s->err = H3_ERR_MESSAGE_ERROR;
+		len = -1;
+		goto out;
+	}
+
+	if (!(appbuf = qcc_get_stream_rxbuf(qcs))) {
+		TRACE_ERROR("HTX buffer alloc failure", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+		len = -1;
+		goto out;
+	}
+	BUG_ON(!b_size(appbuf)); /* TODO */
+	htx = htx_from_buf(appbuf);
+
+	flags |= HTX_SL_F_VER_11;
+	flags |= HTX_SL_F_XFER_LEN;
+
+	sl = htx_add_stline(htx, HTX_BLK_RES_SL, flags, ist("HTTP/3.0"), status, ist(""));
+	if (!sl) {
+		len = -1;
+		goto out;
+	}
+	sl->info.res.status = code;
+
+	/* These responses never have content, whatever the content-length. */
+	no_body = (code < 200 || code == 204 || code == 304 || h3s->flags & H3_SF_RESP_NO_BODY);
+	if (fin && code >= 200)
+		sl->flags |= HTX_SL_F_BODYLESS;
+
+	for (; !isteq(list[hdr_idx].n, ist("")); ++hdr_idx) {
+		if (istmatch(list[hdr_idx].n, ist(":"))) {
+			TRACE_ERROR("pseudo-header field after fields", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+			h3s->err = H3_ERR_MESSAGE_ERROR;
+			len = -1;
+			goto out;
+		}
+
+		for (i = 0; i < list[hdr_idx].n.len; ++i) {
+			const char c = list[hdr_idx].n.ptr[i];
+			if ((uint8_t)(c - 'A') < 'Z' - 'A' || !HTTP_IS_TOKEN(c)) {
+				TRACE_ERROR("invalid characters in field name", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+				h3s->err = H3_ERR_MESSAGE_ERROR;
+				len = -1;
+				goto out;
+			}
+		}
+
+		ctl = ist_find_ctl(list[hdr_idx].v);
+		if (unlikely(ctl) && http_header_has_forbidden_char(list[hdr_idx].v, ctl)) {
+			TRACE_ERROR("control character present in header value", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+			h3s->err = H3_ERR_MESSAGE_ERROR;
+			len = -1;
+			goto out;
+		}
+
+		if (isteq(list[hdr_idx].n, ist("content-length")) && code >= 200) {
+			ret = http_parse_cont_len_header(&list[hdr_idx].v,
+			                                 &h3s->body_len,
+			                                 h3s->flags & H3_SF_HAVE_CLEN);
+			if (ret < 0) {
+				TRACE_ERROR("invalid content-length", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+				h3s->err = H3_ERR_MESSAGE_ERROR;
+				len = -1;
+				goto out;
+			}
+			else if (!ret) {
+				/* Skip duplicated value. */
+				continue;
+			}
+
+			sl->flags |= HTX_SL_F_CLEN;
+			if (!no_body) {
+				h3s->flags |= H3_SF_HAVE_CLEN;
+				if (h3_check_body_size(qcs, fin)) {
+					len = -1;
+					goto out;
+				}
+			}
+		}
+		else if (isteq(list[hdr_idx].n, ist("connection")) ||
+		         isteq(list[hdr_idx].n, ist("proxy-connection")) ||
+		         isteq(list[hdr_idx].n, ist("keep-alive")) ||
+		         isteq(list[hdr_idx].n, ist("transfer-encoding"))) {
+			/* RFC 9114 4.2. HTTP Fields */
+			TRACE_ERROR("invalid connection header", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+			h3s->err = H3_ERR_MESSAGE_ERROR;
+			len = -1;
+			goto out;
+		}
+
+		if (!htx_add_header(htx, list[hdr_idx].n, list[hdr_idx].v)) {
+			len = -1;
+			goto out;
+		}
+	}
+
+	if (!htx_add_endof(htx, HTX_BLK_EOH)) {
+		len = -1;
+		goto out;
+	}
+
+	/* Wait for the final response after an interim one. */
+	if (code >= 200) {
+		h3s->st_req = H3S_ST_REQ_HEADERS;
+		if (fin)
+			htx->flags |= HTX_FL_EOM;
+	}
+
+ out:
+	/* HTX may be non NULL if error before previous htx_to_buf(). */
+	if (appbuf)
+		htx_to_buf(htx, appbuf);
+
+	TRACE_LEAVE(H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+	return len;
+}
+
 /* Parse from buffer <buf> a H3 HEADERS frame of length <len> used as trailers.
  * Data are copied in a local HTX buffer and transfer to the stream connector
  * layer. <fin> must be set if this is the last data to transfer from this
@@ -966,15 +1376,29 @@ static ssize_t h3_trailers_to_htx(struct qcs *qcs, const struct buffer *buf,
 	int hdr_idx, ret;
 	const char *ctl;
 	int qpack_err;
+	uint64_t ric;
 	int i;
 
 	TRACE_ENTER(H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
 
 	/* TODO support buffer wrapping */
 	BUG_ON(b_head(buf) + len >= b_wrap(buf));
-	ret = qpack_decode_fs((const unsigned char *)b_head(buf), len, tmp,
-	                    list, sizeof(list) / sizeof(list[0]));
-	if (ret < 0) {
+	ret = qpack_decode_fs(&h3c->qpack_dec, (const unsigned char *)b_head(buf), len, tmp,
+	                      list, sizeof(list) / sizeof(list[0]), &ric);
+	if (ret == -QPACK_RET_BLOCKED) {
+		if (h3_qpack_fs_blocked(qcs)) {
+			TRACE_ERROR("too many QPACK blocked streams", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+			h3c->err = QPACK_ERR_DECOMPRESSION_FAILED;
+			qcc_report_glitch(qcs->qcc, 1);
+			len = -1;
+			goto out;
+		}
+
+		TRACE_STATE("field section blocked on QPACK encoder stream", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
+		len = 0;
+		goto out;
+	}
+	else if (ret < 0) {
 		TRACE_ERROR("QPACK decoding error", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
 		if ((qpack_err = qpack_err_decode(ret)) >= 0) {
 			h3c->err = qpack_err;
@@ -984,6 +1408,8 @@ static ssize_t h3_trailers_to_htx(struct qcs *qcs, const struct buffer *buf,
 		goto out;
 	}
 
+	h3_qpack_fs_decoded(qcs, ric);
+
 	if (!(appbuf = qcc_get_stream_rxbuf(qcs))) {
 		TRACE_ERROR("HTX buffer alloc failure", H3_EV_RX_FRAME|H3_EV_RX_HDR, qcs->qcc->conn, qcs);
 		len = -1;
@@ -1255,6 +1681,103 @@ static ssize_t h3_parse_settings_frm(struct h3c *h3c, const struct buffer *buf,
 	return ret;
 }
 
+/* Parse a PRIORITY_UPDATE frame of length <len> for request streams from
+ * <buf> and update the priority of the designated stream. Updates for streams
+ * which are not opened yet or already closed are ignored.
+ *
+ * Returns the number of consumed bytes or a negative error code.
+ */
+static ssize_t h3_parse_priority_update_frm(struct h3c *h3c, const struct buffer *buf,
+                                            size_t len)
+{
+	struct buffer b, *value;
+	struct eb64_node *node;
+	struct qcs *qcs;
+	uint64_t id;
+	size_t ret = 0;
+
+	TRACE_ENTER(H3_EV_RX_FRAME, h3c->qcc->conn);
+
+	/* Work on a copy of <buf>. */
+	b = b_make(b_orig(buf), b_size(buf), b_head_ofs(buf), len);
+
+	if (!b_quic_dec_int(&id, &b, &ret)) {
+		h3c->err = H3_ERR_FRAME_ERROR;
+		qcc_report_glitch(h3c->qcc, 1);
+		TRACE_ERROR("invalid PRIORITY_UPDATE frame", H3_EV_RX_FRAME, h3c->qcc->conn);
+		return -1;
+	}
+
+	/* RFC 9218 7.2. HTTP/3 PRIORITY_UPDATE Frame
+	 *
+	 * If a server receives a PRIORITY_UPDATE frame with a Prioritized
+	 * Element ID that is not a client-initiated bidirectional stream, it
+	 * MUST respond with a connection error of type H3_ID_ERROR.
+	 */
+	if (!quic_stream_is_bidi(id) || !quic_stream_is_remote(h3c->qcc, id)) {
+		h3c->err = H3_ERR_ID_ERROR;
+		qcc_report_glitch(h3c->qcc, 1);
+		TRACE_ERROR("invalid PRIORITY_UPDATE stream ID", H3_EV_RX_FRAME, h3c->qcc->conn);
+		return -1;
+	}
+
+	node = eb64_lookup(&h3c->qcc->streams_by_id, id);
+	if (node) {
+		qcs = eb64_entry(node, struct qcs, by_id);
+		value = get_trash_chunk();
+		b_getblk(&b, b_orig(value), len - ret, 0);
+		http_parse_priority(ist2(b_orig(value), len - ret), &qcs->prio);
+	}
+
+	TRACE_LEAVE(H3_EV_RX_FRAME, h3c->qcc->conn);
+	return len;
+}
+
+/* Parse a GOAWAY frame of length <len> from <buf> on <h3c> backend connection.
+ * No new request is opened on the connection once it has been received.
+ *
+ * Returns the frame length on success else a negative value.
+ */
+static ssize_t h3_parse_goaway_frm(struct h3c *h3c, const struct buffer *buf,
+                                   size_t len)
+{
+	struct buffer b;
+	uint64_t id;
+	size_t ret = 0;
+
+	TRACE_ENTER(H3_EV_RX_FRAME, h3c->qcc->conn);
+
+	/* Work on a copy of <buf>. */
+	b = b_make(b_orig(buf), b_size(buf), b_head_ofs(buf), len);
+
+	if (!b_quic_dec_int(&id, &b, &ret) || ret != len) {
+		h3c->err = H3_ERR_FRAME_ERROR;
+		qcc_report_glitch(h3c->qcc, 1);
+		TRACE_ERROR("invalid GOAWAY frame", H3_EV_RX_FRAME, h3c->qcc->conn);
+		return -1;
+	}
+
+	/* RFC 9114 5.2. Connection Shutdown
+	 *
+	 * A client receiving a GOAWAY frame with a stream ID of any other type
+	 * MUST treat this as a connection error of type H3_ID_ERROR.
+	 */
+	if (!quic_stream_is_bidi(id) || !quic_stream_is_local(h3c->qcc, id)) {
+		h3c->err = H3_ERR_ID_ERROR;
+		qcc_report_glitch(h3c->qcc, 1);
+		TRACE_ERROR("invalid GOAWAY stream ID", H3_EV_RX_FRAME, h3c->qcc->conn);
+		return -1;
+	}
+
+	/* Streams already opened are left to the server which resets those it
+	 * won't process. Only prevent the connection from being reused.
+	 */
+	h3c->qcc->flags |= QC_CF_CONN_SHUT;
+
+	TRACE_LEAVE(H3_EV_RX_FRAME, h3c->qcc->conn);
+	return len;
+}
+
 /* Transcode HTTP/3 payload received in buffer <b> to HTX data for stream
  * <qcs>. If <fin> is set, it indicates that no more data will arrive after.
  *
@@ -1394,29 +1917,57 @@ static ssize_t h3_rcv_buf(struct qcs *qcs, struct buffer *b, int fin)
 		if (last_stream_frame && h3s->flags & H3_SF_HAVE_CLEN && h3_check_body_size(qcs, last_stream_frame))
 			break;
 
-		h3_inc_frame_type_cnt(h3c->prx_counters, ftype);
+		/* frame already accounted if its decoding was blocked */
+		if (!(h3s->flags & H3_SF_QPACK_BLOCKED))
+			h3_inc_frame_type_cnt(h3c->prx_counters, ftype);
 		switch (ftype) {
 		case H3_FT_DATA:
 			ret = h3_data_to_htx(qcs, b, flen, last_stream_frame);
 			h3s->st_req = H3S_ST_REQ_DATA;
 			break;
 		case H3_FT_HEADERS:
-			if (h3s->st_req == H3S_ST_REQ_BEFORE) {
+			if (h3s->st_req == H3S_ST_REQ_BEFORE && conn_is_back(qcs->qcc->conn)) {
+				/* Stream state is only updated on final response. */
+				ret = h3_resp_headers_to_htx(qcs, b, flen, last_stream_frame);
+			}
+			else if (h3s->st_req == H3S_ST_REQ_BEFORE) {
 				ret = h3_headers_to_htx(qcs, b, flen, last_stream_frame);
-				h3s->st_req = H3S_ST_REQ_HEADERS;
+				if (!(h3s->flags & H3_SF_QPACK_BLOCKED))
+					h3s->st_req = H3S_ST_REQ_HEADERS;
 			}
 			else {
 				ret = h3_trailers_to_htx(qcs, b, flen, last_stream_frame);
-				h3s->st_req = H3S_ST_REQ_TRAILERS;
+				if (!(h3s->flags & H3_SF_QPACK_BLOCKED))
+					h3s->st_req = H3S_ST_REQ_TRAILERS;
 			}
 			break;
+		case H3_FT_GOAWAY:
+			if (conn_is_back(qcs->qcc->conn)) {
+				ret = h3_parse_goaway_frm(qcs->qcc->ctx, b, flen);
+				if (ret < 0) {
+					qcc_set_error(qcs->qcc, h3c->err, 1);
+					goto err;
+				}
+				break;
+			}
+			__fallthrough;
 		case H3_FT_CANCEL_PUSH:
 		case H3_FT_PUSH_PROMISE:
 		case H3_FT_MAX_PUSH_ID:
-		case H3_FT_GOAWAY:
 			/* Not supported */
 			ret = flen;
 			break;
+		case H3_FT_PRIORITY_UPDATE_REQ:
+			ret = h3_parse_priority_update_frm(qcs->qcc->ctx, b, flen);
+			if (ret < 0) {
+				qcc_set_error(qcs->qcc, h3c->err, 1);
+				goto err;
+			}
+			break;
+		case H3_FT_PRIORITY_UPDATE_PUSH:
+			/* Server push is not supported */
+			ret = flen;
+			break;
 		case H3_FT_SETTINGS:
 			ret = h3_parse_settings_frm(qcs->qcc->ctx, b, flen);
 			if (ret < 0) {
@@ -1425,6 +1976,7 @@ static ssize_t h3_rcv_buf(struct qcs *qcs, struct buffer *b, int fin)
 				goto err;
 			}
 			h3c->flags |= H3_CF_SETTINGS_RECV;
+			h3_qpack_enc_start(h3c);
 			break;
 		default:
 			/* draft-ietf-quic-http34 9. Extensions to HTTP/3
@@ -1442,6 +1994,14 @@ static ssize_t h3_rcv_buf(struct qcs *qcs, struct buffer *b, int fin)
 			b_del(b, ret);
 			total += ret;
 		}
+
+		/* Wait for QPACK encoder stream insertions, decoding will be
+		 * retried from the MUX I/O handler.
+		 */
+		if (h3s->flags & H3_SF_QPACK_BLOCKED) {
+			TRACE_STATE("pause parsing on QPACK blocked stream", H3_EV_RX_FRAME, qcs->qcc->conn, qcs);
+			break;
+		}
 	}
 
 	/* Reset demux frame type for traces. */
@@ -1476,6 +2036,100 @@ static ssize_t h3_rcv_buf(struct qcs *qcs, struct buffer *b, int fin)
 	return -1;
 }
 
+/* Fast-forward the payload of DATA frames from <b> buffer of <qcs> request
+ * stream directly into <out>, without HTX conversion. At most <count> bytes of
+ * payload are copied. The caller must ensure <out> has enough contiguous room.
+ * <fin> must be set if <b> contains the last data of the stream.
+ *
+ * Fast-forward is interrupted on any frame other than DATA or on the end of
+ * the stream. In this case QC_SF_RX_FASTFWD is removed from <qcs> so that the
+ * remaining data are demultiplexed via h3_rcv_buf().
+ *
+ * Returns the number of bytes consumed from <b>, frame headers included.
+ */
+static size_t h3_rcv_ff(struct qcs *qcs, struct buffer *b, struct buffer *out,
+                        size_t count, int fin)
+{
+	struct h3s *h3s = qcs->ctx;
+	struct h3c *h3c = h3s->h3c;
+	size_t total = 0, len;
+
+	TRACE_ENTER(H3_EV_RX_FRAME|H3_EV_RX_DATA, qcs->qcc->conn, qcs);
+
+	/* Only the payload following the request HEADERS can be forwarded. */
+	if (h3s->type != H3S_T_REQ ||
+	    (h3s->st_req != H3S_ST_REQ_HEADERS && h3s->st_req != H3S_ST_REQ_DATA) ||
+	    (h3s->demux_frame_len && h3s->demux_frame_type != H3_FT_DATA)) {
+		TRACE_STATE("cannot fast-forward on current frame", H3_EV_RX_FRAME|H3_EV_RX_DATA, qcs->qcc->conn, qcs);
+		goto stop;
+	}
+
+	while (b_data(b)) {
+		if (!h3s->demux_frame_len) {
+			struct buffer hdr = *b;
+			uint64_t ftype, flen;
+			size_t hlen;
+
+			/* Peek the next frame header and leave it in place if
+			 * it must be parsed by h3_rcv_buf().
+			 */
+			hlen = h3_decode_frm_header(&ftype, &flen, &hdr);
+			if (!hlen) {
+				TRACE_PROTO("pause on incomplete frame header", H3_EV_RX_FRAME|H3_EV_RX_DATA, qcs->qcc->conn, qcs);
+				break;
+			}
+
+			if (ftype != H3_FT_DATA) {
+				TRACE_STATE("stop fast-forward on non DATA frame", H3_EV_RX_FRAME|H3_EV_RX_DATA, qcs->qcc->conn, qcs);
+				goto stop;
+			}
+
+			*b = hdr;
+			total += hlen;
+			h3_inc_frame_type_cnt(h3c->prx_counters, ftype);
+			h3s->demux_frame_type = ftype;
+			h3s->demux_frame_len = flen;
+			h3s->st_req = H3S_ST_REQ_DATA;
+
+			h3s->data_len += flen;
+			if (h3s->flags & H3_SF_HAVE_CLEN && h3_check_body_size(qcs, 0))
+				goto err;
+		}
+
+		len = MIN(h3s->demux_frame_len, b_data(b));
+		if (len > count)
+			len = count;
+		if (!len && h3s->demux_frame_len)
+			break;
+
+		b_force_xfer(out, b, len);
+		h3s->demux_frame_len -= len;
+		count -= len;
+		total += len;
+
+		if (!h3s->demux_frame_len)
+			h3s->demux_frame_type = H3_FT_UNINIT;
+	}
+
+	/* End of stream is reported by h3_rcv_buf() as a HTX EOM. */
+	if (fin && !b_data(b)) {
+		if (h3s->flags & H3_SF_HAVE_CLEN && h3_check_body_size(qcs, 1))
+			goto err;
+		goto stop;
+	}
+
+	TRACE_LEAVE(H3_EV_RX_FRAME|H3_EV_RX_DATA, qcs->qcc->conn, qcs);
+	return total;
+
+ err:
+	qcc_abort_stream_read(qcs);
+	qcc_reset_stream(qcs, h3s->err);
+ stop:
+	qcs->flags &= ~QC_SF_RX_FASTFWD;
+	TRACE_LEAVE(H3_EV_RX_FRAME|H3_EV_RX_DATA, qcs->qcc->conn, qcs);
+	return total;
+}
+
 /* Function used to emit stream data from <qcs> control uni-stream.
  *
  * On success return the number of sent bytes. A negative code is used on
@@ -1551,16 +2205,27 @@ static int h3_control_send(struct qcs *qcs, void *ctx)
 	return -1;
 }
 
-static int h3_resp_headers_send(struct qcs *qcs, struct htx *htx)
+/* Convert the HTX start-line and headers from <htx> into a H3 HEADERS frame
+ * into <qcs> buffer. This is used both for responses on frontend streams and
+ * for requests on backend streams. Returns the size of HTX blocks removed, 0
+ * if the frame could not be emitted yet, or a negative error code.
+ */
+static int h3_headers_send(struct qcs *qcs, struct htx *htx)
 {
+	struct h3s *h3s = qcs->ctx;
+	struct h3c *h3c = h3s->h3c;
 	int err;
 	struct buffer outbuf;
 	struct buffer headers_buf = BUF_NULL;
+	struct buffer ins = BUF_NULL;
 	struct buffer *res;
+	unsigned char pfx[QPACK_ENC_MAX_PFX];
+	struct buffer pfx_buf;
 	struct http_hdr list[global.tune.max_http_hdr];
 	struct htx_sl *sl;
 	struct htx_blk *blk;
 	enum htx_blk_type type;
+	struct ist meth = IST_NULL, scheme = IST_NULL, auth = IST_NULL, path = IST_NULL;
 	int frame_length_size;  /* size in bytes of frame length varint field */
 	int smallbuf = 1;
 	int ret = 0;
@@ -1587,6 +2252,25 @@ static int h3_resp_headers_send(struct qcs *qcs, struct htx *htx)
 			/* TODO should be on h3 layer */
 			status = sl->info.res.status;
 		}
+		else if (type == HTX_BLK_REQ_SL) {
+			struct http_uri_parser parser;
+
+			/* start-line -> request pseudo-headers */
+			BUG_ON(sl);
+			sl = htx_get_blk_ptr(htx, blk);
+			meth = htx_sl_req_meth(sl);
+			path = htx_sl_req_uri(sl);
+			if (sl->info.req.meth == HTTP_METH_HEAD)
+				h3s->flags |= H3_SF_RESP_NO_BODY;
+
+			/* absolute-form URI : split it in pseudo-headers */
+			if (sl->flags & HTX_SL_F_HAS_SCHM) {
+				parser = http_uri_parser_init(path);
+				scheme = http_parse_scheme(&parser);
+				auth = http_parse_authority(&parser, 1);
+				path = http_parse_path(&parser);
+			}
+		}
 		else if (type == HTX_BLK_HDR) {
 			if (unlikely(hdr >= sizeof(list) / sizeof(list[0]) - 1)) {
 				TRACE_ERROR("too many headers", H3_EV_TX_FRAME|H3_EV_TX_HDR, qcs->qcc->conn, qcs);
@@ -1594,6 +2278,12 @@ static int h3_resp_headers_send(struct qcs *qcs, struct htx *htx)
 			}
 			list[hdr].n = htx_get_blk_name(htx, blk);
 			list[hdr].v = htx_get_blk_value(htx, blk);
+			if (isttest(meth) && isteq(list[hdr].n, ist("host"))) {
+				/* conveyed as :authority for requests */
+				if (!isttest(auth))
+					auth = list[hdr].v;
+				continue;
+			}
 			hdr++;
 		}
 		else {
@@ -1607,6 +2297,19 @@ static int h3_resp_headers_send(struct qcs *qcs, struct htx *htx)
 
 	list[hdr].n = ist("");
 
+	if (isttest(meth)) {
+		if (!isttest(scheme))
+			scheme = ist("https");
+		if (!istlen(path))
+			path = ist("/");
+	}
+
+	/* QPACK encoder stream instructions are written directly into its
+	 * buffer and emitted in all cases, even if the HEADERS frame is not.
+	 */
+	if (h3c->qpack_enc.dht)
+		h3_qpack_ins_prepare(h3c->qpack_enc_strm, &ins);
+
  retry:
 	res = smallbuf ? qcc_get_stream_txbuf(qcs, &err, 1) :
 	                 qcc_realloc_stream_txbuf(qcs);
@@ -1620,19 +2323,37 @@ static int h3_resp_headers_send(struct qcs *qcs, struct htx *htx)
 		goto end;
 	}
 
-	/* Buffer allocated just now : must be enough for frame type + length as a max varint size */
-	BUG_ON(b_room(res) < 5);
+	/* Buffer allocated just now : must be enough for frame type + length
+	 * as a max varint size and the field section prefix.
+	 */
+	BUG_ON(b_room(res) < 5 + QPACK_ENC_MAX_PFX);
 
 	b_reset(&outbuf);
 	outbuf = b_make(b_tail(res), b_contig_space(res), 0, 0);
-	/* Start the headers after frame type + length */
-	headers_buf = b_make(b_head(res) + 5, b_size(res) - 5, 0, 0);
+	/* Start the field lines after frame type + length and section prefix,
+	 * as the prefix depends on the dynamic table entries referenced.
+	 */
+	headers_buf = b_make(b_head(res) + 5 + QPACK_ENC_MAX_PFX,
+	                     b_size(res) - 5 - QPACK_ENC_MAX_PFX, 0, 0);
 
 	TRACE_DATA("encoding HEADERS frame", H3_EV_TX_FRAME|H3_EV_TX_HDR,
 	           qcs->qcc->conn, qcs);
-	if (qpack_encode_field_section_line(&headers_buf))
-		goto err_full;
-	if (qpack_encode_int_status(&headers_buf, status)) {
+	qpack_enc_fs_start(&h3c->qpack_enc);
+	if (isttest(meth)) {
+		/* RFC 9114 4.4. The CONNECT Method
+		 *
+		 * The :scheme and :path pseudo-header fields are omitted.
+		 */
+		if (qpack_encode_method(&headers_buf, sl->info.req.meth, meth) ||
+		    (sl->info.req.meth != HTTP_METH_CONNECT &&
+		     (qpack_encode_scheme(&headers_buf, scheme) ||
+		      qpack_encode_path(&headers_buf, path))) ||
+		    (isttest(auth) && qpack_encode_auth(&headers_buf, auth))) {
+			TRACE_ERROR("error during request pseudo-headers encoding", H3_EV_TX_FRAME|H3_EV_TX_HDR, qcs->qcc->conn, qcs);
+			goto err_full;
+		}
+	}
+	else if (qpack_encode_int_status(&headers_buf, status)) {
 		/* TODO handle invalid status code VS no buf space left */
 		TRACE_ERROR("error during status code encoding", H3_EV_TX_FRAME|H3_EV_TX_HDR, qcs->qcc->conn, qcs);
 		goto err_full;
@@ -1665,18 +2386,25 @@ static int h3_resp_headers_send(struct qcs *qcs, struct htx *htx)
 			list[hdr].v = ist("trailers");
 		}
 
-		if (qpack_encode_header(&headers_buf, list[hdr].n, list[hdr].v))
+		if (qpack_encode_header_dht(&h3c->qpack_enc, &ins, &headers_buf, list[hdr].n, list[hdr].v))
 			goto err_full;
 	}
 
+	/* Now insert the field section prefix just before the field lines. */
+	pfx_buf = b_make((char *)pfx, sizeof(pfx), 0, 0);
+	if (qpack_enc_fs_prefix(&h3c->qpack_enc, &pfx_buf))
+		goto err;
+	memcpy(b_orig(&headers_buf) - b_data(&pfx_buf), pfx, b_data(&pfx_buf));
+	qpack_enc_fs_commit(&h3c->qpack_enc, qcs->id);
+
 	/* Now that all headers are encoded, we are certain that res buffer is
 	 * big enough
 	 */
-	frame_length_size = quic_int_getsize(b_data(&headers_buf));
-	res->head += 4 - frame_length_size;
+	frame_length_size = quic_int_getsize(b_data(&pfx_buf) + b_data(&headers_buf));
+	res->head += 4 + QPACK_ENC_MAX_PFX - b_data(&pfx_buf) - frame_length_size;
 	b_putchr(res, 0x01); /* h3 HEADERS frame type */
-	b_quic_enc_int(res, b_data(&headers_buf), 0);
-	b_add(res, b_data(&headers_buf));
+	b_quic_enc_int(res, b_data(&pfx_buf) + b_data(&headers_buf), 0);
+	b_add(res, b_data(&pfx_buf) + b_data(&headers_buf));
 
 	ret = 0;
 	blk = htx_get_head_blk(htx);
@@ -1689,6 +2417,7 @@ static int h3_resp_headers_send(struct qcs *qcs, struct htx *htx)
 	}
 
  end:
+	h3_qpack_ins_send(h3c->qpack_enc_strm, &ins);
 	TRACE_LEAVE(H3_EV_TX_FRAME|H3_EV_TX_HDR, qcs->qcc->conn, qcs);
 	return ret;
 
@@ -1699,6 +2428,7 @@ static int h3_resp_headers_send(struct qcs *qcs, struct htx *htx)
 		goto retry;
 	}
  err:
+	h3_qpack_ins_send(h3c->qpack_enc_strm, &ins);
 	TRACE_DEVEL("leaving on error", H3_EV_TX_FRAME|H3_EV_TX_HDR, qcs->qcc->conn, qcs);
 	return -1;
 }
@@ -1814,7 +2544,7 @@ static int h3_resp_trailers_send(struct qcs *qcs, struct htx *htx)
 		if (isteq(list[hdr].n, ist("")))
 			break;
 
-		/* forbidden HTTP/3 headers, cf h3_resp_headers_send() */
+		/* forbidden HTTP/3 headers, cf h3_headers_send() */
 		if (isteq(list[hdr].n, ist("host")) ||
 		    isteq(list[hdr].n, ist("content-length")) ||
 		    isteq(list[hdr].n, ist("connection")) ||
@@ -2024,13 +2754,11 @@ static size_t h3_snd_buf(struct qcs *qcs, struct buffer *buf, size_t count)
 		btype = htx_get_blk_type(blk);
 		bsize = htx_get_blksz(blk);
 
-		/* Not implemented : QUIC on backend side */
-		BUG_ON(btype == HTX_BLK_REQ_SL);
-
 		switch (btype) {
+		case HTX_BLK_REQ_SL:
 		case HTX_BLK_RES_SL:
 			/* start-line -> HEADERS h3 frame */
-			ret = h3_resp_headers_send(qcs, htx);
+			ret = h3_headers_send(qcs, htx);
 			if (ret > 0) {
 				total += ret;
 				count -= ret;
@@ -2094,7 +2822,7 @@ static size_t h3_snd_buf(struct qcs *qcs, struct buffer *buf, size_t count)
 	 * and close the stream normally.
 	 */
 	if (unlikely((htx->flags & HTX_FL_EOM) && htx_is_empty(htx)) &&
-	             !qcs_is_close_remote(qcs)) {
+	             !qcs_is_close_remote(qcs) && !conn_is_back(qcs->qcc->conn)) {
 	        /* Generate a STOP_SENDING if full response transferred before
 	         * receiving the full request.
 	         */
@@ -2255,9 +2983,25 @@ static int h3_attach(struct qcs *qcs, void *conn_ctx)
 	h3s->err = 0;
 
 	if (quic_stream_is_bidi(qcs->id)) {
+		/* RFC 9114 6.1. Bidirectional Streams
+		 *
+		 * HTTP/3 does not use server-initiated bidirectional streams,
+		 * though an extension could define a use for these streams.
+		 * Clients MUST treat receipt of a server-initiated bidirectional
+		 * stream as a connection error of type H3_STREAM_CREATION_ERROR
+		 * unless such an extension has been negotiated.
+		 */
+		if (quic_stream_is_remote(qcs->qcc, qcs->id) && conn_is_back(qcs->qcc->conn)) {
+			TRACE_ERROR("server-initiated bidi stream", H3_EV_H3S_NEW, qcs->qcc->conn, qcs);
+			qcc_set_error(qcs->qcc, H3_ERR_STREAM_CREATION_ERROR, 1);
+			goto err;
+		}
+
 		h3s->type = H3S_T_REQ;
 		h3s->st_req = H3S_ST_REQ_BEFORE;
-		qcs_wait_http_req(qcs);
+		/* Only the frontend waits for a request on a new stream. */
+		if (!conn_is_back(qcs->qcc->conn))
+			qcs_wait_http_req(qcs);
 	}
 	else {
 		/* stream type must be decoded for unidirectional streams */
@@ -2294,9 +3038,28 @@ static int h3_attach(struct qcs *qcs, void *conn_ctx)
 static void h3_detach(struct qcs *qcs)
 {
 	struct h3s *h3s = qcs->ctx;
+	struct h3c *h3c = h3s->h3c;
+	struct buffer ins;
 
 	TRACE_ENTER(H3_EV_H3S_END, qcs->qcc->conn, qcs);
 
+	if (h3s->flags & H3_SF_QPACK_BLOCKED) {
+		/* RFC 9204 4.4.2. Stream Cancellation
+		 *
+		 * When a stream is reset or reading is abandoned, the decoder
+		 * emits a Stream Cancellation instruction.
+		 */
+		h3c->qpack_dec.blocked--;
+		h3_qpack_ins_prepare(h3c->qpack_dec_strm, &ins);
+		qpack_dec_cancel_stream(&h3c->qpack_dec, &ins, qcs->id);
+		h3_qpack_ins_send(h3c->qpack_dec_strm, &ins);
+	}
+
+	if (qcs == h3c->qpack_enc_strm)
+		h3c->qpack_enc_strm = NULL;
+	else if (qcs == h3c->qpack_dec_strm)
+		h3c->qpack_dec_strm = NULL;
+
 	pool_free(pool_head_h3s, h3s);
 	qcs->ctx = NULL;
 
@@ -2359,7 +3122,6 @@ static int h3_send_goaway(struct h3c *h3c)
 static int h3_init(struct qcc *qcc)
 {
 	struct h3c *h3c;
-	const struct listener *li = __objt_listener(qcc->conn->target);
 
 	TRACE_ENTER(H3_EV_H3C_NEW, qcc->conn);
 
@@ -2371,14 +3133,31 @@ static int h3_init(struct qcc *qcc)
 
 	h3c->qcc = qcc;
 	h3c->ctrl_strm = NULL;
+	h3c->qpack_enc_strm = NULL;
+	h3c->qpack_dec_strm = NULL;
 	h3c->err = 0;
 	h3c->flags = 0;
 	h3c->id_goaway = 0;
+	h3c->qpack_max_table_capacity = 0;
+	h3c->qpack_blocked_streams = 0;
+
+	qpack_enc_init(&h3c->qpack_enc);
+	qpack_dec_init(&h3c->qpack_dec, h3_settings_qpack_max_table_capacity,
+	               h3_settings_qpack_blocked_streams);
 
 	qcc->ctx = h3c;
-	h3c->prx_counters =
-		EXTRA_COUNTERS_GET(li->bind_conf->frontend->extra_counters_fe,
-		                   &h3_stats_module);
+	if (!conn_is_back(qcc->conn)) {
+		const struct listener *li = __objt_listener(qcc->conn->target);
+
+		h3c->prx_counters =
+			EXTRA_COUNTERS_GET(li->bind_conf->frontend->extra_counters_fe,
+			                   &h3_stats_module);
+	}
+	else {
+		h3c->prx_counters =
+			EXTRA_COUNTERS_GET(qcc->proxy->extra_counters_be,
+			                   &h3_stats_module);
+	}
 	LIST_INIT(&h3c->buf_wait.list);
 
 	TRACE_LEAVE(H3_EV_H3C_NEW, qcc->conn);
@@ -2418,6 +3197,18 @@ static int h3_finalize(void *ctx)
 		goto err;
 	}
 
+	/* The decoder stream is only needed if the peer may use our dynamic
+	 * table. The encoder stream is opened once the peer SETTINGS are known.
+	 */
+	if (h3_settings_qpack_max_table_capacity) {
+		h3c->qpack_dec_strm = h3_qpack_open_stream(h3c, H3_UNI_S_T_QPACK_DEC);
+		if (!h3c->qpack_dec_strm) {
+			TRACE_ERROR("cannot init QPACK decoder stream", H3_EV_H3C_NEW, qcc->conn);
+			qcc_set_error(qcc, H3_ERR_INTERNAL_ERROR, 1);
+			goto err;
+		}
+	}
+
 	TRACE_LEAVE(H3_EV_H3C_NEW, qcc->conn);
 	return 0;
 
@@ -2456,6 +3247,9 @@ static void h3_shutdown(void *ctx)
 static void h3_release(void *ctx)
 {
 	struct h3c *h3c = ctx;
+
+	qpack_enc_release(&h3c->qpack_enc);
+	qpack_dec_release(&h3c->qpack_dec);
 	pool_free(pool_head_h3c, h3c);
 }
 
@@ -2483,6 +3277,8 @@ static inline const char *h3_ft_str(uint64_t type)
 	case H3_FT_MAX_PUSH_ID:  return "MAX_PUSH_ID";
 	case H3_FT_CANCEL_PUSH:  return "CANCEL_PUSH";
 	case H3_FT_GOAWAY:       return "GOAWAY";
+	case H3_FT_PRIORITY_UPDATE_REQ:
+	case H3_FT_PRIORITY_UPDATE_PUSH: return "PRIORITY_UPDATE";
 	default:                 return "_UNKNOWN_";
 	}
 }
@@ -2523,6 +3319,7 @@ const struct qcc_app_ops h3_ops = {
 	.attach      = h3_attach,
 	.rcv_buf     = h3_rcv_buf,
 	.snd_buf     = h3_snd_buf,
+	.rcv_ff      = h3_rcv_ff,
 	.nego_ff     = h3_nego_ff,
 	.done_ff     = h3_done_ff,
 	.close       = h3_close,
@@ -2532,3 +3329,57 @@ const struct qcc_app_ops h3_ops = {
 	.report_susp = h3_report_susp,
 	.release     = h3_release,
 };
+
+/* config parser for global "tune.h3.qpack.{max-table-capacity,encoder-table-size}" */
+static int h3_parse_qpack_table_size(char **args, int section_type, struct proxy *curpx,
+                                     const struct proxy *defpx, const char *file, int line,
+                                     char **err)
+{
+	uint64_t *vptr;
+	int val;
+
+	if (too_many_args(1, args, err, NULL))
+		return -1;
+
+	/* decoder/encoder */
+	vptr = (args[0][14] == 'm') ? &h3_settings_qpack_max_table_capacity :
+	       &h3_qpack_encoder_table_size;
+
+	val = atoi(args[1]);
+	if (val < 0 || val > 65536) {
+		memprintf(err, "'%s' expects a numeric value between 0 and 65536.", args[0]);
+		return -1;
+	}
+	*vptr = val;
+	return 0;
+}
+
+/* config keyword parsers */
+static struct cfg_kw_list cfg_kws = {ILH, {
+	{ CFG_GLOBAL, "tune.h3.qpack.encoder-table-size", h3_parse_qpack_table_size },
+	{ CFG_GLOBAL, "tune.h3.qpack.max-table-capacity", h3_parse_qpack_table_size },
+	{ 0, NULL, NULL }
+}};
+
+INITCALL1(STG_REGISTER, cfg_register_keywords, &cfg_kws);
+
+/* initialize the QPACK dynamic tables pool after the config is parsed.
+ * Returns zero on success, non-zero on error.
+ */
+static int init_h3()
+{
+	const uint64_t size = MAX(h3_settings_qpack_max_table_capacity,
+	                          h3_qpack_encoder_table_size);
+
+	if (!size)
+		return ERR_NONE;
+
+	pool_head_qpack_tbl = create_pool("qpack_tbl", size, MEM_F_SHARED|MEM_F_EXACT);
+	if (!pool_head_qpack_tbl) {
+		ha_alert("failed to allocate qpack_tbl memory pool\n");
+		return (ERR_ALERT | ERR_FATAL);
+	}
+	return ERR_NONE;
+}
+
+REGISTER_POST_CHECK(init_h3);
@@ -186,6 +186,7 @@ struct global global = {
 		.pool_low_ratio  = 20,
 		.pool_high_ratio = 25,
 		.max_http_hdr = MAX_HTTP_HDR,
+		.http_priorities = 1,
 #ifdef USE_OPENSSL
 		.sslcachesize = SSLCACHESIZE,
 #endif
@@ -205,6 +206,7 @@ struct global global = {
 		.quic_reorder_ratio = QUIC_DFLT_REORDER_RATIO,
 		.quic_retry_threshold = QUIC_DFLT_RETRY_THRESHOLD,
 		.quic_max_frame_loss = QUIC_DFLT_MAX_FRAME_LOSS,
+		.quic_pacing_burst = QUIC_DFLT_PACING_BURST,
 #endif /* USE_QUIC */
 	},
 #ifdef USE_OPENSSL
@@ -32,6 +32,7 @@
 
 #include <import/ist.h>
 #include <haproxy/hpack-enc.h>
+#include <haproxy/hpack-tbl.h>
 #include <haproxy/http-hdr-t.h>
 
 /*
@@ -138,6 +139,34 @@ const signed short hpack_pos_len[32] = {
          /*   24: */   -1,  609,   -1,  636,   -1,   -1,   -1,   -1,
 };
 
+/* Looks up header field name <n> in the static table and returns the index of
+ * its first occurrence, or zero if it is not there.
+ */
+static inline int hpack_sht_name_idx(const struct ist n)
+{
+	int pos;
+
+	if (n.len >= sizeof(hpack_pos_len) / sizeof(hpack_pos_len[0]))
+		return 0;
+
+	pos = hpack_pos_len[n.len];
+	if (pos < 0)
+		return 0;
+
+	/* At least one header field of this length exist */
+	do {
+		char idx;
+
+		pos++;
+		idx = hpack_enc_stream[pos++];
+		pos += n.len;
+		if (isteq(ist2(&hpack_enc_stream[pos - n.len], n.len), n))
+			return idx;
+	} while ((unsigned char)hpack_enc_stream[pos] == n.len);
+
+	return 0;
+}
+
 /* Tries to encode header whose name is <n> and value <v> into the chunk <out>.
  * Returns non-zero on success, 0 on failure (buffer full).
  */
@@ -146,35 +175,21 @@ int hpack_encode_header(struct buffer *out, const struct ist n,
 {
 	int len = out->data;
 	int size = out->size;
-	int pos;
+	int idx;
 
 	if (len >= size)
 		return 0;
 
 	/* look for the header field <n> in the static table */
-	if (n.len >= sizeof(hpack_pos_len) / sizeof(hpack_pos_len[0]))
-		goto make_literal;
-
-	pos = hpack_pos_len[n.len];
-	if (pos >= 0) {
-		/* At least one header field of this length exist */
-		do {
-			char idx;
-
-			pos++;
-			idx = hpack_enc_stream[pos++];
-			pos += n.len;
-			if (isteq(ist2(&hpack_enc_stream[pos - n.len], n.len), n)) {
-				/* emit literal with indexing (7541#6.2.1) :
-				 * [ 0 | 1 | Index (6+) ]
-				 */
-				out->area[len++] = idx | 0x40;
-				goto emit_value;
-			}
-		} while ((unsigned char)hpack_enc_stream[pos] == n.len);
+	idx = hpack_sht_name_idx(n);
+	if (idx) {
+		/* emit literal with indexing (7541#6.2.1) :
+		 * [ 0 | 1 | Index (6+) ]
+		 */
+		out->area[len++] = idx | 0x40;
+		goto emit_value;
 	}
 
- make_literal:
 	if (likely(n.len < 127 && len + 2 + n.len <= size)) {
 		out->area[len++] = 0x00;      /* literal without indexing -- new name */
 		out->area[len++] = n.len;     /* single-byte length encoding */
@@ -208,3 +223,157 @@ int hpack_encode_header(struct buffer *out, const struct ist n,
 	out->data = len;
 	return 1;
 }
+
+/* Returns the representation the dynamic table encoder must use for header
+ * field <n>:<v> when the table's size is <size> bytes. Credentials must never
+ * be indexed, not even by intermediaries, and the same goes for short cookies
+ * which are easy to guess by observing the compression ratio (RFC7541#7.1.3).
+ * Fields whose values are expected to change with each message are not
+ * indexed either, as they would only evict useful entries.
+ */
+static inline int hpack_enc_policy(const struct ist n, const struct ist v, uint32_t size)
+{
+	if (isteq(n, ist("authorization")) ||
+	    isteq(n, ist("proxy-authorization")) ||
+	    (v.len < 20 && (isteq(n, ist("cookie")) || isteq(n, ist("set-cookie")))))
+		return 0x10; /* never indexed */
+
+	if (n.len + v.len + 32 > size / 4 ||
+	    (isteq(n, ist(":path")) && istchr(v, '?')) ||
+	    isteq(n, ist("content-length")) ||
+	    isteq(n, ist("content-range")) ||
+	    isteq(n, ist("etag")) ||
+	    isteq(n, ist("last-modified")) ||
+	    isteq(n, ist("if-modified-since")) ||
+	    isteq(n, ist("if-none-match")) ||
+	    isteq(n, ist("location")) ||
+	    isteq(n, ist("set-cookie")) ||
+	    isteq(n, ist("age")))
+		return 0x00; /* not indexed */
+
+	return 0x40; /* incremental indexing */
+}
+
+/* Tries to encode header whose name is <n> and value <v> into the chunk <out>,
+ * using the encoder's dynamic headers table <dht> which must exactly reflect
+ * what the peer's decoder knows. Fields already present in the static or the
+ * dynamic table are sent as a single index, and other ones may be inserted
+ * into both tables depending on the indexing policy. Returns non-zero on
+ * success, 0 on failure (buffer full). Note that on failure the table may
+ * already have been updated, so the caller must be able to roll it back.
+ */
+int hpack_encode_header_dht(struct hpack_dht *dht, struct buffer *out,
+                            const struct ist n, const struct ist v)
+{
+	const struct hpack_dte *dte;
+	int len = out->data;
+	int size = out->size;
+	uint32_t nidx;
+	uint32_t idx;
+	int rep;
+
+	/* static table: the fields with a value are grouped by name */
+	nidx = hpack_sht_name_idx(n);
+	for (idx = nidx; idx && idx < HPACK_SHT_SIZE && isteq(hpack_sht[idx].n, n); idx++) {
+		if (isteq(hpack_sht[idx].v, v))
+			goto emit_index;
+	}
+
+	/* dynamic table, from the most recent entry */
+	for (idx = 1; idx <= dht->used; idx++) {
+		dte = hpack_get_dte(dht, idx);
+		if (!dte)
+			break;
+
+		if (!isteq(hpack_get_name(dht, dte), n))
+			continue;
+
+		if (isteq(hpack_get_value(dht, dte), v)) {
+			idx += HPACK_SHT_SIZE - 1;
+			goto emit_index;
+		}
+
+		if (!nidx)
+			nidx = idx + HPACK_SHT_SIZE - 1;
+	}
+
+	rep = hpack_enc_policy(n, v, dht->size);
+
+	/* The name index must designate the entry as it was before the
+	 * insertion. If the insertion fails, the entry is just not indexed.
+	 * The oldest entries might have been evicted then, which is harmless
+	 * since the peer will evict them later when it needs to.
+	 */
+	if (rep == 0x40 &&
+	    (!hpack_dht_make_room(dht, n.len + v.len) || hpack_dht_insert(dht, n, v) < 0))
+		rep = 0x00;
+
+	/* literal with incremental indexing (7541#6.2.1) :
+	 *   [ 0 | 1 | Index (6+) ]
+	 * literal without indexing (7541#6.2.2) :
+	 *   [ 0 | 0 | 0 | 0 | Index (4+) ]
+	 * literal never indexed (7541#6.2.3) :
+	 *   [ 0 | 0 | 0 | 1 | Index (4+) ]
+	 */
+	len = hpack_encode_int(out->area, len, size, rep, (rep == 0x40) ? 6 : 4, nidx);
+	if (!len)
+		return 0;
+
+	if (!nidx) {
+		/* new name */
+		if (!hpack_len_to_bytes(n.len) ||
+		    len + hpack_len_to_bytes(n.len) + n.len > size)
+			return 0;
+
+		len = hpack_encode_len(out->area, len, n.len);
+		ist2bin(out->area + len, n);
+		len += n.len;
+	}
+
+	if (!hpack_len_to_bytes(v.len) ||
+	    len + hpack_len_to_bytes(v.len) + v.len > size)
+		return 0;
+
+	len = hpack_encode_len(out->area, len, v.len);
+	memcpy(out->area + len, v.ptr, v.len);
+	len += v.len;
+
+	out->data = len;
+	return 1;
+
+ emit_index:
+	/* indexed header field (7541#6.1) :
+	 *   [ 1 | Index (7+) ]
+	 */
+	len = hpack_encode_int(out->area, len, size, 0x80, 7, idx);
+	if (!len)
+		return 0;
+
+	out->data = len;
+	return 1;
+}
+
+/* Flushes the encoder's dynamic headers table <dht> and resizes it to <size>
+ * bytes after the peer changed its SETTINGS_HEADER_TABLE_SIZE, and emits the
+ * matching dynamic table size updates into <out> (RFC7541#4.2): first a zero
+ * size to flush the peer's table, then the new size unless it is zero. These
+ * must start the next header block. Returns non-zero on success, 0 on failure
+ * (buffer full), in which case the table is left untouched.
+ */
+int hpack_encode_dtsu(struct hpack_dht *dht, struct buffer *out, uint32_t size)
+{
+	int len;
+
+	/* dynamic table size update (7541#6.3) :
+	 *   [ 0 | 0 | 1 | Max size (5+) ]
+	 */
+	len = hpack_encode_int(out->area, out->data, out->size, 0x20, 5, 0);
+	if (len && size)
+		len = hpack_encode_int(out->area, len, out->size, 0x20, 5, size);
+	if (!len)
+		return 0;
+
+	out->data = len;
+	hpack_dht_init(dht, size);
+	return 1;
+}
@@ -1474,6 +1474,72 @@ struct ist http_trim_trailing_spht(struct ist value)
 	return ret;
 }
 
+/* Returns a pointer to the character following the RFC 8941 string starting
+ * at <p>, which points to its opening double quote, or <end> if the string is
+ * not terminated. Escaped characters are skipped.
+ */
+static const char *http_skip_sf_string(const char *p, const char *end)
+{
+	for (p++; p < end; p++) {
+		if (*p == '"')
+			return p + 1;
+		if (*p == '\\' && ++p == end)
+			break;
+	}
+	return end;
+}
+
+/* Parses <value>, the value of a "priority" header field or of a
+ * PRIORITY_UPDATE frame, which is an RFC 8941 dictionary, and updates <prio>
+ * with the urgency ("u") and incremental ("i") parameters it contains. As
+ * mandated by RFC 9218, unknown members, parameters and invalid values are
+ * ignored, leaving the corresponding priority parameter unchanged. Strings
+ * are skipped as a whole so that the commas they may contain do not start a
+ * new member.
+ */
+void http_parse_priority(const struct ist value, struct http_prio *prio)
+{
+	const char *p = istptr(value);
+	const char *end = istend(value);
+	const char *key, *val;
+	size_t klen, vlen;
+
+	while (p < end) {
+		while (p < end && (HTTP_IS_SPHT(*p) || *p == ','))
+			p++;
+
+		key = p;
+		while (p < end && *p != '=' && *p != ';' && *p != ',' && !HTTP_IS_SPHT(*p))
+			p++;
+		klen = p - key;
+
+		val = NULL;
+		vlen = 0;
+		if (p < end && *p == '=') {
+			val = ++p;
+			while (p < end && *p != ';' && *p != ',' && !HTTP_IS_SPHT(*p))
+				p = (*p == '"') ? http_skip_sf_string(p, end) : p + 1;
+			vlen = p - val;
+		}
+
+		/* skip parameters */
+		while (p < end && *p != ',')
+			p = (*p == '"') ? http_skip_sf_string(p, end) : p + 1;
+
+		if (klen == 1 && *key == 'u') {
+			if (vlen == 1 && *val >= '0' && *val <= '0' + HTTP_PRIO_URG_MAX)
+				prio->urg = *val - '0';
+		}
+		else if (klen == 1 && *key == 'i') {
+			/* a bare key is a boolean true */
+			if (!val)
+				prio->inc = 1;
+			else if (vlen == 2 && val[0] == '?' && (val[1] == '0' || val[1] == '1'))
+				prio->inc = val[1] - '0';
+		}
+	}
+}
+
 /* initialize the required structures and arrays */
 static void _http_init()
 {
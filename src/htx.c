@@ -28,21 +28,25 @@ static inline __attribute__((always_inline)) void htx_memcpy(void *dst, void *sr
 }
 
 /* Defragments an HTX message. It removes unused blocks and unwraps the payloads
- * part. A temporary buffer is used to do so. This function never fails. Most of
- * time, we need keep a ref on a specific HTX block. Thus is <blk> is set, the
- * pointer on its new position, after defrag, is returned. In addition, if the
- * size of the block must be altered, <blkinfo> info must be provided (!=
- * 0). But in this case, it remains the caller responsibility to update the
- * block content.
+ * part. This function never fails. Most of time, we need keep a ref on a
+ * specific HTX block. Thus is <blk> is set, the pointer on its new position,
+ * after defrag, is returned. In addition, if the size of the block must be
+ * altered, <blkinfo> info must be provided (!= 0). But in this case, it remains
+ * the caller responsibility to update the block content.
+ *
+ * When payloads are stored in the same order as their blocks, which is the case
+ * unless the free space wrapped, they are packed in place. Otherwise, they are
+ * first copied into a temporary buffer. In both cases, only the used parts of
+ * the message are copied.
  */
 /* TODO: merge data blocks into one */
 struct htx_blk *htx_defrag(struct htx *htx, struct htx_blk *blk, uint32_t blkinfo)
 {
-	struct buffer *chunk = get_trash_chunk();
-	struct htx *tmp = htxbuf(chunk);
+	struct buffer *chunk;
+	struct htx *tmp;
 	struct htx_blk *newblk, *oldblk;
 	uint32_t new, old, blkpos;
-	uint32_t addr, blksz;
+	uint32_t addr, blksz, info;
 	int32_t first = -1;
 
 	if (htx->head == -1)
@@ -52,8 +56,59 @@ struct htx_blk *htx_defrag(struct htx *htx, struct htx_blk *blk, uint32_t blkinf
 
 	new  = 0;
 	addr = 0;
+
+	/* A block may only be resized when using a temporary buffer, because
+	 * growing it in place could overwrite the next payloads.
+	 */
+	if (blkinfo)
+		goto copy;
+
+	for (old = htx_get_head(htx); old != -1; old = htx_get_next(htx, old)) {
+		oldblk = htx_get_blk(htx, old);
+		if (htx_get_blk_type(oldblk) == HTX_BLK_UNUSED)
+			continue;
+		if (oldblk->addr < addr)
+			goto copy;
+		addr = oldblk->addr + htx_get_blksz(oldblk);
+	}
+
+	/* Payloads are ordered, each one may be moved backwards. Blocks are
+	 * moved backwards too, and never to a position not visited yet.
+	 */
+	addr = 0;
+	for (old = htx_get_head(htx); old != -1; old = htx_get_next(htx, old)) {
+		oldblk = htx_get_blk(htx, old);
+		if (htx_get_blk_type(oldblk) == HTX_BLK_UNUSED)
+			continue;
+
+		blksz = htx_get_blksz(oldblk);
+		if (oldblk->addr != addr)
+			memmove((void *)htx->blocks + addr, htx_get_blk_ptr(htx, oldblk), blksz);
+
+		/* update the start-line position */
+		if (htx->first == old)
+			first = new;
+
+		/* if <blk> is defined, save its new position */
+		if (blk != NULL && blk == oldblk)
+			blkpos = new;
+
+		info = oldblk->info;
+		newblk = htx_get_blk(htx, new);
+		newblk->addr = addr;
+		newblk->info = info;
+
+		addr += blksz;
+		new++;
+	}
+	goto end;
+
+  copy:
+	chunk = get_trash_chunk();
+	tmp = htxbuf(chunk);
 	tmp->size = htx->size;
 	tmp->data = 0;
+	addr = 0;
 
 	/* start from the head */
 	for (old = htx_get_head(htx); old != -1; old = htx_get_next(htx, old)) {
@@ -81,18 +136,21 @@ struct htx_blk *htx_defrag(struct htx *htx, struct htx_blk *blk, uint32_t blkinf
 
 		blksz = htx_get_blksz(newblk);
 		addr += blksz;
-		tmp->data += blksz;
 		new++;
 	}
 
-	htx->data = tmp->data;
+	/* only copy back the payloads and the blocks in use */
+	memcpy((void *)htx->blocks, (void *)tmp->blocks, addr);
+	memcpy((void *)htx_get_blk(htx, new - 1), (void *)htx_get_blk(tmp, new - 1), new * sizeof(*newblk));
+
+  end:
+	htx->data = addr;
 	htx->first = first;
 	htx->head = 0;
 	htx->tail = new - 1;
 	htx->head_addr = htx->end_addr = 0;
 	htx->tail_addr = addr;
 	htx->flags &= ~HTX_FL_FRAGMENTED;
-	htx_memcpy((void *)htx->blocks, (void *)tmp->blocks, htx->size);
 
 	return ((blkpos == -1) ? NULL : htx_get_blk(htx, blkpos));
 }
@@ -22,6 +22,7 @@
 #include <haproxy/cfgparse.h>
 #include <haproxy/cli-t.h>
 #include <haproxy/connection.h>
+#include <haproxy/cpuset.h>
 #include <haproxy/errors.h>
 #include <haproxy/fd.h>
 #include <haproxy/freq_ctr.h>
@@ -60,6 +61,12 @@ const char* li_status_st[LI_STATE_COUNT] = {
 	[LI_STATUS_FULL]    = "FULL",
 };
 
+/* number of connections listener_accept() may push to accept queues before
+ * waking up their threads ("tune.listener.accept-batch"). 0 wakes the target
+ * thread up for each connection.
+ */
+static uint accept_batch = 0;
+
 #if defined(USE_THREAD)
 
 struct accept_queue_ring accept_queue_rings[MAX_THREADS] __attribute__((aligned(64))) = { };
@@ -157,6 +164,7 @@ struct task *accept_queue_process(struct task *t, void *context, unsigned int st
 
 		li = __objt_listener(conn->target);
 		_HA_ATOMIC_INC(&li->thr_conn[ti->ltid]);
+		update_freq_ctr(&activity[tid].acc_rate, 1);
 		ret = li->bind_conf->accept(conn);
 		if (ret <= 0) {
 			/* connection was terminated by the application */
@@ -184,6 +192,17 @@ struct task *accept_queue_process(struct task *t, void *context, unsigned int st
 	return NULL;
 }
 
+/* Wakes up the accept queue tasklets of the <nb> threads whose numbers are
+ * listed in <thr>, after connections were pushed into their rings by a batch.
+ */
+static void accept_queue_wakeup_batch(const uint *thr, uint nb)
+{
+	while (nb--) {
+		_HA_ATOMIC_INC(&activity[thr[nb]].accq_wakeup);
+		tasklet_wakeup(accept_queue_rings[thr[nb]].tasklet);
+	}
+}
+
 /* Initializes the accept-queues. Returns 0 on success, otherwise ERR_* flags */
 static int accept_queue_init()
 {
@@ -1013,6 +1032,41 @@ static inline int listener_uses_maxconn(const struct listener *l)
 	return !(l->bind_conf->options & (BC_O_UNLIMITED|BC_O_XPRT_MAXCONN));
 }
 
+#if defined(USE_THREAD) && defined(USE_CPU_AFFINITY) && defined(SO_INCOMING_CPU)
+/* Returns the global thread number which is the only one of listener <l>'s
+ * shard bound by cpu-map to the CPU that processed connection <conn> in the
+ * kernel, or -1 if this CPU is unknown or not exclusively assigned to one of
+ * the listener's enabled threads. When the thread belongs to another receiver
+ * of the shard, <new_li> is set to its listener, otherwise it is left intact.
+ */
+static int listener_incoming_cpu_thread(struct listener *l, struct connection *conn,
+                                        struct listener **new_li)
+{
+	socklen_t len = sizeof(int);
+	int cpu, r, nbr, thr;
+
+	if (l->rx.proto->proto_type != PROTO_TYPE_STREAM || conn->handle.fd < 0)
+		return -1;
+
+	if (getsockopt(conn->handle.fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) == -1 || cpu < 0)
+		return -1;
+
+	nbr = l->rx.shard_info ? l->rx.shard_info->nbgroups : 1;
+	for (r = 0; r < nbr; r++) {
+		struct receiver *rx = l->rx.shard_info ? l->rx.shard_info->members[r] : &l->rx;
+		const struct tgroup_info *g = &ha_tgroup_info[rx->bind_tgroup - 1];
+
+		thr = cpu_map_cpu_thread(rx->bind_tgroup, rx->bind_thread & _HA_ATOMIC_LOAD(&g->threads_enabled), cpu);
+		if (thr < 0)
+			continue;
+		if (rx != &l->rx)
+			*new_li = rx->owner;
+		return g->base + thr;
+	}
+	return -1;
+}
+#endif
+
 /* This function is called on a read event from a listening socket, corresponding
  * to an accept. It tries to accept as many connections as possible, and for each
  * calls the listener's accept handler (generally the frontend's accept handler).
@@ -1028,6 +1082,10 @@ void listener_accept(struct listener *l)
 	int next_actconn = 0;
 	int expire;
 	int ret;
+#if defined(USE_THREAD)
+	uint wake_thr[ACCEPT_BATCH_MAX];
+	uint nb_wake = 0, nb_batched = 0;
+#endif
 
 	p = l->bind_conf->frontend;
 	bind_tid_commit = l->rx.proto ? l->rx.proto->bind_tid_commit : NULL;
@@ -1258,6 +1316,24 @@ void listener_accept(struct listener *l)
 			 *   - m is the receiver's thread mask shifted by the thread number
 			 */
 
+			new_li = NULL;
+#if defined(USE_CPU_AFFINITY) && defined(SO_INCOMING_CPU)
+			/* With "incoming-cpu", the connection goes to the thread
+			 * running on the CPU which already processed it in the
+			 * kernel, so that it remains hot in its caches. Only
+			 * unmapped CPUs fall back to the load-based choice below.
+			 */
+			if (l->bind_conf->options & BC_O_INCOMING_CPU) {
+				int cpu_thr = listener_incoming_cpu_thread(l, cli_conn, &new_li);
+
+				if (cpu_thr >= 0) {
+					t = cpu_thr;
+					_HA_ATOMIC_INC(&activity[t].accq_cpu);
+					goto thread_found;
+				}
+			}
+#endif
+
 			/* keep a copy for the final update. thr_idx is composite
 			 * and made of (n2<<16) + n1.
 			 */
@@ -1459,6 +1535,9 @@ void listener_accept(struct listener *l)
 				__ha_cpu_relax();
 			} /* end of main while() loop */
 
+#if defined(USE_CPU_AFFINITY) && defined(SO_INCOMING_CPU)
+		thread_found:
+#endif
 			/* we may need to update the listener in the connection
 			 * if we switched to another group.
 			 */
@@ -1484,9 +1563,29 @@ void listener_accept(struct listener *l)
 			 */
 			ring = &accept_queue_rings[t];
 			if (accept_queue_push_mp(ring, cli_conn, bind_tid_commit)) {
+				uint i;
+
 				_HA_ATOMIC_INC(&activity[t].accq_pushed);
-				tasklet_wakeup(ring->tasklet);
+				if (!accept_batch) {
+					_HA_ATOMIC_INC(&activity[t].accq_wakeup);
+					tasklet_wakeup(ring->tasklet);
+					continue;
+				}
 
+				/* batched mode: only note the target thread, all
+				 * of them will be woken up at once when the batch
+				 * is full or when leaving. This saves many costly
+				 * cross-thread wakeups during connection storms.
+				 */
+				for (i = 0; i < nb_wake && wake_thr[i] != t; i++)
+					;
+				if (i == nb_wake)
+					wake_thr[nb_wake++] = t;
+
+				if (++nb_batched >= accept_batch) {
+					accept_queue_wakeup_batch(wake_thr, nb_wake);
+					nb_wake = nb_batched = 0;
+				}
 				continue;
 			}
 			/* If the ring is full we do a synchronous accept on
@@ -1503,6 +1602,7 @@ void listener_accept(struct listener *l)
 		/* restore the connection's listener in case we failed to migrate above */
 		cli_conn->target = &l->obj_type;
 		_HA_ATOMIC_INC(&l->thr_conn[ti->ltid]);
+		update_freq_ctr(&activity[tid].acc_rate, 1);
 		ret = l->bind_conf->accept(cli_conn);
 		if (unlikely(ret <= 0)) {
 			/* The connection was closed by stream_accept(). Either
@@ -1536,6 +1636,11 @@ void listener_accept(struct listener *l)
 	} /* end of for (max_accept--) */
 
  end:
+#if defined(USE_THREAD)
+	/* wake up the threads of the last incomplete batch */
+	if (nb_wake)
+		accept_queue_wakeup_batch(wake_thr, nb_wake);
+#endif
 	if (next_conn)
 		_HA_ATOMIC_DEC(&l->nbconn);
 
@@ -2541,6 +2646,26 @@ static int cfg_parse_tune_listener_mq(char **args, int section_type, struct prox
 	return 0;
 }
 
+/* config parser for global "tune.listener.accept-batch" */
+static int cfg_parse_tune_listener_accept_batch(char **args, int section_type, struct proxy *curpx,
+                                                const struct proxy *defpx, const char *file, int line,
+                                                char **err)
+{
+	char *stop;
+	ulong batch;
+
+	if (too_many_args(1, args, err, NULL))
+		return -1;
+
+	batch = strtoul(args[1], &stop, 10);
+	if (!*args[1] || *stop || batch > ACCEPT_BATCH_MAX) {
+		memprintf(err, "'%s' expects an integer value between 0 and %d.", args[0], ACCEPT_BATCH_MAX);
+		return -1;
+	}
+	accept_batch = batch;
+	return 0;
+}
+
 /* Note: must not be declared <const> as its list will be overwritten.
  * Please take care of keeping this list alphabetically sorted.
  */
@@ -2590,6 +2715,7 @@ INITCALL1(STG_REGISTER, bind_register_keywords, &bind_kws);
 
 /* config keyword parsers */
 static struct cfg_kw_list cfg_kws = {ILH, {
+	{ CFG_GLOBAL, "tune.listener.accept-batch",     cfg_parse_tune_listener_accept_batch },
 	{ CFG_GLOBAL, "tune.listener.default-shards",   cfg_parse_tune_listener_shards  },
 	{ CFG_GLOBAL, "tune.listener.multi-queue",      cfg_parse_tune_listener_mq      },
 	{ 0, NULL, NULL }
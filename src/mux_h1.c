@@ -3866,7 +3866,17 @@ static int h1_send(struct h1c *h1c)
 	if (h1c->flags & H1C_F_CO_STREAMER)
 		flags |= CO_SFL_STREAMER;
 
-	ret = conn->xprt->snd_buf(conn, conn->xprt_ctx, &h1c->obuf, b_data(&h1c->obuf), flags);
+	if (conn->xprt->snd_buf_zc) {
+		/* the transport layer may avoid copying large buffers, in
+		 * which case it consumes the data itself.
+		 */
+		ret = conn->xprt->snd_buf_zc(conn, conn->xprt_ctx, &h1c->obuf, b_data(&h1c->obuf), flags);
+	}
+	else {
+		ret = conn->xprt->snd_buf(conn, conn->xprt_ctx, &h1c->obuf, b_data(&h1c->obuf), flags);
+		b_del(&h1c->obuf, ret);
+	}
+
 	if (ret > 0) {
 		TRACE_DATA("data sent", H1_EV_H1C_SEND, h1c->conn, 0, 0, (size_t[]){ret});
 		if (h1c->flags & H1C_F_OUT_FULL) {
@@ -3874,7 +3884,6 @@ static int h1_send(struct h1c *h1c)
 			TRACE_STATE("h1c obuf not full anymore", H1_EV_STRM_SEND|H1_EV_H1S_BLK, h1c->conn);
 		}
 		HA_ATOMIC_ADD(&h1c->px_counters->bytes_out, ret);
-		b_del(&h1c->obuf, ret);
 		sent = 1;
 	}
 
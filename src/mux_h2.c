@@ -20,6 +20,7 @@
 #include <haproxy/hpack-dec.h>
 #include <haproxy/hpack-enc.h>
 #include <haproxy/hpack-tbl.h>
+#include <haproxy/http.h>
 #include <haproxy/http_htx.h>
 #include <haproxy/htx.h>
 #include <haproxy/istbuf.h>
@@ -56,6 +57,8 @@ struct h2c {
 	int32_t max_id; /* highest ID known on this connection, <0 before preface */
 	uint32_t rcvd_c; /* newly received data to ACK for the connection */
 	uint32_t rcvd_s; /* newly received data to ACK for the current stream (dsi) or zero */
+	uint32_t rtt;    /* round trip time measured by the last PING (ms), 0=unknown */
+	uint32_t ping_date; /* date the last RTT measurement PING was sent (ms) */
 
 	/* states for the demux direction */
 	struct hpack_dht *ddht; /* demux dynamic header table */
@@ -71,9 +74,11 @@ struct h2c {
 
 	/* states for the mux direction */
 	struct buffer mbuf[H2C_MBUF_CNT];   /* mux buffers (ring) */
+	struct hpack_dht *edht; /* mux encoder dynamic header table, NULL if unused */
 	int32_t miw; /* mux initial window size for all new streams */
 	int32_t mws; /* mux window size. Can be negative. */
 	int32_t mfs; /* mux's max frame size */
+	uint32_t shts; /* peer's SETTINGS_HEADER_TABLE_SIZE */
 
 	int timeout;        /* idle timeout duration in ticks */
 	int shut_timeout;   /* idle timeout duration in ticks after GOAWAY was sent */
@@ -108,6 +113,10 @@ struct h2s {
 	int32_t id; /* stream ID */
 	uint32_t flags;      /* H2_SF_* */
 	int sws;             /* stream window size, to be added to the mux's initial window size */
+	uint32_t rws;        /* receive window size target, may be grown above the initial one by autotuning */
+	uint32_t rwe;        /* receive window already granted above the initial window size */
+	uint32_t at_rcvd;    /* data received during the current autotuning epoch */
+	uint32_t at_date;    /* start date of the current autotuning epoch (ms) */
 	enum h2_err errcode; /* H2 err code (H2_ERR_*) */
 	enum h2_ss st;
 	uint16_t status;     /* HTTP response status */
@@ -115,6 +124,7 @@ struct h2s {
 	struct buffer rxbuf; /* receive buffer, always valid (buf_empty or real buffer) */
 	struct wait_event *subs;  /* recv wait_event the stream connector associated is waiting on (via h2_subscribe) */
 	struct list list; /* To be used when adding in h2c->send_list or h2c->fctl_lsit */
+	struct http_prio prio; /* RFC9218 priority, used to order the send lists */
 	struct tasklet *shut_tl;  /* deferred shutdown tasklet, to retry to send an RST after we failed to,
 				   * in case there's no other subscription to do it */
 
@@ -448,6 +458,12 @@ DECLARE_STATIC_POOL(pool_head_h2s, "h2s", sizeof(struct h2s));
  */
 #define H2_INITIAL_WINDOW_INCREMENT ((1U<<31)-1 - 65535)
 
+/* opaque payload of the PINGs used to measure the round trip time */
+static const char h2_rtt_ping[8] = "HAPXRTT";
+
+/* interval between two RTT measurements for receive window autotuning (ms) */
+#define H2_RTT_PING_INTERVAL 10000
+
 /* maximum amount of data we're OK with re-aligning for buffer optimizations */
 #define MAX_DATA_REALIGN 1024
 
@@ -456,6 +472,12 @@ static int h2_settings_header_table_size      =  4096; /* initial value */
 static int h2_settings_initial_window_size    = 65536; /* default initial value */
 static int h2_be_settings_initial_window_size =     0; /* backend's default initial value */
 static int h2_fe_settings_initial_window_size =     0; /* frontend's default initial value */
+static int h2_settings_max_window_size        =     0; /* default max autotuned window, 0=disabled */
+static int h2_be_settings_max_window_size     =     0; /* backend's default max autotuned window */
+static int h2_fe_settings_max_window_size     =     0; /* frontend's default max autotuned window */
+static int h2_settings_encoder_table_size     =     0; /* default HPACK encoder table size, 0=disabled */
+static int h2_be_settings_encoder_table_size  =     0; /* backend's HPACK encoder table size */
+static int h2_fe_settings_encoder_table_size  =     0; /* frontend's HPACK encoder table size */
 static int h2_be_glitches_threshold           =     0; /* backend's max glitches: unlimited */
 static int h2_fe_glitches_threshold           =     0; /* frontend's max glitches: unlimited */
 static unsigned int h2_settings_max_concurrent_streams    = 100; /* default value */
@@ -681,6 +703,59 @@ static inline int h2c_max_concurrent_streams(const struct h2c *h2c)
 	return ret;
 }
 
+/* returns the initial window size advertised on a connection, depending on
+ * its side (frontend or backend), falling back to the default
+ * h2_settings_initial_window_size.
+ */
+static inline int h2c_initial_window_size(const struct h2c *h2c)
+{
+	int ret;
+
+	ret = (h2c->flags & H2_CF_IS_BACK) ?
+		h2_be_settings_initial_window_size :
+		h2_fe_settings_initial_window_size;
+
+	ret = ret ? ret : h2_settings_initial_window_size;
+	return ret;
+}
+
+/* returns the maximum stream window size that receive window autotuning may
+ * grant on a connection, depending on its side (frontend or backend), falling
+ * back to the default h2_settings_max_window_size. A value not larger than the
+ * initial window size means that autotuning is disabled. The window is never
+ * allowed to cover more than what may be buffered for the stream, which is its
+ * single rxbuf plus the connection's demux buffer once the rxbuf is full. Any
+ * excess would remain in the socket and block the other streams.
+ */
+static inline int h2c_max_window_size(const struct h2c *h2c)
+{
+	int ret;
+
+	ret = (h2c->flags & H2_CF_IS_BACK) ?
+		h2_be_settings_max_window_size :
+		h2_fe_settings_max_window_size;
+
+	ret = ret ? ret : h2_settings_max_window_size;
+	return MIN(ret, 2 * global.tune.bufsize);
+}
+
+/* returns the maximum size of the HPACK dynamic table the encoder may use on a
+ * connection, depending on its side (frontend or backend), falling back to the
+ * default h2_settings_encoder_table_size. It is bounded by the size of the
+ * tables that can be allocated. Zero means that the encoder doesn't use any.
+ */
+static inline uint32_t h2c_encoder_table_size(const struct h2c *h2c)
+{
+	int ret;
+
+	ret = (h2c->flags & H2_CF_IS_BACK) ?
+		h2_be_settings_encoder_table_size :
+		h2_fe_settings_encoder_table_size;
+
+	ret = ret ? ret : h2_settings_encoder_table_size;
+	return MIN(ret, h2_settings_header_table_size);
+}
+
 /* update h2c timeout if needed */
 static void h2c_update_timeout(struct h2c *h2c)
 {
@@ -1020,9 +1095,10 @@ static inline void h2_trace_header(const struct ist hn, const struct ist hv,
 /* hpack-encode header name <hn> and value <hv>, possibly emitting a trace if
  * currently enabled. This is done on behalf of function <func> at <trc_loc>
  * passed as ist(TRC_LOC), h2c <h2c>, and h2s <h2s>, all of which may be NULL.
- * The trace is only emitted if the header is emitted (in which case non-zero
- * is returned). The trash is modified. In the traces, the header's name will
- * be truncated to 256 chars and the header's value to 1024 chars.
+ * The h2c's encoder dynamic table is used when it has one. The trace is only
+ * emitted if the header is emitted (in which case non-zero is returned). The
+ * trash is modified. In the traces, the header's name will be truncated to 256
+ * chars and the header's value to 1024 chars.
  */
 static inline int h2_encode_header(struct buffer *buf, const struct ist hn, const struct ist hv,
 				   uint64_t mask, const struct ist trc_loc, const char *func,
@@ -1030,13 +1106,60 @@ static inline int h2_encode_header(struct buffer *buf, const struct ist hn, cons
 {
 	int ret;
 
-	ret = hpack_encode_header(buf, hn, hv);
+	if (h2c && h2c->edht)
+		ret = hpack_encode_header_dht(h2c->edht, buf, hn, hv);
+	else
+		ret = hpack_encode_header(buf, hn, hv);
 	if (ret)
 		h2_trace_header(hn, hv, mask, trc_loc, func, h2c, h2s);
 
 	return ret;
 }
 
+/* Prepares the encoder dynamic table of <h2c>, if any, before (re)starting to
+ * encode a header block into <out>. Since the encoding may be aborted and
+ * restarted (e.g. after a buffer realign or switch), the table is saved into
+ * <*snap> on the first call and restored from it on the next ones. If the peer
+ * changed its SETTINGS_HEADER_TABLE_SIZE, the table is then flushed and resized
+ * and the dynamic table size updates are emitted by hpack_encode_dtsu().
+ * Returns non-zero on success or zero if <out> is full.
+ */
+static int h2c_edht_start(struct h2c *h2c, struct hpack_dht **snap, struct buffer *out)
+{
+	if (!h2c->edht)
+		return 1;
+
+	if (*snap) {
+		memcpy(h2c->edht, *snap, MAX((*snap)->size, sizeof(**snap)));
+	}
+	else {
+		*snap = hpack_dht_alloc();
+		if (!*snap) {
+			/* the table cannot be secured anymore: stop using it,
+			 * the peer's one will simply never be referenced.
+			 */
+			hpack_dht_free(h2c->edht);
+			h2c->edht = NULL;
+			return 1;
+		}
+		memcpy(*snap, h2c->edht, MAX(h2c->edht->size, sizeof(**snap)));
+	}
+
+	if (!(h2c->flags & H2_CF_SHTS_UPDATED))
+		return 1;
+
+	return hpack_encode_dtsu(h2c->edht, out, MIN(h2c->shts, h2c_encoder_table_size(h2c)));
+}
+
+/* Rolls back the encoder dynamic table of <h2c> to the state saved into <snap>
+ * by h2c_edht_start() when a header block could not be committed.
+ */
+static inline void h2c_edht_abort(struct h2c *h2c, struct hpack_dht *snap)
+{
+	if (h2c->edht && snap)
+		memcpy(h2c->edht, snap, MAX(snap->size, sizeof(*snap)));
+}
+
 /*****************************************************************/
 /* functions below are dedicated to the mux setup and management */
 /*****************************************************************/
@@ -1113,6 +1236,14 @@ static int h2_init(struct connection *conn, struct proxy *prx, struct session *s
 	if (!h2c->ddht)
 		goto fail;
 
+	/* the encoder's table is only an optimization, we can live without */
+	h2c->edht = NULL;
+	if (h2c_encoder_table_size(h2c)) {
+		h2c->edht = hpack_dht_alloc();
+		if (h2c->edht)
+			hpack_dht_init(h2c->edht, MIN(h2c_encoder_table_size(h2c), 4096));
+	}
+
 	/* Initialise the context. */
 	h2c->st0 = H2_CS_PREFACE;
 	h2c->conn = conn;
@@ -1121,6 +1252,8 @@ static int h2_init(struct connection *conn, struct proxy *prx, struct session *s
 	h2c->errcode = H2_ERR_NO_ERROR;
 	h2c->rcvd_c = 0;
 	h2c->rcvd_s = 0;
+	h2c->rtt = 0;
+	h2c->ping_date = 0;
 	h2c->nb_streams = 0;
 	h2c->nb_sc = 0;
 	h2c->nb_reserved = 0;
@@ -1136,6 +1269,7 @@ static int h2_init(struct connection *conn, struct proxy *prx, struct session *s
 	h2c->miw = 65535; /* mux initial window size */
 	h2c->mws = 65535; /* mux window size */
 	h2c->mfs = 16384; /* initial max frame size */
+	h2c->shts = 4096; /* initial header table size */
 	h2c->streams_by_id = EB_ROOT;
 	LIST_INIT(&h2c->send_list);
 	LIST_INIT(&h2c->fctl_list);
@@ -1172,6 +1306,7 @@ static int h2_init(struct connection *conn, struct proxy *prx, struct session *s
 	TRACE_LEAVE(H2_EV_H2C_NEW, conn);
 	return 0;
   fail_stream:
+	hpack_dht_free(h2c->edht);
 	hpack_dht_free(h2c->ddht);
   fail:
 	task_destroy(t);
@@ -1225,6 +1360,7 @@ static void h2_release(struct h2c *h2c)
 	TRACE_ENTER(H2_EV_H2C_END);
 
 	hpack_dht_free(h2c->ddht);
+	hpack_dht_free(h2c->edht);
 
 	b_dequeue(&h2c->buf_wait);
 
@@ -1545,6 +1681,27 @@ static int h2_fragment_headers(struct buffer *b, uint32_t mfs)
 	return 1;
 }
 
+/* Appends stream <h2s> to the send or fctl list <head> of its connection. On
+ * the frontend side, unless disabled by "tune.http.priorities", the list is
+ * kept ordered by RFC9218 priorities, so that the most urgent streams are
+ * woken up first when there is room again, and incremental streams of a same
+ * urgency are served in turn. The stream must not be in a list yet.
+ */
+static inline void h2s_queue(struct list *head, struct h2s *h2s)
+{
+	struct h2s *cur;
+
+	if (global.tune.http_priorities && !(h2s->h2c->flags & H2_CF_IS_BACK)) {
+		list_for_each_entry(cur, head, list) {
+			if (http_prio_before(&h2s->prio, h2s->id, &cur->prio, cur->id)) {
+				/* insert just before <cur> */
+				LIST_APPEND(&cur->list, &h2s->list);
+				return;
+			}
+		}
+	}
+	LIST_APPEND(head, &h2s->list);
+}
 
 /* marks stream <h2s> as CLOSED and decrement the number of active streams for
  * its connection if the stream was not yet closed. Please use this exclusively
@@ -1652,10 +1809,15 @@ static struct h2s *h2s_new(struct h2c *h2c, int id)
 	h2s->shut_tl->process = h2_deferred_shut;
 	h2s->shut_tl->context = h2s;
 	LIST_INIT(&h2s->list);
+	http_prio_init(&h2s->prio);
 	h2s->h2c       = h2c;
 	h2s->sess      = NULL;
 	h2s->sd        = NULL;
 	h2s->sws       = 0;
+	h2s->rws       = h2c_initial_window_size(h2c);
+	h2s->rwe       = 0;
+	h2s->at_rcvd   = 0;
+	h2s->at_date   = now_ms;
 	h2s->flags     = H2_SF_NONE;
 	h2s->errcode   = H2_ERR_NO_ERROR;
 	h2s->st        = H2_SS_IDLE;
@@ -1867,10 +2029,7 @@ static int h2c_send_settings(struct h2c *h2c)
 		chunk_memcat(&buf, str, 6);
 	}
 
-	iws = (h2c->flags & H2_CF_IS_BACK) ?
-	      h2_be_settings_initial_window_size:
-	      h2_fe_settings_initial_window_size;
-	iws = iws ? iws : h2_settings_initial_window_size;
+	iws = h2c_initial_window_size(h2c);
 
 	if (iws != 65535) {
 		char str[6] = "\x00\x04"; /* initial_window_size */
@@ -2372,7 +2531,7 @@ static void h2c_unblock_sfctl(struct h2c *h2c)
 			LIST_DEL_INIT(&h2s->list);
 			if ((h2s->subs && h2s->subs->events & SUB_RETRY_SEND) ||
 			    h2s->flags & (H2_SF_WANT_SHUTR|H2_SF_WANT_SHUTW))
-				LIST_APPEND(&h2c->send_list, &h2s->list);
+				h2s_queue(&h2c->send_list, h2s);
 		}
 		node = eb32_next(node);
 	}
@@ -2446,6 +2605,7 @@ static int h2c_handle_settings(struct h2c *h2c)
 			h2c->mfs = arg;
 			break;
 		case H2_SETTINGS_HEADER_TABLE_SIZE:
+			h2c->shts = arg;
 			h2c->flags |= H2_CF_SHTS_UPDATED;
 			break;
 		case H2_SETTINGS_ENABLE_PUSH:
@@ -2528,6 +2688,103 @@ static int h2c_ack_settings(struct h2c *h2c)
 	return ret;
 }
 
+/* try to send a PING used to measure the round trip time to the peer for the
+ * receive window autotuning. Its ACK is processed by h2c_handle_ping(). It's
+ * safe to call it when no such PING is needed. Returns > 0 on success or zero
+ * on missing room or failure. It may return an error in h2c.
+ */
+static int h2c_send_rtt_ping(struct h2c *h2c)
+{
+	struct buffer *res;
+	char str[17];
+	int ret = 1;
+
+	TRACE_ENTER(H2_EV_TX_FRAME|H2_EV_TX_PING, h2c->conn);
+
+	if (!(h2c->flags & H2_CF_RTT_PING_WANT))
+		goto out;
+
+	memcpy(str,
+	       "\x00\x00\x08"     /* length : 8 */
+	       "\x06" "\x00"      /* type   : 6, flags : none */
+	       "\x00\x00\x00\x00" /* stream ID */, 9);
+	memcpy(str + 9, h2_rtt_ping, 8);
+
+	res = br_tail(h2c->mbuf);
+ retry:
+	if (!h2_get_buf(h2c, res)) {
+		h2c->flags |= H2_CF_MUX_MALLOC;
+		h2c->flags |= H2_CF_DEM_MROOM;
+		ret = 0;
+		goto out;
+	}
+
+	ret = b_istput(res, ist2(str, 17));
+	if (unlikely(ret <= 0)) {
+		if (!ret) {
+			if ((res = br_tail_add(h2c->mbuf)) != NULL)
+				goto retry;
+			h2c->flags |= H2_CF_MUX_MFULL;
+			h2c->flags |= H2_CF_DEM_MROOM;
+		}
+		else {
+			h2c_error(h2c, H2_ERR_INTERNAL_ERROR);
+			ret = 0;
+		}
+		goto out;
+	}
+
+	h2c->flags = (h2c->flags & ~H2_CF_RTT_PING_WANT) | H2_CF_RTT_PING_SENT;
+	h2c->ping_date = now_ms;
+ out:
+	TRACE_LEAVE(H2_EV_TX_FRAME|H2_EV_TX_PING, h2c->conn);
+	return ret;
+}
+
+/* Receive window autotuning, called for each <bytes> of DATA transferred to
+ * stream <h2s>. Similarly to what other stacks do, the stream's data are
+ * accounted for in epochs. Once half of the stream's target window was
+ * received, if it took less than 4 round trips per full window, the peer
+ * is considered limited by the flow control (a window-limited peer delivers
+ * one window per round trip), and the target is doubled, within the
+ * configured maximum. Conversely, when it took more than 64 round trips per
+ * window, the target is halved, down to the initial window size, so that slow
+ * peers do not keep large amounts of data in flight. The RTT is measured
+ * using PING frames sent on the first data and every few seconds.
+ */
+static void h2s_autotune_window(struct h2s *h2s, uint32_t bytes)
+{
+	struct h2c *h2c = h2s->h2c;
+	uint32_t iws = h2c_initial_window_size(h2c);
+	uint32_t max = h2c_max_window_size(h2c);
+	uint64_t elapsed;
+
+	if (max <= iws)
+		return;
+
+	if (!(h2c->flags & (H2_CF_RTT_PING_WANT|H2_CF_RTT_PING_SENT)) &&
+	    (!h2c->rtt || (uint32_t)(now_ms - h2c->ping_date) >= H2_RTT_PING_INTERVAL))
+		h2c->flags |= H2_CF_RTT_PING_WANT;
+
+	h2s->at_rcvd += bytes;
+	if (h2s->at_rcvd < h2s->rws / 2 || !h2c->rtt)
+		return;
+
+	elapsed = (uint32_t)(now_ms - h2s->at_date);
+	if (elapsed * h2s->rws < 4ULL * h2s->at_rcvd * h2c->rtt) {
+		if (h2s->rws < max)
+			h2s->rws = MIN((uint64_t)h2s->rws * 2, max);
+	}
+	else if (elapsed * h2s->rws > 64ULL * h2s->at_rcvd * h2c->rtt) {
+		if (h2s->rws > iws)
+			h2s->rws = MAX(h2s->rws / 2, iws);
+	}
+
+	TRACE_STATE("receive window autotuned", H2_EV_RX_FRAME|H2_EV_RX_DATA, h2c->conn, h2s, 0, (void *)(long)h2s->rws);
+	h2s->at_rcvd = 0;
+	h2s->at_date = now_ms;
+}
+
 /* processes a PING frame and schedules an ACK if needed. The caller must pass
  * the pointer to the payload in <payload>. Returns > 0 on success or zero on
  * missing data. The caller must have already verified frame length
@@ -2535,9 +2792,26 @@ static int h2c_ack_settings(struct h2c *h2c)
  */
 static int h2c_handle_ping(struct h2c *h2c)
 {
+	char payload[8];
+
 	/* schedule a response */
 	if (!(h2c->dff & H2_F_PING_ACK))
 		h2c->st0 = H2_CS_FRAME_A;
+	else if (h2c->flags & H2_CF_RTT_PING_SENT) {
+		/* process full frame only */
+		if (b_data(&h2c->dbuf) < 8) {
+			h2c->flags |= H2_CF_DEM_SHORT_READ;
+			return 0;
+		}
+
+		h2_get_buf_bytes(payload, 8, &h2c->dbuf, 0);
+		if (memcmp(payload, h2_rtt_ping, 8) == 0) {
+			/* 0 means unknown, and ms are coarse on local networks */
+			h2c->rtt = MAX((uint32_t)(now_ms - h2c->ping_date), 1);
+			h2c->flags &= ~H2_CF_RTT_PING_SENT;
+			TRACE_STATE("measured RTT", H2_EV_RX_FRAME|H2_EV_RX_PING, h2c->conn, 0, 0, (void *)(long)h2c->rtt);
+		}
+	}
 	return 1;
 }
 
@@ -2621,6 +2895,9 @@ static int h2c_send_conn_wu(struct h2c *h2c)
  */
 static int h2c_send_strm_wu(struct h2c *h2c)
 {
+	struct h2s *h2s = NULL;
+	uint32_t inc;
+	int delta = 0;
 	int ret = 1;
 
 	TRACE_ENTER(H2_EV_TX_FRAME|H2_EV_TX_WU, h2c->conn);
@@ -2628,10 +2905,36 @@ static int h2c_send_strm_wu(struct h2c *h2c)
 	if (h2c->rcvd_s <= 0)
 		goto out;
 
+	inc = h2c->rcvd_s;
+	if (h2c_max_window_size(h2c) > h2c_initial_window_size(h2c)) {
+		/* window autotuning: grant the stream the difference between
+		 * the current target and what it was already granted, or
+		 * withhold some of the acknowledged data if the target was
+		 * lowered, without going below the initial window.
+		 */
+		h2s = h2c_st_by_id(h2c, h2c->dsi);
+		if (h2s->id) {
+			delta = (int)(h2s->rws - h2c_initial_window_size(h2c)) - (int)h2s->rwe;
+			if (delta < 0)
+				delta = -MIN(-delta, MIN(inc, h2s->rwe));
+			inc += delta;
+		}
+	}
+
+	if (!inc) {
+		/* everything was withheld */
+		h2s->rwe += delta;
+		h2c->rcvd_s = 0;
+		goto out;
+	}
+
 	/* send WU for the stream */
-	ret = h2c_send_window_update(h2c, h2c->dsi, h2c->rcvd_s);
-	if (ret > 0)
+	ret = h2c_send_window_update(h2c, h2c->dsi, inc);
+	if (ret > 0) {
+		if (delta)
+			h2s->rwe += delta;
 		h2c->rcvd_s = 0;
+	}
  out:
 	TRACE_LEAVE(H2_EV_TX_FRAME|H2_EV_TX_WU, h2c->conn);
 	return ret;
@@ -2741,7 +3044,7 @@ static int h2c_handle_window_update(struct h2c *h2c, struct h2s *h2s)
 			LIST_DEL_INIT(&h2s->list);
 			if ((h2s->subs && h2s->subs->events & SUB_RETRY_SEND) ||
 			    h2s->flags & (H2_SF_WANT_SHUTR|H2_SF_WANT_SHUTW))
-				LIST_APPEND(&h2c->send_list, &h2s->list);
+				h2s_queue(&h2c->send_list, h2s);
 		}
 	}
 	else {
@@ -2836,6 +3139,62 @@ static int h2c_handle_priority(struct h2c *h2c)
 	return 1;
 }
 
+/* processes a PRIORITY_UPDATE frame, and updates the RFC9218 priority of the
+ * stream it designates. The frame is ignored for streams which are not open
+ * (idle or closed). Returns > 0 on success or zero on missing data. It may
+ * return an error in h2c. Described in RFC9218#7.1.
+ */
+static int h2c_handle_priority_update(struct h2c *h2c)
+{
+	struct buffer *value;
+	struct h2s *h2s;
+	int id;
+
+	TRACE_ENTER(H2_EV_RX_FRAME|H2_EV_RX_PRIO, h2c->conn);
+
+	if (h2c->dsi != 0 || h2c->dfl < 4) {
+		/* RFC9218#7.1: must be sent on stream 0 and carry at least
+		 * the prioritized stream ID.
+		 */
+		h2c_report_glitch(h2c, 1);
+		TRACE_ERROR("invalid PRIORITY_UPDATE frame", H2_EV_RX_FRAME|H2_EV_RX_PRIO, h2c->conn);
+		h2c_error(h2c, h2c->dsi ? H2_ERR_PROTOCOL_ERROR : H2_ERR_FRAME_SIZE_ERROR);
+		HA_ATOMIC_INC(&h2c->px_counters->conn_proto_err);
+		TRACE_DEVEL("leaving on error", H2_EV_RX_FRAME|H2_EV_RX_PRIO, h2c->conn);
+		return 0;
+	}
+
+	/* process full frame only */
+	if (b_data(&h2c->dbuf) < h2c->dfl) {
+		TRACE_DEVEL("leaving on missing data", H2_EV_RX_FRAME|H2_EV_RX_PRIO, h2c->conn);
+		h2c->flags |= H2_CF_DEM_SHORT_READ;
+		return 0;
+	}
+
+	id = h2_get_n32(&h2c->dbuf, 0) & 0x7FFFFFFF;
+	if (!id) {
+		h2c_report_glitch(h2c, 1);
+		TRACE_ERROR("PRIORITY_UPDATE for stream 0", H2_EV_RX_FRAME|H2_EV_RX_PRIO, h2c->conn);
+		h2c_error(h2c, H2_ERR_PROTOCOL_ERROR);
+		HA_ATOMIC_INC(&h2c->px_counters->conn_proto_err);
+		TRACE_DEVEL("leaving on error", H2_EV_RX_FRAME|H2_EV_RX_PRIO, h2c->conn);
+		return 0;
+	}
+
+	h2s = h2c_st_by_id(h2c, id);
+	if (h2s->st == H2_SS_IDLE || h2s->st == H2_SS_CLOSED)
+		goto end;
+
+	/* the new priority will be used next time the stream gets queued */
+	value = get_trash_chunk();
+	b_getblk(&h2c->dbuf, b_orig(value), h2c->dfl - 4, 4);
+	http_parse_priority(ist2(b_orig(value), h2c->dfl - 4), &h2s->prio);
+	TRACE_STATE("updated stream priority", H2_EV_RX_FRAME|H2_EV_RX_PRIO, h2c->conn, h2s);
+ end:
+	TRACE_LEAVE(H2_EV_RX_FRAME|H2_EV_RX_PRIO, h2c->conn);
+	return 1;
+}
+
 /* processes an RST_STREAM frame, and sets the 32-bit error code on the stream.
  * Returns > 0 on success or zero on missing data. The caller must have already
  * verified frame length and stream ID validity. Described in RFC7540#6.4.
@@ -2884,6 +3243,8 @@ static int h2c_handle_rst_stream(struct h2c *h2c, struct h2s *h2s)
 static struct h2s *h2c_frt_handle_headers(struct h2c *h2c, struct h2s *h2s)
 {
 	struct buffer rxbuf = BUF_NULL;
+	struct http_prio prio;
+	struct http_hdr_ctx ctx;
 	unsigned long long body_len = 0;
 	uint32_t flags = 0;
 	int error;
@@ -3020,12 +3381,20 @@ static struct h2s *h2c_frt_handle_headers(struct h2c *h2c, struct h2s *h2s)
 	 * Xfer the rxbuf to the stream. On success, the new stream owns the
 	 * rxbuf. On error, it is released here.
 	 */
+	http_prio_init(&prio);
+	if (global.tune.http_priorities) {
+		ctx.blk = NULL;
+		while (http_find_header(htxbuf(&rxbuf), ist("priority"), &ctx, 1))
+			http_parse_priority(ctx.value, &prio);
+	}
+
 	h2s = h2c_frt_stream_new(h2c, h2c->dsi, &rxbuf, flags);
 	if (!h2s) {
 		h2s = (struct h2s*)h2_refused_stream;
 		TRACE_USER("refused H2 req.  ", H2_EV_RX_FRAME|H2_EV_RX_HDR|H2_EV_STRM_NEW|H2_EV_STRM_END, h2c->conn, h2s, &rxbuf);
 		goto send_rst;
 	}
+	h2s->prio = prio;
 
 	h2s->st = H2_SS_OPEN;
 	h2s->flags |= flags;
@@ -3926,6 +4295,15 @@ static void h2_process_demux(struct h2c *h2c)
 			HA_ATOMIC_INC(&h2c->px_counters->goaway_rcvd);
 			break;
 
+		case H2_FT_PRIORITY_UPDATE:
+			if (h2c->st0 == H2_CS_FRAME_P && !(h2c->flags & H2_CF_IS_BACK) &&
+			    h2c->dfl <= b_size(&h2c->dbuf)) {
+				TRACE_PROTO("receiving H2 PRIORITY_UPDATE frame", H2_EV_RX_FRAME|H2_EV_RX_PRIO, h2c->conn, h2s);
+				ret = h2c_handle_priority_update(h2c);
+				break;
+			}
+			__fallthrough;
+
 			/* implement all extra frame types here */
 		default:
 			TRACE_PROTO("receiving H2 ignored frame", H2_EV_RX_FRAME, h2c->conn, h2s);
@@ -3981,6 +4359,12 @@ static void h2_process_demux(struct h2c *h2c)
 		h2c_send_conn_wu(h2c);
 	}
 
+	if ((h2c->flags & H2_CF_RTT_PING_WANT) &&
+	    !(h2c->flags & (H2_CF_MUX_MFULL | H2_CF_DEM_MROOM))) {
+		TRACE_PROTO("sending H2 RTT PING frame", H2_EV_TX_FRAME|H2_EV_TX_PING, h2c->conn);
+		h2c_send_rtt_ping(h2c);
+	}
+
  done:
 	if (h2c->st0 >= H2_CS_ERROR || (h2c->flags & H2_CF_DEM_SHORT_READ)) {
 		if (h2c->flags & H2_CF_RCVD_SHUT)
@@ -4108,6 +4492,11 @@ static int h2_process_mux(struct h2c *h2c)
 	    h2c_send_conn_wu(h2c) < 0)
 		goto fail;
 
+	if ((h2c->flags & H2_CF_RTT_PING_WANT) &&
+	    !(h2c->flags & (H2_CF_MUX_MFULL | H2_CF_MUX_MALLOC)) &&
+	    h2c_send_rtt_ping(h2c) < 0)
+		goto fail;
+
 	/* First we always process the flow control list because the streams
 	 * waiting there were already elected for immediate emission but were
 	 * blocked just on this.
@@ -4287,25 +4676,75 @@ static int h2_send(struct h2c *h2c)
 			flags |= CO_SFL_STREAMER;
 		}
 
-		for (buf = br_head(h2c->mbuf); b_size(buf); buf = br_del_head(h2c->mbuf)) {
-			if (b_data(buf)) {
-				int ret = conn->xprt->snd_buf(conn, conn->xprt_ctx, buf, b_data(buf),
-							      flags | (to_send > 1 ? CO_SFL_MSG_MORE : 0));
-				if (!ret) {
-					done = 1;
-					break;
+		if (to_send > 1 && conn->xprt->snd_iov) {
+			/* several buffers are pending, and the transport layer
+			 * is able to send them all at once without having to
+			 * linearize them first, that's one syscall saved per
+			 * buffer.
+			 */
+			struct iovec iov[H2C_MBUF_CNT * 2];
+			const char *blk1, *blk2;
+			size_t len1, len2, ret;
+			uint idx = br_head_idx(h2c->mbuf);
+			int iovcnt = 0;
+
+			while (1) {
+				buf = &h2c->mbuf[idx];
+				if (b_data(buf)) {
+					if (b_getblk_nc(buf, &blk1, &len1, &blk2, &len2, 0, b_data(buf)) == 2) {
+						iov[iovcnt].iov_base = (void *)blk1;
+						iov[iovcnt++].iov_len = len1;
+						blk1 = blk2;
+						len1 = len2;
+					}
+					iov[iovcnt].iov_base = (void *)blk1;
+					iov[iovcnt++].iov_len = len1;
 				}
+				if (idx == br_tail_idx(h2c->mbuf))
+					break;
+				if (++idx >= br_size(h2c->mbuf))
+					idx = 1;
+			}
+
+			ret = conn->xprt->snd_iov(conn, conn->xprt_ctx, iov, iovcnt, flags);
+			if (ret) {
 				sent = 1;
-				to_send--;
-				TRACE_DATA("sent data", H2_EV_H2C_SEND, h2c->conn, 0, buf, (void*)(long)ret);
-				b_del(buf, ret);
+				TRACE_DATA("sent data", H2_EV_H2C_SEND, h2c->conn, 0, br_head(h2c->mbuf), (void*)(long)ret);
+			}
+
+			for (buf = br_head(h2c->mbuf); b_size(buf); buf = br_del_head(h2c->mbuf)) {
+				len1 = MIN(ret, b_data(buf));
+				b_del(buf, len1);
+				ret -= len1;
 				if (b_data(buf)) {
 					done = 1;
 					break;
 				}
+				b_free(buf);
+				released++;
+			}
+		}
+		else {
+			for (buf = br_head(h2c->mbuf); b_size(buf); buf = br_del_head(h2c->mbuf)) {
+				if (b_data(buf)) {
+					int ret = conn->xprt->snd_buf(conn, conn->xprt_ctx, buf, b_data(buf),
+								      flags | (to_send > 1 ? CO_SFL_MSG_MORE : 0));
+					if (!ret) {
+						done = 1;
+						break;
+					}
+					sent = 1;
+					to_send--;
+					TRACE_DATA("sent data", H2_EV_H2C_SEND, h2c->conn, 0, buf, (void*)(long)ret);
+					b_del(buf, ret);
+					if (b_data(buf)) {
+						done = 1;
+						break;
+					}
+				}
+				b_free(buf);
+				released++;
 			}
-			b_free(buf);
-			released++;
 		}
 
 		if (released)
@@ -5031,9 +5470,9 @@ static void h2_do_shutr(struct h2s *h2s, struct se_abort_info *reason)
 	h2s->flags |= H2_SF_WANT_SHUTR;
 	if (!LIST_INLIST(&h2s->list)) {
 		if (h2s->flags & H2_SF_BLK_MFCTL)
-			LIST_APPEND(&h2c->fctl_list, &h2s->list);
+			h2s_queue(&h2c->fctl_list, h2s);
 		else if (h2s->flags & (H2_SF_BLK_MBUSY|H2_SF_BLK_MROOM))
-			LIST_APPEND(&h2c->send_list, &h2s->list);
+			h2s_queue(&h2c->send_list, h2s);
 	}
 	TRACE_LEAVE(H2_EV_STRM_SHUT, h2c->conn, h2s);
 	return;
@@ -5121,9 +5560,9 @@ static void h2_do_shutw(struct h2s *h2s, struct se_abort_info *reason)
 	h2s->flags |= H2_SF_WANT_SHUTW;
 	if (!LIST_INLIST(&h2s->list)) {
 		if (h2s->flags & H2_SF_BLK_MFCTL)
-			LIST_APPEND(&h2c->fctl_list, &h2s->list);
+			h2s_queue(&h2c->fctl_list, h2s);
 		else if (h2s->flags & (H2_SF_BLK_MBUSY|H2_SF_BLK_MROOM))
-			LIST_APPEND(&h2c->send_list, &h2s->list);
+			h2s_queue(&h2c->send_list, h2s);
 	}
 	TRACE_LEAVE(H2_EV_STRM_SHUT, h2c->conn, h2s);
 	return;
@@ -5611,6 +6050,7 @@ static int h2_frt_transfer_data(struct h2s *h2s)
 	h2c->dfl    -= sent;
 	h2c->rcvd_c += sent;
 	h2c->rcvd_s += sent;  // warning, this can also affect the closed streams!
+	h2s_autotune_window(h2s, sent);
 
 	if (h2s->flags & H2_SF_DATA_CLEN) {
 		h2s->body_len -= sent;
@@ -5670,6 +6110,7 @@ static size_t h2s_snd_fhdrs(struct h2s *h2s, struct htx *htx)
 {
 	struct http_hdr list[global.tune.max_http_hdr];
 	struct h2c *h2c = h2s->h2c;
+	struct hpack_dht *snap = NULL;
 	struct htx_blk *blk;
 	struct buffer outbuf;
 	struct buffer *mbuf;
@@ -5751,7 +6192,9 @@ static size_t h2s_snd_fhdrs(struct h2s *h2s, struct htx *htx)
 		h2c->flags |= H2_CF_MUX_MALLOC;
 		h2s->flags |= H2_SF_BLK_MROOM;
 		TRACE_STATE("waiting for room in output buffer", H2_EV_TX_FRAME|H2_EV_TX_HDR|H2_EV_H2S_BLK, h2c->conn, h2s);
-		return 0;
+		h2c_edht_abort(h2c, snap);
+		ret = 0;
+		goto end;
 	}
 
 	chunk_reset(&outbuf);
@@ -5772,7 +6215,14 @@ static size_t h2s_snd_fhdrs(struct h2s *h2s, struct htx *htx)
 	write_n32(outbuf.area + 5, h2s->id); // 4 bytes
 	outbuf.data = 9;
 
-	if ((h2c->flags & (H2_CF_SHTS_UPDATED|H2_CF_DTSU_EMITTED)) == H2_CF_SHTS_UPDATED) {
+	if (!h2c_edht_start(h2c, &snap, &outbuf)) {
+		if (b_space_wraps(mbuf))
+			goto realign_again;
+		goto full;
+	}
+
+	if (!h2c->edht &&
+	    (h2c->flags & (H2_CF_SHTS_UPDATED|H2_CF_DTSU_EMITTED)) == H2_CF_SHTS_UPDATED) {
 		/* SETTINGS_HEADER_TABLE_SIZE changed, we must send an HPACK
 		 * dynamic table size update so that some clients are not
 		 * confused. In practice we only need to send the DTSU when the
@@ -5793,13 +6243,22 @@ static size_t h2s_snd_fhdrs(struct h2s *h2s, struct htx *htx)
 	}
 
 	/* encode status, which necessarily is the first one */
-	if (!hpack_encode_int_status(&outbuf, h2s->status)) {
+	if (h2c->edht) {
+		char sts[4];
+
+		if (!h2_encode_header(&outbuf, ist(":status"), ist(ultoa_r(h2s->status, sts, sizeof(sts))),
+		                      H2_EV_TX_FRAME|H2_EV_TX_HDR, ist(TRC_LOC), __FUNCTION__, h2c, h2s)) {
+			if (b_space_wraps(mbuf))
+				goto realign_again;
+			goto full;
+		}
+	}
+	else if (!hpack_encode_int_status(&outbuf, h2s->status)) {
 		if (b_space_wraps(mbuf))
 			goto realign_again;
 		goto full;
 	}
-
-	if ((TRACE_SOURCE)->verbosity >= H2_VERB_ADVANCED) {
+	else if ((TRACE_SOURCE)->verbosity >= H2_VERB_ADVANCED) {
 		char sts[4];
 
 		h2_trace_header(ist(":status"), ist(ultoa_r(h2s->status, sts, sizeof(sts))),
@@ -5903,6 +6362,7 @@ static size_t h2s_snd_fhdrs(struct h2s *h2s, struct htx *htx)
 
 	/* OK we could properly deliver the response */
  end:
+	hpack_dht_free(snap);
 	TRACE_LEAVE(H2_EV_TX_FRAME|H2_EV_TX_HDR, h2c->conn, h2s);
 	return ret;
  full:
@@ -5910,6 +6370,7 @@ static size_t h2s_snd_fhdrs(struct h2s *h2s, struct htx *htx)
 		goto retry;
 	h2c->flags |= H2_CF_MUX_MFULL;
 	h2s->flags |= H2_SF_BLK_MROOM;
+	h2c_edht_abort(h2c, snap);
 	ret = 0;
 	TRACE_STATE("mux buffer full", H2_EV_TX_FRAME|H2_EV_TX_HDR|H2_EV_H2S_BLK, h2c->conn, h2s);
 	goto end;
@@ -5917,6 +6378,7 @@ static size_t h2s_snd_fhdrs(struct h2s *h2s, struct htx *htx)
 	/* unparsable HTX messages, too large ones to be produced in the local
 	 * list etc go here (unrecoverable errors).
 	 */
+	h2c_edht_abort(h2c, snap);
 	h2s_error(h2s, H2_ERR_INTERNAL_ERROR);
 	ret = 0;
 	goto end;
@@ -5935,6 +6397,7 @@ static size_t h2s_snd_bhdrs(struct h2s *h2s, struct htx *htx)
 {
 	struct http_hdr list[global.tune.max_http_hdr];
 	struct h2c *h2c = h2s->h2c;
+	struct hpack_dht *snap = NULL;
 	struct htx_blk *blk;
 	struct buffer outbuf;
 	struct buffer *mbuf;
@@ -6058,7 +6521,9 @@ static size_t h2s_snd_bhdrs(struct h2s *h2s, struct htx *htx)
 		h2c->flags |= H2_CF_MUX_MALLOC;
 		h2s->flags |= H2_SF_BLK_MROOM;
 		TRACE_STATE("waiting for room in output buffer", H2_EV_TX_FRAME|H2_EV_TX_HDR|H2_EV_H2S_BLK, h2c->conn, h2s);
-		return 0;
+		h2c_edht_abort(h2c, snap);
+		ret = 0;
+		goto end;
 	}
 
 	chunk_reset(&outbuf);
@@ -6079,8 +6544,16 @@ static size_t h2s_snd_bhdrs(struct h2s *h2s, struct htx *htx)
 	write_n32(outbuf.area + 5, h2s->id); // 4 bytes
 	outbuf.data = 9;
 
+	if (!h2c_edht_start(h2c, &snap, &outbuf)) {
+		if (b_space_wraps(mbuf))
+			goto realign_again;
+		goto full;
+	}
+
 	/* encode the method, which necessarily is the first one */
-	if (!hpack_encode_method(&outbuf, sl->info.req.meth, meth)) {
+	if (!(h2c->edht ?
+	      hpack_encode_header_dht(h2c->edht, &outbuf, ist(":method"), meth) :
+	      hpack_encode_method(&outbuf, sl->info.req.meth, meth))) {
 		if (b_space_wraps(mbuf))
 			goto realign_again;
 		goto full;
@@ -6161,7 +6634,9 @@ static size_t h2s_snd_bhdrs(struct h2s *h2s, struct htx *htx)
 				scheme = ist("https");
 		}
 
-		if (!hpack_encode_scheme(&outbuf, scheme)) {
+		if (!(h2c->edht ?
+		      hpack_encode_header_dht(h2c->edht, &outbuf, ist(":scheme"), scheme) :
+		      hpack_encode_scheme(&outbuf, scheme))) {
 			/* output full */
 			if (b_space_wraps(mbuf))
 				goto realign_again;
@@ -6187,7 +6662,9 @@ static size_t h2s_snd_bhdrs(struct h2s *h2s, struct htx *htx)
 				uri = ist("/");
 		}
 
-		if (!hpack_encode_path(&outbuf, uri)) {
+		if (!(h2c->edht ?
+		      hpack_encode_header_dht(h2c->edht, &outbuf, ist(":path"), uri) :
+		      hpack_encode_path(&outbuf, uri))) {
 			/* output full */
 			if (b_space_wraps(mbuf))
 				goto realign_again;
@@ -6303,6 +6780,11 @@ static size_t h2s_snd_bhdrs(struct h2s *h2s, struct htx *htx)
 	h2s->flags |= H2_SF_HEADERS_SENT;
 	h2s->st = H2_SS_OPEN;
 
+	if (h2c->edht) {
+		/* the table size update was sent above */
+		h2c->flags &= ~H2_CF_SHTS_UPDATED;
+	}
+
 	if (es_now) {
 		TRACE_PROTO("setting ES on HEADERS frame", H2_EV_TX_FRAME|H2_EV_TX_HDR, h2c->conn, h2s, htx);
 		// trim any possibly pending data (eg: inconsistent content-length)
@@ -6311,12 +6793,14 @@ static size_t h2s_snd_bhdrs(struct h2s *h2s, struct htx *htx)
 	}
 
  end:
+	hpack_dht_free(snap);
 	return ret;
  full:
 	if ((mbuf = br_tail_add(h2c->mbuf)) != NULL)
 		goto retry;
 	h2c->flags |= H2_CF_MUX_MFULL;
 	h2s->flags |= H2_SF_BLK_MROOM;
+	h2c_edht_abort(h2c, snap);
 	ret = 0;
 	TRACE_STATE("mux buffer full", H2_EV_TX_FRAME|H2_EV_TX_HDR|H2_EV_H2S_BLK, h2c->conn, h2s);
 	goto end;
@@ -6324,6 +6808,7 @@ static size_t h2s_snd_bhdrs(struct h2s *h2s, struct htx *htx)
 	/* unparsable HTX messages, too large ones to be produced in the local
 	 * list etc go here (unrecoverable errors).
 	 */
+	h2c_edht_abort(h2c, snap);
 	h2s_error(h2s, H2_ERR_INTERNAL_ERROR);
 	ret = 0;
 	goto end;
@@ -6720,6 +7205,7 @@ static size_t h2s_make_trailers(struct h2s *h2s, struct htx *htx)
 {
 	struct http_hdr list[global.tune.max_http_hdr];
 	struct h2c *h2c = h2s->h2c;
+	struct hpack_dht *snap = NULL;
 	struct htx_blk *blk;
 	struct buffer outbuf;
 	struct buffer *mbuf;
@@ -6765,6 +7251,7 @@ static size_t h2s_make_trailers(struct h2s *h2s, struct htx *htx)
 		h2c->flags |= H2_CF_MUX_MALLOC;
 		h2s->flags |= H2_SF_BLK_MROOM;
 		TRACE_STATE("waiting for room in output buffer", H2_EV_TX_FRAME|H2_EV_TX_HDR|H2_EV_H2S_BLK, h2c->conn, h2s);
+		h2c_edht_abort(h2c, snap);
 		goto end;
 	}
 
@@ -6786,6 +7273,12 @@ static size_t h2s_make_trailers(struct h2s *h2s, struct htx *htx)
 	write_n32(outbuf.area + 5, h2s->id); // 4 bytes
 	outbuf.data = 9;
 
+	if (!h2c_edht_start(h2c, &snap, &outbuf)) {
+		if (b_space_wraps(mbuf))
+			goto realign_again;
+		goto full;
+	}
+
 	/* encode all headers */
 	for (idx = 0; idx < hdr; idx++) {
 		/* these ones do not exist in H2 or must not appear in
@@ -6843,6 +7336,11 @@ static size_t h2s_make_trailers(struct h2s *h2s, struct htx *htx)
 	h2c->flags |= H2_CF_MBUF_HAS_DATA;
 	h2s->flags |= H2_SF_ES_SENT;
 
+	if (h2c->edht) {
+		/* the table size update was sent above */
+		h2c->flags &= ~H2_CF_SHTS_UPDATED;
+	}
+
 	if (h2s->st == H2_SS_OPEN)
 		h2s->st = H2_SS_HLOC;
 	else
@@ -6863,6 +7361,7 @@ static size_t h2s_make_trailers(struct h2s *h2s, struct htx *htx)
 	}
 
  end:
+	hpack_dht_free(snap);
 	TRACE_LEAVE(H2_EV_TX_FRAME|H2_EV_TX_HDR, h2c->conn, h2s);
 	return ret;
  full:
@@ -6870,6 +7369,7 @@ static size_t h2s_make_trailers(struct h2s *h2s, struct htx *htx)
 		goto retry;
 	h2c->flags |= H2_CF_MUX_MFULL;
 	h2s->flags |= H2_SF_BLK_MROOM;
+	h2c_edht_abort(h2c, snap);
 	ret = 0;
 	TRACE_STATE("mux buffer full", H2_EV_TX_FRAME|H2_EV_TX_HDR|H2_EV_H2S_BLK, h2c->conn, h2s);
 	goto end;
@@ -6877,6 +7377,7 @@ static size_t h2s_make_trailers(struct h2s *h2s, struct htx *htx)
 	/* unparsable HTX messages, too large ones to be produced in the local
 	 * list etc go here (unrecoverable errors).
 	 */
+	h2c_edht_abort(h2c, snap);
 	h2s_error(h2s, H2_ERR_INTERNAL_ERROR);
 	ret = 0;
 	goto end;
@@ -6909,11 +7410,11 @@ static int h2_subscribe(struct stconn *sc, int event_type, struct wait_event *es
 		    !LIST_INLIST(&h2s->list)) {
 			if (h2s->flags & H2_SF_BLK_MFCTL) {
 				TRACE_DEVEL("Adding to fctl list", H2_EV_STRM_SEND, h2c->conn, h2s);
-				LIST_APPEND(&h2c->fctl_list, &h2s->list);
+				h2s_queue(&h2c->fctl_list, h2s);
 			}
 			else {
 				TRACE_DEVEL("Adding to send list", H2_EV_STRM_SEND, h2c->conn, h2s);
-				LIST_APPEND(&h2c->send_list, &h2s->list);
+				h2s_queue(&h2c->send_list, h2s);
 			}
 		}
 	}
@@ -7433,8 +7934,8 @@ static int h2_dump_h2s_info(struct buffer *msg, const struct h2s *h2s, const cha
 	if (!h2s)
 		return ret;
 
-	chunk_appendf(msg, " h2s.id=%d .st=%s .flg=0x%04x .rxbuf=%u@%p+%u/%u",
-		      h2s->id, h2s_st_to_str(h2s->st), h2s->flags,
+	chunk_appendf(msg, " h2s.id=%d .st=%s .flg=0x%04x .urg=%u .inc=%u .rxbuf=%u@%p+%u/%u",
+		      h2s->id, h2s_st_to_str(h2s->st), h2s->flags, h2s->prio.urg, h2s->prio.inc,
 		      (unsigned int)b_data(&h2s->rxbuf), b_orig(&h2s->rxbuf),
 		      (unsigned int)b_head_ofs(&h2s->rxbuf), (unsigned int)b_size(&h2s->rxbuf));
 
@@ -7503,9 +8004,9 @@ static int h2_dump_h2c_info(struct buffer *msg, struct h2c *h2c, const char *pfx
 	hmbuf = br_head(h2c->mbuf);
 	tmbuf = br_tail(h2c->mbuf);
 	chunk_appendf(msg, " h2c.st0=%s .err=%d .maxid=%d .lastid=%d .flg=0x%04x"
-		      " .nbst=%u .nbsc=%u, .glitches=%d",
+		      " .nbst=%u .nbsc=%u, .glitches=%d .rtt=%u",
 		      h2c_st_to_str(h2c->st0), h2c->errcode, h2c->max_id, h2c->last_sid, h2c->flags,
-		      h2c->nb_streams, h2c->nb_sc, h2c->glitches);
+		      h2c->nb_streams, h2c->nb_sc, h2c->glitches, h2c->rtt);
 
 	if (pfx)
 		chunk_appendf(msg, "\n%s", pfx);
@@ -7726,6 +8227,29 @@ static int h2_parse_header_table_size(char **args, int section_type, struct prox
 	return 0;
 }
 
+/* config parser for global "tune.h2.{be.,fe.,}encoder-table-size" */
+static int h2_parse_encoder_table_size(char **args, int section_type, struct proxy *curpx,
+                                       const struct proxy *defpx, const char *file, int line,
+                                       char **err)
+{
+	int *vptr;
+
+	if (too_many_args(1, args, err, NULL))
+		return -1;
+
+	/* backend/frontend/default */
+	vptr = (args[0][8] == 'b') ? &h2_be_settings_encoder_table_size :
+	       (args[0][8] == 'f') ? &h2_fe_settings_encoder_table_size :
+	       &h2_settings_encoder_table_size;
+
+	*vptr = atoi(args[1]);
+	if (*vptr < 0 || *vptr > 65536) {
+		memprintf(err, "'%s' expects a numeric value between 0 and 65536.", args[0]);
+		return -1;
+	}
+	return 0;
+}
+
 /* config parser for global "tune.h2.{be.,fe.,}initial-window-size" */
 static int h2_parse_initial_window_size(char **args, int section_type, struct proxy *curpx,
                                         const struct proxy *defpx, const char *file, int line,
@@ -7749,6 +8273,37 @@ static int h2_parse_initial_window_size(char **args, int section_type, struct pr
 	return 0;
 }
 
+/* config parser for global "tune.h2.{be.,fe.,}max-window-size" */
+static int h2_parse_max_window_size(char **args, int section_type, struct proxy *curpx,
+                                    const struct proxy *defpx, const char *file, int line,
+                                    char **err)
+{
+	const char *res;
+	uint size;
+	int *vptr;
+
+	if (too_many_args(1, args, err, NULL))
+		return -1;
+
+	/* backend/frontend/default */
+	vptr = (args[0][8] == 'b') ? &h2_be_settings_max_window_size :
+	       (args[0][8] == 'f') ? &h2_fe_settings_max_window_size :
+	       &h2_settings_max_window_size;
+
+	res = parse_size_err(args[1], &size);
+	if (res != NULL) {
+		memprintf(err, "unexpected '%s' after size passed to '%s'", res, args[0]);
+		return -1;
+	}
+
+	if (size > 0x7FFFFFFF) {
+		memprintf(err, "'%s' expects a size no larger than 2147483647 bytes.", args[0]);
+		return -1;
+	}
+	*vptr = size;
+	return 0;
+}
+
 /* config parser for global "tune.h2.{be.,fe.,}max-concurrent-streams" */
 static int h2_parse_max_concurrent_streams(char **args, int section_type, struct proxy *curpx,
                                            const struct proxy *defpx, const char *file, int line,
@@ -7867,17 +8422,23 @@ INITCALL1(STG_REGISTER, register_mux_proto, &mux_proto_h2);
 
 /* config keyword parsers */
 static struct cfg_kw_list cfg_kws = {ILH, {
+	{ CFG_GLOBAL, "tune.h2.be.encoder-table-size",  h2_parse_encoder_table_size     },
 	{ CFG_GLOBAL, "tune.h2.be.glitches-threshold",  h2_parse_glitches_threshold     },
 	{ CFG_GLOBAL, "tune.h2.be.initial-window-size", h2_parse_initial_window_size    },
 	{ CFG_GLOBAL, "tune.h2.be.max-concurrent-streams", h2_parse_max_concurrent_streams },
+	{ CFG_GLOBAL, "tune.h2.be.max-window-size",     h2_parse_max_window_size        },
+	{ CFG_GLOBAL, "tune.h2.fe.encoder-table-size",  h2_parse_encoder_table_size     },
 	{ CFG_GLOBAL, "tune.h2.fe.glitches-threshold",  h2_parse_glitches_threshold     },
 	{ CFG_GLOBAL, "tune.h2.fe.initial-window-size", h2_parse_initial_window_size    },
 	{ CFG_GLOBAL, "tune.h2.fe.max-concurrent-streams", h2_parse_max_concurrent_streams },
 	{ CFG_GLOBAL, "tune.h2.fe.max-total-streams",   h2_parse_max_total_streams      },
+	{ CFG_GLOBAL, "tune.h2.fe.max-window-size",     h2_parse_max_window_size        },
+	{ CFG_GLOBAL, "tune.h2.encoder-table-size",     h2_parse_encoder_table_size     },
 	{ CFG_GLOBAL, "tune.h2.header-table-size",      h2_parse_header_table_size      },
 	{ CFG_GLOBAL, "tune.h2.initial-window-size",    h2_parse_initial_window_size    },
 	{ CFG_GLOBAL, "tune.h2.max-concurrent-streams", h2_parse_max_concurrent_streams },
 	{ CFG_GLOBAL, "tune.h2.max-frame-size",         h2_parse_max_frame_size         },
+	{ CFG_GLOBAL, "tune.h2.max-window-size",        h2_parse_max_window_size        },
 	{ CFG_GLOBAL, "tune.h2.zero-copy-fwd-send",     h2_parse_zero_copy_fwd_snd },
 	{ 0, NULL, NULL }
 }};
@@ -9,6 +9,7 @@
 #include <haproxy/dynbuf.h>
 #include <haproxy/global-t.h>
 #include <haproxy/h3.h>
+#include <haproxy/http.h>
 #include <haproxy/list.h>
 #include <haproxy/ncbuf.h>
 #include <haproxy/pool.h>
@@ -22,6 +23,8 @@
 #include <haproxy/quic_sock.h>
 #include <haproxy/quic_stream.h>
 #include <haproxy/quic_tp-t.h>
+#include <haproxy/server.h>
+#include <haproxy/session.h>
 #include <haproxy/ssl_sock-t.h>
 #include <haproxy/stconn.h>
 #include <haproxy/time.h>
@@ -114,6 +117,7 @@ static struct qcs *qcs_new(struct qcc *qcc, uint64_t id, enum qcs_type type)
 	 */
 	LIST_INIT(&qcs->el_opening);
 	LIST_INIT(&qcs->el_send);
+	http_prio_init(&qcs->prio);
 	LIST_INIT(&qcs->el_fctl);
 	LIST_INIT(&qcs->el_buf);
 	qcs->start = TICK_ETERNITY;
@@ -233,6 +237,16 @@ static forceinline void qcc_rm_hreq(struct qcc *qcc)
 		qcc_reset_idle_start(qcc);
 }
 
+/* Returns the number of local bidirectional streams which can still be opened
+ * on <qcc> according to the peer limit.
+ */
+static inline uint64_t qcc_bidi_l_left(const struct qcc *qcc)
+{
+	const uint64_t opened = qcc->next_bidi_l >> QCS_ID_TYPE_SHIFT;
+
+	return qcc->rfctl.ms_bidi > opened ? qcc->rfctl.ms_bidi - opened : 0;
+}
+
 static inline int qcc_is_dead(const struct qcc *qcc)
 {
 	/* Maintain connection if stream endpoints are still active. */
@@ -249,6 +263,14 @@ static inline int qcc_is_dead(const struct qcc *qcc)
 		return 1;
 	}
 
+	/* Backend connections are kept idle for reuse only as long as new
+	 * streams may still be opened.
+	 */
+	if (conn_is_back(qcc->conn) &&
+	    (qcc->flags & QC_CF_CONN_SHUT || !qcc_bidi_l_left(qcc))) {
+		return 1;
+	}
+
 	return 0;
 }
 
@@ -594,6 +616,15 @@ void qcc_set_error(struct qcc *qcc, int err, int app)
 	tasklet_wakeup(qcc->wait_event.tasklet);
 }
 
+/* Wake up <qcc> I/O handler. This is useful for the application layer when it
+ * emits data outside of the stream layer context, or to retry the decoding of
+ * streams which were blocked on a connection-wide condition.
+ */
+void qcc_wakeup(struct qcc *qcc)
+{
+	tasklet_wakeup(qcc->wait_event.tasklet);
+}
+
 /* Increment glitch counter for <qcc> connection by <inc> steps. If configured
  * threshold reached, close the connection with an error code.
  */
@@ -794,6 +825,50 @@ struct stconn *qcs_attach_sc(struct qcs *qcs, struct buffer *buf, char fin)
 	return qcs->sd->sc;
 }
 
+/* Open a new local bidirectional stream on <qcc> backend connection for <sc>
+ * stream connector. Its stream endpoint descriptor is replaced by the one of
+ * <sc>.
+ *
+ * Returns the allocated stream instance or NULL on error.
+ */
+static struct qcs *qcc_bck_stream_new(struct qcc *qcc, struct stconn *sc)
+{
+	struct qcs *qcs;
+
+	TRACE_ENTER(QMUX_EV_QCS_NEW, qcc->conn);
+
+	if (!qcc_bidi_l_left(qcc)) {
+		TRACE_ERROR("no more streams left", QMUX_EV_QCS_NEW, qcc->conn);
+		goto err;
+	}
+
+	qcs = qcc_init_stream_local(qcc, 1);
+	if (!qcs) {
+		TRACE_ERROR("stream allocation failure", QMUX_EV_QCS_NEW, qcc->conn);
+		goto err;
+	}
+
+	if (sc_attach_mux(sc, qcs, qcc->conn) < 0) {
+		TRACE_ERROR("cannot attach stream connector", QMUX_EV_QCS_NEW, qcc->conn, qcs);
+		qcs_free(qcs);
+		goto err;
+	}
+
+	/* Use stream connector endpoint instead of the one allocated by qcs_new(). */
+	sedesc_free(qcs->sd);
+	qcs->sd = sc->sedesc;
+	if (!(global.tune.no_zero_copy_fwd & NO_ZERO_COPY_FWD_QUIC_SND))
+		se_fl_set(qcs->sd, SE_FL_MAY_FASTFWD_CONS);
+	++qcc->nb_sc;
+
+	TRACE_LEAVE(QMUX_EV_QCS_NEW, qcc->conn, qcs);
+	return qcs;
+
+ err:
+	TRACE_DEVEL("leaving on error", QMUX_EV_QCS_NEW, qcc->conn);
+	return NULL;
+}
+
 /* Use this function for a stream <id> which is not in <qcc> stream tree. It
  * returns true if the associated stream is closed.
  */
@@ -977,6 +1052,13 @@ static int qcc_decode_qcs(struct qcc *qcc, struct qcs *qcs)
 
 	TRACE_ENTER(QMUX_EV_QCS_RECV, qcc->conn, qcs);
 
+	/* Data are retrieved directly by the stream layer via fast-forward. */
+	if (qcs->flags & QC_SF_RX_FASTFWD) {
+		TRACE_DATA("data left for fast-forward", QMUX_EV_QCS_RECV, qcc->conn, qcs);
+		qcs_notify_recv(qcs);
+		goto end;
+	}
+
 	b = qcs_b_dup(&qcs->rx.ncbuf);
 
 	/* Signal FIN to application if STREAM FIN received with all data. */
@@ -1007,6 +1089,7 @@ static int qcc_decode_qcs(struct qcc *qcc, struct qcs *qcs)
 	if (ret || (!b_data(&b) && fin))
 		qcs_notify_recv(qcs);
 
+ end:
 	TRACE_LEAVE(QMUX_EV_QCS_RECV, qcc->conn, qcs);
 	return 0;
 
@@ -1015,6 +1098,18 @@ static int qcc_decode_qcs(struct qcc *qcc, struct qcs *qcs)
 	return 1;
 }
 
+/* Stop the fast-forward of data received on <qcs>. Data left in its Rx buffer
+ * are immediately demultiplexed so that they can be retrieved via rcv_buf.
+ */
+static void qcs_stop_rx_fastfwd(struct qcs *qcs)
+{
+	TRACE_STATE("stop fast-forward of received data", QMUX_EV_QCS_RECV, qcs->qcc->conn, qcs);
+
+	qcs->flags &= ~QC_SF_RX_FASTFWD;
+	if (ncb_data(&qcs->rx.ncbuf, 0) || qcs_is_close_remote(qcs))
+		qcc_decode_qcs(qcs->qcc, qcs);
+}
+
 /* Allocate if needed and retrieve <qcs> stream buffer for data reception.
  *
  * Returns buffer pointer. May be NULL on allocation failure.
@@ -1233,6 +1328,43 @@ void qcc_reset_stream(struct qcs *qcs, int err)
 	tasklet_wakeup(qcc->wait_event.tasklet);
 }
 
+/* Appends <qcs> to its connection send_list. On the frontend side, unless
+ * disabled by "tune.http.priorities", bidirectional streams are ordered by
+ * their RFC 9218 priority so that the most urgent ones are the first to be
+ * granted the connection window, and incremental ones of the same urgency are
+ * served in round-robin. Unidirectional streams are never overtaken. <qcs>
+ * must not be in the list yet.
+ */
+static void qcs_queue_send(struct qcs *qcs)
+{
+	struct qcc *qcc = qcs->qcc;
+	struct qcs *cur;
+
+	if (global.tune.http_priorities && !conn_is_back(qcc->conn) &&
+	    quic_stream_is_bidi(qcs->id)) {
+		list_for_each_entry(cur, &qcc->send_list, el_send) {
+			if (quic_stream_is_bidi(cur->id) &&
+			    http_prio_before(&qcs->prio, qcs->id, &cur->prio, cur->id)) {
+				/* insert just before <cur> */
+				LIST_APPEND(&cur->el_send, &qcs->el_send);
+				return;
+			}
+		}
+	}
+	LIST_APPEND(&qcc->send_list, &qcs->el_send);
+}
+
+/* Moves all streams from <list> back to their connection send_list. */
+static void qcs_requeue_send(struct list *list)
+{
+	struct qcs *qcs, *qcs_tmp;
+
+	list_for_each_entry_safe(qcs, qcs_tmp, list, el_send) {
+		LIST_DEL_INIT(&qcs->el_send);
+		qcs_queue_send(qcs);
+	}
+}
+
 /* Register <qcs> stream for emission of STREAM, STOP_SENDING or RESET_STREAM.
  * Set <urg> to 1 if stream content should be treated in priority compared to
  * other streams. For STREAM emission, <count> must contains the size of the
@@ -1253,7 +1385,7 @@ void qcc_send_stream(struct qcs *qcs, int urg, int count)
 	}
 	else {
 		if (!LIST_INLIST(&qcs->el_send))
-			LIST_APPEND(&qcs->qcc->send_list, &qcs->el_send);
+			qcs_queue_send(qcs);
 	}
 
 	if (count) {
@@ -1557,6 +1689,26 @@ int qcc_recv_max_stream_data(struct qcc *qcc, uint64_t id, uint64_t max)
 	return 1;
 }
 
+/* Handle a new MAX_STREAMS_BIDI frame. <max> must contains the maximum streams
+ * field of the frame. Only the limit on local bidirectional streams is used
+ * as unidirectional ones are all opened on connection startup.
+ *
+ * Returns 0 on success else non-zero.
+ */
+int qcc_recv_max_streams_bidi(struct qcc *qcc, uint64_t max)
+{
+	TRACE_ENTER(QMUX_EV_QCC_RECV, qcc->conn);
+
+	TRACE_PROTO("receiving MAX_STREAMS_BIDI", QMUX_EV_QCC_RECV, qcc->conn);
+	if (max > qcc->rfctl.ms_bidi) {
+		TRACE_DATA("increase remote max-streams-bidi", QMUX_EV_QCC_RECV, qcc->conn);
+		qcc->rfctl.ms_bidi = max;
+	}
+
+	TRACE_LEAVE(QMUX_EV_QCC_RECV, qcc->conn);
+	return 0;
+}
+
 /* Handle a new RESET_STREAM frame from stream ID <id> with error code <err>
  * and final stream size <final_size>.
  *
@@ -2204,7 +2356,9 @@ static int qcc_io_send(struct qcc *qcc)
 	struct list frms = LIST_HEAD_INIT(frms);
 	/* Temporary list for QCS on error. */
 	struct list qcs_failed = LIST_HEAD_INIT(qcs_failed);
-	struct qcs *qcs, *qcs_tmp, *first_qcs = NULL;
+	/* Temporary list for QCS which transferred some bytes. */
+	struct list qcs_sent = LIST_HEAD_INIT(qcs_sent);
+	struct qcs *qcs, *qcs_tmp;
 	uint64_t window_conn = qfctl_rcap(&qcc->tx.fc);
 	int ret, total = 0, resent;
 
@@ -2248,10 +2402,6 @@ static int qcc_io_send(struct qcc *qcc)
 
 	/* Send STREAM/STOP_SENDING/RESET_STREAM data for registered streams. */
 	list_for_each_entry_safe(qcs, qcs_tmp, &qcc->send_list, el_send) {
-		/* Check if all QCS were processed. */
-		if (qcs == first_qcs)
-			break;
-
 		/* Stream must not be present in send_list if it has nothing to send. */
 		BUG_ON(!(qcs->flags & (QC_SF_FIN_STREAM|QC_SF_TO_STOP_SENDING|QC_SF_TO_RESET)) &&
 		       (!qcs->stream || !qcs_prep_bytes(qcs)));
@@ -2304,17 +2454,17 @@ static int qcc_io_send(struct qcc *qcc)
 
 			total += ret;
 			if (ret) {
-				/* Move QCS with some bytes transferred at the
-				 * end of send-list for next iterations.
+				/* Move QCS with some bytes transferred aside.
+				 * They are requeued once the whole send-list
+				 * was processed, at the end of their priority
+				 * level, for next iterations.
 				 */
 				LIST_DEL_INIT(&qcs->el_send);
-				LIST_APPEND(&qcc->send_list, &qcs->el_send);
-				/* Remember first moved QCS as checkpoint to interrupt loop */
-				if (!first_qcs)
-					first_qcs = qcs;
+				LIST_APPEND(&qcs_sent, &qcs->el_send);
 			}
 		}
 	}
+	qcs_requeue_send(&qcs_sent);
 
 	/* Retry sending until no frame to send, data rejected or connection
 	 * flow-control limit reached.
@@ -2358,12 +2508,12 @@ static int qcc_io_send(struct qcc *qcc)
 			qc_frm_free(qcc->conn->handle.qc, &frm);
 	}
 
+	/* Re-insert QCS left aside on early sending interruption. */
+	qcs_requeue_send(&qcs_sent);
+
 	/* Re-insert on-error QCS at the end of the send-list. */
 	if (!LIST_ISEMPTY(&qcs_failed)) {
-		list_for_each_entry_safe(qcs, qcs_tmp, &qcs_failed, el_send) {
-			LIST_DEL_INIT(&qcs->el_send);
-			LIST_APPEND(&qcc->send_list, &qcs->el_send);
-		}
+		qcs_requeue_send(&qcs_failed);
 
 		if (!qfctl_rblocked(&qcc->tx.fc))
 			tasklet_wakeup(qcc->wait_event.tasklet);
@@ -2405,7 +2555,8 @@ static int qcc_io_recv(struct qcc *qcc)
 		qcs = eb64_entry(node, struct qcs, by_id);
 		id = qcs->id;
 
-		if (!ncb_data(&qcs->rx.ncbuf, 0) || (qcs->flags & QC_SF_DEM_FULL)) {
+		if (!ncb_data(&qcs->rx.ncbuf, 0) ||
+		    (qcs->flags & (QC_SF_DEM_FULL|QC_SF_RX_FASTFWD))) {
 			node = eb64_next(node);
 			continue;
 		}
@@ -2504,7 +2655,8 @@ static void qcc_shutdown(struct qcc *qcc)
 }
 
 /* Loop through all qcs from <qcc>. Report error on stream endpoint if
- * connection on error and wake them.
+ * connection on error and wake them. On backend side, streams are also woken
+ * to be notified about the connection establishment.
  */
 static int qcc_wake_some_streams(struct qcc *qcc)
 {
@@ -2525,6 +2677,9 @@ static int qcc_wake_some_streams(struct qcc *qcc)
 			se_fl_set_error(qcs->sd);
 			qcs_alert(qcs);
 		}
+		else if (conn_is_back(qcc->conn)) {
+			qcs_alert(qcs);
+		}
 	}
 
 	return 0;
@@ -2742,6 +2897,8 @@ static int qmux_init(struct connection *conn, struct proxy *prx,
 {
 	struct qcc *qcc;
 	struct quic_transport_params *lparams, *rparams;
+	/* On backend side, the stream connector is the initial context. */
+	struct stconn *sc = conn_is_back(conn) ? conn->ctx : NULL;
 
 	TRACE_ENTER(QMUX_EV_QCC_NEW);
 
@@ -2773,6 +2930,7 @@ static int qmux_init(struct connection *conn, struct proxy *prx,
 
 	rparams = &conn->handle.qc->tx.params;
 	qfctl_init(&qcc->tx.fc, rparams->initial_max_data);
+	qcc->rfctl.ms_bidi = rparams->initial_max_streams_bidi;
 	qcc->rfctl.msd_bidi_l = rparams->initial_max_stream_data_bidi_local;
 	qcc->rfctl.msd_bidi_r = rparams->initial_max_stream_data_bidi_remote;
 	qcc->rfctl.msd_uni_l = rparams->initial_max_stream_data_uni;
@@ -2844,12 +3002,17 @@ static int qmux_init(struct connection *conn, struct proxy *prx,
 		goto err;
 	}
 
-	if (qcc->app_ops == &h3_ops)
-		proxy_inc_fe_cum_sess_ver_ctr(sess->listener, prx, 3);
+	if (!conn_is_back(conn)) {
+		if (qcc->app_ops == &h3_ops)
+			proxy_inc_fe_cum_sess_ver_ctr(sess->listener, prx, 3);
 
-	/* Register conn for idle front closing. This is done once everything is allocated. */
-	if (!conn_is_back(conn))
+		/* Register conn for idle front closing. This is done once everything is allocated. */
 		LIST_APPEND(&mux_stopping_data[tid].list, &conn->stopping_list);
+	}
+	else if (sc && !qcc_bck_stream_new(qcc, sc)) {
+		TRACE_ERROR("cannot open backend stream", QMUX_EV_QCC_NEW|QMUX_EV_QCC_ERR, conn);
+		goto err;
+	}
 
 	/* init read cycle */
 	tasklet_wakeup(qcc->wait_event.tasklet);
@@ -2875,6 +3038,57 @@ static int qmux_init(struct connection *conn, struct proxy *prx,
 	return -1;
 }
 
+/* Returns the number of streams which can still be attached to <conn>
+ * backend connection.
+ */
+static int qmux_avail_streams(struct connection *conn)
+{
+	struct server *srv = objt_server(conn->target);
+	struct qcc *qcc = conn->ctx;
+	uint64_t opened, ret;
+
+	if (qcc->flags & (QC_CF_ERR_CONN|QC_CF_ERRL|QC_CF_APP_SHUT|QC_CF_CONN_SHUT))
+		return 0;
+
+	ret = MIN(qcc_bidi_l_left(qcc), INT_MAX);
+	if (ret && srv && srv->max_reuse >= 0) {
+		opened = qcc->next_bidi_l >> QCS_ID_TYPE_SHIFT;
+		ret = MIN(ret, opened <= srv->max_reuse ? srv->max_reuse - opened + 1 : 0);
+	}
+	return ret;
+}
+
+/* Returns the number of streams in use on <conn>. */
+static int qmux_used_streams(struct connection *conn)
+{
+	struct qcc *qcc = conn->ctx;
+
+	return qcc->nb_sc;
+}
+
+/* Attach a new stream to <conn> backend connection for <sd> stream endpoint.
+ * Returns 0 on success else -1.
+ */
+static int qmux_attach(struct connection *conn, struct sedesc *sd, struct session *sess)
+{
+	struct qcc *qcc = conn->ctx;
+	struct qcs *qcs;
+
+	TRACE_ENTER(QMUX_EV_QCS_NEW, conn);
+
+	qcs = qcc_bck_stream_new(qcc, sd->sc);
+	if (!qcs) {
+		TRACE_DEVEL("leaving on stream creation failure", QMUX_EV_QCS_NEW, conn);
+		return -1;
+	}
+
+	/* the connection is not idle anymore */
+	qcc_refresh_timeout(qcc);
+
+	TRACE_LEAVE(QMUX_EV_QCS_NEW, conn, qcs);
+	return 0;
+}
+
 static void qmux_destroy(void *ctx)
 {
 	struct qcc *qcc = ctx;
@@ -2914,6 +3128,55 @@ static void qmux_strm_detach(struct sedesc *sd)
 
 	qcs_destroy(qcs);
 
+	if (conn_is_back(qcc->conn) && !qcc_is_dead(qcc)) {
+		struct connection *conn = qcc->conn;
+
+		if (conn->flags & CO_FL_PRIVATE) {
+			/* Add the connection in the session server list, if not
+			 * already done. A private connection is only used by the
+			 * session which owns it.
+			 */
+			if (!conn->owner || !session_add_conn(conn->owner, conn, conn->target)) {
+				conn->owner = NULL;
+				if (!qcc->nb_sc) {
+					TRACE_DEVEL("cannot own connection, releasing it", QMUX_EV_STRM_END, conn);
+					goto release;
+				}
+			}
+			else if (!qcc->nb_sc) {
+				if (session_check_idle_conn(conn->owner, conn) != 0) {
+					/* the connection was either released or moved to the server idle list */
+					TRACE_DEVEL("leaving without reusable idle connection", QMUX_EV_STRM_END);
+					return;
+				}
+			}
+		}
+		else if (!qcc->nb_sc) {
+			/* If the connection is owned by the session, first remove
+			 * it from its list.
+			 */
+			if (conn->owner) {
+				session_unown_conn(conn->owner, conn);
+				conn->owner = NULL;
+			}
+
+			if (!srv_add_to_idle_list(objt_server(conn->target), conn, 1)) {
+				TRACE_DEVEL("connection refused by idle list, releasing it", QMUX_EV_STRM_END, conn);
+				goto release;
+			}
+
+			/* Idle connections are never taken over by other
+			 * threads, so the connection may still be used below.
+			 */
+			TRACE_DEVEL("reusable idle connection", QMUX_EV_STRM_END, conn);
+		}
+		else if (!conn->hash_node->node.node.leaf_p &&
+		         qmux_avail_streams(conn) > 0 && objt_server(conn->target) &&
+		         !LIST_INLIST(&conn->sess_el)) {
+			srv_add_to_avail_list(__objt_server(conn->target), conn);
+		}
+	}
+
 	if (qcc_is_dead(qcc)) {
 		TRACE_STATE("killing dead connection", QMUX_EV_STRM_END, qcc->conn);
 		goto release;
@@ -2944,6 +3207,10 @@ static size_t qmux_strm_rcv_buf(struct stconn *sc, struct buffer *buf,
 
 	TRACE_ENTER(QMUX_EV_STRM_RECV, qcc->conn, qcs);
 
+	/* Data left for fast-forward must now be converted to HTX. */
+	if (qcs->flags & QC_SF_RX_FASTFWD)
+		qcs_stop_rx_fastfwd(qcs);
+
 	ret = qcs_http_rcv_buf(qcs, buf, count, &fin);
 
 	if (b_data(&qcs->rx.app_buf)) {
@@ -2983,6 +3250,16 @@ static size_t qmux_strm_rcv_buf(struct stconn *sc, struct buffer *buf,
 			se_fl_set(qcs->sd, SE_FL_ERROR);
 		}
 
+		/* Next payload may be fast-forwarded without HTX conversion. */
+		if (!se_fl_test(qcs->sd, SE_FL_EOI|SE_FL_EOS|SE_FL_ERROR) &&
+		    qcc->app_ops->rcv_ff &&
+		    !(global.tune.no_zero_copy_fwd & NO_ZERO_COPY_FWD_QUIC_RCV)) {
+			se_fl_set(qcs->sd, SE_FL_MAY_FASTFWD_PROD);
+		}
+		else {
+			se_fl_clr(qcs->sd, SE_FL_MAY_FASTFWD_PROD);
+		}
+
 		if (b_size(&qcs->rx.app_buf)) {
 			b_free(&qcs->rx.app_buf);
 			offer_buffers(NULL, 1);
@@ -3006,6 +3283,95 @@ static size_t qmux_strm_rcv_buf(struct stconn *sc, struct buffer *buf,
 	return ret;
 }
 
+/* Called from the upper layer to fast-forward up to <count> bytes of data
+ * received on <sc> stream directly to the opposite endpoint, without HTX
+ * conversion. Returns the number of forwarded bytes or a negative value if data
+ * must be retrieved via rcv_buf first.
+ */
+static int qmux_strm_fastfwd(struct stconn *sc, unsigned int count, unsigned int flags)
+{
+	struct qcs *qcs = __sc_mux_strm(sc);
+	struct qcc *qcc = qcs->qcc;
+	struct sedesc *sdo = NULL;
+	struct buffer b;
+	size_t try, ret, data, total = 0;
+	int fin;
+
+	TRACE_ENTER(QMUX_EV_STRM_RECV, qcc->conn, qcs);
+
+	/* HTX data already demultiplexed must be retrieved first. */
+	if (b_data(&qcs->rx.app_buf)) {
+		TRACE_STATE("HTX data pending, cannot fast-forward", QMUX_EV_STRM_RECV, qcc->conn, qcs);
+		TRACE_LEAVE(QMUX_EV_STRM_RECV, qcc->conn, qcs);
+		return -1;
+	}
+
+	se_fl_clr(qcs->sd, SE_FL_RCV_MORE | SE_FL_WANT_ROOM);
+
+	if (qcs->flags & QC_SF_READ_ABORTED) {
+		TRACE_STATE("stream read aborted", QMUX_EV_STRM_RECV, qcc->conn, qcs);
+		goto stop;
+	}
+
+	sdo = se_opposite(qcs->sd);
+	if (!sdo) {
+		TRACE_STATE("Opposite endpoint not available yet", QMUX_EV_STRM_RECV, qcc->conn, qcs);
+		goto end;
+	}
+
+	/* From now on, received data are left in Rx buffer by the demux. */
+	qcs->flags |= QC_SF_RX_FASTFWD;
+
+	b = qcs_b_dup(&qcs->rx.ncbuf);
+	fin = qcs_is_close_remote(qcs);
+	if (!b_data(&b) && !fin)
+		goto end;
+
+	try = se_nego_ff(sdo, &BUF_NULL, count, NEGO_FF_FL_NONE);
+	if (sdo->iobuf.flags & IOBUF_FL_NO_FF) {
+		/* Fast forwarding is not supported by the consumer */
+		TRACE_DEVEL("Fast-forwarding not supported by opposite endpoint, disable it", QMUX_EV_STRM_RECV, qcc->conn, qcs);
+		goto stop;
+	}
+	if (sdo->iobuf.flags & IOBUF_FL_FF_BLOCKED) {
+		se_fl_set(qcs->sd, SE_FL_RCV_MORE | SE_FL_WANT_ROOM);
+		TRACE_STATE("waiting for more room", QMUX_EV_STRM_RECV, qcc->conn, qcs);
+		goto end;
+	}
+
+	b_add(sdo->iobuf.buf, sdo->iobuf.offset);
+	data = b_data(sdo->iobuf.buf);
+	ret = qcc->app_ops->rcv_ff(qcs, &b, sdo->iobuf.buf, try, fin);
+	total = b_data(sdo->iobuf.buf) - data;
+	b_sub(sdo->iobuf.buf, sdo->iobuf.offset);
+	sdo->iobuf.data += total;
+
+	if (ret)
+		qcs_consume(qcs, ret);
+	se_done_ff(sdo);
+	TRACE_DEVEL("data fast-forwarded", QMUX_EV_STRM_RECV, qcc->conn, qcs);
+
+	if (qcs->flags & QC_SF_TO_RESET) {
+		if (!se_fl_test(qcs->sd, SE_FL_ERROR|SE_FL_ERR_PENDING))
+			se_fl_set_error(qcs->sd);
+		goto stop;
+	}
+
+	/* Interrupted by the application layer. */
+	if (!(qcs->flags & QC_SF_RX_FASTFWD))
+		goto stop;
+
+ end:
+	TRACE_LEAVE(QMUX_EV_STRM_RECV, qcc->conn, qcs);
+	return total;
+
+ stop:
+	se_fl_clr(qcs->sd, SE_FL_MAY_FASTFWD_PROD);
+	qcs_stop_rx_fastfwd(qcs);
+	TRACE_LEAVE(QMUX_EV_STRM_RECV, qcc->conn, qcs);
+	return total;
+}
+
 static size_t qmux_strm_snd_buf(struct stconn *sc, struct buffer *buf,
                                 size_t count, int flags)
 {
@@ -3289,6 +3655,11 @@ static int qmux_ctl(struct connection *conn, enum mux_ctl_type mux_ctl, void *ou
 	struct qcc *qcc = conn->ctx;
 
 	switch (mux_ctl) {
+	case MUX_CTL_STATUS:
+		if (!(qcc->flags & (QC_CF_ERR_CONN|QC_CF_ERRL)))
+			return MUX_STATUS_READY;
+		return 0;
+
 	case MUX_CTL_EXIT_STATUS:
 		return MUX_ES_UNKNOWN;
 
@@ -3383,12 +3754,16 @@ static const struct mux_ops qmux_ops = {
 	.detach      = qmux_strm_detach,
 	.rcv_buf     = qmux_strm_rcv_buf,
 	.snd_buf     = qmux_strm_snd_buf,
+	.fastfwd     = qmux_strm_fastfwd,
 	.nego_fastfwd = qmux_strm_nego_ff,
 	.done_fastfwd = qmux_strm_done_ff,
 	.resume_fastfwd = qmux_strm_resume_ff,
 	.subscribe   = qmux_strm_subscribe,
 	.unsubscribe = qmux_strm_unsubscribe,
 	.wake        = qmux_wake,
+	.attach      = qmux_attach,
+	.avail_streams = qmux_avail_streams,
+	.used_streams = qmux_used_streams,
 	.shut       = qmux_strm_shut,
 	.ctl         = qmux_ctl,
 	.sctl        = qmux_sctl,
@@ -3422,6 +3797,6 @@ void qcc_show_quic(struct qcc *qcc)
 }
 
 static struct mux_proto_list mux_proto_quic =
-  { .token = IST("quic"), .mode = PROTO_MODE_HTTP, .side = PROTO_SIDE_FE, .mux = &qmux_ops };
+  { .token = IST("quic"), .mode = PROTO_MODE_HTTP, .side = PROTO_SIDE_BOTH, .mux = &qmux_ops };
 
 INITCALL1(STG_REGISTER, register_mux_proto, &mux_proto_quic);
@@ -42,6 +42,7 @@
 #include <haproxy/proto_quic.h>
 #include <haproxy/proto_udp.h>
 #include <haproxy/proxy-t.h>
+#include <haproxy/quic_cid.h>
 #include <haproxy/quic_conn.h>
 #include <haproxy/quic_sock.h>
 #include <haproxy/sock.h>
@@ -59,8 +60,10 @@ DECLARE_STATIC_POOL(pool_head_quic_rxbuf, "quic_rxbuf", QUIC_RX_BUFSZ);
 
 static int quic_bind_listener(struct listener *listener, char *errmsg, int errlen);
 static int quic_connect_server(struct connection *conn, int flags);
+static int quic_conn_init_client(struct connection *conn, int fd);
 static void quic_enable_listener(struct listener *listener);
 static void quic_disable_listener(struct listener *listener);
+static void quic_unbind_listener(struct listener *l);
 static int quic_bind_tid_prep(struct connection *conn, int new_tid);
 static void quic_bind_tid_commit(struct connection *conn);
 static void quic_bind_tid_reset(struct connection *conn);
@@ -76,7 +79,7 @@ struct protocol proto_quic4 = {
 	.enable         = quic_enable_listener,
 	.disable        = quic_disable_listener,
 	.add            = default_add_listener,
-	.unbind         = default_unbind_listener,
+	.unbind         = quic_unbind_listener,
 	.suspend        = default_suspend_listener,
 	.resume         = default_resume_listener,
 	.accept_conn    = quic_sock_accept_conn,
@@ -121,7 +124,7 @@ struct protocol proto_quic6 = {
 	.enable         = quic_enable_listener,
 	.disable        = quic_disable_listener,
 	.add            = default_add_listener,
-	.unbind         = default_unbind_listener,
+	.unbind         = quic_unbind_listener,
 	.suspend        = default_suspend_listener,
 	.resume         = default_resume_listener,
 	.accept_conn    = quic_sock_accept_conn,
@@ -466,18 +469,100 @@ int quic_connect_server(struct connection *conn, int flags)
 		conn->flags &= ~CO_FL_WAIT_L4_CONN;
 	}
 
-	conn_ctrl_init(conn);       /* registers the FD */
-	HA_ATOMIC_OR(&fdtab[fd].state, FD_LINGER_RISK);  /* close hard if needed */
-
-	if (conn->flags & CO_FL_WAIT_L4_CONN) {
-		fd_want_send(fd);
-		fd_cant_send(fd);
-		fd_cant_recv(fd);
+	/* The UDP socket is now bound to the server address. Allocate the
+	 * quic-conn which owns it and drives the handshake.
+	 */
+	if (!quic_conn_init_client(conn, fd)) {
+		port_range_release_port(fdinfo[fd].port_range, fdinfo[fd].local_port);
+		fdinfo[fd].port_range = NULL;
+		close(fd);
+		conn->handle.fd = -1;
+		conn->err_code = CO_ER_SSL_NO_MEM;
+		conn->flags |= CO_FL_ERROR;
+		return SF_ERR_RESOURCE;
 	}
 
 	return SF_ERR_NONE;  /* connection is OK */
 }
 
+/* Allocate and start the quic-conn for <conn> outgoing connection, using <fd>
+ * connected UDP socket. On success, <conn> becomes a FD-less connection owning
+ * the quic-conn, and <fd> is owned by this latter. The handshake is scheduled
+ * and <conn> waits for its completion.
+ *
+ * Returns 1 on success else 0. On error, <fd> must be closed by the caller.
+ */
+static int quic_conn_init_client(struct connection *conn, int fd)
+{
+	struct quic_connection_id *conn_id = NULL;
+	struct quic_conn *qc = NULL;
+	struct sockaddr_storage local_addr;
+	int new_tid;
+	socklen_t addrlen = sizeof(local_addr);
+	struct quic_cid dcid = { .len = QUIC_HAP_CID_LEN };
+	const struct quic_cid token_odcid = { .len = 0 };
+
+	if (getsockname(fd, (struct sockaddr *)&local_addr, &addrlen) == -1)
+		clear_addr(&local_addr);
+
+	if (global.tune.quic_pacing == QUIC_PACING_TXTIME && quic_sock_set_txtime(fd) < 0)
+		goto err;
+
+	/* RFC 9000 7.2. Negotiating Connection IDs
+	 *
+	 * When an Initial packet is sent by a client that has not previously
+	 * received an Initial or Retry packet from the server, the client
+	 * populates the Destination Connection ID field with an unpredictable
+	 * value.
+	 */
+	if (RAND_bytes(dcid.data, dcid.len) != 1)
+		goto err;
+
+	conn_id = new_quic_cid(NULL, NULL, NULL, NULL, NULL);
+	if (!conn_id)
+		goto err;
+
+	qc = qc_new_conn(qc_supported_version(QUIC_PROTOCOL_VERSION_1),
+	                 conn->dst->ss_family == AF_INET, &dcid, &conn_id->cid,
+	                 &token_odcid, conn_id, &local_addr, conn->dst, 0, 0, conn);
+	if (!qc) {
+		pool_free(pool_head_quic_connection_id, conn_id);
+		goto err;
+	}
+
+	/* A random CID collision is not expected but must not be fatal. */
+	if (quic_cid_insert(conn_id, &new_tid)) {
+		pool_free(pool_head_quic_connection_id, conn_id);
+		goto err;
+	}
+	eb64_insert(qc->cids, &conn_id->seq_num);
+	qc->next_cid_seq_num = 1;
+
+	/* The quic-conn now owns the socket. */
+	qc->fd = fd;
+	fd_insert(fd, qc, quic_conn_sock_fd_iocb, tgid, ti->ltid_bit);
+	fd_want_recv(fd);
+	_HA_ATOMIC_INC(&jobs);
+
+	conn->handle.qc = qc;
+	conn->flags |= CO_FL_FDLESS;
+	conn->xprt_ctx = qc->xprt_ctx;
+	conn_ctrl_init(conn);
+
+	/* The connection is usable only after the handshake completion. */
+	conn->flags &= ~CO_FL_WAIT_L4_CONN;
+	conn->flags |= CO_FL_SSL_WAIT_HS | CO_FL_WAIT_L6_CONN;
+
+	/* Emit the ClientHello. */
+	tasklet_wakeup(qc->wait_event.tasklet);
+	return 1;
+
+ err:
+	if (qc)
+		quic_conn_release(qc);
+	return 0;
+}
+
 /* Allocate the RX buffers for <l> listener.
  * Return 1 if succeeded, 0 if not.
  */
@@ -576,6 +661,22 @@ static int quic_test_socketopts(struct listener *l)
 #endif
 	}
 
+	/* Check for SO_TXTIME support, required to delegate pacing to the kernel. */
+	if (global.tune.quic_pacing == QUIC_PACING_TXTIME) {
+		if (fdtest < 0) {
+			fdtest = socket(rx->proto->fam->sock_domain,
+					rx->proto->sock_type, rx->proto->sock_prot);
+			if (fdtest < 0)
+				goto err;
+		}
+
+		if (quic_sock_set_txtime(fdtest) < 0) {
+			ha_alert("Your platform does not support SO_TXTIME. "
+			         "QUIC pacing will be performed by timers instead.\n");
+			global.tune.quic_pacing = QUIC_PACING_TIMER;
+		}
+	}
+
 	if (fdtest >= 0)
 		close(fdtest);
 	return ERR_NONE;
@@ -585,6 +686,220 @@ static int quic_test_socketopts(struct listener *l)
 	return ERR_FATAL;
 }
 
+/* Returns the number of UDP sockets bound to address <addr> in the current
+ * network namespace, or -1 if it cannot be determined. All the sockets of
+ * the same family bound to the same address with SO_REUSEPORT belong to the
+ * same reuseport group.
+ */
+static int quic_count_bound_socks(const struct sockaddr_storage *addr)
+{
+#if defined(__linux__)
+	char line[512], key[48];
+	uint32_t a[4];
+	size_t len;
+	FILE *f;
+	int ret = 0;
+
+	/* the kernel dumps the address as 32-bit words in host order */
+	if (addr->ss_family == AF_INET) {
+		memcpy(a, &((struct sockaddr_in *)addr)->sin_addr, 4);
+		snprintf(key, sizeof(key), "%08X:%04X", a[0], get_host_port(addr));
+		f = fopen("/proc/net/udp", "r");
+	}
+	else {
+		memcpy(a, &((struct sockaddr_in6 *)addr)->sin6_addr, 16);
+		snprintf(key, sizeof(key), "%08X%08X%08X%08X:%04X", a[0], a[1], a[2], a[3], get_host_port(addr));
+		f = fopen("/proc/net/udp6", "r");
+	}
+
+	if (!f)
+		return -1;
+
+	len = strlen(key);
+	while (fgets(line, sizeof(line), f)) {
+		/* "  sl: local_address rem_address ..." */
+		char *p = strchr(line, ':');
+
+		if (!p)
+			continue;
+		p++;
+		while (*p == ' ')
+			p++;
+		if (strncmp(p, key, len) == 0 && p[len] == ' ')
+			ret++;
+	}
+	fclose(f);
+	return ret;
+#else
+	return -1;
+#endif
+}
+
+/* Attach to the reuseport group of the socket of listener <l> the CID steering
+ * program built from the steering indexes and slots of the listeners of its
+ * bind line which share its address. Returns the setsockopt() result.
+ */
+static int quic_steer_update(struct listener *l)
+{
+	struct listener *li;
+	short map[256];
+	int i, nb = 0;
+
+	for (i = 0; i < 256; i++)
+		map[i] = -1;
+
+	list_for_each_entry(li, &l->bind_conf->listeners, by_bind) {
+		if (!(li->rx.flags & RX_F_QUIC_CID_STEER) ||
+		    ipcmp(&li->rx.addr, &l->rx.addr, 1) != 0)
+			continue;
+		map[li->rx.quic_steer_idx] = li->rx.quic_steer_pos;
+		if (li->rx.quic_steer_idx >= nb)
+			nb = li->rx.quic_steer_idx + 1;
+	}
+	return quic_sock_set_cid_steering(l->rx.fd, map, nb);
+}
+
+/* Enable the CID steering on listener <l>. The slot of its socket in the
+ * reuseport group of its address, which is stamped in all the CIDs of the
+ * connections it receives, is only known if the group was created by the
+ * listeners of this bind line, so the steering is refused if any other socket
+ * was bound to this address before, be it from another bind line, another
+ * process or an inherited one, or if another bind line will bind this address
+ * later. This also requires that the connections never leave the thread of
+ * the listener, thus that it is bound to a single thread. A warning is emitted
+ * if steering cannot be enabled, the datagrams being then redispatched between
+ * threads as usual. This is called under the protocol lock.
+ */
+static void quic_steer_listener(struct listener *l)
+{
+	struct bind_conf *bc = l->bind_conf;
+	struct protocol *protos[] = { &proto_quic4, &proto_quic6, &proto_udp4, &proto_udp6 };
+	struct receiver *rx;
+	struct listener *li;
+	const char *msg;
+	int idx = 0;
+	int i;
+
+	if (my_popcountl(l->rx.bind_thread) != 1 || (l->rx.flags & RX_F_MUST_DUP)) {
+		/* all the listeners of the bind line are in the same situation */
+		if (&l->by_bind != bc->listeners.n)
+			return;
+		msg = "listener bound to multiple threads (see 'shards by-thread')";
+		goto warn;
+	}
+
+	/* the listeners of the bind line are bound in turn, and a warning was
+	 * already emitted if steering was refused on a previous one.
+	 */
+	list_for_each_entry(li, &bc->listeners, by_bind) {
+		if (li == l || !(li->rx.flags & RX_F_BOUND) ||
+		    ipcmp(&li->rx.addr, &l->rx.addr, 1) != 0)
+			continue;
+		if (!(li->rx.flags & RX_F_QUIC_CID_STEER))
+			return;
+		idx++;
+	}
+
+	if (l->rx.flags & RX_F_INHERITED) {
+		msg = "inherited socket";
+		goto warn;
+	}
+
+	if (l->rx.settings->netns) {
+		msg = "not supported with 'namespace'";
+		goto warn;
+	}
+
+	for (i = 0; i < sizeof(protos) / sizeof(protos[0]); i++) {
+		list_for_each_entry(rx, &protos[i]->receivers, proto_list) {
+			li = LIST_ELEM(rx, struct listener *, rx);
+			if (li->bind_conf != bc && ipcmp(&rx->addr, &l->rx.addr, 1) == 0) {
+				msg = "address shared with another bind line";
+				goto warn;
+			}
+		}
+	}
+
+	if (idx > 255) {
+		msg = "too many listeners on the same address";
+		goto warn;
+	}
+
+	if (quic_count_bound_socks(&l->rx.addr) != idx + 1) {
+		msg = "address already bound by other sockets";
+		goto warn;
+	}
+
+	l->rx.quic_steer_idx = l->rx.quic_steer_pos = idx;
+	l->rx.flags |= RX_F_QUIC_CID_STEER;
+	if (quic_steer_update(l) < 0) {
+		l->rx.flags &= ~RX_F_QUIC_CID_STEER;
+		msg = strerror(errno);
+		goto warn;
+	}
+	return;
+
+ warn:
+	ha_warning("Proxy '%s': 'quic-cid-steering' ignored on bind '%s' at [%s:%d]: %s.\n",
+	           bc->frontend->id, bc->arg, bc->file, bc->line, msg);
+}
+
+/* Called once the socket of listener <l> which had CID steering enabled was
+ * closed. When a socket leaves a reuseport group, the kernel moves the last
+ * socket of the group to its slot, so the same is done on the slots of the
+ * other listeners of the bind line sharing this group and the steering program
+ * is rebuilt. If the group now holds sockets which are not known, for instance
+ * because the closed one is still open in another process, the steering is
+ * disabled on the whole group. Nothing is done in the master process, which
+ * does not own the group. This is called under the listener's lock.
+ */
+static void quic_unsteer_listener(struct listener *l)
+{
+	struct listener *li, *ref = NULL;
+	int nb = 0;
+
+	HA_ATOMIC_AND(&l->rx.flags, ~RX_F_QUIC_CID_STEER);
+	if (master)
+		return;
+
+	list_for_each_entry(li, &l->bind_conf->listeners, by_bind) {
+		if ((li->rx.flags & RX_F_QUIC_CID_STEER) && ipcmp(&li->rx.addr, &l->rx.addr, 1) == 0) {
+			ref = li;
+			nb++;
+		}
+	}
+
+	if (!ref)
+		return;
+
+	if (quic_count_bound_socks(&l->rx.addr) == nb) {
+		list_for_each_entry(li, &l->bind_conf->listeners, by_bind) {
+			if ((li->rx.flags & RX_F_QUIC_CID_STEER) && li->rx.quic_steer_pos == nb &&
+			    ipcmp(&li->rx.addr, &l->rx.addr, 1) == 0)
+				li->rx.quic_steer_pos = l->rx.quic_steer_pos;
+		}
+		if (quic_steer_update(ref) == 0)
+			return;
+	}
+
+	/* unknown group layout: fall back to the kernel hash */
+	list_for_each_entry(li, &l->bind_conf->listeners, by_bind) {
+		if (ipcmp(&li->rx.addr, &l->rx.addr, 1) == 0)
+			HA_ATOMIC_AND(&li->rx.flags, ~RX_F_QUIC_CID_STEER);
+	}
+	quic_sock_set_cid_steering(ref->rx.fd, NULL, 0);
+}
+
+/* Unbind listener <l>, then update the CID steering of its reuseport group if
+ * its socket was closed. Must be called under the listener's lock.
+ */
+static void quic_unbind_listener(struct listener *l)
+{
+	default_unbind_listener(l);
+	if ((l->rx.flags & RX_F_QUIC_CID_STEER) && !(l->rx.flags & RX_F_BOUND))
+		quic_unsteer_listener(l);
+}
+
 /* This function tries to bind a QUIC4/6 listener. It may return a warning or
  * an error message in <errmsg> if the message is at most <errlen> bytes long
  * (including '\0'). Note that <errmsg> may be NULL if <errlen> is also zero.
@@ -649,12 +964,21 @@ static int quic_bind_listener(struct listener *listener, char *errmsg, int errle
 	if (quic_test_socketopts(listener))
 		return ERR_FATAL;
 
+	if (global.tune.quic_pacing == QUIC_PACING_TXTIME && quic_sock_set_txtime(fd) < 0) {
+		ha_alert("Could not enable SO_TXTIME on QUIC listener socket. "
+		         "QUIC pacing will be performed by timers instead.\n");
+		global.tune.quic_pacing = QUIC_PACING_TIMER;
+	}
+
 	if (global.tune.frontend_rcvbuf)
 		setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &global.tune.frontend_rcvbuf, sizeof(global.tune.frontend_rcvbuf));
 
 	if (global.tune.frontend_sndbuf)
 		setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &global.tune.frontend_sndbuf, sizeof(global.tune.frontend_sndbuf));
 
+	if (listener->bind_conf->options & BC_O_QUIC_CID_STEER)
+		quic_steer_listener(listener);
+
 	listener_set_state(listener, LI_LISTEN);
 
  udp_return:
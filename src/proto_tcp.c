@@ -32,6 +32,7 @@
 #include <haproxy/api.h>
 #include <haproxy/arg.h>
 #include <haproxy/connection.h>
+#include <haproxy/cpuset.h>
 #include <haproxy/errors.h>
 #include <haproxy/fd.h>
 #include <haproxy/global.h>
@@ -632,6 +633,24 @@ int tcp_bind_listener(struct listener *listener, char *errmsg, int errlen)
 		setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &zero,
 		    sizeof(zero));
 #endif
+#if defined(SO_INCOMING_CPU) && defined(USE_CPU_AFFINITY)
+	if ((listener->bind_conf->options & BC_O_INCOMING_CPU) &&
+	    listener->rx.bind_thread && !atleast2(listener->rx.bind_thread)) {
+		/* A listener serving a single thread (e.g. "shards by-thread")
+		 * advertises the CPU this thread is bound to so that the kernel
+		 * (>= 6.2) prefers it among the reuseport group for connections
+		 * processed by this CPU.
+		 */
+		int cpu = cpu_map_thread_cpu(listener->rx.bind_tgroup, my_ffsl(listener->rx.bind_thread) - 1);
+
+		if (cpu >= 0 &&
+		    setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) == -1) {
+			chunk_appendf(msg, "%scannot set SO_INCOMING_CPU, (%s)", msg->data ? ", " : "",
+				      strerror(errno));
+			err |= ERR_WARN;
+		}
+	}
+#endif
 #if defined(TCP_FASTOPEN)
 	if (listener->bind_conf->options & BC_O_TCP_FO) {
 		/* TFO needs a queue length, let's use the configured backlog */
@@ -30,6 +30,7 @@
 #include <haproxy/mux_quic.h>
 #include <haproxy/qpack-t.h>
 #include <haproxy/qpack-dec.h>
+#include <haproxy/qpack-enc.h>
 #include <haproxy/qpack-tbl.h>
 #include <haproxy/hpack-huff.h>
 #include <haproxy/hpack-tbl.h>
@@ -93,15 +94,126 @@ static uint64_t qpack_get_varint(const unsigned char **buf, uint64_t *len_in, in
 	return 0;
 }
 
-/* Decode an encoder stream.
+/* Reads a string literal from <*raw> of <*len> bytes, whose length is encoded
+ * on a <b>-bit prefix preceded by the Huffman flag. Huffman-encoded strings are
+ * decoded into <tmp>, other ones point into <*raw>. On success, <str> is set,
+ * <raw> and <len> are updated past the string and 0 is returned. Otherwise a
+ * negative QPACK_RET_* code is returned, -QPACK_RET_TRUNCATED meaning that the
+ * string is incomplete.
+ */
+static int qpack_get_str(const unsigned char **raw, uint64_t *len, int b,
+                         struct buffer *tmp, struct ist *str)
+{
+	uint64_t slen;
+	int h;
+
+	if (!*len)
+		return -QPACK_RET_TRUNCATED;
+
+	h = **raw & (1 << b);
+	slen = qpack_get_varint(raw, len, b);
+	if (*len == (uint64_t)-1 || *len < slen)
+		return -QPACK_RET_TRUNCATED;
+
+	qpack_debug_printf(stderr, " h=%d length=%llu", !!h, (unsigned long long)slen);
+	if (h) {
+		char *trash;
+		int nlen;
+
+		trash = chunk_newstr(tmp);
+		if (!trash)
+			return -QPACK_RET_TOO_LARGE;
+
+		nlen = huff_dec(*raw, slen, trash, tmp->size - tmp->data);
+		if (nlen == (uint32_t)-1) {
+			qpack_debug_printf(stderr, " can't decode huffman.\n");
+			return -QPACK_RET_HUFFMAN;
+		}
+
+		qpack_debug_printf(stderr, " [huff %d->%d '%s']", (int)slen, (int)nlen, trash);
+		/* makes an ist from tmp storage */
+		b_add(tmp, nlen);
+		*str = ist2(trash, nlen);
+	}
+	else {
+		*str = ist2(*raw, slen);
+	}
+
+	*raw += slen;
+	*len -= slen;
+	return 0;
+}
+
+/* Returns the contiguous contents of <buf>, using the trash chunk <tmp> as
+ * storage if it wraps.
+ */
+static const unsigned char *qpack_linearize(struct buffer *buf, struct buffer *tmp)
+{
+	if (b_head(buf) + b_data(buf) <= b_wrap(buf))
+		return (const unsigned char *)b_head(buf);
+
+	b_getblk(buf, tmp->area, b_data(buf), 0);
+	return (const unsigned char *)tmp->area;
+}
+
+/* Initializes the decoder context <dec> which announced <max_cap> bytes as
+ * dynamic table capacity and <max_blocked> blocked streams.
+ */
+void qpack_dec_init(struct qpack_dec *dec, uint64_t max_cap, uint64_t max_blocked)
+{
+	dec->dht = NULL;
+	dec->max_cap = max_cap;
+	dec->max_blocked = max_blocked;
+	dec->blocked = 0;
+	dec->ic = dec->krc = 0;
+}
+
+/* Releases all the resources attached to the decoder context <dec>. */
+void qpack_dec_release(struct qpack_dec *dec)
+{
+	if (dec->dht) {
+		qpack_dht_free(dec->dht);
+		dec->dht = NULL;
+	}
+}
+
+/* Inserts header field <name>:<value> into the dynamic table of <dec>. Both
+ * strings must not point into the table as they could be evicted first.
+ * Returns 0 on success else a QPACK or HTTP/3 error code.
+ */
+static int qpack_dec_insert(struct qpack_dec *dec, const struct ist name, const struct ist value)
+{
+	/* RFC 9204 3.2.2. Dynamic Table Capacity and Eviction
+	 *
+	 * It is an error if the encoder attempts to add an entry that is
+	 * larger than the dynamic table capacity; the decoder MUST treat this
+	 * as a connection error of type QPACK_ENCODER_STREAM_ERROR.
+	 */
+	if (!dec->dht || name.len + value.len + 32 > dec->dht->size)
+		return QPACK_ERR_ENCODER_STREAM_ERROR;
+
+	if (qpack_dht_insert(dec->dht, name, value) < 0)
+		return H3_ERR_INTERNAL_ERROR;
+
+	dec->ic++;
+	return 0;
+}
+
+/* Decode an encoder stream from <buf> and apply its instructions to the dynamic
+ * table of decoder <dec>. <qcs> is the stream instance used to report errors.
  *
- * Returns 0 on success else non-zero.
+ * Returns the number of bytes consumed, an incomplete instruction being left
+ * in the buffer, or a negative value on error.
  */
-int qpack_decode_enc(struct buffer *buf, int fin, void *ctx)
+ssize_t qpack_decode_enc(struct qpack_dec *dec, struct buffer *buf, int fin, struct qcs *qcs)
 {
-	struct qcs *qcs = ctx;
-	size_t len;
+	struct buffer *tmp = get_trash_chunk();
+	const unsigned char *raw;
+	struct ist name, value;
+	uint64_t len, left, idx;
 	unsigned char inst;
+	int err = QPACK_ERR_ENCODER_STREAM_ERROR;
+	int ret;
 
 	/* RFC 9204 4.2. Encoder and Decoder Streams
 	 *
@@ -123,44 +235,143 @@ int qpack_decode_enc(struct buffer *buf, int fin, void *ctx)
 		return 0;
 	}
 
-	inst = (unsigned char)*b_head(buf) & QPACK_ENC_INST_BITMASK;
-	if (inst == QPACK_ENC_INST_DUP) {
-		/* Duplicate */
-	}
-	else if (inst & QPACK_ENC_INST_IWNR_BIT) {
-		/* Insert With Name Reference */
-	}
-	else if (inst & QPACK_ENC_INST_IWLN_BIT) {
-		/* Insert with literal name */
-	}
-	else if (inst & QPACK_ENC_INST_SDTC_BIT) {
-		/* Set dynamic table capacity */
-		int capacity = *b_head(buf) & 0x1f;
-
-		/* RFC 9204 4.3.1. Set Dynamic Table Capacity
-		 *
-		 * The decoder MUST treat a new dynamic table capacity
-		 * value that exceeds this limit as a connection error of type
-		 * QPACK_ENCODER_STREAM_ERROR.
-		 */
-		if (capacity) {
-			qcc_set_error(qcs->qcc, QPACK_ERR_ENCODER_STREAM_ERROR, 1);
-			return -1;
+	raw = qpack_linearize(buf, get_trash_chunk());
+	while (len) {
+		left = len;
+		chunk_reset(tmp);
+
+		inst = *raw;
+		if (inst & QPACK_ENC_INST_IWNR_BIT) {
+			/* Insert With Name Reference
+			 * | 1 | T |    Name Index (6+)    |
+			 */
+			idx = qpack_get_varint(&raw, &len, 6);
+			if (len == (uint64_t)-1)
+				goto incomplete;
+
+			if (inst & 0x40) {
+				if (idx >= QPACK_SHT_SIZE)
+					goto err;
+				name = qpack_sht[idx].n;
+			}
+			else {
+				/* relative index from the last insertion */
+				if (!dec->dht || idx >= dec->dht->used)
+					goto err;
+				name = qpack_idx_to_name(dec->dht, idx);
+				if (!chunk_memcat(tmp, istptr(name), istlen(name)))
+					goto err;
+				name = ist2(b_head(tmp), istlen(name));
+			}
+
+			ret = qpack_get_str(&raw, &len, 7, tmp, &value);
+			if (ret == -QPACK_RET_TRUNCATED)
+				goto incomplete;
+			else if (ret < 0)
+				goto err;
+
+			if ((err = qpack_dec_insert(dec, name, value)))
+				goto err;
+			err = QPACK_ERR_ENCODER_STREAM_ERROR;
 		}
+		else if (inst & QPACK_ENC_INST_IWLN_BIT) {
+			/* Insert With Literal Name
+			 * | 0 | 1 | H | Name Length (5+)  |
+			 */
+			ret = qpack_get_str(&raw, &len, 5, tmp, &name);
+			if (ret == -QPACK_RET_TRUNCATED)
+				goto incomplete;
+			else if (ret < 0)
+				goto err;
+
+			ret = qpack_get_str(&raw, &len, 7, tmp, &value);
+			if (ret == -QPACK_RET_TRUNCATED)
+				goto incomplete;
+			else if (ret < 0)
+				goto err;
+
+			if ((err = qpack_dec_insert(dec, name, value)))
+				goto err;
+			err = QPACK_ERR_ENCODER_STREAM_ERROR;
+		}
+		else if (inst & QPACK_ENC_INST_SDTC_BIT) {
+			/* Set Dynamic Table Capacity
+			 * | 0 | 0 | 1 |   Capacity (5+)   |
+			 */
+			idx = qpack_get_varint(&raw, &len, 5);
+			if (len == (uint64_t)-1)
+				goto incomplete;
 
+			/* RFC 9204 4.3.1. Set Dynamic Table Capacity
+			 *
+			 * The decoder MUST treat a new dynamic table capacity
+			 * value that exceeds this limit as a connection error of type
+			 * QPACK_ENCODER_STREAM_ERROR.
+			 */
+			if (idx > dec->max_cap)
+				goto err;
+
+			if (!dec->dht) {
+				if (idx) {
+					dec->dht = qpack_dht_alloc();
+					if (!dec->dht) {
+						err = H3_ERR_INTERNAL_ERROR;
+						goto err;
+					}
+					qpack_dht_init(dec->dht, idx);
+				}
+			}
+			else if (qpack_dht_set_capacity(dec->dht, idx) < 0) {
+				err = H3_ERR_INTERNAL_ERROR;
+				goto err;
+			}
+		}
+		else {
+			/* Duplicate
+			 * | 0 | 0 | 0 |    Index (5+)     |
+			 */
+			idx = qpack_get_varint(&raw, &len, 5);
+			if (len == (uint64_t)-1)
+				goto incomplete;
+
+			if (!dec->dht || idx >= dec->dht->used)
+				goto err;
+
+			name = qpack_idx_to_name(dec->dht, idx);
+			value = qpack_idx_to_value(dec->dht, idx);
+			if (!chunk_memcat(tmp, istptr(name), istlen(name)) ||
+			    !chunk_memcat(tmp, istptr(value), istlen(value)))
+				goto err;
+
+			name = ist2(b_orig(tmp), istlen(name));
+			value = ist2(b_orig(tmp) + istlen(name), istlen(value));
+			if ((err = qpack_dec_insert(dec, name, value)))
+				goto err;
+			err = QPACK_ERR_ENCODER_STREAM_ERROR;
+		}
 	}
 
-	return 0;
+	return b_data(buf);
+
+ incomplete:
+	return b_data(buf) - left;
+
+ err:
+	qpack_debug_printf(stderr, "##ERR@%d(inst=0x%02x)\n", __LINE__, inst);
+	qcc_set_error(qcs->qcc, err, 1);
+	return -1;
 }
 
-/* Decode an decoder stream.
+/* Decode a decoder stream from <buf> and apply its instructions to encoder
+ * <enc>. <qcs> is the stream instance used to report errors.
  *
- * Returns 0 on success else non-zero.
+ * Returns the number of bytes consumed, an incomplete instruction being left
+ * in the buffer, or a negative value on error.
  */
-int qpack_decode_dec(struct buffer *buf, int fin, void *ctx)
+ssize_t qpack_decode_dec(struct qpack_enc *enc, struct buffer *buf, int fin, struct qcs *qcs)
 {
-	struct qcs *qcs = ctx;
-	size_t len;
+	const unsigned char *raw;
+	uint64_t len, left, val;
 	unsigned char inst;
 
 	/* RFC 9204 4.2. Encoder and Decoder Streams
@@ -183,32 +394,97 @@ int qpack_decode_dec(struct buffer *buf, int fin, void *ctx)
 		return 0;
 	}
 
-	inst = (unsigned char)*b_head(buf) & QPACK_DEC_INST_BITMASK;
-	if (inst == QPACK_DEC_INST_ICINC) {
-		/* Insert count increment */
+	raw = qpack_linearize(buf, get_trash_chunk());
+	while (len) {
+		left = len;
+		inst = *raw;
+		if (inst & QPACK_DEC_INST_SACK) {
+			/* Section Acknowledgment
+			 * | 1 |      Stream ID (7+)       |
+			 */
+			val = qpack_get_varint(&raw, &len, 7);
+			if (len == (uint64_t)-1)
+				goto incomplete;
 
-		/* RFC 9204 4.4.3. Insert Count Increment
-		 *
-		 * An encoder that receives an Increment field equal to zero, or one
-		 * that increases the Known Received Count beyond what the encoder has
-		 * sent, MUST treat this as a connection error of type
-		 * QPACK_DECODER_STREAM_ERROR.
-		 */
+			if (qpack_enc_ack_section(enc, val))
+				goto err;
+		}
+		else if (inst & QPACK_DEC_INST_SCCL) {
+			/* Stream Cancellation
+			 * | 0 | 1 |     Stream ID (6+)    |
+			 */
+			val = qpack_get_varint(&raw, &len, 6);
+			if (len == (uint64_t)-1)
+				goto incomplete;
 
-		/* For the moment haproxy does not emit dynamic table insertion. */
-		qcc_set_error(qcs->qcc, QPACK_ERR_DECODER_STREAM_ERROR, 1);
-		return -1;
-	}
-	else if (inst & QPACK_DEC_INST_SACK) {
-		/* Section Acknowledgment */
-	}
-	else if (inst & QPACK_DEC_INST_SCCL) {
-		/* Stream cancellation */
+			qpack_enc_cancel_stream(enc, val);
+		}
+		else {
+			/* Insert Count Increment
+			 * | 0 | 0 |     Increment (6+)    |
+			 */
+			val = qpack_get_varint(&raw, &len, 6);
+			if (len == (uint64_t)-1)
+				goto incomplete;
+
+			if (qpack_enc_ack_inserts(enc, val))
+				goto err;
+		}
 	}
 
+	return b_data(buf);
+
+ incomplete:
+	return b_data(buf) - left;
+
+ err:
+	qpack_debug_printf(stderr, "##ERR@%d(inst=0x%02x)\n", __LINE__, inst);
+	qcc_set_error(qcs->qcc, QPACK_ERR_DECODER_STREAM_ERROR, 1);
+	return -1;
+}
+
+/* Writes into <out> a Section Acknowledgment for the field section of Required
+ * Insert Count <ric> decoded by <dec> on stream <id>. Returns 0 on success else
+ * non-zero if <out> is full.
+ */
+int qpack_dec_ack_section(struct qpack_dec *dec, struct buffer *out, uint64_t id, uint64_t ric)
+{
+	/* | 1 |      Stream ID (7+)       | */
+	if (qpack_encode_prefix_integer(out, id, 7, QPACK_DEC_INST_SACK))
+		return 1;
+
+	if (ric > dec->krc)
+		dec->krc = ric;
 	return 0;
 }
 
+/* Writes into <out> an Insert Count Increment for the insertions processed by
+ * <dec> which were not acknowledged yet. Returns 0 on success else non-zero if
+ * <out> is full.
+ */
+int qpack_dec_ack_inserts(struct qpack_dec *dec, struct buffer *out)
+{
+	if (dec->ic == dec->krc)
+		return 0;
+
+	/* | 0 | 0 |     Increment (6+)    | */
+	if (qpack_encode_prefix_integer(out, dec->ic - dec->krc, 6, QPACK_DEC_INST_ICINC))
+		return 1;
+
+	dec->krc = dec->ic;
+	return 0;
+}
+
+/* Writes into <out> a Stream Cancellation for stream <id> on which a field
+ * section decoding was abandoned. Returns 0 on success else non-zero if <out>
+ * is full.
+ */
+int qpack_dec_cancel_stream(struct qpack_dec *dec, struct buffer *out, uint64_t id)
+{
+	/* | 0 | 1 |     Stream ID (6+)    | */
+	return qpack_encode_prefix_integer(out, id, 6, QPACK_DEC_INST_SCCL);
+}
+
 /* Decode a field section prefix made of <enc_ric> and <db> two varints.
  * Also set the 'S' sign bit for <db>.
  * Return a negative error if failed, 0 if not.
@@ -216,11 +492,14 @@ int qpack_decode_dec(struct buffer *buf, int fin, void *ctx)
 static int qpack_decode_fs_pfx(uint64_t *enc_ric, uint64_t *db, int *sign_bit,
                                const unsigned char **raw, uint64_t *len)
 {
+	if (!*len)
+		return -QPACK_RET_RIC;
+
 	*enc_ric = qpack_get_varint(raw, len, 8);
-	if (*len == (uint64_t)-1)
+	if (*len == (uint64_t)-1 || !*len)
 		return -QPACK_RET_RIC;
 
-	*sign_bit = **raw & 0x8;
+	*sign_bit = **raw & 0x80;
 	*db = qpack_get_varint(raw, len, 7);
 	if (*len == (uint64_t)-1)
 		return -QPACK_RET_DB;
@@ -228,19 +507,100 @@ static int qpack_decode_fs_pfx(uint64_t *enc_ric, uint64_t *db, int *sign_bit,
 	return 0;
 }
 
-/* Decode a field section from the <raw> buffer of <len> bytes. Each parsed
- * header is inserted into <list> of <list_size> entries max and uses <tmp> as
- * a storage for some elements pointing into it. An end marker is inserted at
- * the end of the list with empty strings as name/value.
+/* Computes the Required Insert Count <ric> and the Base <base> of a field
+ * section from its prefix fields <enc_ric>, <db> and sign bit <s> according to
+ * the state of decoder <dec>. Returns 0 on success else a negative error.
+ */
+static int qpack_decode_ric(const struct qpack_dec *dec, uint64_t enc_ric, uint64_t db, int s,
+                            uint64_t *ric, uint64_t *base)
+{
+	uint64_t max_entries = dec->max_cap / 32;
+	uint64_t full_range = 2 * max_entries;
+	uint64_t max_value, max_wrapped;
+
+	*ric = *base = 0;
+	if (!enc_ric)
+		return 0;
+
+	/* RFC 9204 4.5.1.1. Required Insert Count */
+	if (enc_ric > full_range)
+		return -QPACK_RET_DECOMP;
+
+	max_value = dec->ic + max_entries;
+	max_wrapped = (max_value / full_range) * full_range;
+	*ric = max_wrapped + enc_ric - 1;
+
+	if (*ric > max_value) {
+		if (*ric <= full_range)
+			return -QPACK_RET_DECOMP;
+		*ric -= full_range;
+	}
+
+	if (!*ric)
+		return -QPACK_RET_DECOMP;
+
+	/* RFC 9204 4.5.1.2. Base */
+	if (s) {
+		if (db >= *ric)
+			return -QPACK_RET_DECOMP;
+		*base = *ric - db - 1;
+	}
+	else {
+		*base = *ric + db;
+	}
+
+	return 0;
+}
+
+/* Retrieves into <name> and <value> the dynamic table entry of decoder <dec>
+ * with absolute index <abs> referenced by a field section whose Required Insert
+ * Count is <ric>. Returns 0 on success else a negative error.
+ */
+static int qpack_get_dyn_entry(const struct qpack_dec *dec, uint64_t abs, uint64_t ric,
+                               struct ist *name, struct ist *value)
+{
+	uint64_t idx;
+
+	/* RFC9204 2.2.3 Invalid References
+	 *
+	 * If the decoder encounters a reference in a field line representation
+	 * to a dynamic table entry that has already been evicted or that has an
+	 * absolute index greater than or equal to the declared Required Insert
+	 * Count (Section 4.5.1), it MUST treat this as a connection error of
+	 * type QPACK_DECOMPRESSION_FAILED.
+	 */
+	if (abs >= ric || !dec->dht)
+		return -QPACK_RET_DECOMP;
+
+	idx = dec->ic - 1 - abs;
+	if (idx >= dec->dht->used)
+		return -QPACK_RET_DECOMP;
+
+	*name = qpack_idx_to_name(dec->dht, idx);
+	if (value)
+		*value = qpack_idx_to_value(dec->dht, idx);
+	return 0;
+}
+
+/* Decode a field section from the <raw> buffer of <len> bytes using decoder
+ * <dec>. Each parsed header is inserted into <list> of <list_size> entries max
+ * and uses <tmp> as a storage for some elements pointing into it. An end marker
+ * is inserted at the end of the list with empty strings as name/value. The
+ * headers may also point into the dynamic table, so they must be consumed
+ * before any further encoder stream processing. The Required Insert Count of
+ * the section is stored into <ric>, a non-null value meaning that it must be
+ * acknowledged.
  *
  * Returns the number of headers inserted into list excluding the end marker.
- * In case of error, a negative code QPACK_RET_* is returned.
+ * In case of error, a negative code QPACK_RET_* is returned. -QPACK_RET_BLOCKED
+ * indicates that the section references entries not received yet.
  */
-int qpack_decode_fs(const unsigned char *raw, uint64_t len, struct buffer *tmp,
-                    struct http_hdr *list, int list_size)
+int qpack_decode_fs(struct qpack_dec *dec, const unsigned char *raw, uint64_t len,
+                    struct buffer *tmp, struct http_hdr *list, int list_size,
+                    uint64_t *ric)
 {
 	struct ist name, value;
-	uint64_t enc_ric, db;
+	uint64_t enc_ric, db, base;
 	int s;
 	unsigned int efl_type;
 	int ret;
@@ -255,9 +615,28 @@ int qpack_decode_fs(const unsigned char *raw, uint64_t len, struct buffer *tmp,
 		goto out;
 	}
 
+	ret = qpack_decode_ric(dec, enc_ric, db, s, ric, &base);
+	if (ret < 0) {
+		qpack_debug_printf(stderr, "##ERR@%d(%d)\n", __LINE__, ret);
+		goto out;
+	}
+
 	chunk_reset(tmp);
-	qpack_debug_printf(stderr, "enc_ric: %llu db: %llu s=%d\n", 
-	                   (unsigned long long)enc_ric, (unsigned long long)db, !!s);
+	qpack_debug_printf(stderr, "enc_ric: %llu db: %llu s=%d ric=%llu base=%llu\n",
+	                   (unsigned long long)enc_ric, (unsigned long long)db, !!s,
+	                   (unsigned long long)*ric, (unsigned long long)base);
+
+	/* RFC 9204 2.1.2. Blocked Streams
+	 *
+	 * If the decoder encounters a field section with a Required Insert
+	 * Count greater than its own Insert Count, the stream cannot be
+	 * processed immediately.
+	 */
+	if (*ric > dec->ic) {
+		ret = -QPACK_RET_BLOCKED;
+		goto out;
+	}
+
 	/* Decode field lines */
 	while (len) {
 		if (hdr_idx >= list_size) {
@@ -271,12 +650,9 @@ int qpack_decode_fs(const unsigned char *raw, uint64_t len, struct buffer *tmp,
 		qpack_debug_printf(stderr, "efl_type=0x%02x\n", efl_type);
 
 		if (efl_type == QPACK_LFL_WPBNM) {
-			/* Literal field line with post-base name reference
-			 * TODO adjust this when dynamic table support is implemented.
-			 */
-#if 0
-			uint64_t index __maybe_unused, length;
-			unsigned int n __maybe_unused, h __maybe_unused;
+			/* Literal field line with post-base name reference */
+			uint64_t index;
+			unsigned int n __maybe_unused;
 
 			qpack_debug_printf(stderr, "literal field line with post-base name reference:");
 			n = *raw & 0x08;
@@ -288,42 +664,21 @@ int qpack_decode_fs(const unsigned char *raw, uint64_t len, struct buffer *tmp,
 			}
 
 			qpack_debug_printf(stderr, " n=%d index=%llu", !!n, (unsigned long long)index);
-			h = *raw & 0x80;
-			length = qpack_get_varint(&raw, &len, 7);
-			if (len == (uint64_t)-1) {
+			ret = qpack_get_dyn_entry(dec, base + index, *ric, &name, NULL);
+			if (ret < 0) {
 				qpack_debug_printf(stderr, "##ERR@%d\n", __LINE__);
-				ret = -QPACK_RET_TRUNCATED;
 				goto out;
 			}
 
-			qpack_debug_printf(stderr, " h=%d length=%llu", !!h, (unsigned long long)length);
-
-			if (len < length) {
+			ret = qpack_get_str(&raw, &len, 7, tmp, &value);
+			if (ret < 0) {
 				qpack_debug_printf(stderr, "##ERR@%d\n", __LINE__);
-				ret = -QPACK_RET_TRUNCATED;
 				goto out;
 			}
-
-			raw += length;
-			len -= length;
-#endif
-
-			/* RFC9204 2.2.3 Invalid References
-			 *
-			 * If the decoder encounters a reference in a field line representation
-			 * to a dynamic table entry that has already been evicted or that has an
-			 * absolute index greater than or equal to the declared Required Insert
-			 * Count (Section 4.5.1), it MUST treat this as a connection error of
-			 * type QPACK_DECOMPRESSION_FAILED.
-			 */
-			return -QPACK_RET_DECOMP;
 		}
 		else if (efl_type == QPACK_IFL_WPBI) {
-			/* Indexed field line with post-base index
-			 * TODO adjust this when dynamic table support is implemented.
-			 */
-#if 0
-			uint64_t index __maybe_unused;
+			/* Indexed field line with post-base index */
+			uint64_t index;
 
 			qpack_debug_printf(stderr, "indexed field line with post-base index:");
 			index = qpack_get_varint(&raw, &len, 4);
@@ -334,17 +689,11 @@ int qpack_decode_fs(const unsigned char *raw, uint64_t len, struct buffer *tmp,
 			}
 
 			qpack_debug_printf(stderr, " index=%llu", (unsigned long long)index);
-#endif
-
-			/* RFC9204 2.2.3 Invalid References
-			 *
-			 * If the decoder encounters a reference in a field line representation
-			 * to a dynamic table entry that has already been evicted or that has an
-			 * absolute index greater than or equal to the declared Required Insert
-			 * Count (Section 4.5.1), it MUST treat this as a connection error of
-			 * type QPACK_DECOMPRESSION_FAILED.
-			 */
-			return -QPACK_RET_DECOMP;
+			ret = qpack_get_dyn_entry(dec, base + index, *ric, &name, &value);
+			if (ret < 0) {
+				qpack_debug_printf(stderr, "##ERR@%d\n", __LINE__);
+				goto out;
+			}
 		}
 		else if (efl_type & QPACK_IFL_BIT) {
 			/* Indexed field line */
@@ -360,30 +709,27 @@ int qpack_decode_fs(const unsigned char *raw, uint64_t len, struct buffer *tmp,
 				goto out;
 			}
 
+			qpack_debug_printf(stderr,  " t=%d index=%llu", !!static_tbl, (unsigned long long)index);
 			if (static_tbl && index < QPACK_SHT_SIZE) {
 				name = qpack_sht[index].n;
 				value = qpack_sht[index].v;
 			}
+			else if (static_tbl || index >= base) {
+				ret = -QPACK_RET_DECOMP;
+				goto out;
+			}
 			else {
-				/* RFC9204 2.2.3 Invalid References
-				 *
-				 * If the decoder encounters a reference in a field line representation
-				 * to a dynamic table entry that has already been evicted or that has an
-				 * absolute index greater than or equal to the declared Required Insert
-				 * Count (Section 4.5.1), it MUST treat this as a connection error of
-				 * type QPACK_DECOMPRESSION_FAILED.
-				 *
-				 * TODO adjust this when dynamic table support is implemented.
-				 */
-				return -QPACK_RET_DECOMP;
+				ret = qpack_get_dyn_entry(dec, base - 1 - index, *ric, &name, &value);
+				if (ret < 0) {
+					qpack_debug_printf(stderr, "##ERR@%d\n", __LINE__);
+					goto out;
+				}
 			}
-
-			qpack_debug_printf(stderr,  " t=%d index=%llu", !!static_tbl, (unsigned long long)index);
 		}
 		else if (efl_type & QPACK_LFL_WNR_BIT) {
 			/* Literal field line with name reference */
-			uint64_t index, length;
-			unsigned int static_tbl, n __maybe_unused, h;
+			uint64_t index;
+			unsigned int static_tbl, n __maybe_unused;
 
 			qpack_debug_printf(stderr, "Literal field line with name reference:");
 			n = efl_type & 0x20;
@@ -395,165 +741,47 @@ int qpack_decode_fs(const unsigned char *raw, uint64_t len, struct buffer *tmp,
 				goto out;
 			}
 
+			qpack_debug_printf(stderr, " n=%d t=%d index=%llu", !!n, !!static_tbl, (unsigned long long)index);
 			if (static_tbl && index < QPACK_SHT_SIZE) {
 				name = qpack_sht[index].n;
 			}
-			else {
-				/* RFC9204 2.2.3 Invalid References
-				 *
-				 * If the decoder encounters a reference in a field line representation
-				 * to a dynamic table entry that has already been evicted or that has an
-				 * absolute index greater than or equal to the declared Required Insert
-				 * Count (Section 4.5.1), it MUST treat this as a connection error of
-				 * type QPACK_DECOMPRESSION_FAILED.
-				 *
-				 * TODO adjust this when dynamic table support is implemented.
-				 */
-				return -QPACK_RET_DECOMP;
-			}
-
-			qpack_debug_printf(stderr, " n=%d t=%d index=%llu", !!n, !!static_tbl, (unsigned long long)index);
-			h = *raw & 0x80;
-			length = qpack_get_varint(&raw, &len, 7);
-			if (len == (uint64_t)-1) {
-				qpack_debug_printf(stderr, "##ERR@%d\n", __LINE__);
-				ret = -QPACK_RET_TRUNCATED;
+			else if (static_tbl || index >= base) {
+				ret = -QPACK_RET_DECOMP;
 				goto out;
 			}
-
-			qpack_debug_printf(stderr, " h=%d length=%llu", !!h, (unsigned long long)length);
-			if (h) {
-				char *trash;
-				int nlen;
-
-				trash = chunk_newstr(tmp);
-				if (!trash) {
+			else {
+				ret = qpack_get_dyn_entry(dec, base - 1 - index, *ric, &name, NULL);
+				if (ret < 0) {
 					qpack_debug_printf(stderr, "##ERR@%d\n", __LINE__);
-					ret = -QPACK_RET_TOO_LARGE;
-					goto out;
-				}
-				nlen = huff_dec(raw, length, trash, tmp->size - tmp->data);
-				if (nlen == (uint32_t)-1) {
-					qpack_debug_printf(stderr, " can't decode huffman.\n");
-					ret = -QPACK_RET_HUFFMAN;
 					goto out;
 				}
-
-				qpack_debug_printf(stderr, " [name huff %d->%d '%s']", (int)length, (int)nlen, trash);
-				/* makes an ist from tmp storage */
-				b_add(tmp, nlen);
-				value = ist2(trash, nlen);
-			}
-			else {
-				value = ist2(raw, length);
 			}
 
-			if (len < length) {
+			ret = qpack_get_str(&raw, &len, 7, tmp, &value);
+			if (ret < 0) {
 				qpack_debug_printf(stderr, "##ERR@%d\n", __LINE__);
-				ret = -QPACK_RET_TRUNCATED;
 				goto out;
 			}
-
-			raw += length;
-			len -= length;
 		}
 		else if (efl_type & QPACK_LFL_WLN_BIT) {
 			/* Literal field line with literal name */
-			unsigned int n __maybe_unused, hname, hvalue;
-			uint64_t name_len, value_len;
+			unsigned int n __maybe_unused;
 
 			qpack_debug_printf(stderr, "Literal field line with literal name:");
 			n = *raw & 0x10;
-			hname = *raw & 0x08;
-			name_len = qpack_get_varint(&raw, &len, 3);
-			if (len == (uint64_t)-1) {
-				qpack_debug_printf(stderr, "##ERR@%d\n", __LINE__);
-				ret = -QPACK_RET_TRUNCATED;
-				goto out;
-			}
+			qpack_debug_printf(stderr, " n=%d", !!n);
 
-			qpack_debug_printf(stderr, " n=%d hname=%d name_len=%llu", !!n, !!hname, (unsigned long long)name_len);
-			/* Name string */
-
-			if (len < name_len) {
+			ret = qpack_get_str(&raw, &len, 3, tmp, &name);
+			if (ret < 0) {
 				qpack_debug_printf(stderr, "##ERR@%d\n", __LINE__);
-				ret = -QPACK_RET_TRUNCATED;
 				goto out;
 			}
 
-			if (hname) {
-				char *trash;
-				int nlen;
-
-				trash = chunk_newstr(tmp);
-				if (!trash) {
-					qpack_debug_printf(stderr, "##ERR@%d\n", __LINE__);
-					ret = -QPACK_RET_TOO_LARGE;
-					goto out;
-				}
-				nlen = huff_dec(raw, name_len, trash, tmp->size - tmp->data);
-				if (nlen == (uint32_t)-1) {
-					qpack_debug_printf(stderr, " can't decode huffman.\n");
-					ret = -QPACK_RET_HUFFMAN;
-					goto out;
-				}
-
-				qpack_debug_printf(stderr, " [name huff %d->%d '%s']", (int)name_len, (int)nlen, trash);
-				/* makes an ist from tmp storage */
-				b_add(tmp, nlen);
-				name = ist2(trash, nlen);
-			}
-			else {
-				name = ist2(raw, name_len);
-			}
-
-			raw += name_len;
-			len -= name_len;
-
-			hvalue = *raw & 0x80;
-			value_len = qpack_get_varint(&raw, &len, 7);
-			if (len == (uint64_t)-1) {
+			ret = qpack_get_str(&raw, &len, 7, tmp, &value);
+			if (ret < 0) {
 				qpack_debug_printf(stderr, "##ERR@%d\n", __LINE__);
-				ret = -QPACK_RET_TRUNCATED;
 				goto out;
 			}
-
-			qpack_debug_printf(stderr, " hvalue=%d value_len=%llu", !!hvalue, (unsigned long long)value_len);
-
-			if (len < value_len) {
-				qpack_debug_printf(stderr, "##ERR@%d\n", __LINE__);
-				ret = -QPACK_RET_TRUNCATED;
-				goto out;
-			}
-
-			if (hvalue) {
-				char *trash;
-				int nlen;
-
-				trash = chunk_newstr(tmp);
-				if (!trash) {
-					qpack_debug_printf(stderr, "##ERR@%d\n", __LINE__);
-					ret = -QPACK_RET_TOO_LARGE;
-					goto out;
-				}
-				nlen = huff_dec(raw, value_len, trash, tmp->size - tmp->data);
-				if (nlen == (uint32_t)-1) {
-					qpack_debug_printf(stderr, " can't decode huffman.\n");
-					ret = -QPACK_RET_HUFFMAN;
-					goto out;
-				}
-
-				qpack_debug_printf(stderr, " [name huff %d->%d '%s']", (int)value_len, (int)nlen, trash);
-				/* makes an ist from tmp storage */
-				b_add(tmp, nlen);
-				value = ist2(trash, nlen);
-			}
-			else {
-				value = ist2(raw, value_len);
-			}
-
-			raw += value_len;
-			len -= value_len;
 		}
 
 		/* We must not accept empty header names (forbidden by the spec and used
@@ -2,13 +2,18 @@
 
 #include <haproxy/buf.h>
 #include <haproxy/intops.h>
+#include <haproxy/list.h>
+#include <haproxy/pool.h>
+#include <haproxy/qpack-tbl.h>
+
+DECLARE_STATIC_POOL(pool_head_qpack_enc_fs, "qpack_enc_fs", sizeof(struct qpack_enc_fs));
 
 /* Returns the byte size required to encode <i> as a <prefix_size>-prefix
  * integer.
  */
-static size_t qpack_get_prefix_int_size(int i, int prefix_size)
+static size_t qpack_get_prefix_int_size(uint64_t i, int prefix_size)
 {
-	int n = (1 << prefix_size) - 1;
+	uint64_t n = (1 << prefix_size) - 1;
 	if (i < n) {
 		return 1;
 	}
@@ -23,16 +28,15 @@ static size_t qpack_get_prefix_int_size(int i, int prefix_size)
 }
 
 /* Encode the integer <i> in the buffer <out> in a <prefix_size>-bit prefix
- * integer. The caller must ensure there is enough size in the buffer. The
- * prefix is OR-ed with <before_prefix> byte.
+ * integer. The prefix is OR-ed with <before_prefix> byte.
  *
- * Returns 0 if success else non-zero.
+ * Returns 0 if success else non-zero if there is not enough room in <out>.
  */
-static int qpack_encode_prefix_integer(struct buffer *out, int i,
-                                       int prefix_size,
-                                       unsigned char before_prefix)
+int qpack_encode_prefix_integer(struct buffer *out, uint64_t i,
+                                int prefix_size,
+                                unsigned char before_prefix)
 {
-	const int mod = (1 << prefix_size) - 1;
+	const uint64_t mod = (1 << prefix_size) - 1;
 	BUG_ON_HOT(!prefix_size);
 
 	if (i < mod) {
@@ -42,10 +46,9 @@ static int qpack_encode_prefix_integer(struct buffer *out, int i,
 		b_putchr(out, before_prefix | i);
 	}
 	else {
-		int to_encode = i - mod;
-		const size_t sz = to_encode / mod;
+		uint64_t to_encode = i - mod;
 
-		if (b_room(out) < sz)
+		if (b_room(out) < qpack_get_prefix_int_size(i, prefix_size))
 			return 1;
 
 		b_putchr(out, before_prefix | mod);
@@ -132,6 +135,77 @@ int qpack_encode_int_status(struct buffer *out, unsigned int status)
 	return 0;
 }
 
+/* Encode a field line with value <v> referencing the static table entry <idx>
+ * as name, or directly the entry if <full> is set as its value matches.
+ * Returns 0 on success else non-zero.
+ */
+static int qpack_encode_static(struct buffer *out, int idx, int full, const struct ist v)
+{
+	if (full) {
+		/* indexed field line */
+		if (b_room(out) < qpack_get_prefix_int_size(idx, 6))
+			return 1;
+
+		qpack_encode_prefix_integer(out, idx, 6, 0xc0);
+		return 0;
+	}
+
+	/* literal field line with name reference */
+	if (b_room(out) < qpack_get_prefix_int_size(idx, 4) +
+	                  qpack_get_prefix_int_size(v.len, 7) + v.len)
+		return 1;
+
+	qpack_encode_prefix_integer(out, idx, 4, 0x50);
+	qpack_encode_prefix_integer(out, v.len, 7, 0x00);
+	b_putist(out, v);
+	return 0;
+}
+
+/* Encode :method pseudo-header <meth>, <other> being the method name if not a
+ * well-known one. Returns 0 on success else non-zero.
+ */
+int qpack_encode_method(struct buffer *out, enum http_meth_t meth, struct ist other)
+{
+	int idx = 0;
+
+	switch (meth) {
+	case HTTP_METH_CONNECT: idx = 15; break;
+	case HTTP_METH_DELETE:  idx = 16; break;
+	case HTTP_METH_GET:     idx = 17; break;
+	case HTTP_METH_HEAD:    idx = 18; break;
+	case HTTP_METH_OPTIONS: idx = 19; break;
+	case HTTP_METH_POST:    idx = 20; break;
+	case HTTP_METH_PUT:     idx = 21; break;
+	default: break;
+	}
+
+	return idx ? qpack_encode_static(out, idx, 1, IST_NULL) :
+	             qpack_encode_static(out, 15, 0, other);
+}
+
+/* Encode :scheme pseudo-header <scheme>. Returns 0 on success else non-zero. */
+int qpack_encode_scheme(struct buffer *out, const struct ist scheme)
+{
+	if (isteqi(scheme, ist("https")))
+		return qpack_encode_static(out, 23, 1, IST_NULL);
+	else if (isteqi(scheme, ist("http")))
+		return qpack_encode_static(out, 22, 1, IST_NULL);
+
+	return qpack_encode_static(out, 22, 0, scheme);
+}
+
+/* Encode :path pseudo-header <path>. Returns 0 on success else non-zero. */
+int qpack_encode_path(struct buffer *out, const struct ist path)
+{
+	return qpack_encode_static(out, 1, isteq(path, ist("/")), path);
+}
+
+/* Encode :authority pseudo-header <auth>. Returns 0 on success else non-zero. */
+int qpack_encode_auth(struct buffer *out, const struct ist auth)
+{
+	return qpack_encode_static(out, 0, 0, auth);
+}
+
 /* Returns 0 on success else non-zero. */
 int qpack_encode_field_section_line(struct buffer *out)
 {
@@ -149,11 +223,16 @@ int qpack_encode_field_section_line(struct buffer *out)
 }
 
 #define QPACK_LFL_WLN_BIT  0x20 // Literal field line with literal name
+#define QPACK_LFL_WNR_BIT  0x40 // Literal field line with name reference
+#define QPACK_IFL_BIT      0x80 // Indexed field line
+#define QPACK_LFL_N_BIT    0x10 // Never indexed literal with literal name
 
-/* Encode a header in literal field line with literal name.
+/* Encode a header in literal field line with literal name, with the bits of
+ * <flags> set in the first byte.
  * Returns 0 on success else non-zero.
  */
-int qpack_encode_header(struct buffer *out, const struct ist n, const struct ist v)
+static int _qpack_encode_header(struct buffer *out, const struct ist n, const struct ist v,
+                                unsigned char flags)
 {
 	int i;
 	size_t sz = qpack_get_prefix_int_size(n.len, 3) + n.len +
@@ -168,7 +247,7 @@ int qpack_encode_header(struct buffer *out, const struct ist n, const struct ist
 	 * H: huffman encoded
 	 * name len
 	 */
-	qpack_encode_prefix_integer(out, n.len, 3, QPACK_LFL_WLN_BIT);
+	qpack_encode_prefix_integer(out, n.len, 3, QPACK_LFL_WLN_BIT | flags);
 	/* name */
 	for (i = 0; i < n.len; ++i)
 		b_putchr(out, n.ptr[i]);
@@ -183,3 +262,393 @@ int qpack_encode_header(struct buffer *out, const struct ist n, const struct ist
 
 	return 0;
 }
+
+/* Encode a header in literal field line with literal name.
+ * Returns 0 on success else non-zero.
+ */
+int qpack_encode_header(struct buffer *out, const struct ist n, const struct ist v)
+{
+	return _qpack_encode_header(out, n, v, 0);
+}
+
+/* Initializes the encoder context <enc>. The dynamic table remains unused
+ * until qpack_enc_set_capacity() is called.
+ */
+void qpack_enc_init(struct qpack_enc *enc)
+{
+	enc->dht = NULL;
+	enc->max_entries = 0;
+	enc->ic = enc->krc = 0;
+	LIST_INIT(&enc->fs_list);
+	enc->fs_count = 0;
+	enc->fs_cur = NULL;
+	enc->fs_base = 0;
+}
+
+/* Releases all the resources attached to the encoder context <enc>. */
+void qpack_enc_release(struct qpack_enc *enc)
+{
+	struct qpack_enc_fs *fs, *back;
+
+	list_for_each_entry_safe(fs, back, &enc->fs_list, list) {
+		LIST_DELETE(&fs->list);
+		pool_free(pool_head_qpack_enc_fs, fs);
+	}
+	enc->fs_count = 0;
+
+	pool_free(pool_head_qpack_enc_fs, enc->fs_cur);
+	enc->fs_cur = NULL;
+
+	if (enc->dht) {
+		qpack_dht_free(enc->dht);
+		enc->dht = NULL;
+	}
+}
+
+/* Enables the dynamic table of encoder <enc> with a capacity of <cap> bytes,
+ * which must not exceed the peer's SETTINGS_QPACK_MAX_TABLE_CAPACITY <max_cap>
+ * nor the size of the QPACK tables pool. The corresponding Set Dynamic Table
+ * Capacity instruction is written into <ins> for the encoder stream. This may
+ * only be done once per connection.
+ *
+ * Returns 0 on success else non-zero, in which case the dynamic table is not
+ * used.
+ */
+int qpack_enc_set_capacity(struct qpack_enc *enc, struct buffer *ins,
+                           uint64_t max_cap, uint32_t cap)
+{
+	BUG_ON(enc->dht || cap > max_cap);
+
+	if (!cap)
+		return 1;
+
+	/* RFC 9204 4.3.1. Set Dynamic Table Capacity
+	 * | 0 | 0 | 1 |   Capacity (5+)   |
+	 */
+	if (b_room(ins) < qpack_get_prefix_int_size(cap, 5))
+		return 1;
+
+	enc->dht = qpack_dht_alloc();
+	if (!enc->dht)
+		return 1;
+
+	qpack_dht_init(enc->dht, cap);
+	enc->max_entries = max_cap / 32;
+	qpack_encode_prefix_integer(ins, cap, 5, 0x20);
+	return 0;
+}
+
+/* Prepares encoder <enc> for the encoding of a new field section. Only entries
+ * already acknowledged by the decoder are referenced so that the peer never
+ * has to block the stream, and these references are tracked until the section
+ * is acknowledged to prevent their eviction. If no tracking storage is
+ * available, the dynamic table is not referenced by this section.
+ */
+void qpack_enc_fs_start(struct qpack_enc *enc)
+{
+	if (!enc->dht)
+		return;
+
+	if (!enc->fs_cur)
+		enc->fs_cur = pool_alloc(pool_head_qpack_enc_fs);
+
+	if (enc->fs_cur) {
+		enc->fs_cur->ric = 0;
+		enc->fs_cur->min_ref = UINT64_MAX;
+	}
+	enc->fs_base = enc->krc;
+}
+
+/* Encodes the prefix of the field section being encoded by <enc> into <out>.
+ * Returns 0 on success else non-zero.
+ */
+int qpack_enc_fs_prefix(struct qpack_enc *enc, struct buffer *out)
+{
+	uint64_t ric = enc->fs_cur ? enc->fs_cur->ric : 0;
+
+	if (!enc->dht || !ric)
+		return qpack_encode_field_section_line(out);
+
+	/* RFC 9204 4.5.1. Encoded Field Section Prefix
+	 * |   Required Insert Count (8+)  |
+	 * | S |      Delta Base (7+)      |
+	 *
+	 * Base is always greater than or equal to the Required Insert Count.
+	 */
+	if (qpack_encode_prefix_integer(out, ric % (2 * enc->max_entries) + 1, 8, 0x00) ||
+	    qpack_encode_prefix_integer(out, enc->fs_base - ric, 7, 0x00))
+		return 1;
+
+	return 0;
+}
+
+/* Registers the field section just encoded by <enc> for stream <id> as sent,
+ * if it references the dynamic table.
+ */
+void qpack_enc_fs_commit(struct qpack_enc *enc, uint64_t id)
+{
+	struct qpack_enc_fs *fs = enc->fs_cur;
+
+	if (!fs || !fs->ric)
+		return;
+
+	fs->id = id;
+	LIST_APPEND(&enc->fs_list, &fs->list);
+	enc->fs_count++;
+	enc->fs_cur = NULL;
+}
+
+/* Records a reference to dynamic table entry <abs> by the current section. */
+static inline void qpack_enc_fs_ref(struct qpack_enc *enc, uint64_t abs)
+{
+	if (abs + 1 > enc->fs_cur->ric)
+		enc->fs_cur->ric = abs + 1;
+	if (abs < enc->fs_cur->min_ref)
+		enc->fs_cur->min_ref = abs;
+}
+
+/* Returns the representation the dynamic table encoder must use for header
+ * field <n>:<v> when the table's capacity is <size> bytes. Credentials must
+ * never be indexed, not even by intermediaries, and the same goes for short
+ * cookies which are easy to guess by observing the compression ratio
+ * (RFC9204#7.1.3). Fields whose values are expected to change with each
+ * message are not indexed either, as they would only evict useful entries.
+ */
+static inline int qpack_enc_policy(const struct ist n, const struct ist v, uint32_t size)
+{
+	if (isteq(n, ist("authorization")) ||
+	    isteq(n, ist("proxy-authorization")) ||
+	    (v.len < 20 && (isteq(n, ist("cookie")) || isteq(n, ist("set-cookie")))))
+		return QPACK_LFL_N_BIT; /* never indexed */
+
+	if (n.len + v.len + 32 > size / 4 ||
+	    (isteq(n, ist(":path")) && istchr(v, '?')) ||
+	    isteq(n, ist("content-length")) ||
+	    isteq(n, ist("content-range")) ||
+	    isteq(n, ist("date")) ||
+	    isteq(n, ist("etag")) ||
+	    isteq(n, ist("last-modified")) ||
+	    isteq(n, ist("if-modified-since")) ||
+	    isteq(n, ist("if-none-match")) ||
+	    isteq(n, ist("location")) ||
+	    isteq(n, ist("set-cookie")) ||
+	    isteq(n, ist("age")))
+		return 0x00; /* not indexed */
+
+	return 0x40; /* inserted */
+}
+
+/* Tries to insert header field <n>:<v> into the dynamic table of <enc> and to
+ * write the corresponding Insert With Literal Name instruction into <ins>.
+ * Entries may only be evicted once acknowledged and not referenced anymore by
+ * unacknowledged field sections, including the one being encoded. Returns
+ * non-zero if the entry was inserted.
+ */
+static int qpack_enc_insert(struct qpack_enc *enc, struct buffer *ins,
+                            const struct ist n, const struct ist v)
+{
+	struct qpack_dht *dht = enc->dht;
+	const struct qpack_dte *dte;
+	struct qpack_enc_fs *fs;
+	uint64_t limit = enc->krc;
+	uint32_t room;
+	unsigned int idx;
+	size_t sz;
+
+	sz = qpack_get_prefix_int_size(n.len, 5) + n.len +
+	     qpack_get_prefix_int_size(v.len, 7) + v.len;
+	if (b_room(ins) < sz)
+		return 0;
+
+	if (enc->fs_cur && enc->fs_cur->min_ref < limit)
+		limit = enc->fs_cur->min_ref;
+	list_for_each_entry(fs, &enc->fs_list, list) {
+		if (fs->min_ref < limit)
+			limit = fs->min_ref;
+	}
+
+	/* check that the oldest entries to be evicted are evictable */
+	room = dht->size - (dht->used * 32 + dht->total);
+	for (idx = dht->used; room < n.len + v.len + 32; ) {
+		if (!idx)
+			return 0;
+
+		idx--;
+		if (enc->ic - 1 - idx >= limit)
+			return 0;
+
+		dte = qpack_get_dte(dht, idx);
+		if (!dte)
+			return 0;
+		room += dte->nlen + dte->vlen + 32;
+	}
+
+	if (!qpack_dht_make_room(dht, n.len + v.len) || qpack_dht_insert(dht, n, v) < 0)
+		return 0;
+
+	enc->ic++;
+
+	/* RFC 9204 4.3.3. Insert with Literal Name
+	 * | 0 | 1 | H | Name Length (5+)  |
+	 * |  Name String (Length bytes)   |
+	 * | H |     Value Length (7+)     |
+	 * |  Value String (Length bytes)  |
+	 */
+	qpack_encode_prefix_integer(ins, n.len, 5, 0x40);
+	b_putist(ins, n);
+	qpack_encode_prefix_integer(ins, v.len, 7, 0x00);
+	b_putist(ins, v);
+	return 1;
+}
+
+/* Tries to encode header field <n>:<v> into <out> using the dynamic table of
+ * encoder <enc>, between qpack_enc_fs_start() and qpack_enc_fs_prefix() calls.
+ * Fields present in the table are sent as a single index once the decoder
+ * acknowledged their insertion, and other ones may be inserted depending on
+ * the indexing policy, in which case the insertion instruction is written
+ * into <ins> for the encoder stream. Without dynamic table, this falls back
+ * to qpack_encode_header(). Note that on failure the table may already have
+ * been updated, but this remains consistent with the peer as long as <ins> is
+ * emitted.
+ *
+ * Returns 0 on success else non-zero (buffer full).
+ */
+int qpack_encode_header_dht(struct qpack_enc *enc, struct buffer *ins, struct buffer *out,
+                            const struct ist n, const struct ist v)
+{
+	struct qpack_dht *dht = enc->dht;
+	const struct qpack_dte *dte;
+	uint64_t nabs = UINT64_MAX;
+	uint64_t abs;
+	unsigned int idx;
+	int may_ref;
+	int rep;
+
+	if (!dht)
+		return qpack_encode_header(out, n, v);
+
+	rep = qpack_enc_policy(n, v, dht->size);
+	if (rep == QPACK_LFL_N_BIT)
+		return _qpack_encode_header(out, n, v, QPACK_LFL_N_BIT);
+
+	may_ref = enc->fs_cur && enc->fs_count < QPACK_ENC_MAX_FS;
+
+	/* from the most recent entry */
+	for (idx = 0; idx < dht->used; idx++) {
+		dte = qpack_get_dte(dht, idx);
+		if (!dte)
+			break;
+
+		if (!isteq(qpack_get_name(dht, dte), n))
+			continue;
+
+		abs = enc->ic - 1 - idx;
+		if (isteq(qpack_get_value(dht, dte), v)) {
+			if (may_ref && abs < enc->fs_base) {
+				/* RFC 9204 4.5.2. Indexed Field Line
+				 * | 1 | T |      Index (6+)       |
+				 */
+				if (qpack_encode_prefix_integer(out, enc->fs_base - 1 - abs, 6, QPACK_IFL_BIT))
+					return 1;
+
+				qpack_enc_fs_ref(enc, abs);
+				return 0;
+			}
+
+			/* insertion not acknowledged yet */
+			rep = 0x00;
+		}
+
+		if (nabs == UINT64_MAX && abs < enc->fs_base)
+			nabs = abs;
+	}
+
+	if (rep == 0x40)
+		qpack_enc_insert(enc, ins, n, v);
+
+	if (!may_ref || nabs == UINT64_MAX)
+		return qpack_encode_header(out, n, v);
+
+	/* RFC 9204 4.5.4. Literal Field Line with Name Reference
+	 * | 0 | 1 | N | T |Name Index (4+)|
+	 * | H |     Value Length (7+)     |
+	 * |  Value String (Length bytes)  |
+	 */
+	if (b_room(out) < qpack_get_prefix_int_size(enc->fs_base - 1 - nabs, 4) +
+	                  qpack_get_prefix_int_size(v.len, 7) + v.len)
+		return 1;
+
+	qpack_encode_prefix_integer(out, enc->fs_base - 1 - nabs, 4, QPACK_LFL_WNR_BIT);
+	qpack_encode_prefix_integer(out, v.len, 7, 0x00);
+	b_putist(out, v);
+	qpack_enc_fs_ref(enc, nabs);
+	return 0;
+}
+
+/* Processes a Section Acknowledgment received from the decoder for stream
+ * <id>, which refers to the oldest unacknowledged section sent on it.
+ * Returns 0 on success else non-zero if no section is waiting for it.
+ */
+int qpack_enc_ack_section(struct qpack_enc *enc, uint64_t id)
+{
+	struct qpack_enc_fs *fs;
+
+	list_for_each_entry(fs, &enc->fs_list, list) {
+		if (fs->id != id)
+			continue;
+
+		if (fs->ric > enc->krc)
+			enc->krc = fs->ric;
+
+		LIST_DELETE(&fs->list);
+		enc->fs_count--;
+		pool_free(pool_head_qpack_enc_fs, fs);
+		return 0;
+	}
+
+	/* RFC 9204 4.4.1. Section Acknowledgment
+	 *
+	 * If an encoder receives a Section Acknowledgment instruction
+	 * referring to a stream on which every encoded field section with a
+	 * non-zero Required Insert Count has already been acknowledged, this
+	 * MUST be treated as a connection error of type
+	 * QPACK_DECODER_STREAM_ERROR.
+	 */
+	return 1;
+}
+
+/* Processes a Stream Cancellation received from the decoder for stream <id>:
+ * its unacknowledged sections do not reference the table anymore.
+ */
+void qpack_enc_cancel_stream(struct qpack_enc *enc, uint64_t id)
+{
+	struct qpack_enc_fs *fs, *back;
+
+	list_for_each_entry_safe(fs, back, &enc->fs_list, list) {
+		if (fs->id != id)
+			continue;
+
+		LIST_DELETE(&fs->list);
+		enc->fs_count--;
+		pool_free(pool_head_qpack_enc_fs, fs);
+	}
+}
+
+/* Processes an Insert Count Increment of <inc> received from the decoder.
+ * Returns 0 on success else non-zero if it is invalid.
+ */
+int qpack_enc_ack_inserts(struct qpack_enc *enc, uint64_t inc)
+{
+	/* RFC 9204 4.4.3. Insert Count Increment
+	 *
+	 * An encoder that receives an Increment field equal to zero, or one
+	 * that increases the Known Received Count beyond what the encoder has
+	 * sent, MUST treat this as a connection error of type
+	 * QPACK_DECODER_STREAM_ERROR.
+	 */
+	if (!inc || inc > enc->ic - enc->krc)
+		return 1;
+
+	enc->krc += inc;
+	return 0;
+}
@@ -152,8 +152,8 @@ void qpack_dht_dump(FILE *out, const struct qpack_dht *dht)
 	unsigned int slot;
 	char name[4096], value[4096];
 
-	for (i = QPACK_SHT_SIZE; i < QPACK_SHT_SIZE + dht->used; i++) {
-		slot = (qpack_get_dte(dht, i - QPACK_SHT_SIZE + 1) - dht->dte);
+	for (i = 0; i < dht->used; i++) {
+		slot = (qpack_get_dte(dht, i) - dht->dte);
 		fprintf(out, "idx=%u slot=%u name=<%s> value=<%s> addr=%u-%u\n",
 			i, slot,
 			istpad(name, qpack_idx_to_name(dht, i)).ptr,
@@ -198,6 +198,8 @@ void qpack_dht_check_consistency(const struct qpack_dht *dht)
 /* rebuild a new dynamic header table from <dht> with an unwrapped index and
  * contents at the end. The new table is returned, the caller must not use the
  * previous one anymore. NULL may be returned if no table could be allocated.
+ * Note that <dht>'s size may be smaller than the pool's, in which case the
+ * contents are moved to the end of the <dht->size> first bytes.
  */
 static struct qpack_dht *qpack_dht_defrag(struct qpack_dht *dht)
 {
@@ -212,6 +214,7 @@ static struct qpack_dht *qpack_dht_defrag(struct qpack_dht *dht)
 	if (!alt_dht)
 		return NULL;
 
+	qpack_dht_init(alt_dht, dht->size);
 	alt_dht->total = dht->total;
 	alt_dht->used = dht->used;
 	alt_dht->wrap = dht->used;
@@ -413,3 +416,46 @@ int qpack_dht_insert(struct qpack_dht *dht, struct ist name, struct ist value)
 	memcpy((void *)dht + dht->dte[head].addr + name.len, value.ptr, value.len);
 	return 0;
 }
+
+/* Changes the capacity of table <dht> to <size> bytes, which must not be
+ * larger than the pool's objects, evicting the oldest entries which do not fit
+ * anymore. Returns 0 on success or a negative value if the table could not be
+ * reorganized, in which case it is left unchanged.
+ */
+int qpack_dht_set_capacity(struct qpack_dht *dht, uint32_t size)
+{
+	struct qpack_dht *alt_dht;
+	unsigned int tail;
+
+	if (!dht->used) {
+		dht->size = size;
+		return 0;
+	}
+
+	/* The entries are currently stored at the end of the previous area
+	 * and must be moved within the new one, so work on a copy to be able
+	 * to roll back on failure.
+	 */
+	alt_dht = qpack_dht_alloc();
+	if (!alt_dht)
+		return -1;
+
+	memcpy(alt_dht, dht, dht->size);
+	while (alt_dht->used && alt_dht->used * 32 + alt_dht->total > size) {
+		tail = qpack_dht_get_tail(alt_dht);
+		alt_dht->total -= alt_dht->dte[tail].nlen + alt_dht->dte[tail].vlen;
+		if (tail == alt_dht->front)
+			alt_dht->front = alt_dht->head;
+		alt_dht->used--;
+	}
+
+	alt_dht->size = size;
+	if (!qpack_dht_defrag(alt_dht)) {
+		qpack_dht_free(alt_dht);
+		return -1;
+	}
+
+	memcpy(dht, alt_dht, size);
+	qpack_dht_free(alt_dht);
+	return 0;
+}
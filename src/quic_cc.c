@@ -47,3 +47,48 @@ void quic_cc_state_trace(struct buffer *buf, const struct quic_cc *cc)
 {
 	cc->algo->state_trace(buf, cc);
 }
+
+/* Notify the congestion controller of <path> that all the packets newly
+ * acknowledged by an ACK frame have been handled, passing it the resulting
+ * delivery rate sample.
+ */
+void quic_cc_ack_rcvd(struct quic_cc_path *path)
+{
+	quic_cc_drs_on_ack_end(&path->drs, path->loss.rtt_min * 1000ULL);
+	if (path->cc.algo->on_ack_rcvd)
+		path->cc.algo->on_ack_rcvd(&path->cc, &path->drs.rs);
+	quic_cc_drs_rs_reset(&path->drs);
+}
+
+/* Returns the current pacing rate of <path> in bytes per millisecond. The
+ * congestion control algorithm may provide its own estimation, otherwise the
+ * congestion window is spread over the smoothed RTT with a 1.25 gain as
+ * suggested by RFC 9002 7.7.
+ */
+uint64_t quic_cc_pacing_rate(const struct quic_cc_path *path)
+{
+	if (path->cc.algo->pacing_rate)
+		return path->cc.algo->pacing_rate(&path->cc);
+
+	return quic_cc_path_rate(path, 125);
+}
+
+/* Account for <bytes> emitted at <now> (ns) on <path> and push its next
+ * departure time accordingly. A sender late by less than QUIC_PACING_SLACK_NS
+ * may catch up, which compensates for the scheduling and timers granularity.
+ */
+void quic_pacing_sent(struct quic_cc_path *path, size_t bytes, uint64_t now)
+{
+	uint64_t rate;
+
+	if (!now)
+		return;
+
+	rate = quic_cc_pacing_rate(path);
+	if (!rate)
+		rate = 1;
+
+	if (path->pacing_next + QUIC_PACING_SLACK_NS < now)
+		path->pacing_next = now - QUIC_PACING_SLACK_NS;
+	path->pacing_next += bytes * 1000000ULL / rate;
+}
@@ -0,0 +1,952 @@
+/*
+ * BBR congestion control algorithm.
+ *
+ * This is a model-based congestion controller. Instead of reacting to losses
+ * only, it continuously estimates the bottleneck bandwidth and the round trip
+ * propagation time of the path from the delivery rate samples, and derives
+ * from them both its pacing rate and its congestion window. The bandwidth is
+ * regularly probed by cycling the pacing gain, and the minimum RTT by briefly
+ * reducing the data in flight. Losses are only used to bound the model. This
+ * implementation follows the BBRv3 description from draft-ietf-ccwg-bbr.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, version 2.1
+ * exclusively.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <haproxy/api-t.h>
+#include <haproxy/buf.h>
+#include <haproxy/chunk.h>
+#include <haproxy/quic_cc.h>
+#include <haproxy/quic_cc_drs.h>
+#include <haproxy/quic_conn-t.h>
+#include <haproxy/quic_trace.h>
+#include <haproxy/tools.h>
+#include <haproxy/trace.h>
+
+/* All the gains are expressed in percents. */
+#define BBR_STARTUP_PACING_GAIN      277 /* 4 * ln(2) */
+#define BBR_STARTUP_CWND_GAIN        200
+#define BBR_DRAIN_PACING_GAIN         35 /* 1 / 2.885 */
+#define BBR_DEFAULT_CWND_GAIN        200
+#define BBR_PROBE_DOWN_PACING_GAIN    90
+#define BBR_PROBE_UP_PACING_GAIN     125
+#define BBR_PROBE_UP_CWND_GAIN       225
+#define BBR_PROBE_RTT_CWND_GAIN       50
+#define BBR_PACING_MARGIN              1 /* pace below the estimated bandwidth */
+#define BBR_LOSS_THRESH                2 /* maximum tolerated loss rate when probing */
+#define BBR_BETA                      70 /* multiplicative decrease on loss */
+#define BBR_HEADROOM                  15 /* free space left for cross traffic */
+#define BBR_FULL_BW_THRESH           125 /* minimum bandwidth growth per round */
+#define BBR_FULL_BW_COUNT              3 /* rounds without growth to fill the pipe */
+#define BBR_STARTUP_FULL_LOSS_CNT      6 /* loss events in a round to exit startup */
+#define BBR_MAX_PROBE_UP_ROUNDS       30
+#define BBR_MAX_RENO_ROUNDS           63
+#define BBR_EXTRA_ACKED_WIN_ROUNDS     5 /* half of the aggregation filter length */
+
+/* All the durations are expressed in microseconds. */
+#define BBR_MIN_RTT_FILTER_LEN  10000000ULL
+#define BBR_PROBE_RTT_INTERVAL   5000000ULL
+#define BBR_PROBE_RTT_DURATION    200000ULL
+#define BBR_PROBE_WAIT_BASE      2000000ULL
+#define BBR_PROBE_WAIT_RAND      1000000ULL
+
+#define BBR_INFINITE ((uint64_t)-1)
+
+enum bbr_state {
+	BBR_ST_STARTUP,
+	BBR_ST_DRAIN,
+	BBR_ST_PROBE_BW_DOWN,
+	BBR_ST_PROBE_BW_CRUISE,
+	BBR_ST_PROBE_BW_REFILL,
+	BBR_ST_PROBE_BW_UP,
+	BBR_ST_PROBE_RTT,
+};
+
+/* Progress of a bandwidth probing cycle as seen from the ACKs. */
+enum bbr_ack_phase {
+	BBR_ACKS_INIT,
+	BBR_ACKS_REFILLING,
+	BBR_ACKS_PROBE_STARTING,
+	BBR_ACKS_PROBE_FEEDBACK,
+	BBR_ACKS_PROBE_STOPPING,
+};
+
+#define BBR_FL_FILLED_PIPE          0x01 /* the bottleneck bandwidth was reached once */
+#define BBR_FL_FULL_BW_NOW          0x02 /* the bandwidth stopped growing */
+#define BBR_FL_ROUND_START          0x04 /* a new round trip started with this ACK */
+#define BBR_FL_LOSS_ROUND_START     0x08 /* a new loss round started with this ACK */
+#define BBR_FL_LOSS_IN_ROUND        0x10 /* losses were detected during this round */
+#define BBR_FL_PROBE_RTT_EXPIRED    0x20 /* the min RTT was not refreshed recently */
+#define BBR_FL_PROBE_RTT_ROUND_DONE 0x40 /* a round elapsed in PROBE_RTT state */
+#define BBR_FL_BW_PROBE_SAMPLES     0x80 /* the samples may be used to bound inflight */
+
+/* BBR state */
+struct bbr {
+	/* Max delivery rates of the last two probing cycles (bytes/s). */
+	uint64_t max_bw_filter[2];
+	uint64_t max_bw;
+	/* Bandwidth used by the model, bounded by <bw_lo> (bytes/s). */
+	uint64_t bw;
+	uint64_t bw_lo;
+	uint64_t bw_latest;
+	/* Data in flight bounds (bytes). */
+	uint64_t inflight_hi;
+	uint64_t inflight_lo;
+	uint64_t inflight_latest;
+	uint64_t full_bw;
+	uint64_t pacing_rate;
+	uint64_t initial_cwnd;
+	uint64_t prior_cwnd;
+	/* Delivered bytes which end the current round and loss round. */
+	uint64_t next_round_delivered;
+	uint64_t loss_round_delivered;
+	/* Data ACKed in excess of the estimated bandwidth, used to compensate
+	 * for ACK aggregation, over the last two windows of rounds (bytes).
+	 */
+	uint64_t extra_acked[2];
+	uint64_t extra_acked_delivered;
+	uint64_t extra_acked_interval_start;
+	/* ACKed bytes and packet count to grow <inflight_hi> when probing. */
+	uint64_t bw_probe_up_acks;
+	uint64_t bw_probe_up_cnt;
+	/* Minimum RTT and its probing (us). */
+	uint64_t min_rtt;
+	uint64_t min_rtt_stamp;
+	uint64_t probe_rtt_min_delay;
+	uint64_t probe_rtt_min_stamp;
+	uint64_t probe_rtt_done_stamp;
+	/* Start and duration of the current probing cycle phase (us). */
+	uint64_t cycle_stamp;
+	uint64_t bw_probe_wait;
+	uint32_t round_count;
+	uint32_t rounds_since_bw_probe;
+	uint32_t bw_probe_up_rounds;
+	uint32_t cycle_count;
+	uint32_t loss_events_in_round;
+	uint32_t extra_acked_win_rounds;
+	uint32_t extra_acked_win_idx;
+	uint16_t pacing_gain;
+	uint16_t cwnd_gain;
+	uint8_t state;
+	uint8_t ack_phase;
+	uint8_t full_bw_count;
+	uint8_t flags;
+};
+
+static const char *bbr_state_str(const struct bbr *bbr)
+{
+	switch (bbr->state) {
+	case BBR_ST_STARTUP:         return "startup";
+	case BBR_ST_DRAIN:           return "drain";
+	case BBR_ST_PROBE_BW_DOWN:   return "probe_bw_down";
+	case BBR_ST_PROBE_BW_CRUISE: return "probe_bw_cruise";
+	case BBR_ST_PROBE_BW_REFILL: return "probe_bw_refill";
+	case BBR_ST_PROBE_BW_UP:     return "probe_bw_up";
+	case BBR_ST_PROBE_RTT:       return "probe_rtt";
+	default:                     return "unknown";
+	}
+}
+
+static inline int bbr_is_in_probe_bw(const struct bbr *bbr)
+{
+	return bbr->state >= BBR_ST_PROBE_BW_DOWN && bbr->state <= BBR_ST_PROBE_BW_UP;
+}
+
+static inline int bbr_is_probing_bw(const struct bbr *bbr)
+{
+	return bbr->state == BBR_ST_STARTUP ||
+		bbr->state == BBR_ST_PROBE_BW_REFILL ||
+		bbr->state == BBR_ST_PROBE_BW_UP;
+}
+
+static inline uint64_t bbr_min_pipe_cwnd(const struct quic_cc_path *path)
+{
+	return 4 * path->mtu;
+}
+
+/* Returns the bandwidth-delay product of <bw> with <gain> applied. */
+static uint64_t bbr_bdp(const struct bbr *bbr, uint64_t bw, uint gain)
+{
+	if (bbr->min_rtt == BBR_INFINITE)
+		return bbr->initial_cwnd;
+
+	return bw * bbr->min_rtt / 1000000ULL * gain / 100;
+}
+
+/* Returns the data in flight required to fully use the path at <bw> with
+ * <gain>, including a budget for the datagrams sent by bursts.
+ */
+static uint64_t bbr_inflight(const struct quic_cc_path *path,
+                             const struct bbr *bbr, uint64_t bw, uint gain)
+{
+	uint64_t inflight;
+
+	inflight = bbr_bdp(bbr, bw, gain) + 3 * path->mtu;
+	inflight = MAX(inflight, bbr_min_pipe_cwnd(path));
+	if (bbr->state == BBR_ST_PROBE_BW_UP)
+		inflight += 2 * path->mtu;
+
+	return inflight;
+}
+
+static inline uint64_t bbr_target_inflight(const struct quic_cc_path *path,
+                                           const struct bbr *bbr)
+{
+	return MIN(bbr_bdp(bbr, bbr->bw, 100), path->cwnd);
+}
+
+/* Returns <inflight_hi> minus some headroom left to the other flows. */
+static uint64_t bbr_inflight_with_headroom(const struct quic_cc_path *path,
+                                           const struct bbr *bbr)
+{
+	uint64_t headroom;
+
+	if (bbr->inflight_hi == BBR_INFINITE)
+		return BBR_INFINITE;
+
+	headroom = MAX(path->mtu, bbr->inflight_hi * BBR_HEADROOM / 100);
+	if (bbr->inflight_hi < headroom)
+		return bbr_min_pipe_cwnd(path);
+
+	return MAX(bbr->inflight_hi - headroom, bbr_min_pipe_cwnd(path));
+}
+
+static inline int bbr_has_elapsed_in_phase(const struct bbr *bbr, uint64_t interval)
+{
+	return quic_cc_drs_now() > bbr->cycle_stamp + interval;
+}
+
+static inline void bbr_start_round(const struct quic_cc_path *path, struct bbr *bbr)
+{
+	bbr->next_round_delivered = path->drs.delivered;
+}
+
+static void bbr_save_cwnd(const struct quic_cc_path *path, struct bbr *bbr)
+{
+	if (bbr->state != BBR_ST_PROBE_RTT)
+		bbr->prior_cwnd = path->cwnd;
+	else
+		bbr->prior_cwnd = MAX(bbr->prior_cwnd, path->cwnd);
+}
+
+static void bbr_restore_cwnd(struct quic_cc_path *path, struct bbr *bbr)
+{
+	path->cwnd = MAX(path->cwnd, bbr->prior_cwnd);
+}
+
+static void bbr_reset_full_bw(struct bbr *bbr)
+{
+	bbr->full_bw = 0;
+	bbr->full_bw_count = 0;
+	bbr->flags &= ~BBR_FL_FULL_BW_NOW;
+}
+
+static void bbr_reset_lower_bounds(struct bbr *bbr)
+{
+	bbr->bw_lo = BBR_INFINITE;
+	bbr->inflight_lo = BBR_INFINITE;
+}
+
+static void bbr_reset_congestion_signals(struct bbr *bbr)
+{
+	bbr->flags &= ~BBR_FL_LOSS_IN_ROUND;
+	bbr->bw_latest = 0;
+	bbr->inflight_latest = 0;
+}
+
+static void bbr_advance_max_bw_filter(struct bbr *bbr)
+{
+	bbr->cycle_count++;
+	bbr->max_bw_filter[bbr->cycle_count & 1] = 0;
+	bbr->max_bw = MAX(bbr->max_bw_filter[0], bbr->max_bw_filter[1]);
+}
+
+static void bbr_enter_startup(struct bbr *bbr)
+{
+	bbr->state = BBR_ST_STARTUP;
+	bbr->pacing_gain = BBR_STARTUP_PACING_GAIN;
+	bbr->cwnd_gain = BBR_STARTUP_CWND_GAIN;
+}
+
+static void bbr_enter_drain(struct bbr *bbr)
+{
+	bbr->state = BBR_ST_DRAIN;
+	bbr->pacing_gain = BBR_DRAIN_PACING_GAIN;
+	bbr->cwnd_gain = BBR_DEFAULT_CWND_GAIN;
+}
+
+/* Randomize the time before the next bandwidth probe to desynchronize the
+ * flows sharing the same bottleneck.
+ */
+static void bbr_pick_probe_wait(struct bbr *bbr)
+{
+	bbr->rounds_since_bw_probe = statistical_prng_range(2);
+	bbr->bw_probe_wait = BBR_PROBE_WAIT_BASE +
+		(uint64_t)statistical_prng_range(1000) * BBR_PROBE_WAIT_RAND / 1000;
+}
+
+static void bbr_start_probe_bw_down(struct quic_cc_path *path, struct bbr *bbr)
+{
+	bbr_reset_congestion_signals(bbr);
+	bbr->bw_probe_up_cnt = BBR_INFINITE;
+	bbr_pick_probe_wait(bbr);
+	bbr->cycle_stamp = quic_cc_drs_now();
+	bbr->ack_phase = BBR_ACKS_PROBE_STOPPING;
+	bbr_start_round(path, bbr);
+	bbr->state = BBR_ST_PROBE_BW_DOWN;
+	bbr->pacing_gain = BBR_PROBE_DOWN_PACING_GAIN;
+	bbr->cwnd_gain = BBR_DEFAULT_CWND_GAIN;
+}
+
+static void bbr_start_probe_bw_cruise(struct bbr *bbr)
+{
+	bbr->state = BBR_ST_PROBE_BW_CRUISE;
+	bbr->pacing_gain = 100;
+	bbr->cwnd_gain = BBR_DEFAULT_CWND_GAIN;
+}
+
+static void bbr_start_probe_bw_refill(struct quic_cc_path *path, struct bbr *bbr)
+{
+	bbr_reset_lower_bounds(bbr);
+	bbr->bw_probe_up_rounds = 0;
+	bbr->bw_probe_up_acks = 0;
+	bbr->ack_phase = BBR_ACKS_REFILLING;
+	bbr_start_round(path, bbr);
+	bbr->state = BBR_ST_PROBE_BW_REFILL;
+	bbr->pacing_gain = 100;
+	bbr->cwnd_gain = BBR_DEFAULT_CWND_GAIN;
+}
+
+/* Set the number of packets to be ACKed to grow <inflight_hi> by one packet,
+ * doubling the growth at each round.
+ */
+static void bbr_raise_inflight_hi_slope(const struct quic_cc_path *path, struct bbr *bbr)
+{
+	uint64_t growth_this_round = 1ULL << bbr->bw_probe_up_rounds;
+
+	bbr->bw_probe_up_rounds = MIN(bbr->bw_probe_up_rounds + 1, BBR_MAX_PROBE_UP_ROUNDS);
+	bbr->bw_probe_up_cnt = MAX(path->cwnd / path->mtu / growth_this_round, 1);
+}
+
+static void bbr_start_probe_bw_up(struct quic_cc_path *path, struct bbr *bbr,
+                                  const struct quic_cc_rs *rs)
+{
+	bbr->ack_phase = BBR_ACKS_PROBE_STARTING;
+	bbr_start_round(path, bbr);
+	bbr_reset_full_bw(bbr);
+	bbr->full_bw = quic_cc_rs_rate(rs);
+	bbr->state = BBR_ST_PROBE_BW_UP;
+	bbr->pacing_gain = BBR_PROBE_UP_PACING_GAIN;
+	bbr->cwnd_gain = BBR_PROBE_UP_CWND_GAIN;
+	bbr_raise_inflight_hi_slope(path, bbr);
+}
+
+/* Returns true if the losses of <rs> sample exceed the tolerated loss rate. */
+static inline int bbr_is_inflight_too_high(const struct quic_cc_rs *rs)
+{
+	return rs->lost * 100 > rs->tx_in_flight * BBR_LOSS_THRESH;
+}
+
+static void bbr_handle_inflight_too_high(struct quic_cc_path *path, struct bbr *bbr,
+                                         const struct quic_cc_rs *rs)
+{
+	bbr->flags &= ~BBR_FL_BW_PROBE_SAMPLES;
+	if (!rs->is_app_limited)
+		bbr->inflight_hi = MAX(rs->tx_in_flight,
+		                       bbr_target_inflight(path, bbr) * BBR_BETA / 100);
+	if (bbr->state == BBR_ST_PROBE_BW_UP)
+		bbr_start_probe_bw_down(path, bbr);
+}
+
+static int bbr_check_inflight_too_high(struct quic_cc_path *path, struct bbr *bbr,
+                                       const struct quic_cc_rs *rs)
+{
+	if (!bbr_is_inflight_too_high(rs))
+		return 0;
+
+	if (bbr->flags & BBR_FL_BW_PROBE_SAMPLES)
+		bbr_handle_inflight_too_high(path, bbr, rs);
+	return 1;
+}
+
+static inline int bbr_is_cwnd_limited(const struct quic_cc_path *path,
+                                      const struct quic_cc_rs *rs)
+{
+	return rs->tx_in_flight + path->mtu >= path->cwnd;
+}
+
+/* Grow <inflight_hi> while probing for more bandwidth without losses. */
+static void bbr_probe_inflight_hi_upward(const struct quic_cc_path *path, struct bbr *bbr,
+                                         const struct quic_cc_rs *rs)
+{
+	uint64_t cnt, delta;
+
+	if (!bbr_is_cwnd_limited(path, rs) || path->cwnd < bbr->inflight_hi)
+		return;
+
+	bbr->bw_probe_up_acks += rs->newly_acked;
+	cnt = bbr->bw_probe_up_cnt * path->mtu;
+	if (bbr->bw_probe_up_acks >= cnt) {
+		delta = bbr->bw_probe_up_acks / cnt;
+		bbr->bw_probe_up_acks -= delta * cnt;
+		bbr->inflight_hi += delta * path->mtu;
+	}
+
+	if (bbr->flags & BBR_FL_ROUND_START)
+		bbr_raise_inflight_hi_slope(path, bbr);
+}
+
+static void bbr_adapt_upper_bounds(struct quic_cc_path *path, struct bbr *bbr,
+                                   const struct quic_cc_rs *rs)
+{
+	if (bbr->flags & BBR_FL_ROUND_START) {
+		if (bbr->ack_phase == BBR_ACKS_PROBE_STARTING)
+			bbr->ack_phase = BBR_ACKS_PROBE_FEEDBACK;
+		else if (bbr->ack_phase == BBR_ACKS_PROBE_STOPPING &&
+		         bbr_is_in_probe_bw(bbr) && !rs->is_app_limited)
+			bbr_advance_max_bw_filter(bbr);
+	}
+
+	if (bbr_check_inflight_too_high(path, bbr, rs))
+		return;
+
+	if (bbr->inflight_hi == BBR_INFINITE)
+		return;
+
+	if (rs->tx_in_flight > bbr->inflight_hi)
+		bbr->inflight_hi = rs->tx_in_flight;
+
+	if (bbr->state == BBR_ST_PROBE_BW_UP)
+		bbr_probe_inflight_hi_upward(path, bbr, rs);
+}
+
+/* Probe more often than every two seconds on paths with a small BDP, to
+ * remain fair with Reno flows.
+ */
+static int bbr_is_reno_coexistence_probe_time(const struct quic_cc_path *path,
+                                              const struct bbr *bbr)
+{
+	uint64_t reno_rounds = bbr_target_inflight(path, bbr) / path->mtu;
+
+	return bbr->rounds_since_bw_probe >= MIN(reno_rounds, BBR_MAX_RENO_ROUNDS);
+}
+
+static int bbr_check_time_to_probe_bw(struct quic_cc_path *path, struct bbr *bbr)
+{
+	if (bbr_has_elapsed_in_phase(bbr, bbr->bw_probe_wait) ||
+	    bbr_is_reno_coexistence_probe_time(path, bbr)) {
+		bbr_start_probe_bw_refill(path, bbr);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int bbr_check_time_to_cruise(const struct quic_cc_path *path, const struct bbr *bbr)
+{
+	if (path->in_flight > bbr_inflight_with_headroom(path, bbr))
+		return 0;
+
+	return path->in_flight <= bbr_inflight(path, bbr, bbr->max_bw, 100);
+}
+
+static int bbr_check_time_to_go_down(const struct quic_cc_path *path, struct bbr *bbr,
+                                     const struct quic_cc_rs *rs)
+{
+	if (bbr_is_cwnd_limited(path, rs) && path->cwnd >= bbr->inflight_hi) {
+		bbr_reset_full_bw(bbr);
+		bbr->full_bw = quic_cc_rs_rate(rs);
+	}
+	else if (bbr->flags & BBR_FL_FULL_BW_NOW) {
+		return 1;
+	}
+
+	return 0;
+}
+
+static void bbr_update_probe_bw_cycle_phase(struct quic_cc_path *path, struct bbr *bbr,
+                                            const struct quic_cc_rs *rs)
+{
+	if (!(bbr->flags & BBR_FL_FILLED_PIPE))
+		return;
+
+	bbr_adapt_upper_bounds(path, bbr, rs);
+	if (!bbr_is_in_probe_bw(bbr))
+		return;
+
+	switch (bbr->state) {
+	case BBR_ST_PROBE_BW_DOWN:
+		if (bbr_check_time_to_probe_bw(path, bbr))
+			break;
+		if (bbr_check_time_to_cruise(path, bbr))
+			bbr_start_probe_bw_cruise(bbr);
+		break;
+
+	case BBR_ST_PROBE_BW_CRUISE:
+		bbr_check_time_to_probe_bw(path, bbr);
+		break;
+
+	case BBR_ST_PROBE_BW_REFILL:
+		/* After one round of REFILL, start UP. */
+		if (bbr->flags & BBR_FL_ROUND_START) {
+			bbr->flags |= BBR_FL_BW_PROBE_SAMPLES;
+			bbr_start_probe_bw_up(path, bbr, rs);
+		}
+		break;
+
+	case BBR_ST_PROBE_BW_UP:
+		if (bbr_check_time_to_go_down(path, bbr, rs))
+			bbr_start_probe_bw_down(path, bbr);
+		break;
+	}
+}
+
+static void bbr_update_round(struct quic_cc_path *path, struct bbr *bbr,
+                             const struct quic_cc_rs *rs)
+{
+	if (rs->prior_delivered >= bbr->next_round_delivered) {
+		bbr_start_round(path, bbr);
+		bbr->round_count++;
+		bbr->rounds_since_bw_probe++;
+		bbr->flags |= BBR_FL_ROUND_START;
+	}
+	else {
+		bbr->flags &= ~BBR_FL_ROUND_START;
+	}
+}
+
+static void bbr_update_max_bw(struct quic_cc_path *path, struct bbr *bbr,
+                              const struct quic_cc_rs *rs)
+{
+	uint64_t rate = quic_cc_rs_rate(rs);
+	uint64_t *slot;
+
+	bbr_update_round(path, bbr, rs);
+	if (!rate || (rate < bbr->max_bw && rs->is_app_limited))
+		return;
+
+	slot = &bbr->max_bw_filter[bbr->cycle_count & 1];
+	*slot = MAX(*slot, rate);
+	bbr->max_bw = MAX(bbr->max_bw_filter[0], bbr->max_bw_filter[1]);
+}
+
+static void bbr_update_latest_delivery_signals(struct quic_cc_path *path, struct bbr *bbr,
+                                               const struct quic_cc_rs *rs)
+{
+	bbr->flags &= ~BBR_FL_LOSS_ROUND_START;
+	bbr->bw_latest = MAX(bbr->bw_latest, quic_cc_rs_rate(rs));
+	bbr->inflight_latest = MAX(bbr->inflight_latest, rs->delivered);
+	if (rs->prior_delivered >= bbr->loss_round_delivered) {
+		bbr->loss_round_delivered = path->drs.delivered;
+		bbr->flags |= BBR_FL_LOSS_ROUND_START;
+	}
+}
+
+static void bbr_advance_latest_delivery_signals(struct bbr *bbr, const struct quic_cc_rs *rs)
+{
+	if (bbr->flags & BBR_FL_LOSS_ROUND_START) {
+		bbr->bw_latest = quic_cc_rs_rate(rs);
+		bbr->inflight_latest = rs->delivered;
+	}
+}
+
+/* Reduce the lower bounds of the model after a round with losses. This is not
+ * done while probing for bandwidth where some losses are expected.
+ */
+static void bbr_adapt_lower_bounds_from_congestion(const struct quic_cc_path *path,
+                                                   struct bbr *bbr)
+{
+	if (bbr_is_probing_bw(bbr) || !(bbr->flags & BBR_FL_LOSS_IN_ROUND))
+		return;
+
+	if (bbr->bw_lo == BBR_INFINITE)
+		bbr->bw_lo = bbr->max_bw;
+	if (bbr->inflight_lo == BBR_INFINITE)
+		bbr->inflight_lo = path->cwnd;
+
+	bbr->bw_lo = MAX(bbr->bw_latest, bbr->bw_lo * BBR_BETA / 100);
+	bbr->inflight_lo = MAX(bbr->inflight_latest, bbr->inflight_lo * BBR_BETA / 100);
+}
+
+/* Exit STARTUP if too many losses were detected during the last round. */
+static void bbr_check_startup_high_loss(const struct quic_cc_path *path, struct bbr *bbr,
+                                        const struct quic_cc_rs *rs)
+{
+	if (bbr->state != BBR_ST_STARTUP || (bbr->flags & BBR_FL_FILLED_PIPE))
+		return;
+
+	if (bbr->loss_events_in_round >= BBR_STARTUP_FULL_LOSS_CNT &&
+	    bbr_is_inflight_too_high(rs)) {
+		bbr->inflight_hi = MAX(bbr_bdp(bbr, bbr->max_bw, 100), bbr->inflight_latest);
+		bbr->flags |= BBR_FL_FILLED_PIPE;
+	}
+}
+
+static void bbr_update_congestion_signals(struct quic_cc_path *path, struct bbr *bbr,
+                                          const struct quic_cc_rs *rs)
+{
+	bbr_update_max_bw(path, bbr, rs);
+	if (rs->newly_lost)
+		bbr->flags |= BBR_FL_LOSS_IN_ROUND;
+
+	if (!(bbr->flags & BBR_FL_LOSS_ROUND_START))
+		return;
+
+	bbr_check_startup_high_loss(path, bbr, rs);
+	bbr_adapt_lower_bounds_from_congestion(path, bbr);
+	bbr->flags &= ~BBR_FL_LOSS_IN_ROUND;
+	bbr->loss_events_in_round = 0;
+}
+
+static inline uint64_t bbr_extra_acked(const struct bbr *bbr)
+{
+	return MAX(bbr->extra_acked[0], bbr->extra_acked[1]);
+}
+
+/* Estimate the amount of data ACKed in excess of the estimated bandwidth, as
+ * delayed or aggregated ACKs would otherwise stall the emission.
+ */
+static void bbr_update_ack_aggregation(const struct quic_cc_path *path, struct bbr *bbr,
+                                       const struct quic_cc_rs *rs)
+{
+	uint64_t now = quic_cc_drs_now();
+	uint64_t expected, extra;
+
+	if (bbr->flags & BBR_FL_ROUND_START) {
+		/* One round only while the pipe is not filled. */
+		if (!(bbr->flags & BBR_FL_FILLED_PIPE) ||
+		    ++bbr->extra_acked_win_rounds >= BBR_EXTRA_ACKED_WIN_ROUNDS) {
+			bbr->extra_acked_win_rounds = 0;
+			bbr->extra_acked_win_idx ^= 1;
+			bbr->extra_acked[bbr->extra_acked_win_idx] = 0;
+		}
+	}
+
+	expected = bbr->bw * (now - bbr->extra_acked_interval_start) / 1000000ULL;
+	/* Restart the sampling interval when the ACK rate is below the bandwidth. */
+	if (bbr->extra_acked_delivered <= expected) {
+		bbr->extra_acked_delivered = 0;
+		bbr->extra_acked_interval_start = now;
+		expected = 0;
+	}
+
+	bbr->extra_acked_delivered += rs->newly_acked;
+	extra = MIN(bbr->extra_acked_delivered - expected, path->cwnd);
+	if (extra > bbr->extra_acked[bbr->extra_acked_win_idx])
+		bbr->extra_acked[bbr->extra_acked_win_idx] = extra;
+}
+
+/* Detect that the bandwidth stopped growing for BBR_FULL_BW_COUNT rounds. */
+static void bbr_check_full_bw_reached(struct bbr *bbr, const struct quic_cc_rs *rs)
+{
+	uint64_t rate = quic_cc_rs_rate(rs);
+
+	if ((bbr->flags & BBR_FL_FULL_BW_NOW) || !(bbr->flags & BBR_FL_ROUND_START) ||
+	    rs->is_app_limited)
+		return;
+
+	if (rate >= bbr->full_bw * BBR_FULL_BW_THRESH / 100) {
+		bbr->full_bw = rate;
+		bbr->full_bw_count = 0;
+		return;
+	}
+
+	if (++bbr->full_bw_count >= BBR_FULL_BW_COUNT)
+		bbr->flags |= BBR_FL_FULL_BW_NOW | BBR_FL_FILLED_PIPE;
+}
+
+static void bbr_check_startup_done(struct bbr *bbr)
+{
+	if (bbr->state == BBR_ST_STARTUP && (bbr->flags & BBR_FL_FILLED_PIPE))
+		bbr_enter_drain(bbr);
+}
+
+static void bbr_check_drain_done(struct quic_cc_path *path, struct bbr *bbr)
+{
+	if (bbr->state == BBR_ST_DRAIN &&
+	    path->in_flight <= bbr_inflight(path, bbr, bbr->bw, 100))
+		bbr_start_probe_bw_down(path, bbr);
+}
+
+static void bbr_update_min_rtt(struct bbr *bbr, const struct quic_cc_rs *rs)
+{
+	uint64_t now = quic_cc_drs_now();
+	uint64_t rtt = MAX(rs->rtt, 1);
+
+	if (now > bbr->probe_rtt_min_stamp + BBR_PROBE_RTT_INTERVAL)
+		bbr->flags |= BBR_FL_PROBE_RTT_EXPIRED;
+	else
+		bbr->flags &= ~BBR_FL_PROBE_RTT_EXPIRED;
+
+	if (rtt < bbr->probe_rtt_min_delay || (bbr->flags & BBR_FL_PROBE_RTT_EXPIRED)) {
+		bbr->probe_rtt_min_delay = rtt;
+		bbr->probe_rtt_min_stamp = now;
+	}
+
+	if (bbr->probe_rtt_min_delay < bbr->min_rtt ||
+	    now > bbr->min_rtt_stamp + BBR_MIN_RTT_FILTER_LEN) {
+		bbr->min_rtt = bbr->probe_rtt_min_delay;
+		bbr->min_rtt_stamp = bbr->probe_rtt_min_stamp;
+	}
+}
+
+static inline uint64_t bbr_probe_rtt_cwnd(const struct quic_cc_path *path,
+                                          const struct bbr *bbr)
+{
+	return MAX(bbr_bdp(bbr, bbr->bw, BBR_PROBE_RTT_CWND_GAIN), bbr_min_pipe_cwnd(path));
+}
+
+static void bbr_exit_probe_rtt(struct quic_cc_path *path, struct bbr *bbr)
+{
+	bbr_reset_lower_bounds(bbr);
+	if (bbr->flags & BBR_FL_FILLED_PIPE) {
+		bbr_start_probe_bw_down(path, bbr);
+		bbr_start_probe_bw_cruise(bbr);
+	}
+	else {
+		bbr_enter_startup(bbr);
+	}
+}
+
+static void bbr_handle_probe_rtt(struct quic_cc_path *path, struct bbr *bbr)
+{
+	uint64_t now = quic_cc_drs_now();
+
+	/* Ignore the low rate samples during PROBE_RTT. */
+	quic_cc_drs_on_app_limited(path);
+
+	if (!bbr->probe_rtt_done_stamp &&
+	    path->in_flight <= bbr_probe_rtt_cwnd(path, bbr)) {
+		/* Wait for at least BBR_PROBE_RTT_DURATION and one round. */
+		bbr->probe_rtt_done_stamp = now + BBR_PROBE_RTT_DURATION;
+		bbr->flags &= ~BBR_FL_PROBE_RTT_ROUND_DONE;
+		bbr_start_round(path, bbr);
+	}
+	else if (bbr->probe_rtt_done_stamp) {
+		if (bbr->flags & BBR_FL_ROUND_START)
+			bbr->flags |= BBR_FL_PROBE_RTT_ROUND_DONE;
+		if ((bbr->flags & BBR_FL_PROBE_RTT_ROUND_DONE) &&
+		    now > bbr->probe_rtt_done_stamp) {
+			bbr->probe_rtt_min_stamp = now;
+			bbr_restore_cwnd(path, bbr);
+			bbr_exit_probe_rtt(path, bbr);
+		}
+	}
+}
+
+static void bbr_check_probe_rtt(struct quic_cc_path *path, struct bbr *bbr)
+{
+	if (bbr->state != BBR_ST_PROBE_RTT && (bbr->flags & BBR_FL_PROBE_RTT_EXPIRED)) {
+		bbr_save_cwnd(path, bbr);
+		bbr->probe_rtt_done_stamp = 0;
+		bbr->ack_phase = BBR_ACKS_PROBE_STOPPING;
+		bbr_start_round(path, bbr);
+		bbr->state = BBR_ST_PROBE_RTT;
+		bbr->pacing_gain = 100;
+		bbr->cwnd_gain = BBR_PROBE_RTT_CWND_GAIN;
+	}
+
+	if (bbr->state == BBR_ST_PROBE_RTT)
+		bbr_handle_probe_rtt(path, bbr);
+}
+
+static void bbr_set_pacing_rate(struct bbr *bbr)
+{
+	uint64_t rate;
+
+	rate = bbr->bw * bbr->pacing_gain / 100 * (100 - BBR_PACING_MARGIN) / 100;
+	if ((bbr->flags & BBR_FL_FILLED_PIPE) || rate > bbr->pacing_rate)
+		bbr->pacing_rate = rate;
+}
+
+static void bbr_set_cwnd(struct quic_cc_path *path, struct bbr *bbr,
+                         const struct quic_cc_rs *rs)
+{
+	uint64_t max_inflight, cap;
+
+	max_inflight = bbr_inflight(path, bbr, bbr->bw, bbr->cwnd_gain) + bbr_extra_acked(bbr);
+
+	if (rs->newly_lost)
+		path->cwnd -= MIN(rs->newly_lost, path->cwnd);
+
+	if (bbr->flags & BBR_FL_FILLED_PIPE)
+		path->cwnd = MIN(path->cwnd + rs->newly_acked, max_inflight);
+	else if (path->cwnd < max_inflight || path->drs.delivered < bbr->initial_cwnd)
+		path->cwnd += rs->newly_acked;
+	path->cwnd = MAX(path->cwnd, bbr_min_pipe_cwnd(path));
+
+	if (bbr->state == BBR_ST_PROBE_RTT)
+		path->cwnd = MIN(path->cwnd, bbr_probe_rtt_cwnd(path, bbr));
+
+	/* Bound the window by the model. */
+	cap = BBR_INFINITE;
+	if (bbr_is_in_probe_bw(bbr) && bbr->state != BBR_ST_PROBE_BW_CRUISE)
+		cap = bbr->inflight_hi;
+	else if (bbr->state == BBR_ST_PROBE_RTT || bbr->state == BBR_ST_PROBE_BW_CRUISE)
+		cap = bbr_inflight_with_headroom(path, bbr);
+	cap = MIN(cap, bbr->inflight_lo);
+	cap = MAX(cap, bbr_min_pipe_cwnd(path));
+	path->cwnd = MIN(path->cwnd, cap);
+
+	path->cwnd = MIN(path->cwnd, path->max_cwnd);
+	path->mcwnd = MAX(path->cwnd, path->mcwnd);
+}
+
+static int quic_cc_bbr_init(struct quic_cc *cc)
+{
+	struct quic_cc_path *path = container_of(cc, struct quic_cc_path, cc);
+	struct bbr *bbr = quic_cc_priv(cc);
+	uint64_t now = quic_cc_drs_now();
+
+	memset(bbr, 0, sizeof(*bbr));
+	bbr->initial_cwnd = path->cwnd;
+	bbr->min_rtt = BBR_INFINITE;
+	bbr->min_rtt_stamp = now;
+	bbr->extra_acked_interval_start = now;
+	bbr->probe_rtt_min_delay = BBR_INFINITE;
+	bbr->probe_rtt_min_stamp = now;
+	bbr->inflight_hi = BBR_INFINITE;
+	bbr->bw_probe_up_cnt = BBR_INFINITE;
+	bbr_reset_lower_bounds(bbr);
+	bbr_enter_startup(bbr);
+
+	return 1;
+}
+
+/* Persistent congestion: restart from the minimum window. */
+static void quic_cc_bbr_slow_start(struct quic_cc *cc)
+{
+	struct quic_cc_path *path = container_of(cc, struct quic_cc_path, cc);
+	struct bbr *bbr = quic_cc_priv(cc);
+
+	bbr_save_cwnd(path, bbr);
+	path->cwnd = bbr_min_pipe_cwnd(path);
+}
+
+/* The model is updated once per ACK frame by quic_cc_bbr_on_ack_rcvd(). Only
+ * the loss events are counted here.
+ */
+static void quic_cc_bbr_event(struct quic_cc *cc, struct quic_cc_event *ev)
+{
+	struct bbr *bbr = quic_cc_priv(cc);
+
+	TRACE_ENTER(QUIC_EV_CONN_CC, cc->qc);
+	if (ev->type == QUIC_CC_EVT_LOSS) {
+		TRACE_PROTO("CC bbr", QUIC_EV_CONN_CC, cc->qc, ev);
+		bbr->loss_events_in_round += ev->loss.count;
+	}
+	TRACE_LEAVE(QUIC_EV_CONN_CC, cc->qc);
+}
+
+static void quic_cc_bbr_on_ack_rcvd(struct quic_cc *cc, const struct quic_cc_rs *rs)
+{
+	struct quic_cc_path *path = container_of(cc, struct quic_cc_path, cc);
+	struct bbr *bbr = quic_cc_priv(cc);
+
+	TRACE_ENTER(QUIC_EV_CONN_CC, cc->qc);
+	/* No in flight packet was acknowledged. */
+	if (!rs->prior_time)
+		goto leave;
+
+	bbr_update_latest_delivery_signals(path, bbr, rs);
+	bbr_update_congestion_signals(path, bbr, rs);
+	bbr_update_ack_aggregation(path, bbr, rs);
+	bbr_check_full_bw_reached(bbr, rs);
+	bbr_check_startup_done(bbr);
+	bbr_check_drain_done(path, bbr);
+	bbr_update_probe_bw_cycle_phase(path, bbr, rs);
+	bbr_update_min_rtt(bbr, rs);
+	bbr_check_probe_rtt(path, bbr);
+	bbr_advance_latest_delivery_signals(bbr, rs);
+	bbr->bw = MIN(bbr->max_bw, bbr->bw_lo);
+
+	bbr_set_pacing_rate(bbr);
+	bbr_set_cwnd(path, bbr, rs);
+	TRACE_PROTO("CC bbr", QUIC_EV_CONN_CC, cc->qc, NULL, cc);
+
+ leave:
+	TRACE_LEAVE(QUIC_EV_CONN_CC, cc->qc);
+}
+
+static void quic_cc_bbr_hystart_start_round(struct quic_cc *cc, uint64_t pn)
+{
+}
+
+/* Returns the pacing rate in bytes per millisecond. Before the first bandwidth
+ * sample, the initial window is spread over the smoothed RTT with the startup
+ * gain.
+ */
+static uint64_t quic_cc_bbr_pacing_rate(const struct quic_cc *cc)
+{
+	const struct quic_cc_path *path = container_of(cc, struct quic_cc_path, cc);
+	struct bbr *bbr = quic_cc_priv(cc);
+
+	if (!bbr->pacing_rate)
+		return quic_cc_path_rate(path, BBR_STARTUP_PACING_GAIN);
+
+	return MAX(bbr->pacing_rate / 1000, 1);
+}
+
+static inline long long bbr_val(uint64_t v)
+{
+	return v == BBR_INFINITE ? -1 : (long long)v;
+}
+
+static void quic_cc_bbr_state_trace(struct buffer *buf, const struct quic_cc *cc)
+{
+	struct quic_cc_path *path = container_of(cc, struct quic_cc_path, cc);
+	struct bbr *bbr = quic_cc_priv(cc);
+
+	chunk_appendf(buf, " state=%s cwnd=%llu mcwnd=%llu bw=%llu minrtt=%lldus"
+	              " pacing_rate=%llu inflight_hi=%lld pktloss=%llu",
+	              bbr_state_str(bbr),
+	              (ullong)path->cwnd, (ullong)path->mcwnd,
+	              (ullong)bbr->bw, bbr_val(bbr->min_rtt),
+	              (ullong)bbr->pacing_rate, bbr_val(bbr->inflight_hi),
+	              (ullong)path->loss.nb_lost_pkt);
+}
+
+static void quic_cc_bbr_state_cli(struct buffer *buf, const struct quic_cc_path *path)
+{
+	struct bbr *bbr = quic_cc_priv(&path->cc);
+
+	chunk_appendf(buf, "  cc: state=%s bw=%llu max_bw=%llu bw_lo=%lld minrtt=%lldus rounds=%u\n"
+	              "      pacing_rate=%llu pacing_gain=%u cwnd_gain=%u extra_acked=%llu\n"
+	              "      inflight_hi=%lld inflight_lo=%lld\n",
+	              bbr_state_str(bbr), (ullong)bbr->bw, (ullong)bbr->max_bw,
+	              bbr_val(bbr->bw_lo), bbr_val(bbr->min_rtt), bbr->round_count,
+	              (ullong)bbr->pacing_rate, bbr->pacing_gain, bbr->cwnd_gain,
+	              (ullong)bbr_extra_acked(bbr),
+	              bbr_val(bbr->inflight_hi), bbr_val(bbr->inflight_lo));
+}
+
+struct quic_cc_algo quic_cc_algo_bbr = {
+	.type        = QUIC_CC_ALGO_TP_BBR,
+	.init        = quic_cc_bbr_init,
+	.event       = quic_cc_bbr_event,
+	.slow_start  = quic_cc_bbr_slow_start,
+	.hystart_start_round = quic_cc_bbr_hystart_start_round,
+	.state_trace = quic_cc_bbr_state_trace,
+	.state_cli   = quic_cc_bbr_state_cli,
+	.pacing_rate = quic_cc_bbr_pacing_rate,
+	.on_ack_rcvd = quic_cc_bbr_on_ack_rcvd,
+};
+
+void quic_cc_bbr_check(void)
+{
+	struct quic_cc *cc;
+	BUG_ON_HOT(sizeof(struct bbr) > sizeof(cc->priv));
+}
+
+INITCALL0(STG_REGISTER, quic_cc_bbr_check);
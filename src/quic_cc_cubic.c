@@ -672,6 +672,17 @@ static void quic_cc_cubic_state_cli(struct buffer *buf, const struct quic_cc_pat
 	              (int64_t)(path->cwnd - c->last_w_max));
 }
 
+/* Spread twice the window over a RTT during slow start to keep up with its
+ * growth, and 1.25 times the window otherwise as suggested by RFC 9002 7.7.
+ */
+static uint64_t quic_cc_cubic_pacing_rate(const struct quic_cc *cc)
+{
+	const struct quic_cc_path *path = container_of(cc, struct quic_cc_path, cc);
+	struct cubic *c = quic_cc_priv(cc);
+
+	return quic_cc_path_rate(path, c->state == QUIC_CC_ST_SS || c->state == QUIC_CC_ST_CS ? 200 : 125);
+}
+
 struct quic_cc_algo quic_cc_algo_cubic = {
 	.type        = QUIC_CC_ALGO_TP_CUBIC,
 	.init        = quic_cc_cubic_init,
@@ -680,6 +691,7 @@ struct quic_cc_algo quic_cc_algo_cubic = {
 	.hystart_start_round = quic_cc_cubic_hystart_start_round,
 	.state_trace = quic_cc_cubic_state_trace,
 	.state_cli   = quic_cc_cubic_state_cli,
+	.pacing_rate = quic_cc_cubic_pacing_rate,
 };
 
 void quic_cc_cubic_check(void)
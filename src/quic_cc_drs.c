@@ -0,0 +1,118 @@
+/*
+ * Delivery rate sampling for QUIC congestion control.
+ *
+ * The delivery rate of a path is estimated upon each ACK receipt from the
+ * amount of data delivered since the most recently acknowledged packet was
+ * sent, as described by draft-cheng-iccrg-delivery-rate-estimation. These
+ * samples are used by model-based congestion control algorithms such as BBR.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, version 2.1
+ * exclusively.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <haproxy/api.h>
+#include <haproxy/quic_cc_drs.h>
+#include <haproxy/quic_tx-t.h>
+
+/* Snapshot the delivery state of <path> into <pkt> which is about to be sent.
+ * Must be called before <pkt> is accounted as in flight.
+ */
+void quic_cc_drs_on_pkt_sent(struct quic_cc_path *path, struct quic_tx_packet *pkt)
+{
+	struct quic_cc_drs *drs = &path->drs;
+	uint64_t now = quic_cc_drs_now();
+
+	/* Start a new sampling period after an idle period. */
+	if (!path->in_flight)
+		drs->first_sent_time = drs->delivered_time = now;
+
+	pkt->rs.delivered       = drs->delivered;
+	pkt->rs.lost            = drs->lost;
+	pkt->rs.delivered_time  = drs->delivered_time;
+	pkt->rs.first_sent_time = drs->first_sent_time;
+	pkt->rs.time_sent       = now;
+	pkt->rs.tx_in_flight    = path->in_flight + pkt->in_flight_len;
+	pkt->rs.is_app_limited  = !!drs->app_limited;
+}
+
+/* Account for the delivery of <pkt> on <drs>, updating the current rate sample
+ * if this packet is the most recently sent among those acknowledged by the
+ * ACK frame being processed.
+ */
+void quic_cc_drs_on_pkt_acked(struct quic_cc_drs *drs, struct quic_tx_packet *pkt)
+{
+	struct quic_cc_rs *rs = &drs->rs;
+	uint64_t now = quic_cc_drs_now();
+
+	drs->delivered += pkt->in_flight_len;
+	drs->delivered_time = now;
+	rs->newly_acked += pkt->in_flight_len;
+
+	if (rs->prior_time && pkt->rs.time_sent < drs->first_sent_time)
+		return;
+
+	rs->prior_delivered = pkt->rs.delivered;
+	rs->prior_lost      = pkt->rs.lost;
+	rs->prior_time      = pkt->rs.delivered_time;
+	rs->tx_in_flight    = pkt->rs.tx_in_flight;
+	rs->is_app_limited  = pkt->rs.is_app_limited;
+	rs->send_elapsed    = pkt->rs.time_sent - pkt->rs.first_sent_time;
+	rs->ack_elapsed     = drs->delivered_time - pkt->rs.delivered_time;
+	rs->rtt             = now - pkt->rs.time_sent;
+	drs->first_sent_time = pkt->rs.time_sent;
+}
+
+/* Account for the loss of <pkt> on <drs>. */
+void quic_cc_drs_on_pkt_lost(struct quic_cc_drs *drs, struct quic_tx_packet *pkt)
+{
+	drs->lost += pkt->in_flight_len;
+	drs->rs.newly_lost += pkt->in_flight_len;
+}
+
+/* Finalize the rate sample of <drs> once all the packets acknowledged by an
+ * ACK frame have been handled. The sample interval is left null if there is no
+ * valid sample, for instance when it is shorter than <min_rtt> (us).
+ */
+void quic_cc_drs_on_ack_end(struct quic_cc_drs *drs, uint64_t min_rtt)
+{
+	struct quic_cc_rs *rs = &drs->rs;
+
+	/* End of the application limited phase. */
+	if (drs->app_limited && drs->delivered > drs->app_limited)
+		drs->app_limited = 0;
+
+	rs->interval = 0;
+	if (!rs->prior_time)
+		return;
+
+	rs->delivered = drs->delivered - rs->prior_delivered;
+	rs->lost = drs->lost - rs->prior_lost;
+	/* Use the longest of the send and ACK phases to avoid overestimating
+	 * the rate with ACK compression or bursts.
+	 */
+	rs->interval = MAX(rs->send_elapsed, rs->ack_elapsed);
+	if (rs->interval < min_rtt)
+		rs->interval = 0;
+}
+
+/* Mark <path> as application limited: the sender has nothing more to send
+ * while the congestion window is not full. The samples taken until the data
+ * in flight are delivered do not reflect the path capacity.
+ */
+void quic_cc_drs_on_app_limited(struct quic_cc_path *path)
+{
+	struct quic_cc_drs *drs = &path->drs;
+
+	drs->app_limited = MAX(drs->delivered + path->in_flight, 1);
+}
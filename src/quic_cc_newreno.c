@@ -214,6 +214,17 @@ static void quic_cc_nr_event(struct quic_cc *cc, struct quic_cc_event *ev)
 	return quic_cc_nr_state_cbs[nr->state](cc, ev);
 }
 
+/* Same pacing gains as for cubic: twice the window per RTT during slow start,
+ * 1.25 times otherwise.
+ */
+static uint64_t quic_cc_nr_pacing_rate(const struct quic_cc *cc)
+{
+	const struct quic_cc_path *path = container_of(cc, struct quic_cc_path, cc);
+	struct nr *nr = quic_cc_priv(cc);
+
+	return quic_cc_path_rate(path, nr->state == QUIC_CC_ST_SS ? 200 : 125);
+}
+
 struct quic_cc_algo quic_cc_algo_nr = {
 	.type        = QUIC_CC_ALGO_TP_NEWRENO,
 	.init        = quic_cc_nr_init,
@@ -221,6 +232,7 @@ struct quic_cc_algo quic_cc_algo_nr = {
 	.slow_start  = quic_cc_nr_slow_start,
 	.hystart_start_round = quic_cc_nr_hystart_start_round,
 	.state_trace = quic_cc_nr_state_trace,
+	.pacing_rate = quic_cc_nr_pacing_rate,
 };
 
 void quic_cc_nr_check(void)
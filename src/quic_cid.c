@@ -61,7 +61,8 @@ static int quic_stateless_reset_token_init(struct quic_connection_id *conn_id)
  * Returns the derived CID.
  */
 static struct quic_cid quic_derive_cid(const struct quic_cid *orig,
-                                       const struct sockaddr_storage *addr)
+                                       const struct sockaddr_storage *addr,
+                                       const struct listener *li)
 {
 	struct quic_cid cid;
 	const struct sockaddr_in *in;
@@ -110,6 +111,7 @@ static struct quic_cid quic_derive_cid(const struct quic_cid *orig,
 	for (i = 0; i < sizeof(hash); ++i)
 		cid.data[i] = hash >> ((sizeof(hash) * 7) - (8 * i));
 	cid.len = sizeof(hash);
+	quic_cid_steer(&cid, li);
 
 	return cid;
 }
@@ -117,15 +119,17 @@ static struct quic_cid quic_derive_cid(const struct quic_cid *orig,
 /* Allocate a new CID and attach it to <root> ebtree.
  *
  * If <orig> and <addr> params are non null, the new CID value is directly
- * derived from them. Else a random value is generated. The CID is then marked
- * with the current thread ID.
+ * derived from them and from <li> listener which received the packet carrying
+ * <orig>. Else a random value is generated. The CID is then marked with the
+ * current thread ID.
  *
  * Returns the new CID if succeeded, NULL if not.
  */
 struct quic_connection_id *new_quic_cid(struct eb_root *root,
                                         struct quic_conn *qc,
                                         const struct quic_cid *orig,
-                                        const struct sockaddr_storage *addr)
+                                        const struct sockaddr_storage *addr,
+                                        const struct listener *li)
 {
 	struct quic_connection_id *conn_id;
 
@@ -143,7 +147,7 @@ struct quic_connection_id *new_quic_cid(struct eb_root *root,
 	conn_id->cid.len = QUIC_HAP_CID_LEN;
 
 	if (!orig) {
-		if (quic_newcid_from_hash64)
+		if (quic_newcid_from_hash64 && qc && qc_is_listener(qc))
 			quic_newcid_from_hash64(conn_id->cid.data, conn_id->cid.len, qc->hash64,
 						global.cluster_secret, sizeof(global.cluster_secret));
 		else if (RAND_bytes(conn_id->cid.data, conn_id->cid.len) != 1) {
@@ -151,10 +155,12 @@ struct quic_connection_id *new_quic_cid(struct eb_root *root,
 			TRACE_ERROR("RAND_bytes() failed", QUIC_EV_CONN_TXPKT, qc);
 			goto err;
 		}
+		else
+			quic_cid_steer(&conn_id->cid, qc ? qc->li : NULL);
 	}
 	else {
 		/* Derive the new CID value from original CID. */
-		conn_id->cid = quic_derive_cid(orig, addr);
+		conn_id->cid = quic_derive_cid(orig, addr, li);
 	}
 
 	if (quic_stateless_reset_token_init(conn_id) != 1) {
@@ -240,13 +246,14 @@ int quic_cmp_cid_conn(const unsigned char *cid, size_t cid_len,
 /* Retrieve the thread ID associated to QUIC connection ID <cid> of length
  * <cid_len>. CID may be not found on the CID tree because it is an ODCID. In
  * this case, it will derived using client address <cli_addr> as hash
- * parameter. However, this is done only if <pos> points to an INITIAL or 0RTT
- * packet of length <len>.
+ * parameter and <li> receiving listener. However, this is done only if <pos>
+ * points to an INITIAL or 0RTT packet of length <len>.
  *
  * Returns the thread ID or a negative error code.
  */
 int quic_get_cid_tid(const unsigned char *cid, size_t cid_len,
                      const struct sockaddr_storage *cli_addr,
+                     const struct listener *li,
                      unsigned char *pos, size_t len)
 {
 	struct quic_cid_tree *tree;
@@ -281,7 +288,7 @@ int quic_get_cid_tid(const unsigned char *cid, size_t cid_len,
 
 		memcpy(orig.data, cid, cid_len);
 		orig.len = cid_len;
-		derive_cid = quic_derive_cid(&orig, cli_addr);
+		derive_cid = quic_derive_cid(&orig, cli_addr, li);
 
 		tree = &quic_cid_trees[quic_cid_tree_idx(&derive_cid)];
 		HA_RWLOCK_RDLOCK(QC_CID_LOCK, &tree->lock);
@@ -298,13 +305,14 @@ int quic_get_cid_tid(const unsigned char *cid, size_t cid_len,
 }
 
 /* Retrieve a quic_conn instance from the <pkt> DCID field. If the packet is an
- * INITIAL or 0RTT type, we may have to use client address <saddr> if an ODCID
- * is used.
+ * INITIAL or 0RTT type, we may have to use client address <saddr> and <li>
+ * receiving listener if an ODCID is used.
  *
  * Returns the instance or NULL if not found.
  */
 struct quic_conn *retrieve_qc_conn_from_cid(struct quic_rx_packet *pkt,
                                             struct sockaddr_storage *saddr,
+                                            const struct listener *li,
                                             int *new_tid)
 {
 	struct quic_conn *qc = NULL;
@@ -327,7 +335,7 @@ struct quic_conn *retrieve_qc_conn_from_cid(struct quic_rx_packet *pkt,
 	 */
 	if (!node && (pkt->type == QUIC_PACKET_TYPE_INITIAL ||
 	     pkt->type == QUIC_PACKET_TYPE_0RTT)) {
-		const struct quic_cid derive_cid = quic_derive_cid(&pkt->dcid, saddr);
+		const struct quic_cid derive_cid = quic_derive_cid(&pkt->dcid, saddr, li);
 
 		HA_RWLOCK_RDUNLOCK(QC_CID_LOCK, &tree->lock);
 
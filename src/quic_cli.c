@@ -4,8 +4,11 @@
 #include <haproxy/cli.h>
 #include <haproxy/list.h>
 #include <haproxy/mux_quic.h>
+#include <haproxy/obj_type.h>
+#include <haproxy/proxy-t.h>
 #include <haproxy/quic_conn-t.h>
 #include <haproxy/quic_tp.h>
+#include <haproxy/server-t.h>
 #include <haproxy/tools.h>
 
 /* incremented by each "show quic". */
@@ -156,11 +159,16 @@ static int cli_parse_show_quic(char **args, char *payload, struct appctx *appctx
 static void dump_quic_oneline(struct show_quic_ctx *ctx, struct quic_conn *qc)
 {
 	char bufaddr[INET6_ADDRSTRLEN], bufport[6];
+	const char *px_id = "-";
 	int ret;
 	unsigned char cid_len;
 
-	ret = chunk_appendf(&trash, "%p[%02u]/%-.12s ", qc, ctx->thr,
-	                    qc->li->bind_conf->frontend->id);
+	if (qc->li)
+		px_id = qc->li->bind_conf->frontend->id;
+	else if (qc->conn && objt_server(qc->conn->target))
+		px_id = __objt_server(qc->conn->target)->proxy->id;
+
+	ret = chunk_appendf(&trash, "%p[%02u]/%-.12s ", qc, ctx->thr, px_id);
 	chunk_appendf(&trash, "%*s", 36 - ret, " "); /* align output */
 
 	/* State */
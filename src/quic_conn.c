@@ -498,7 +498,7 @@ int quic_build_post_handshake_frames(struct quic_conn *qc)
 			goto err;
 		}
 
-		conn_id = new_quic_cid(qc->cids, qc, NULL, NULL);
+		conn_id = new_quic_cid(qc->cids, qc, NULL, NULL, NULL);
 		if (!conn_id) {
 			qc_frm_free(qc, &frm);
 			TRACE_ERROR("CID allocation error", QUIC_EV_CONN_IO_CB, qc);
@@ -552,6 +552,7 @@ struct task *quic_conn_app_io_cb(struct task *t, void *context, unsigned int sta
 {
 	struct list send_list = LIST_HEAD_INIT(send_list);
 	struct quic_conn *qc = context;
+	struct tasklet *tl = (struct tasklet *)t;
 
 	TRACE_ENTER(QUIC_EV_CONN_IO_CB, qc);
 	TRACE_STATE("connection handshake state", QUIC_EV_CONN_IO_CB, qc, &qc->state);
@@ -581,6 +582,14 @@ struct task *quic_conn_app_io_cb(struct task *t, void *context, unsigned int sta
 		goto out;
 	}
 
+	/* Post-handshake CRYPTO data, such as NewSessionTicket messages
+	 * received by backend connections.
+	 */
+	if (HA_ATOMIC_LOAD(&tl->state) & TASK_HEAVY) {
+		qc_ssl_provide_all_quic_data(qc, qc->xprt_ctx);
+		HA_ATOMIC_AND(&tl->state, ~TASK_HEAVY);
+	}
+
 	if (qc->flags & QUIC_FL_CONN_TO_KILL) {
 		TRACE_DEVEL("connection to be killed", QUIC_EV_CONN_IO_CB, qc);
 		goto out;
@@ -602,7 +611,7 @@ struct task *quic_conn_app_io_cb(struct task *t, void *context, unsigned int sta
 	}
 
  out:
-	if ((qc->flags & QUIC_FL_CONN_CLOSING) && qc->mux_state != QC_MUX_READY) {
+	if ((qc->flags & QUIC_FL_CONN_CLOSING) && !qc_has_upper_layer(qc)) {
 		quic_conn_release(qc);
 		qc = NULL;
 	}
@@ -654,7 +663,7 @@ static struct task *quic_conn_closed_io_cb(struct task *t, void *context, unsign
 
 	buf = b_make(cc_qc->cc_buf_area + headlen,
 	             QUIC_MAX_CC_BUFSIZE - headlen, 0, cc_qc->cc_dgram_len);
-	if (qc_snd_buf(qc, &buf, buf.data, 0, 0) < 0) {
+	if (qc_snd_buf(qc, &buf, buf.data, 0, 0, 0) < 0) {
 		TRACE_ERROR("sendto fatal error", QUIC_EV_CONN_IO_CB, qc);
 		quic_release_cc_conn(cc_qc);
 		cc_qc = NULL;
@@ -755,6 +764,15 @@ struct task *quic_conn_io_cb(struct task *t, void *context, unsigned int state)
 	st = qc->state;
 	TRACE_PROTO("connection state", QUIC_EV_CONN_IO_CB, qc, &st);
 
+	/* A connection to a server starts its handshake on its first wakeup. */
+	if (st == QUIC_HS_ST_CLIENT_INITIAL && qc->iel && !qc->iel->tx.crypto.offset &&
+	    !(qc->flags & (QUIC_FL_CONN_CLOSING|QUIC_FL_CONN_TO_KILL))) {
+		if (!qc_ssl_start_handshake(qc)) {
+			qc_kill_conn(qc);
+			goto out;
+		}
+	}
+
 	/* TASK_HEAVY is set when received CRYPTO data have to be handled. */
 	if (HA_ATOMIC_LOAD(&tl->state) & TASK_HEAVY) {
 		qc_ssl_provide_all_quic_data(qc, qc->xprt_ctx);
@@ -796,7 +814,11 @@ struct task *quic_conn_io_cb(struct task *t, void *context, unsigned int state)
 
 	st = qc->state;
 	if (st >= QUIC_HS_ST_COMPLETE) {
-		if (!(qc->flags & QUIC_FL_CONN_HPKTNS_DCD)) {
+		/* A client must wait for the handshake confirmation before
+		 * discarding its Handshake packet number space (RFC 9001 4.9.2).
+		 */
+		if (!(qc->flags & QUIC_FL_CONN_HPKTNS_DCD) &&
+		    (qc_is_listener(qc) || st >= QUIC_HS_ST_CONFIRMED)) {
 			/* Discard the Handshake packet number space. */
 			TRACE_PROTO("discarding Handshake pktns", QUIC_EV_CONN_PHPKTS, qc);
 			quic_pktns_discard(qc->hel->pktns, qc);
@@ -862,7 +884,7 @@ struct task *quic_conn_io_cb(struct task *t, void *context, unsigned int state)
 		quic_nictx_free(qc);
 	}
 
-	if ((qc->flags & QUIC_FL_CONN_CLOSING) && qc->mux_state != QC_MUX_READY) {
+	if ((qc->flags & QUIC_FL_CONN_CLOSING) && !qc_has_upper_layer(qc)) {
 		quic_conn_release(qc);
 		qc = NULL;
 	}
@@ -966,7 +988,9 @@ struct task *qc_process_timer(struct task *task, void *ctx, unsigned int state)
 
 /* Allocate a new QUIC connection with <version> as QUIC version. <ipv4>
  * boolean is set to 1 for IPv4 connection, 0 for IPv6. <server> is set to 1
- * for QUIC servers (or haproxy listeners).
+ * for QUIC servers (or haproxy listeners), in which case <owner> is the
+ * listener, else to 0 for connections to servers, <owner> being the backend
+ * connection.
  * <dcid> is the destination connection ID, <scid> is the source connection ID.
  * This latter <scid> CID as the same value on the wire as the one for <conn_id>
  * which is the first CID of this connection but a different internal representation used to build
@@ -987,7 +1011,9 @@ struct quic_conn *qc_new_conn(const struct quic_version *qv, int ipv4,
 	int i;
 	struct quic_conn *qc = NULL;
 	struct listener *l = server ? owner : NULL;
-	struct proxy *prx = l ? l->bind_conf->frontend : NULL;
+	struct connection *conn = server ? NULL : owner;
+	struct proxy *prx = server ? ((struct listener *)owner)->bind_conf->frontend :
+	                             __objt_server(((struct connection *)owner)->target)->proxy;
 	struct quic_cc_algo *cc_algo = NULL;
 	unsigned int next_actconn = 0, next_sslconn = 0, next_handshake = 0;
 
@@ -1090,11 +1116,18 @@ struct quic_conn *qc_new_conn(const struct quic_version *qv, int ipv4,
 	}
 	/* QUIC Client (outgoing connection to servers) */
 	else {
+		qc->prx_counters = EXTRA_COUNTERS_GET(prx->extra_counters_be,
+		                                      &quic_stats_module);
+		/* A client is not subject to the anti-amplification limit. */
+		qc->flags = QUIC_FL_CONN_PEER_VALIDATED_ADDR;
 		qc->state = QUIC_HS_ST_CLIENT_INITIAL;
-		if (dcid->len)
-			memcpy(qc->dcid.data, dcid->data, dcid->len);
-		qc->dcid.len = dcid->len;
+		/* <dcid> is the random CID used until the server chooses its own
+		 * one. It is also used to derive the Initial secrets.
+		 */
+		qc->odcid = *dcid;
+		qc->dcid = *dcid;
 		qc->li = NULL;
+		qc->conn = conn;
 	}
 	qc->mux_state = QC_MUX_NULL;
 	qc->err = quic_err_transport(QC_ERR_NO_ERROR);
@@ -1107,7 +1140,7 @@ struct quic_conn *qc_new_conn(const struct quic_version *qv, int ipv4,
 		            QUIC_EV_CONN_INIT, qc);
 		qc->flags |= QUIC_FL_CONN_PEER_VALIDATED_ADDR;
 	}
-	else {
+	else if (server) {
 		HA_ATOMIC_INC(&qc->prx_counters->half_open_conn);
 	}
 
@@ -1127,7 +1160,7 @@ struct quic_conn *qc_new_conn(const struct quic_version *qv, int ipv4,
 
 	conn_id->qc = qc;
 
-	if (HA_ATOMIC_LOAD(&l->rx.quic_mode) == QUIC_SOCK_MODE_CONN &&
+	if (server && HA_ATOMIC_LOAD(&l->rx.quic_mode) == QUIC_SOCK_MODE_CONN &&
 	    (global.tune.options & GTUNE_QUIC_SOCK_PER_CONN) &&
 	    is_addr(local_addr)) {
 		TRACE_USER("Allocate a socket for QUIC connection", QUIC_EV_CONN_INIT, qc);
@@ -1178,7 +1211,7 @@ struct quic_conn *qc_new_conn(const struct quic_version *qv, int ipv4,
 	qc->max_ack_delay = 0;
 	/* Only one path at this time (multipath not supported) */
 	qc->path = &qc->paths[0];
-	quic_cc_path_init(qc->path, ipv4, server ? l->bind_conf->max_cwnd : 0,
+	quic_cc_path_init(qc->path, ipv4, server ? l->bind_conf->max_cwnd : QUIC_DFLT_MAX_WINDOW_SIZE,
 	                  cc_algo ? cc_algo : default_quic_cc_algo, qc);
 
 	memcpy(&qc->local_addr, local_addr, sizeof(qc->local_addr));
@@ -1190,6 +1223,13 @@ struct quic_conn *qc_new_conn(const struct quic_version *qv, int ipv4,
 	                                    qc->scid.data, qc->scid.len, token_odcid))
 		goto err;
 
+	if (!server) {
+		quic_transport_params_init(&qc->rx.params, 0);
+		memcpy(qc->rx.params.initial_source_connection_id.data,
+		       qc->scid.data, qc->scid.len);
+		qc->rx.params.initial_source_connection_id.len = qc->scid.len;
+	}
+
 	/* Initialize the idle timeout of the connection at the "max_idle_timeout"
 	 * value from local transport parameters.
 	 */
@@ -1209,7 +1249,7 @@ struct quic_conn *qc_new_conn(const struct quic_version *qv, int ipv4,
 	    !quic_conn_init_idle_timer_task(qc, prx))
 		goto err;
 
-	if (!qc_new_isecs(qc, &qc->iel->tls_ctx, qc->original_version, dcid->data, dcid->len, 1))
+	if (!qc_new_isecs(qc, &qc->iel->tls_ctx, qc->original_version, dcid->data, dcid->len, server))
 		goto err;
 
 	/* Counters initialization */
@@ -1251,6 +1291,14 @@ int qc_handle_conn_migration(struct quic_conn *qc,
 {
 	TRACE_ENTER(QUIC_EV_CONN_LPKT, qc);
 
+	/* Backend connections use a connected socket: their peer address
+	 * cannot change.
+	 */
+	if (!qc_is_listener(qc)) {
+		TRACE_ERROR("Peer address change on backend connection, datagram dropped", QUIC_EV_CONN_LPKT, qc);
+		goto err;
+	}
+
 	/* RFC 9000. Connection Migration
 	 *
 	 * If the peer sent the disable_active_migration transport parameter,
@@ -1357,9 +1405,12 @@ void quic_conn_release(struct quic_conn *qc)
 	/* We must not free the quic-conn if the MUX is still allocated. */
 	BUG_ON(qc->mux_state == QC_MUX_READY);
 
+	/* The "connection close" state relies on the listener socket. It is
+	 * skipped for backend connections which own their socket.
+	 */
 	cc_qc = NULL;
 	if ((qc->flags & QUIC_FL_CONN_CLOSING) && !(qc->flags & QUIC_FL_CONN_EXP_TIMER) &&
-	    qc->tx.cc_buf_area)
+	    qc->tx.cc_buf_area && qc_is_listener(qc))
 		cc_qc = qc_new_cc_conn(qc);
 
 	if (!cc_qc) {
@@ -1519,6 +1570,9 @@ void qc_idle_timer_do_rearm(struct quic_conn *qc, int arm_ack)
 		 * connection with a high RTT.
 		 */
 		expire = MIN(3 * quic_pto(qc), 1000);
+
+		/* No more paced emission. */
+		qc->pacing_expire = TICK_ETERNITY;
 	}
 	else {
 		/* RFC 9000 10.1. Idle Timeout
@@ -1541,7 +1595,7 @@ void qc_idle_timer_do_rearm(struct quic_conn *qc, int arm_ack)
 		/* Arm the ack timer only if not already armed. */
 		if (!tick_isset(qc->ack_expire)) {
 			qc->ack_expire = tick_add(now_ms, MS_TO_TICKS(QUIC_ACK_DELAY));
-			qc->idle_timer_task->expire = qc->ack_expire;
+			qc->idle_timer_task->expire = tick_first(qc->ack_expire, qc->pacing_expire);
 			task_queue(qc->idle_timer_task);
 			TRACE_PROTO("ack timer armed", QUIC_EV_CONN_IDLE_TIMER, qc);
 		}
@@ -1550,6 +1604,7 @@ void qc_idle_timer_do_rearm(struct quic_conn *qc, int arm_ack)
 		qc->idle_timer_task->expire = tick_first(qc->ack_expire, qc->idle_expire);
 		if (qc->state < QUIC_HS_ST_COMPLETE)
 			qc->idle_timer_task->expire = tick_first(qc->hs_expire, qc->idle_expire);
+		qc->idle_timer_task->expire = tick_first(qc->idle_timer_task->expire, qc->pacing_expire);
 		task_queue(qc->idle_timer_task);
 		TRACE_PROTO("idle timer armed", QUIC_EV_CONN_IDLE_TIMER, qc);
 	}
@@ -1586,11 +1641,23 @@ struct task *qc_idle_timer_task(struct task *t, void *ctx, unsigned int state)
 	if ((state & TASK_WOKEN_ANY) == TASK_WOKEN_TIMER && !tick_is_expired(t->expire, now_ms))
 		goto requeue;
 
+	if (tick_is_expired(qc->pacing_expire, now_ms)) {
+		TRACE_PROTO("pacing timer expired", QUIC_EV_CONN_IDLE_TIMER, qc);
+		qc->pacing_expire = TICK_ETERNITY;
+		/* Note that ->idle_expire is always set. */
+		t->expire = tick_first(qc->ack_expire, qc->idle_expire);
+		if (!(qc->flags & (QUIC_FL_CONN_DRAINING|QUIC_FL_CONN_TO_KILL)))
+			qc_notify_send(qc);
+
+		if (!tick_is_expired(t->expire, now_ms))
+			goto requeue;
+	}
+
 	if (tick_is_expired(qc->ack_expire, now_ms)) {
 		TRACE_PROTO("ack timer expired", QUIC_EV_CONN_IDLE_TIMER, qc);
 		qc->ack_expire = TICK_ETERNITY;
 		/* Note that ->idle_expire is always set. */
-		t->expire = qc->idle_expire;
+		t->expire = tick_first(qc->pacing_expire, qc->idle_expire);
 		/* Do not wakeup the I/O handler in DRAINING state or if the
 		 * connection must be killed as soon as possible.
 		 */
@@ -1612,7 +1679,7 @@ struct task *qc_idle_timer_task(struct task *t, void *ctx, unsigned int state)
 	 * responsible to call quic_close to release it.
 	 */
 	qc->flags |= QUIC_FL_CONN_EXP_TIMER;
-	if (qc->mux_state != QC_MUX_READY) {
+	if (!qc_has_upper_layer(qc)) {
 		quic_conn_release(qc);
 		qc = NULL;
 	}
@@ -1644,7 +1711,10 @@ static int quic_conn_init_idle_timer_task(struct quic_conn *qc,
 	TRACE_ENTER(QUIC_EV_CONN_NEW, qc);
 
 
-	timeout = px->timeout.client_hs ? px->timeout.client_hs : px->timeout.client;
+	if (qc_is_listener(qc))
+		timeout = px->timeout.client_hs ? px->timeout.client_hs : px->timeout.client;
+	else
+		timeout = px->timeout.connect;
 	qc->idle_timer_task = task_new_here();
 	if (!qc->idle_timer_task) {
 		TRACE_ERROR("Idle timer task allocation failed", QUIC_EV_CONN_NEW, qc);
@@ -1654,6 +1724,7 @@ static int quic_conn_init_idle_timer_task(struct quic_conn *qc,
 	qc->idle_timer_task->process = qc_idle_timer_task;
 	qc->idle_timer_task->context = qc;
 	qc->ack_expire = TICK_ETERNITY;
+	qc->pacing_expire = TICK_ETERNITY;
 	qc->hs_expire = tick_add_ifset(now_ms, MS_TO_TICKS(timeout));
 	qc_idle_timer_rearm(qc, 1, 0);
 	task_queue(qc->idle_timer_task);
@@ -1718,9 +1789,10 @@ int qc_notify_send(struct quic_conn *qc)
 	const struct quic_pktns *pktns = qc->apktns;
 
 	/* Wake up MUX for new emission unless there is no congestion room or
-	 * connection FD is not ready.
+	 * connection FD is not ready. When emission is paced, this is delayed
+	 * up to the expiration of the pacing timer.
 	 */
-	if (qc->subs && qc->subs->events & SUB_RETRY_SEND) {
+	if (qc->subs && qc->subs->events & SUB_RETRY_SEND && !tick_isset(qc->pacing_expire)) {
 		/* RFC 9002 7.5. Probe Timeout
 		 *
 		 * Probe packets MUST NOT be blocked by the congestion controller.
@@ -1745,6 +1817,28 @@ int qc_notify_send(struct quic_conn *qc)
 	return 0;
 }
 
+/* Arm the pacing timer of <qc> so that the MUX is woken up to resume its
+ * emission in <delay> nanoseconds. As timers have a millisecond resolution,
+ * the pacing schedule allows to catch up on the lost time.
+ */
+void qc_pacing_timer_arm(struct quic_conn *qc, uint64_t delay)
+{
+	unsigned int expire;
+
+	/* It is possible the idle timer task has been already released. */
+	if (!qc->idle_timer_task || (qc->flags & (QUIC_FL_CONN_CLOSING|QUIC_FL_CONN_DRAINING)))
+		return;
+
+	expire = tick_add(now_ms, MS_TO_TICKS((delay + 999999) / 1000000));
+	if (tick_isset(qc->pacing_expire) && !tick_is_lt(expire, qc->pacing_expire))
+		return;
+
+	qc->pacing_expire = expire;
+	qc->idle_timer_task->expire = tick_first(qc->idle_timer_task->expire, expire);
+	task_queue(qc->idle_timer_task);
+	TRACE_PROTO("pacing timer armed", QUIC_EV_CONN_IDLE_TIMER, qc);
+}
+
 /* Notify upper layer of a fatal error which forces to close the connection. */
 void qc_notify_err(struct quic_conn *qc)
 {
@@ -1764,10 +1858,52 @@ void qc_notify_err(struct quic_conn *qc)
 		 */
 		tasklet_wakeup(qc->qcc->wait_event.tasklet);
 	}
+	else if (qc_has_upper_layer(qc)) {
+		struct connection *conn = qc->conn;
+		unsigned int old_flags = conn->flags;
+
+		/* Backend connection still waiting for the handshake: report
+		 * the connection failure to the stream layer.
+		 */
+		TRACE_STATE("error notified to connection", QUIC_EV_CONN_CLOSE, qc);
+		conn->flags |= CO_FL_ERROR | CO_FL_SOCK_RD_SH | CO_FL_SOCK_WR_SH;
+		conn->flags &= ~(CO_FL_SSL_WAIT_HS | CO_FL_WAIT_L6_CONN);
+		conn_notify_mux(conn, old_flags, 0);
+	}
 
 	TRACE_LEAVE(QUIC_EV_CONN_CLOSE, qc);
 }
 
+/* Notify the connection attached to <qc> backend quic-conn about its handshake
+ * completion. The MUX is instantiated at this stage, which in turn wakes up the
+ * stream waiting for the connection establishment.
+ */
+void qc_notify_hs_done(struct quic_conn *qc)
+{
+	struct connection *conn = qc->conn;
+	unsigned int old_flags;
+
+	TRACE_ENTER(QUIC_EV_CONN_IO_CB, qc);
+
+	if (!conn || qc->mux_state != QC_MUX_NULL)
+		goto leave;
+
+	old_flags = conn->flags;
+	conn->flags &= ~(CO_FL_SSL_WAIT_HS | CO_FL_WAIT_L6_CONN);
+	/* The MUX must be considered ready during its initialization. */
+	qc->mux_state = QC_MUX_READY;
+	conn_notify_mux(conn, old_flags, 0);
+	if (qc->mux_state == QC_MUX_READY && !conn->mux) {
+		/* MUX allocation failure. The connection will be released by
+		 * the stream layer.
+		 */
+		qc->mux_state = QC_MUX_NULL;
+	}
+
+ leave:
+	TRACE_LEAVE(QUIC_EV_CONN_IO_CB, qc);
+}
+
 /* Prepare <qc> QUIC connection rebinding to a new thread <new_tid>. Stop and
  * release associated tasks and tasklet and allocate new ones binded to the new
  * thread.
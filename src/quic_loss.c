@@ -1,5 +1,6 @@
 #include <import/eb64tree.h>
 
+#include <haproxy/quic_cc_drs.h>
 #include <haproxy/quic_conn-t.h>
 #include <haproxy/quic_loss.h>
 #include <haproxy/quic_tls.h>
@@ -259,6 +260,8 @@ int qc_release_lost_pkts(struct quic_conn *qc, struct quic_pktns *pktns,
 		qc->path->in_flight -= pkt->in_flight_len;
 		if (pkt->flags & QUIC_FL_TX_PACKET_ACK_ELICITING)
 			qc->path->ifae_pkts--;
+		if (pkt->in_flight_len)
+			quic_cc_drs_on_pkt_lost(&qc->path->drs, pkt);
 		/* Treat the frames of this lost packet. */
 		if (!qc_handle_frms_of_lost_pkt(qc, pkt, &pktns->tx.frms))
 			close = 1;
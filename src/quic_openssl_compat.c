@@ -12,6 +12,7 @@
 
 #include <haproxy/quic_conn.h>
 #include <haproxy/quic_tls.h>
+#include <haproxy/quic_tp.h>
 #include <haproxy/quic_trace.h>
 #include <haproxy/ssl_sock.h>
 #include <haproxy/trace.h>
@@ -42,6 +43,12 @@ static int qc_ssl_compat_add_tps_cb(SSL *ssl, unsigned int ext_type, unsigned in
 {
 	struct quic_conn *qc = SSL_get_ex_data(ssl, ssl_qc_app_data_index);
 
+	/* Do not add this extension for non-QUIC connections which may share
+	 * the same SSL_CTX, as the TCP health checks of a QUIC server.
+	 */
+	if (!qc)
+		return 0;
+
 	TRACE_ENTER(QUIC_EV_CONN_SSL_COMPAT, qc);
 
 	*out = qc->enc_params;
@@ -51,14 +58,43 @@ static int qc_ssl_compat_add_tps_cb(SSL *ssl, unsigned int ext_type, unsigned in
 	return 1;
 }
 
-/* Set the keylog callback used to derive TLS secrets and the callback
- * used to pass local transport parameters to the TLS stack.
+/* Callback used to retrieve the peer transport parameters from the
+ * EncryptedExtensions message received by a QUIC client. The listeners get
+ * them from the ClientHello callback.
+ */
+static int qc_ssl_compat_parse_tps_cb(SSL *ssl, unsigned int ext_type, unsigned int context,
+                                      const unsigned char *in, size_t inlen,
+                                      X509 *x, size_t chainidx, int *al, void *parse_arg)
+{
+	struct quic_conn *qc = SSL_get_ex_data(ssl, ssl_qc_app_data_index);
+	int ret = 1;
+
+	if (!qc || qc_is_listener(qc))
+		return 1;
+
+	TRACE_ENTER(QUIC_EV_CONN_SSL_COMPAT, qc);
+
+	if (!quic_transport_params_store(qc, 1, in, in + inlen)) {
+		*al = SSL_AD_ILLEGAL_PARAMETER;
+		ret = 0;
+		goto leave;
+	}
+
+	qc->flags |= QUIC_FL_CONN_TX_TP_RECEIVED;
+ leave:
+	TRACE_LEAVE(QUIC_EV_CONN_SSL_COMPAT, qc);
+	return ret;
+}
+
+/* Set the keylog callback used to derive TLS secrets and the callbacks used
+ * to exchange the transport parameters with the TLS stack. <bind_conf> is NULL
+ * for the SSL_CTX of a QUIC server.
  * Return 1 if succeeded, 0 if not.
  */
 int quic_tls_compat_init(struct bind_conf *bind_conf, SSL_CTX *ctx)
 {
 	/* Ignore non-QUIC connections */
-	if (bind_conf->xprt != xprt_get(XPRT_QUIC))
+	if (bind_conf && bind_conf->xprt != xprt_get(XPRT_QUIC))
 		return 1;
 
 	/* This callback is already registered if the TLS keylog is activated for
@@ -73,7 +109,7 @@ int quic_tls_compat_init(struct bind_conf *bind_conf, SSL_CTX *ctx)
 	if (!SSL_CTX_add_custom_ext(ctx, QUIC_OPENSSL_COMPAT_SSL_TP_EXT,
 	                            SSL_EXT_CLIENT_HELLO | SSL_EXT_TLS1_3_ENCRYPTED_EXTENSIONS,
 	                            qc_ssl_compat_add_tps_cb, NULL, NULL,
-	                            NULL, NULL))
+	                            qc_ssl_compat_parse_tps_cb, NULL))
 		return 0;
 
 	return 1;
@@ -170,6 +206,10 @@ void quic_tls_compat_keylog_callback(const SSL *ssl, const char *line)
 	else
 		goto leave;
 
+	/* The secrets are labelled from the client point of view */
+	if (!qc_is_listener(qc))
+		write = !write;
+
 	if (*p++ == '\0')
 		goto leave;
 
@@ -510,11 +550,23 @@ int SSL_provide_quic_data(SSL *ssl, enum ssl_encryption_level_t level,
 int SSL_process_quic_post_handshake(SSL *ssl)
 {
 	struct quic_conn *qc = SSL_get_ex_data(ssl, ssl_qc_app_data_index);
+	unsigned char c;
+	int ret = 1;
 
-	/* Do nothing: rely on the TLS message callback to parse alert messages. */
+	/* Servers rely on the TLS message callback to parse alert messages.
+	 * Clients must also process the NewSessionTicket messages to be able
+	 * to resume their sessions: no application data is expected here.
+	 */
 	TRACE_ENTER(QUIC_EV_CONN_SSL_COMPAT, qc);
+	if (!SSL_is_server(ssl)) {
+		ret = SSL_read(ssl, &c, sizeof(c));
+		if (ret <= 0 && SSL_get_error(ssl, ret) == SSL_ERROR_WANT_READ)
+			ret = 1;
+		else if (ret > 0)
+			ret = 0;
+	}
 	TRACE_LEAVE(QUIC_EV_CONN_SSL_COMPAT, qc);
-	return 1;
+	return ret;
 }
 
 int SSL_set_quic_transport_params(SSL *ssl, const uint8_t *params, size_t params_len)
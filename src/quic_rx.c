@@ -328,12 +328,11 @@ static void qc_handle_newly_acked_frm(struct quic_conn *qc, struct quic_frame *f
 
 /* Collect newly acknowledged TX packets from <pkts> ebtree into <newly_acked_pkts>
  * list depending on <largest> and <smallest> packet number of a range of acknowledged
- * packets announced in an ACK frame. <largest_node> may be provided to start
- * looking from this packet node.
+ * packets announced in an ACK frame. The range is removed with a single lookup
+ * for its first packet followed by a walk through the contiguous packets.
  */
 static void qc_newly_acked_pkts(struct quic_conn *qc, struct eb_root *pkts,
                                 struct list *newly_acked_pkts,
-                                struct eb64_node *largest_node,
                                 uint64_t largest, uint64_t smallest)
 {
 	struct eb64_node *node;
@@ -342,21 +341,13 @@ static void qc_newly_acked_pkts(struct quic_conn *qc, struct eb_root *pkts,
 	TRACE_ENTER(QUIC_EV_CONN_PRSAFRM, qc);
 
 	node = eb64_lookup_ge(pkts, smallest);
-	if (!node)
-		goto leave;
-
-	largest_node = largest_node ? largest_node : eb64_lookup_le(pkts, largest);
-	if (!largest_node)
-		goto leave;
-
-	while (node && node->key <= largest_node->key) {
+	while (node && node->key <= largest) {
 		pkt = eb64_entry(node, struct quic_tx_packet, pn_node);
 		LIST_APPEND(newly_acked_pkts, &pkt->list);
 		node = eb64_next(node);
 		eb64_delete(&pkt->pn_node);
 	}
 
- leave:
 	TRACE_LEAVE(QUIC_EV_CONN_PRSAFRM, qc);
 }
 
@@ -379,10 +370,8 @@ static void qc_handle_newly_acked_pkts(struct quic_conn *qc,
 		 * detach the previous one and the next one from <pkt>.
 		 */
 		quic_tx_packet_dgram_detach(pkt);
-		eb64_delete(&pkt->pn_node);
 	}
 
- leave:
 	TRACE_LEAVE(QUIC_EV_CONN_PRSAFRM, qc);
 }
 
@@ -460,8 +449,10 @@ int qc_handle_frms_of_lost_pkt(struct quic_conn *qc,
 	return !close;
 }
 
-/* Send a packet ack event nofication for each newly acked packet of
- * <newly_acked_pkts> list and free them.
+/* Send a single packet ack event notification for all the newly acked packets
+ * of <newly_acked_pkts> list, all from the same packet number space, and free
+ * them. The event reports the total number of acknowledged bytes, and the
+ * packet number and the sending time of the most recently sent packet.
  * Always succeeds.
  */
 static void qc_notify_cc_of_newly_acked_pkts(struct quic_conn *qc,
@@ -469,31 +460,48 @@ static void qc_notify_cc_of_newly_acked_pkts(struct quic_conn *qc,
 {
 	struct quic_tx_packet *pkt, *tmp;
 	struct quic_cc_event ev = { .type = QUIC_CC_EVT_ACK, };
+	struct quic_pktns *pktns = NULL;
+	int64_t largest_acked_pn = -1;
+	uint64_t acked = 0, ifae_pkts = 0;
 
 	TRACE_ENTER(QUIC_EV_CONN_PRSAFRM, qc);
 
 	list_for_each_entry_safe(pkt, tmp, newly_acked_pkts, list) {
-		pkt->pktns->tx.in_flight -= pkt->in_flight_len;
-		qc->path->prep_in_flight -= pkt->in_flight_len;
-		qc->path->in_flight -= pkt->in_flight_len;
+		if (!pktns || pkt->pn_node.key > ev.ack.pn) {
+			ev.ack.time_sent = pkt->time_sent;
+			ev.ack.pn = pkt->pn_node.key;
+		}
+		pktns = pkt->pktns;
+		acked += pkt->in_flight_len;
 		if (pkt->flags & QUIC_FL_TX_PACKET_ACK_ELICITING)
-			qc->path->ifae_pkts--;
-		/* If this packet contained an ACK frame, proceed to the
-		 * acknowledging of range of acks from the largest acknowledged
-		 * packet number which was sent in an ACK frame by this packet.
-		 */
-		if (pkt->largest_acked_pn != -1)
-			qc_treat_ack_of_ack(qc, &pkt->pktns->rx.arngs, pkt->largest_acked_pn);
-		ev.ack.acked = pkt->in_flight_len;
-		ev.ack.time_sent = pkt->time_sent;
-		ev.ack.pn = pkt->pn_node.key;
-		quic_cc_event(&qc->path->cc, &ev);
+			ifae_pkts++;
+		if (pkt->largest_acked_pn > largest_acked_pn)
+			largest_acked_pn = pkt->largest_acked_pn;
+		if (pkt->in_flight_len)
+			quic_cc_drs_on_pkt_acked(&qc->path->drs, pkt);
 		LIST_DEL_INIT(&pkt->list);
 		quic_tx_packet_refdec(pkt);
 	}
 
-	TRACE_LEAVE(QUIC_EV_CONN_PRSAFRM, qc);
+	if (!pktns)
+		goto leave;
+
+	pktns->tx.in_flight -= acked;
+	qc->path->prep_in_flight -= acked;
+	qc->path->in_flight -= acked;
+	qc->path->ifae_pkts -= ifae_pkts;
+	/* If some of these packets contained an ACK frame, proceed to the
+	 * acknowledging of range of acks from the largest acknowledged
+	 * packet number which was sent in an ACK frame by these packets.
+	 */
+	if (largest_acked_pn != -1)
+		qc_treat_ack_of_ack(qc, &pktns->rx.arngs, largest_acked_pn);
+	ev.ack.acked = acked;
+	quic_cc_event(&qc->path->cc, &ev);
+	quic_cc_ack_rcvd(qc->path);
 
+ leave:
+	TRACE_LEAVE(QUIC_EV_CONN_PRSAFRM, qc);
 }
 
 /* Parse ACK frame into <frm> from a buffer at <buf> address with <end> being at
@@ -509,7 +517,7 @@ static int qc_parse_ack_frm(struct quic_conn *qc,
                             const unsigned char **pos, const unsigned char *end)
 {
 	struct qf_ack *ack_frm = &frm->ack;
-	uint64_t smallest, largest;
+	uint64_t smallest, largest, oldest_pn;
 	struct eb_root *pkts;
 	struct eb64_node *largest_node;
 	unsigned int time_sent, pkt_flags;
@@ -552,13 +560,20 @@ static int qc_parse_ack_frm(struct quic_conn *qc,
 		}
 	}
 
+	/* The ACK ranges are announced by decreasing packet numbers. There is
+	 * nothing to collect anymore as soon as they are below the oldest
+	 * packet still waiting for an acknowledgement. Note that the remaining
+	 * ranges must still be parsed.
+	 */
+	oldest_pn = eb_is_empty(pkts) ? UINT64_MAX : eb64_first(pkts)->key;
+
 	TRACE_PROTO("RX ack range", QUIC_EV_CONN_PRSAFRM,
 	            qc, NULL, &largest, &smallest);
 	do {
 		uint64_t gap, ack_range;
 
-		qc_newly_acked_pkts(qc, pkts, &newly_acked_pkts,
-		                    largest_node, largest, smallest);
+		if (largest >= oldest_pn)
+			qc_newly_acked_pkts(qc, pkts, &newly_acked_pkts, largest, smallest);
 		if (!ack_frm->ack_range_num--)
 			break;
 
@@ -585,8 +600,6 @@ static int qc_parse_ack_frm(struct quic_conn *qc,
 			goto err;
 		}
 
-		/* Do not use this node anymore. */
-		largest_node = NULL;
 		/* Next range */
 		smallest = largest - ack_range;
 
@@ -943,6 +956,11 @@ static int qc_parse_pkt_frms(struct quic_conn *qc, struct quic_rx_packet *pkt,
 			}
 			break;
 		case QUIC_FT_MAX_STREAMS_BIDI:
+			if (qc->mux_state == QC_MUX_READY) {
+				struct qf_max_streams *ms_frm = &frm.max_streams_bidi;
+				qcc_recv_max_streams_bidi(qc->qcc, ms_frm->max_streams);
+			}
+			break;
 		case QUIC_FT_MAX_STREAMS_UNI:
 			break;
 		case QUIC_FT_DATA_BLOCKED:
@@ -975,7 +993,7 @@ static int qc_parse_pkt_frms(struct quic_conn *qc, struct quic_rx_packet *pkt,
 			pool_free(pool_head_quic_connection_id, conn_id);
 			TRACE_PROTO("CID retired", QUIC_EV_CONN_PSTRM, qc);
 
-			conn_id = new_quic_cid(qc->cids, qc, NULL, NULL);
+			conn_id = new_quic_cid(qc->cids, qc, NULL, NULL, NULL);
 			if (!conn_id) {
 				TRACE_ERROR("CID allocation error", QUIC_EV_CONN_IO_CB, qc);
 			}
@@ -1025,7 +1043,14 @@ static int qc_parse_pkt_frms(struct quic_conn *qc, struct quic_rx_packet *pkt,
 				goto leave;
 			}
 
-			qc->state = QUIC_HS_ST_CONFIRMED;
+			/* The client handshake is confirmed : the Handshake
+			 * packet number space is discarded by quic_conn_io_cb()
+			 * which is replaced by the application I/O callback.
+			 */
+			if (qc->state < QUIC_HS_ST_CONFIRMED) {
+				qc->state = QUIC_HS_ST_CONFIRMED;
+				qc->wait_event.tasklet->process = quic_conn_app_io_cb;
+			}
 			break;
 		default:
 			/* Unknown frame type must be rejected by qc_parse_frm(). */
@@ -1060,6 +1085,40 @@ static int qc_parse_pkt_frms(struct quic_conn *qc, struct quic_rx_packet *pkt,
 			    qc->state = QUIC_HS_ST_SERVER_HANDSHAKE;
 	    }
 	}
+	else if (!qc_is_listener(qc)) {
+		/* RFC 9000 7.2. Negotiating Connection IDs
+		 *
+		 * Upon first receiving an Initial or Retry packet from the server, the
+		 * client uses the Source Connection ID supplied by the server as the
+		 * Destination Connection ID for subsequent packets, including any 0-RTT
+		 * packets.
+		 */
+		if (pkt->type == QUIC_PACKET_TYPE_INITIAL &&
+		    qc->state == QUIC_HS_ST_CLIENT_INITIAL &&
+		    qc->dcid.len == qc->odcid.len &&
+		    memcmp(qc->dcid.data, qc->odcid.data, qc->odcid.len) == 0) {
+			TRACE_STATE("switching to server chosen DCID", QUIC_EV_CONN_PRSHPKT, qc);
+			qc->dcid = pkt->scid;
+		}
+
+		/* RFC 9001 4.9.1. Discarding Initial Keys
+		 *
+		 * A client MUST discard Initial keys when it first sends a Handshake
+		 * packet. This is done here as soon as Handshake packets may be
+		 * built, that is on the first received one.
+		 */
+		if (pkt->type == QUIC_PACKET_TYPE_HANDSHAKE &&
+		    qc->state == QUIC_HS_ST_CLIENT_INITIAL) {
+			if (qc->ipktns && !quic_tls_pktns_is_dcd(qc, qc->ipktns)) {
+				TRACE_PROTO("discarding Initial pktns", QUIC_EV_CONN_PRSHPKT, qc);
+				quic_pktns_discard(qc->ipktns, qc);
+				qc_set_timer(qc);
+				qc_el_rx_pkts_del(qc->iel);
+				qc_release_pktns_frms(qc, qc->ipktns);
+			}
+			qc->state = QUIC_HS_ST_CLIENT_HANDSHAKE;
+		}
+	}
 
 	ret = 1;
  leave:
@@ -1549,7 +1608,7 @@ static struct quic_conn *quic_rx_pkt_retrieve_conn(struct quic_rx_packet *pkt,
 	prx = l->bind_conf->frontend;
 	prx_counters = EXTRA_COUNTERS_GET(prx->extra_counters_fe, &quic_stats_module);
 
-	qc = retrieve_qc_conn_from_cid(pkt, &dgram->saddr, new_tid);
+	qc = retrieve_qc_conn_from_cid(pkt, &dgram->saddr, l, new_tid);
 
 	/* quic_conn must be set to NULL if bind on another thread. */
 	BUG_ON_HOT(qc && *new_tid != -1);
@@ -1631,7 +1690,7 @@ static struct quic_conn *quic_rx_pkt_retrieve_conn(struct quic_rx_packet *pkt,
 			 * optimization as the client is expected to stop using its ODCID in
 			 * favor of our generated value.
 			 */
-			conn_id = new_quic_cid(NULL, NULL, &pkt->dcid, &pkt->saddr);
+			conn_id = new_quic_cid(NULL, NULL, &pkt->dcid, &pkt->saddr, l);
 			if (!conn_id)
 				goto err;
 
@@ -1695,7 +1754,8 @@ static struct quic_conn *quic_rx_pkt_retrieve_conn(struct quic_rx_packet *pkt,
  * if the packet is incomplete. This function will populate fields of <pkt>
  * instance, most notably its length. <dgram> is the UDP datagram which
  * contains the parsed packet. <l> is the listener instance on which it was
- * received.
+ * received. It is NULL for backend connections, in which case <qc> must be set
+ * to the connection owning the socket the datagram was received on.
  *
  * Returns 0 on success else non-zero. Packet length is guaranteed to be set to
  * the real packet value or to cover all data between <pos> and <end> : this is
@@ -1703,16 +1763,16 @@ static struct quic_conn *quic_rx_pkt_retrieve_conn(struct quic_rx_packet *pkt,
  */
 static int quic_rx_pkt_parse(struct quic_rx_packet *pkt,
                              unsigned char *pos, const unsigned char *end,
-                             struct quic_dgram *dgram, struct listener *l)
+                             struct quic_dgram *dgram, struct quic_conn *qc,
+                             struct listener *l)
 {
 	const unsigned char *beg = pos;
-	struct proxy *prx;
 	struct quic_counters *prx_counters;
 
 	TRACE_ENTER(QUIC_EV_CONN_LPKT);
 
-	prx = l->bind_conf->frontend;
-	prx_counters = EXTRA_COUNTERS_GET(prx->extra_counters_fe, &quic_stats_module);
+	prx_counters = l ? EXTRA_COUNTERS_GET(l->bind_conf->frontend->extra_counters_fe, &quic_stats_module) :
+	                   qc->prx_counters;
 
 	if (end <= pos) {
 		TRACE_PROTO("Packet dropped", QUIC_EV_CONN_LPKT);
@@ -1761,7 +1821,9 @@ static int quic_rx_pkt_parse(struct quic_rx_packet *pkt,
 			goto drop;
 		}
 
-		/* Retry of Version Negotiation packets are only sent by servers */
+		/* Retry of Version Negotiation packets are only sent by servers.
+		 * They are not supported for backend connections.
+		 */
 		if (pkt->type == QUIC_PACKET_TYPE_RETRY ||
 		    (pkt->version && !pkt->version->num)) {
 			TRACE_PROTO("Packet dropped", QUIC_EV_CONN_LPKT);
@@ -1770,6 +1832,12 @@ static int quic_rx_pkt_parse(struct quic_rx_packet *pkt,
 
 		/* RFC9000 6. Version Negotiation */
 		if (!pkt->version) {
+			/* Only servers send Version Negotiation packets. */
+			if (!l) {
+				TRACE_PROTO("Packet dropped", QUIC_EV_CONN_LPKT);
+				goto drop;
+			}
+
 			 /* unsupported version, send Negotiation packet */
 			if (send_version_negotiation(l->rx.fd, &dgram->saddr, pkt)) {
 				TRACE_ERROR("VN packet not sent", QUIC_EV_CONN_LPKT);
@@ -1824,7 +1892,7 @@ static int quic_rx_pkt_parse(struct quic_rx_packet *pkt,
 		 * with a payload that is smaller than the smallest allowed maximum datagram
 		 * size of 1200 bytes.
 		 */
-		if (pkt->type == QUIC_PACKET_TYPE_INITIAL &&
+		if (l && pkt->type == QUIC_PACKET_TYPE_INITIAL &&
 		    dgram->len < QUIC_INITIAL_PACKET_MINLEN) {
 			TRACE_PROTO("RX too short datagram with an Initial packet", QUIC_EV_CONN_LPKT);
 			HA_ATOMIC_INC(&prx_counters->too_short_initial_dgram);
@@ -1835,7 +1903,8 @@ static int quic_rx_pkt_parse(struct quic_rx_packet *pkt,
 		 * ensures that only the packet is dropped but not the whole
 		 * datagram.
 		 */
-		if (pkt->type == QUIC_PACKET_TYPE_0RTT && !l->bind_conf->ssl_conf.early_data) {
+		if (pkt->type == QUIC_PACKET_TYPE_0RTT &&
+		    (!l || !l->bind_conf->ssl_conf.early_data)) {
 			TRACE_PROTO("RX 0-RTT packet not supported", QUIC_EV_CONN_LPKT);
 			goto drop;
 		}
@@ -2059,7 +2128,8 @@ static void qc_rx_pkt_handle(struct quic_conn *qc, struct quic_rx_packet *pkt,
  * this function.
  *
  * If datagram has been received on a quic-conn owned FD, <from_qc> must be set
- * to the connection instance. <li> is the attached listener. The caller is
+ * to the connection instance. <li> is the attached listener, or NULL for
+ * backend connections which always own their socket. The caller is
  * responsible to ensure that the first packet is destined to this connection
  * by comparing CIDs.
  *
@@ -2109,7 +2179,7 @@ int quic_dgram_parse(struct quic_dgram *dgram, struct quic_conn *from_qc,
 			pkt->flags |= QUIC_FL_RX_PACKET_DGRAM_FIRST;
 
 		quic_rx_packet_refinc(pkt);
-		if (quic_rx_pkt_parse(pkt, pos, end, dgram, li))
+		if (quic_rx_pkt_parse(pkt, pos, end, dgram, from_qc, li))
 			goto next;
 
 		/* Search quic-conn instance for first packet of the datagram.
@@ -14,12 +14,18 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <netinet/in.h>
 #include <netinet/udp.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 
+#if defined(__linux__)
+#include <linux/filter.h>
+#include <linux/net_tstamp.h>
+#endif
+
 #include <haproxy/api.h>
 #include <haproxy/buf.h>
 #include <haproxy/connection.h>
@@ -60,8 +66,13 @@ int quic_sock_get_src(struct connection *conn, struct sockaddr *addr, socklen_t
 
 	qc = conn->handle.qc;
 	if (conn_is_back(conn)) {
-		/* no source address defined for outgoing connections for now */
-		return -1;
+		/* back connection, return the local address of its socket */
+		if (!is_addr(&qc->local_addr))
+			return -1;
+		if (len > sizeof(qc->local_addr))
+			len = sizeof(qc->local_addr);
+		memcpy(addr, &qc->local_addr, len);
+		return 0;
 	} else {
 		/* front connection, return the peer's address */
 		if (len > sizeof(qc->peer_addr))
@@ -274,7 +285,7 @@ static int quic_lstnr_dgram_dispatch(unsigned char *pos, size_t len, void *owner
 	if (!dgram)
 		goto err;
 
-	if ((cid_tid = quic_get_cid_tid(dcid, dcid_len, saddr, pos, len)) < 0) {
+	if ((cid_tid = quic_get_cid_tid(dcid, dcid_len, saddr, owner, pos, len)) < 0) {
 		/* Use the current thread if CID not found. If a clients opens
 		 * a connection with multiple packets, it is possible that
 		 * several threads will deal with datagrams sharing the same
@@ -342,6 +353,74 @@ static struct quic_dgram *quic_rxbuf_purge_dgrams(struct quic_receiver_buf *rbuf
 	return prev;
 }
 
+/* ancillary data used to retrieve the destination address of a datagram */
+union quic_pktinfo {
+#ifdef IP_PKTINFO
+	struct in_pktinfo in;
+#else /* !IP_PKTINFO */
+	struct in_addr addr;
+#endif
+#ifdef IPV6_RECVPKTINFO
+	struct in6_pktinfo in6;
+#endif
+};
+
+/* Retrieves into <to> the destination address of a datagram from the ancillary
+ * data of <msg> it was received with. <to> is left untouched if the socket does
+ * not support IP_PKTINFO or affiliated options. The caller must specify
+ * <dst_port> to ensure that <to> address is completely filled.
+ */
+static void quic_recv_dstaddr(struct msghdr *msg, struct sockaddr *to, socklen_t to_len,
+                              uint16_t dst_port)
+{
+	struct cmsghdr *cmsg;
+
+	for (cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+		switch (cmsg->cmsg_level) {
+		case IPPROTO_IP:
+#if defined(IP_PKTINFO)
+			if (cmsg->cmsg_type == IP_PKTINFO) {
+				struct sockaddr_in *in = (struct sockaddr_in *)to;
+				struct in_pktinfo *info = (struct in_pktinfo *)CMSG_DATA(cmsg);
+
+				if (to_len >= sizeof(struct sockaddr_in)) {
+					in->sin_family = AF_INET;
+					in->sin_addr = info->ipi_addr;
+					in->sin_port = dst_port;
+				}
+			}
+#elif defined(IP_RECVDSTADDR)
+			if (cmsg->cmsg_type == IP_RECVDSTADDR) {
+				struct sockaddr_in *in = (struct sockaddr_in *)to;
+				struct in_addr *info = (struct in_addr *)CMSG_DATA(cmsg);
+
+				if (to_len >= sizeof(struct sockaddr_in)) {
+					in->sin_family = AF_INET;
+					in->sin_addr.s_addr = info->s_addr;
+					in->sin_port = dst_port;
+				}
+			}
+#endif /* IP_PKTINFO || IP_RECVDSTADDR */
+			break;
+
+		case IPPROTO_IPV6:
+#ifdef IPV6_RECVPKTINFO
+			if (cmsg->cmsg_type == IPV6_PKTINFO) {
+				struct sockaddr_in6 *in6 = (struct sockaddr_in6 *)to;
+				struct in6_pktinfo *info6 = (struct in6_pktinfo *)CMSG_DATA(cmsg);
+
+				if (to_len >= sizeof(struct sockaddr_in6)) {
+					in6->sin6_family = AF_INET6;
+					memcpy(&in6->sin6_addr, &info6->ipi6_addr, sizeof(in6->sin6_addr));
+					in6->sin6_port = dst_port;
+				}
+			}
+#endif
+			break;
+		}
+	}
+}
+
 /* Receive a single message from datagram socket <fd>. Data are placed in <out>
  * buffer of length <len>.
  *
@@ -358,20 +437,9 @@ static ssize_t quic_recv(int fd, void *out, size_t len,
                          struct sockaddr *to, socklen_t to_len,
                          uint16_t dst_port)
 {
-	union pktinfo {
-#ifdef IP_PKTINFO
-		struct in_pktinfo in;
-#else /* !IP_PKTINFO */
-		struct in_addr addr;
-#endif
-#ifdef IPV6_RECVPKTINFO
-		struct in6_pktinfo in6;
-#endif
-	};
-	char cdata[CMSG_SPACE(sizeof(union pktinfo))];
+	char cdata[CMSG_SPACE(sizeof(union quic_pktinfo))];
 	struct msghdr msg;
 	struct iovec vec;
-	struct cmsghdr *cmsg;
 	ssize_t ret;
 
 	vec.iov_base = out;
@@ -403,71 +471,97 @@ static ssize_t quic_recv(int fd, void *out, size_t len,
 		goto end;
 	}
 
-	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
-		switch (cmsg->cmsg_level) {
-		case IPPROTO_IP:
-#if defined(IP_PKTINFO)
-			if (cmsg->cmsg_type == IP_PKTINFO) {
-				struct sockaddr_in *in = (struct sockaddr_in *)to;
-				struct in_pktinfo *info = (struct in_pktinfo *)CMSG_DATA(cmsg);
+	quic_recv_dstaddr(&msg, to, to_len, dst_port);
+ end:
+	return ret;
+}
 
-				if (to_len >= sizeof(struct sockaddr_in)) {
-					in->sin_family = AF_INET;
-					in->sin_addr = info->ipi_addr;
-					in->sin_port = dst_port;
-				}
-			}
-#elif defined(IP_RECVDSTADDR)
-			if (cmsg->cmsg_type == IP_RECVDSTADDR) {
-				struct sockaddr_in *in = (struct sockaddr_in *)to;
-				struct in_addr *info = (struct in_addr *)CMSG_DATA(cmsg);
+/* Receive up to <count> datagrams from datagram socket <fd>, using a single
+ * recvmmsg() syscall when supported. Datagram <i> is placed at <out> + <i> *
+ * <len>, its length is stored into <lens>[i] and its addresses into <from>[i]
+ * and <to>[i] as done by quic_recv(). Datagrams coming from a restricted port
+ * are reported with a zero length. <count> may not be larger than
+ * QUIC_RX_BATCH_MAX.
+ *
+ * Returns the number of datagrams received, or a negative value on error with
+ * errno set.
+ */
+static int quic_recv_batch(int fd, unsigned char *out, size_t len, int count,
+                           size_t *lens, struct sockaddr_storage *from,
+                           struct sockaddr_storage *to, uint16_t dst_port)
+{
+	ssize_t ret;
 
-				if (to_len >= sizeof(struct sockaddr_in)) {
-					in->sin_family = AF_INET;
-					in->sin_addr.s_addr = info->s_addr;
-					in->sin_port = dst_port;
-				}
-			}
-#endif /* IP_PKTINFO || IP_RECVDSTADDR */
-			break;
+#ifdef HA_HAVE_RECVMMSG
+	char cdata[QUIC_RX_BATCH_MAX][CMSG_SPACE(sizeof(union quic_pktinfo))];
+	struct mmsghdr msgs[QUIC_RX_BATCH_MAX];
+	struct iovec vecs[QUIC_RX_BATCH_MAX];
+	int i;
 
-		case IPPROTO_IPV6:
-#ifdef IPV6_RECVPKTINFO
-			if (cmsg->cmsg_type == IPV6_PKTINFO) {
-				struct sockaddr_in6 *in6 = (struct sockaddr_in6 *)to;
-				struct in6_pktinfo *info6 = (struct in6_pktinfo *)CMSG_DATA(cmsg);
+	BUG_ON(count > QUIC_RX_BATCH_MAX);
 
-				if (to_len >= sizeof(struct sockaddr_in6)) {
-					in6->sin6_family = AF_INET6;
-					memcpy(&in6->sin6_addr, &info6->ipi6_addr, sizeof(in6->sin6_addr));
-					in6->sin6_port = dst_port;
-				}
-			}
-#endif
-			break;
-		}
+	if (count <= 1)
+		goto single;
+
+	memset(msgs, 0, count * sizeof(*msgs));
+	for (i = 0; i < count; i++) {
+		vecs[i].iov_base = out + i * len;
+		vecs[i].iov_len  = len;
+
+		msgs[i].msg_hdr.msg_name       = &from[i];
+		msgs[i].msg_hdr.msg_namelen    = sizeof(from[i]);
+		msgs[i].msg_hdr.msg_iov        = &vecs[i];
+		msgs[i].msg_hdr.msg_iovlen     = 1;
+		msgs[i].msg_hdr.msg_control    = cdata[i];
+		msgs[i].msg_hdr.msg_controllen = sizeof(cdata[i]);
 	}
 
- end:
+	do {
+		ret = recvmmsg(fd, msgs, count, 0, NULL);
+	} while (ret < 0 && errno == EINTR);
+
+	for (i = 0; i < ret; i++) {
+		lens[i] = msgs[i].msg_len;
+		clear_addr(&to[i]);
+		if (unlikely(port_is_restricted(&from[i], HA_PROTO_QUIC)))
+			lens[i] = 0;
+		else
+			quic_recv_dstaddr(&msgs[i].msg_hdr, (struct sockaddr *)&to[i],
+			                  sizeof(to[i]), dst_port);
+	}
 	return ret;
+
+ single:
+#endif
+	ret = quic_recv(fd, out, len,
+	                (struct sockaddr *)&from[0], sizeof(from[0]),
+	                (struct sockaddr *)&to[0], sizeof(to[0]),
+	                dst_port);
+	if (ret < 0)
+		return -1;
+
+	lens[0] = ret;
+	return 1;
 }
 
 /* Function called on a read event from a listening socket. It tries
- * to handle as many connections as possible.
+ * to handle as many connections as possible. Datagrams are retrieved by
+ * batches into the contiguous space of the RX buffer, one slot of the
+ * maximum datagram size each, then packed and dispatched one at a time.
  */
 void quic_lstnr_sock_fd_iocb(int fd)
 {
-	ssize_t ret;
 	struct quic_receiver_buf *rxbuf;
 	struct buffer *buf;
 	struct listener *l = objt_listener(fdtab[fd].owner);
 	struct quic_transport_params *params;
-	/* Source address */
-	struct sockaddr_storage saddr = {0}, daddr = {0};
+	/* Source and destination addresses */
+	struct sockaddr_storage saddr[QUIC_RX_BATCH_MAX], daddr[QUIC_RX_BATCH_MAX];
+	size_t lens[QUIC_RX_BATCH_MAX];
 	size_t max_sz, cspace;
 	struct quic_dgram *new_dgram;
 	unsigned char *dgram_buf;
-	int max_dgrams;
+	int max_dgrams, batch, ret, i;
 
 	BUG_ON(!l);
 
@@ -531,22 +625,33 @@ void quic_lstnr_sock_fd_iocb(int fd)
 		}
 	}
 
+	batch = MIN(b_contig_space(buf) / max_sz, QUIC_RX_BATCH_MAX);
+	batch = MIN(batch, max_dgrams);
+
 	dgram_buf = (unsigned char *)b_tail(buf);
-	ret = quic_recv(fd, dgram_buf, max_sz,
-	                (struct sockaddr *)&saddr, sizeof(saddr),
-	                (struct sockaddr *)&daddr, sizeof(daddr),
-	                get_net_port(&l->rx.addr));
+	ret = quic_recv_batch(fd, dgram_buf, max_sz, batch, lens, saddr, daddr,
+	                      get_net_port(&l->rx.addr));
 	if (ret <= 0)
 		goto out;
 
-	b_add(buf, ret);
-	if (!quic_lstnr_dgram_dispatch(dgram_buf, ret, l, &saddr, &daddr,
-	                               new_dgram, &rxbuf->dgram_list)) {
-		/* If wrong, consume this datagram */
-		b_sub(buf, ret);
+	for (i = 0; i < ret; i++) {
+		unsigned char *pos = (unsigned char *)b_tail(buf);
+
+		/* pack the datagram right after the previous one */
+		if (pos != dgram_buf + i * max_sz)
+			memmove(pos, dgram_buf + i * max_sz, lens[i]);
+
+		b_add(buf, lens[i]);
+		if (!quic_lstnr_dgram_dispatch(pos, lens[i], l, &saddr[i], &daddr[i],
+		                               new_dgram, &rxbuf->dgram_list)) {
+			/* If wrong, consume this datagram */
+			b_sub(buf, lens[i]);
+		}
+		new_dgram = NULL;
 	}
-	new_dgram = NULL;
-	if (--max_dgrams > 0)
+
+	max_dgrams -= ret;
+	if (ret == batch && max_dgrams > 0)
 		goto start;
  out:
 	pool_free(pool_head_quic_dgram, new_dgram);
@@ -678,12 +783,117 @@ static void cmsg_set_gso(struct msghdr *msg, struct cmsghdr **cmsg,
 #endif
 }
 
+static void cmsg_set_txtime(struct msghdr *msg, struct cmsghdr **cmsg,
+                            uint64_t txtime)
+{
+#ifdef SO_TXTIME
+	struct cmsghdr *c;
+	size_t sz = sizeof(txtime);
+
+	/* Set first msg_controllen to be able to use CMSG_* macros. */
+	msg->msg_controllen += CMSG_SPACE(sz);
+
+	*cmsg = !(*cmsg) ? CMSG_FIRSTHDR(msg) : CMSG_NXTHDR(msg, *cmsg);
+	ALREADY_CHECKED(*cmsg);
+	c = *cmsg;
+	c->cmsg_level = SOL_SOCKET;
+	c->cmsg_type = SCM_TXTIME;
+	c->cmsg_len = CMSG_LEN(sz);
+	memcpy(CMSG_DATA(c), &txtime, sz);
+#endif
+}
+
+/* Enable SO_TXTIME on <fd> so that the datagrams sent over it may be stamped
+ * with their departure time, expressed against the monotonic clock. Such
+ * datagrams are then delayed by the kernel fq qdisc until this date.
+ *
+ * Returns 0 on success else a negative value, notably if unsupported.
+ */
+int quic_sock_set_txtime(int fd)
+{
+#ifdef SO_TXTIME
+	struct sock_txtime txt = { .clockid = CLOCK_MONOTONIC, .flags = 0 };
+
+	return setsockopt(fd, SOL_SOCKET, SO_TXTIME, &txt, sizeof(txt));
+#else
+	return -1;
+#endif
+}
+
+/* Attach to <fd> a classic BPF program selecting the socket of its reuseport
+ * group which will receive each datagram. The steering index of the socket is
+ * read from the byte at QUIC_CID_STEER_OFS in the DCID of the packet, which is
+ * known to be QUIC_HAP_CID_LEN long for short header packets, then translated
+ * into the slot of this socket in the group through <map>. <map> has <nb>
+ * entries, entry <i> being the slot of the socket whose steering index is <i>,
+ * or -1 if there is none. The kernel falls back to its usual hash for long
+ * header packets with another DCID length or for unknown indexes, hence for
+ * all packets if <nb> is zero.
+ *
+ * Returns 0 on success else a negative value, notably if unsupported.
+ */
+int quic_sock_set_cid_steering(int fd, const short *map, int nb)
+{
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+	/* The UDP header is already skipped by the kernel. */
+	struct sock_filter code[9 + 2 * 256];
+	struct sock_fprog prog = { .filter = code };
+	int i, identity = (nb > 0);
+	int n = 0;
+
+	if (nb > 256)
+		return -1;
+
+	/* 0: load first byte, go to 7 for short header */
+	code[n++] = (struct sock_filter)BPF_STMT(BPF_LD  | BPF_B   | BPF_ABS, 0);
+	code[n++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x80, 0, 5);
+	/* 2: long header, check DCID length */
+	code[n++] = (struct sock_filter)BPF_STMT(BPF_LD  | BPF_B   | BPF_ABS, 5);
+	code[n++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, QUIC_HAP_CID_LEN, 1, 0);
+	code[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, 0xffffffff);
+	code[n++] = (struct sock_filter)BPF_STMT(BPF_LD  | BPF_B   | BPF_ABS, 6 + QUIC_CID_STEER_OFS);
+	code[n++] = (struct sock_filter)BPF_STMT(BPF_JMP | BPF_JA, 1);
+	/* 7: short header */
+	code[n++] = (struct sock_filter)BPF_STMT(BPF_LD  | BPF_B   | BPF_ABS, 1 + QUIC_CID_STEER_OFS);
+
+	/* 8: translate the index into a slot. The kernel already ignores the
+	 * slots past the end of the group so the index may be directly used
+	 * as long as all the sockets are still at their initial place.
+	 */
+	for (i = 0; i < nb; i++)
+		if (map[i] != i)
+			identity = 0;
+
+	if (identity) {
+		code[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_A, 0);
+	}
+	else {
+		for (i = 0; i < nb; i++) {
+			if (map[i] < 0)
+				continue;
+			code[n++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, i, 0, 1);
+			code[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, map[i]);
+		}
+		code[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, 0xffffffff);
+	}
+
+	prog.len = n;
+	return setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+#else
+	return -1;
+#endif
+}
+
 /* Send a datagram stored into <buf> buffer with <sz> as size. The caller must
  * ensure there is at least <sz> bytes in this buffer.
  *
  * If <gso_size> is non null, it will be used as value for UDP_SEGMENT option.
  * This allows to transmit multiple datagrams in a single syscall.
  *
+ * If <txtime> is non null, it is used as the departure time of the datagrams
+ * (SCM_TXTIME) in nanoseconds on the monotonic clock. The socket must have
+ * been prepared with quic_sock_set_txtime().
+ *
  * Returns the total bytes sent over the socket. 0 is returned if a transient
  * error is encountered which allows send to be retry later. A negative value
  * is used for a fatal error which guarantee that all future send operation for
@@ -693,7 +903,7 @@ static void cmsg_set_gso(struct msghdr *msg, struct cmsghdr **cmsg,
  * done by removing the <qc> arg and replace it with address/port.
  */
 int qc_snd_buf(struct quic_conn *qc, const struct buffer *buf, size_t sz,
-               int flags, uint16_t gso_size)
+               int flags, uint16_t gso_size, uint64_t txtime)
 {
 	ssize_t ret;
 	struct msghdr msg;
@@ -702,12 +912,15 @@ int qc_snd_buf(struct quic_conn *qc, const struct buffer *buf, size_t sz,
 
 	union {
 #ifdef IP_PKTINFO
-		char buf[CMSG_SPACE(sizeof(struct in_pktinfo)) + CMSG_SPACE(sizeof(gso_size))];
+		char buf[CMSG_SPACE(sizeof(struct in_pktinfo)) + CMSG_SPACE(sizeof(gso_size)) +
+		         CMSG_SPACE(sizeof(txtime))];
 #endif /* IP_PKTINFO */
 #ifdef IPV6_RECVPKTINFO
-		char buf6[CMSG_SPACE(sizeof(struct in6_pktinfo)) + CMSG_SPACE(sizeof(gso_size))];
+		char buf6[CMSG_SPACE(sizeof(struct in6_pktinfo)) + CMSG_SPACE(sizeof(gso_size)) +
+		          CMSG_SPACE(sizeof(txtime))];
 #endif /* IPV6_RECVPKTINFO */
-		char bufaddr[CMSG_SPACE(sizeof(struct in_addr)) + CMSG_SPACE(sizeof(gso_size))];
+		char bufaddr[CMSG_SPACE(sizeof(struct in_addr)) + CMSG_SPACE(sizeof(gso_size)) +
+		             CMSG_SPACE(sizeof(txtime))];
 		struct cmsghdr align;
 	} ancillary_data;
 
@@ -766,6 +979,13 @@ int qc_snd_buf(struct quic_conn *qc, const struct buffer *buf, size_t sz,
 		cmsg_set_gso(&msg, &cmsg, gso_size);
 	}
 
+	/* Set the departure time of paced datagrams. */
+	if (txtime) {
+		if (!msg.msg_control)
+			msg.msg_control = ancillary_data.bufaddr;
+		cmsg_set_txtime(&msg, &cmsg, txtime);
+	}
+
 	do {
 		ret = sendmsg(qc_fd(qc), &msg, MSG_DONTWAIT|MSG_NOSIGNAL);
 	} while (ret < 0 && errno == EINTR);
@@ -802,20 +1022,23 @@ int qc_snd_buf(struct quic_conn *qc, const struct buffer *buf, size_t sz,
 	return ret;
 }
 
-/* Receive datagram on <qc> FD-owned socket.
+/* Receive datagram on <qc> FD-owned socket. Datagrams are retrieved by batches
+ * into a buffer, one slot of the maximum datagram size each.
  *
  * Returns the total number of bytes read or a negative value on error.
  */
 int qc_rcv_buf(struct quic_conn *qc)
 {
-	struct sockaddr_storage saddr = {0}, daddr = {0};
-	struct quic_transport_params *params;
+	struct sockaddr_storage saddr[QUIC_RX_BATCH_MAX], daddr[QUIC_RX_BATCH_MAX];
+	size_t lens[QUIC_RX_BATCH_MAX];
 	struct quic_dgram *new_dgram = NULL;
 	struct buffer buf = BUF_NULL;
 	size_t max_sz;
 	unsigned char *dgram_buf;
 	struct listener *l;
 	ssize_t ret = 0;
+	ssize_t total = 0;
+	int batch, count, i;
 
 	/* Do not call this if quic-conn FD is uninitialized. */
 	BUG_ON(qc->fd < 0);
@@ -823,8 +1046,9 @@ int qc_rcv_buf(struct quic_conn *qc)
 	TRACE_ENTER(QUIC_EV_CONN_RCV, qc);
 	l = qc->li;
 
-	params = &l->bind_conf->quic_params;
-	max_sz = params->max_udp_payload_size;
+	/* Backend connections are not attached to any listener. */
+	max_sz = l ? l->bind_conf->quic_params.max_udp_payload_size :
+	             qc->rx.params.max_udp_payload_size;
 
 	do {
 		if (!b_alloc(&buf, DB_MUX_RX))
@@ -832,106 +1056,116 @@ int qc_rcv_buf(struct quic_conn *qc)
 
 		b_reset(&buf);
 		BUG_ON(b_contig_space(&buf) < max_sz);
+		batch = MIN(b_contig_space(&buf) / max_sz, QUIC_RX_BATCH_MAX);
 
-		/* Allocate datagram on first loop or after requeuing. */
-		if (!new_dgram && !(new_dgram = pool_alloc(pool_head_quic_dgram)))
-			break; /* TODO subscribe for memory again available. */
-
-		dgram_buf = (unsigned char *)b_tail(&buf);
-		ret = quic_recv(qc->fd, dgram_buf, max_sz,
-		                (struct sockaddr *)&saddr, sizeof(saddr),
-		                (struct sockaddr *)&daddr, sizeof(daddr),
-		                get_net_port(&qc->local_addr));
-		if (ret <= 0) {
+		count = quic_recv_batch(qc->fd, (unsigned char *)b_tail(&buf), max_sz, batch,
+		                        lens, saddr, daddr, get_net_port(&qc->local_addr));
+		if (count <= 0) {
 			/* Subscribe FD for future reception. */
 			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOTCONN)
 				fd_want_recv(qc->fd);
 			/* TODO handle other error codes as fatal on the connection. */
+			ret = -1;
 			break;
 		}
 
-		b_add(&buf, ret);
+		for (i = 0; i < count; i++) {
+			dgram_buf = (unsigned char *)b_tail(&buf) + i * max_sz;
+			ret = lens[i];
+			if (!ret)
+				continue;
+
+			total += ret;
 
-		new_dgram->obj_type = OBJ_TYPE_DGRAM;
-		new_dgram->buf = dgram_buf;
-		new_dgram->len = ret;
-		new_dgram->dcid_len = 0;
-		new_dgram->dcid = NULL;
-		new_dgram->saddr = saddr;
-		new_dgram->daddr = daddr;
-		new_dgram->qc = NULL;  /* set later via quic_dgram_parse() */
-		new_dgram->flags = 0;
+			/* Allocate datagram on first loop or after requeuing. */
+			if (!new_dgram && !(new_dgram = pool_alloc(pool_head_quic_dgram)))
+				break; /* TODO subscribe for memory again available. */
 
-		TRACE_DEVEL("read datagram", QUIC_EV_CONN_RCV, qc, new_dgram);
+			new_dgram->obj_type = OBJ_TYPE_DGRAM;
+			new_dgram->buf = dgram_buf;
+			new_dgram->len = ret;
+			new_dgram->dcid_len = 0;
+			new_dgram->dcid = NULL;
+			new_dgram->saddr = saddr[i];
+			new_dgram->daddr = daddr[i];
+			new_dgram->qc = NULL;  /* set later via quic_dgram_parse() */
+			new_dgram->flags = 0;
 
-		if (!quic_get_dgram_dcid(new_dgram->buf,
-		                         new_dgram->buf + new_dgram->len,
-		                         &new_dgram->dcid, &new_dgram->dcid_len)) {
-			continue;
-		}
+			TRACE_DEVEL("read datagram", QUIC_EV_CONN_RCV, qc, new_dgram);
 
-		if (!qc_check_dcid(qc, new_dgram->dcid, new_dgram->dcid_len)) {
-			/* Datagram received by error on the connection FD, dispatch it
-			 * to its associated quic-conn.
-			 *
-			 * TODO count redispatch datagrams.
-			 */
-			struct quic_receiver_buf *rxbuf;
-			struct quic_dgram *tmp_dgram;
-			unsigned char *rxbuf_tail;
-			size_t cspace;
-
-			TRACE_STATE("datagram for other connection on quic-conn socket, requeue it", QUIC_EV_CONN_RCV, qc);
-
-			rxbuf = MT_LIST_POP(&l->rx.rxbuf_list, typeof(rxbuf), rxbuf_el);
-			ALREADY_CHECKED(rxbuf);
-			cspace = b_contig_space(&rxbuf->buf);
-
-			tmp_dgram = quic_rxbuf_purge_dgrams(rxbuf);
-			pool_free(pool_head_quic_dgram, tmp_dgram);
-
-			/* Insert a fake datagram if space wraps to consume it. */
-			if (cspace < new_dgram->len && b_space_wraps(&rxbuf->buf)) {
-				struct quic_dgram *fake_dgram = pool_alloc(pool_head_quic_dgram);
-				if (!fake_dgram) {
+			if (!quic_get_dgram_dcid(new_dgram->buf,
+			                         new_dgram->buf + new_dgram->len,
+			                         &new_dgram->dcid, &new_dgram->dcid_len)) {
+				continue;
+			}
+
+			if (!qc_check_dcid(qc, new_dgram->dcid, new_dgram->dcid_len)) {
+				/* Datagram received by error on the connection FD, dispatch it
+				 * to its associated quic-conn.
+				 *
+				 * TODO count redispatch datagrams.
+				 */
+				struct quic_receiver_buf *rxbuf;
+				struct quic_dgram *tmp_dgram;
+				unsigned char *rxbuf_tail;
+				size_t cspace;
+
+				/* A backend connection socket is never shared. */
+				if (!l) {
+					TRACE_STATE("datagram with unknown DCID on backend socket, dropped", QUIC_EV_CONN_RCV, qc);
+					continue;
+				}
+
+				TRACE_STATE("datagram for other connection on quic-conn socket, requeue it", QUIC_EV_CONN_RCV, qc);
+
+				rxbuf = MT_LIST_POP(&l->rx.rxbuf_list, typeof(rxbuf), rxbuf_el);
+				ALREADY_CHECKED(rxbuf);
+				cspace = b_contig_space(&rxbuf->buf);
+
+				tmp_dgram = quic_rxbuf_purge_dgrams(rxbuf);
+				pool_free(pool_head_quic_dgram, tmp_dgram);
+
+				/* Insert a fake datagram if space wraps to consume it. */
+				if (cspace < new_dgram->len && b_space_wraps(&rxbuf->buf)) {
+					struct quic_dgram *fake_dgram = pool_alloc(pool_head_quic_dgram);
+					if (!fake_dgram) {
+						/* TODO count lost datagrams */
+						MT_LIST_APPEND(&l->rx.rxbuf_list, &rxbuf->rxbuf_el);
+						continue;
+					}
+
+					fake_dgram->buf = NULL;
+					fake_dgram->len = cspace;
+					LIST_APPEND(&rxbuf->dgram_list, &fake_dgram->recv_list);
+					b_add(&rxbuf->buf, cspace);
+				}
+
+				/* Recheck contig space after fake datagram insert. */
+				if (b_contig_space(&rxbuf->buf) < new_dgram->len) {
 					/* TODO count lost datagrams */
 					MT_LIST_APPEND(&l->rx.rxbuf_list, &rxbuf->rxbuf_el);
 					continue;
 				}
 
-				fake_dgram->buf = NULL;
-				fake_dgram->len = cspace;
-				LIST_APPEND(&rxbuf->dgram_list, &fake_dgram->recv_list);
-				b_add(&rxbuf->buf, cspace);
-			}
+				rxbuf_tail = (unsigned char *)b_tail(&rxbuf->buf);
+				__b_putblk(&rxbuf->buf, (char *)dgram_buf, new_dgram->len);
+				if (!quic_lstnr_dgram_dispatch(rxbuf_tail, ret, l, &saddr[i], &daddr[i],
+				                               new_dgram, &rxbuf->dgram_list)) {
+					/* TODO count lost datagrams. */
+					b_sub(&rxbuf->buf, ret);
+				}
+				/* datagram was either requeued or released */
+				new_dgram = NULL;
 
-			/* Recheck contig space after fake datagram insert. */
-			if (b_contig_space(&rxbuf->buf) < new_dgram->len) {
-				/* TODO count lost datagrams */
 				MT_LIST_APPEND(&l->rx.rxbuf_list, &rxbuf->rxbuf_el);
 				continue;
 			}
 
-			rxbuf_tail = (unsigned char *)b_tail(&rxbuf->buf);
-			__b_putblk(&rxbuf->buf, (char *)dgram_buf, new_dgram->len);
-			if (!quic_lstnr_dgram_dispatch(rxbuf_tail, ret, l, &saddr, &daddr,
-			                               new_dgram, &rxbuf->dgram_list)) {
-				/* TODO count lost datagrams. */
-				b_sub(&buf, ret);
-			}
-			else {
-				/* datagram must not be freed as it was requeued. */
-				new_dgram = NULL;
-			}
-
-			MT_LIST_APPEND(&l->rx.rxbuf_list, &rxbuf->rxbuf_el);
-			continue;
+			quic_dgram_parse(new_dgram, qc, qc->li);
+			/* A datagram must always be consumed after quic_parse_dgram(). */
+			BUG_ON(new_dgram->buf);
 		}
-
-		quic_dgram_parse(new_dgram, qc, qc->li);
-		/* A datagram must always be consumed after quic_parse_dgram(). */
-		BUG_ON(new_dgram->buf);
-	} while (ret > 0);
+	} while (i == count);
 
 	pool_free(pool_head_quic_dgram, new_dgram);
 
@@ -941,7 +1175,7 @@ int qc_rcv_buf(struct quic_conn *qc)
 	}
 
 	TRACE_LEAVE(QUIC_EV_CONN_RCV, qc);
-	return ret;
+	return total ? total : ret;
 }
 
 /* Allocate a socket file-descriptor specific for QUIC connection <qc>.
@@ -996,6 +1230,12 @@ void qc_alloc_fd(struct quic_conn *qc, const struct sockaddr_storage *src,
 	if (ret < 0)
 		goto err;
 
+	if (global.tune.quic_pacing == QUIC_PACING_TXTIME) {
+		ret = quic_sock_set_txtime(fd);
+		if (ret < 0)
+			goto err;
+	}
+
 	ret = bind(fd, (struct sockaddr *)src, get_addr_len(src));
 	if (ret < 0) {
 		if (errno == EACCES) {
@@ -1,5 +1,8 @@
+#include <haproxy/clock.h>
 #include <haproxy/errors.h>
+#include <haproxy/global.h>
 #include <haproxy/ncbuf.h>
+#include <haproxy/net_helper.h>
 #include <haproxy/proxy.h>
 #include <haproxy/quic_conn.h>
 #include <haproxy/quic_sock.h>
@@ -8,12 +11,266 @@
 #include <haproxy/quic_tp.h>
 #include <haproxy/quic_trace.h>
 #include <haproxy/ssl_sock.h>
+#include <haproxy/task.h>
 #include <haproxy/trace.h>
+#include <haproxy/xxhash.h>
 
 static BIO_METHOD *ha_quic_meth;
 
 DECLARE_POOL(pool_head_quic_ssl_sock_ctx, "quic_ssl_sock_ctx", sizeof(struct ssl_sock_ctx));
 
+#if (defined SSL_CTRL_SET_TLSEXT_TICKET_KEY_CB && TLS_TICKETS_NO > 0)
+/* TLS ticket keys shared by all the QUIC listeners without "tls-ticket-keys"
+ * when "tune.quic.shared-ticket-keys" is enabled. They are derived from the
+ * cluster secret and from the number of the ticket keys period, so that the
+ * threads, the processes started upon reloads and the other nodes sharing the
+ * same cluster secret issue and accept the same tickets.
+ */
+static struct tls_keys_ref *quic_tlskeys_ref;
+static struct task *quic_tlskeys_task;
+static unsigned int quic_tlskeys_period; /* ticket keys period (seconds) */
+static unsigned int quic_tlskeys_epoch;  /* period of the current encryption key */
+
+/* Derive into <key> the ticket key of the <epoch> ticket keys period from the
+ * cluster secret. Return 1 if succeeded, 0 if not.
+ */
+static int quic_tlskey_derive(union tls_sess_key *key, unsigned int epoch)
+{
+	const unsigned char label[] = "tls ticket keys";
+	unsigned char salt[8];
+
+	write_n64(salt, epoch);
+	return quic_hkdf_extract_and_expand(EVP_sha256(),
+	                                    (unsigned char *)&key->key_256, sizeof(key->key_256),
+	                                    global.cluster_secret, sizeof(global.cluster_secret),
+	                                    salt, sizeof(salt), label, sizeof(label) - 1);
+}
+
+/* Fill the ticket keys of <ref> for the <epoch> ticket keys period. As for the
+ * "tls-ticket-keys" files, the penultimate key is used for encryption. The
+ * previous ones are the keys of the previous periods and the last one is the
+ * key of the next period, used by nodes whose clock is slightly in advance.
+ * Return 1 if succeeded, 0 if not.
+ */
+static int quic_tlskeys_update(struct tls_keys_ref *ref, unsigned int epoch)
+{
+	union tls_sess_key keys[TLS_TICKETS_NO];
+	int enc = TLS_TICKETS_NO > 1 ? TLS_TICKETS_NO - 2 : 0;
+	int i, ret = 0;
+
+	for (i = 0; i < TLS_TICKETS_NO; i++) {
+		if (!quic_tlskey_derive(&keys[i], epoch - enc + i))
+			goto out;
+	}
+
+	HA_RWLOCK_WRLOCK(TLSKEYS_REF_LOCK, &ref->lock);
+	memcpy(ref->tlskeys, keys, sizeof(keys));
+	ref->tls_ticket_enc_index = enc;
+	HA_RWLOCK_WRUNLOCK(TLSKEYS_REF_LOCK, &ref->lock);
+	ret = 1;
+ out:
+	memset(keys, 0, sizeof(keys));
+	return ret;
+}
+
+/* Task responsible for the shared ticket keys rotation, woken up at the
+ * beginning of each ticket keys period.
+ */
+static struct task *quic_tlskeys_rotate(struct task *t, void *context, unsigned int state)
+{
+	unsigned int epoch = date.tv_sec / quic_tlskeys_period;
+
+	if (epoch != quic_tlskeys_epoch && quic_tlskeys_update(quic_tlskeys_ref, epoch))
+		quic_tlskeys_epoch = epoch;
+
+	if (epoch != quic_tlskeys_epoch) {
+		/* retry soon */
+		t->expire = tick_add(now_ms, MS_TO_TICKS(1000));
+	}
+	else {
+		t->expire = tick_add(now_ms,
+		                     MS_TO_TICKS(((epoch + 1ULL) * quic_tlskeys_period - date.tv_sec) * 1000));
+	}
+
+	return t;
+}
+
+/* Make <bind_conf> QUIC listener use the shared ticket keys, allocating them
+ * first if needed. The ticket keys period is the session lifetime of <ctx>.
+ * Return 1 if succeeded, 0 if not.
+ */
+static int quic_tlskeys_attach(struct bind_conf *bind_conf, SSL_CTX *ctx)
+{
+	struct tls_keys_ref *ref = quic_tlskeys_ref;
+
+	if (!ref) {
+		ref = calloc(1, sizeof(*ref));
+		if (!ref)
+			return 0;
+
+		ref->tlskeys = calloc(TLS_TICKETS_NO, sizeof(*ref->tlskeys));
+		if (!ref->tlskeys) {
+			free(ref);
+			return 0;
+		}
+
+		LIST_INIT(&ref->list);
+		ref->unique_id = -1;
+		ref->key_size_bits = 256;
+		HA_RWLOCK_INIT(&ref->lock);
+
+		quic_tlskeys_period = SSL_CTX_get_timeout(ctx);
+		if (!quic_tlskeys_period)
+			quic_tlskeys_period = 1;
+		quic_tlskeys_epoch = date.tv_sec / quic_tlskeys_period;
+		if (!quic_tlskeys_update(ref, quic_tlskeys_epoch)) {
+			free(ref->tlskeys);
+			free(ref);
+			return 0;
+		}
+
+		quic_tlskeys_ref = ref;
+	}
+
+	ref->refcount++;
+	bind_conf->keys_ref = ref;
+	return 1;
+}
+
+/* Start the shared ticket keys rotation task if these keys are in use */
+static int quic_tlskeys_task_init(void)
+{
+	if (!quic_tlskeys_ref)
+		return ERR_NONE;
+
+	quic_tlskeys_task = task_new_anywhere();
+	if (!quic_tlskeys_task) {
+		ha_alert("Failed to allocate the QUIC TLS ticket keys rotation task.\n");
+		return ERR_ALERT | ERR_FATAL;
+	}
+
+	quic_tlskeys_task->process = quic_tlskeys_rotate;
+	task_schedule(quic_tlskeys_task, now_ms);
+	return ERR_NONE;
+}
+REGISTER_POST_CHECK(quic_tlskeys_task_init);
+
+static void quic_tlskeys_task_deinit(void)
+{
+	task_destroy(quic_tlskeys_task);
+	quic_tlskeys_task = NULL;
+}
+REGISTER_POST_DEINIT(quic_tlskeys_task_deinit);
+#endif
+
+#if defined(HAVE_SSL_0RTT_QUIC) && !defined(OPENSSL_IS_BORINGSSL) && !defined(OPENSSL_IS_AWSLC)
+/* 0-RTT anti-replay filter. The random of the ClientHello messages carrying
+ * early data are recorded into two generations of bloom filters, the current
+ * one and the previous one, rotated every QUIC_0RTT_FILTER_PERIOD seconds.
+ * Any early data found in these filters is refused and the handshake goes on
+ * as a 1-RTT one. As the filters of the previous processes are unknown after
+ * a reload, early data are also refused during the first period.
+ */
+static struct {
+	ulong *bits[2];      /* current and previous generations */
+	unsigned int gen;    /* generation number of bits[0] */
+	time_t ready;        /* date from which early data may be accepted */
+	__decl_thread(HA_SPINLOCK_T lock);
+} quic_0rtt_filter;
+
+/* Set to 1 if at least one QUIC listener accepts early data */
+static int quic_0rtt_filter_used;
+
+/* Look up <rand> ClientHello random with <len> as length into the 0-RTT
+ * anti-replay filter and record it. Return 1 if it was not found, 0 if the
+ * early data may be a replay.
+ */
+static int quic_0rtt_filter_check(const unsigned char *rand, size_t len)
+{
+	XXH128_hash_t h = XXH3_128bits(rand, len);
+	unsigned int gen = date.tv_sec / QUIC_0RTT_FILTER_PERIOD;
+	int i, seen0 = 1, seen1 = 1;
+
+	HA_SPIN_LOCK(OTHER_LOCK, &quic_0rtt_filter.lock);
+	if (gen > quic_0rtt_filter.gen) {
+		ulong *prev = quic_0rtt_filter.bits[1];
+
+		if (gen == quic_0rtt_filter.gen + 1) {
+			quic_0rtt_filter.bits[1] = quic_0rtt_filter.bits[0];
+			quic_0rtt_filter.bits[0] = prev;
+		}
+		else
+			memset(quic_0rtt_filter.bits[1], 0, QUIC_0RTT_FILTER_BITS / 8);
+		memset(quic_0rtt_filter.bits[0], 0, QUIC_0RTT_FILTER_BITS / 8);
+		quic_0rtt_filter.gen = gen;
+	}
+
+	for (i = 0; i < QUIC_0RTT_FILTER_HASHES; i++) {
+		uint64_t bit = (h.low64 + i * h.high64) & (QUIC_0RTT_FILTER_BITS - 1);
+		ulong mask = 1UL << (bit % LONGBITS);
+
+		if (!(quic_0rtt_filter.bits[0][bit / LONGBITS] & mask))
+			seen0 = 0;
+		if (!(quic_0rtt_filter.bits[1][bit / LONGBITS] & mask))
+			seen1 = 0;
+		quic_0rtt_filter.bits[0][bit / LONGBITS] |= mask;
+	}
+	HA_SPIN_UNLOCK(OTHER_LOCK, &quic_0rtt_filter.lock);
+
+	return !seen0 && !seen1;
+}
+
+/* Callback called by the TLS stack to decide if the early data of <ssl>
+ * session may be accepted. Return 1 if so, 0 if not.
+ */
+static int quic_ssl_allow_early_data_cb(SSL *ssl, void *arg)
+{
+	struct quic_conn *qc = SSL_get_ex_data(ssl, ssl_qc_app_data_index);
+	unsigned char rand[SSL3_RANDOM_SIZE];
+
+	if (date.tv_sec < quic_0rtt_filter.ready) {
+		TRACE_STATE("0-RTT refused during anti-replay filter warmup", QUIC_EV_CONN_IO_CB, qc);
+		return 0;
+	}
+
+	if (SSL_get_client_random(ssl, rand, sizeof(rand)) != sizeof(rand) ||
+	    !quic_0rtt_filter_check(rand, sizeof(rand))) {
+		TRACE_STATE("0-RTT refused by anti-replay filter", QUIC_EV_CONN_IO_CB, qc);
+		HA_ATOMIC_INC(&qc->prx_counters->zero_rtt_replayed);
+		return 0;
+	}
+
+	return 1;
+}
+
+/* Allocate the 0-RTT anti-replay filter if used */
+static int quic_0rtt_filter_init(void)
+{
+	if (!quic_0rtt_filter_used)
+		return ERR_NONE;
+
+	quic_0rtt_filter.bits[0] = calloc(1, QUIC_0RTT_FILTER_BITS / 8);
+	quic_0rtt_filter.bits[1] = calloc(1, QUIC_0RTT_FILTER_BITS / 8);
+	if (!quic_0rtt_filter.bits[0] || !quic_0rtt_filter.bits[1]) {
+		ha_alert("Failed to allocate the QUIC 0-RTT anti-replay filter.\n");
+		return ERR_ALERT | ERR_FATAL;
+	}
+
+	quic_0rtt_filter.gen = date.tv_sec / QUIC_0RTT_FILTER_PERIOD;
+	quic_0rtt_filter.ready = date.tv_sec + QUIC_0RTT_FILTER_PERIOD;
+	HA_SPIN_INIT(&quic_0rtt_filter.lock);
+	return ERR_NONE;
+}
+REGISTER_POST_CHECK(quic_0rtt_filter_init);
+
+static void quic_0rtt_filter_deinit(void)
+{
+	ha_free(&quic_0rtt_filter.bits[0]);
+	ha_free(&quic_0rtt_filter.bits[1]);
+}
+REGISTER_POST_DEINIT(quic_0rtt_filter_deinit);
+#endif
+
 /* Set the encoded version of the transport parameter into the TLS
  * stack depending on <ver> QUIC version and <server> boolean which must
  * be set to 1 for a QUIC server, 0 for a client.
@@ -457,9 +714,29 @@ int ssl_quic_initial_ctx(struct bind_conf *bind_conf)
 #else
 		SSL_CTX_set_options(ctx, SSL_OP_NO_ANTI_REPLAY);
 		SSL_CTX_set_max_early_data(ctx, 0xffffffff);
+		SSL_CTX_set_allow_early_data_cb(ctx, quic_ssl_allow_early_data_cb, NULL);
+		quic_0rtt_filter_used = 1;
 #endif /* ! HAVE_SSL_0RTT_QUIC  */
 	}
 
+	if (global_ssl.life_time)
+		SSL_CTX_set_timeout(ctx, global_ssl.life_time);
+
+#if (defined SSL_CTRL_SET_TLSEXT_TICKET_KEY_CB && TLS_TICKETS_NO > 0)
+	if (!bind_conf->keys_ref && (global.tune.options & GTUNE_QUIC_SHARED_TICKET_KEYS)) {
+		if (!cluster_secret_isset) {
+			ha_alert("Binding [%s:%d] for %s %s: 'tune.quic.shared-ticket-keys' requires 'cluster-secret' to be set.\n",
+			         bind_conf->file, bind_conf->line, proxy_type_str(bind_conf->frontend), bind_conf->frontend->id);
+			cfgerr++;
+		}
+		else if (!quic_tlskeys_attach(bind_conf, ctx)) {
+			ha_alert("Binding [%s:%d] for %s %s: unable to initialize the shared TLS ticket keys.\n",
+			         bind_conf->file, bind_conf->line, proxy_type_str(bind_conf->frontend), bind_conf->frontend->id);
+			cfgerr++;
+		}
+	}
+#endif
+
 #ifdef SSL_CTRL_SET_TLSEXT_HOSTNAME
 # if defined(OPENSSL_IS_BORINGSSL) || defined(OPENSSL_IS_AWSLC)
 	SSL_CTX_set_select_certificate_cb(ctx, ssl_sock_switchctx_cbk);
@@ -480,6 +757,23 @@ int ssl_quic_initial_ctx(struct bind_conf *bind_conf)
 	return cfgerr;
 }
 
+/* Adapt the TLS context <ctx> of <srv> QUIC server to QUIC.
+ * Returns an error count.
+ */
+int ssl_quic_srv_ctx_init(const struct server *srv, SSL_CTX *ctx)
+{
+	int cfgerr = 0;
+
+	SSL_CTX_set_min_proto_version(ctx, TLS1_3_VERSION);
+	SSL_CTX_set_max_proto_version(ctx, TLS1_3_VERSION);
+#ifdef USE_QUIC_OPENSSL_COMPAT
+	if (!quic_tls_compat_init(NULL, ctx))
+		cfgerr++;
+#endif
+
+	return cfgerr;
+}
+
 /* This function gives the detail of the SSL error. It is used only
  * if the debug mode and the verbose mode are activated. It dump all
  * the SSL error until the stack was empty.
@@ -543,7 +837,8 @@ static int qc_ssl_provide_quic_data(struct ncbuf *ncbuf,
 		 * have been received. This may be useful to send packets even if this
 		 * handshake fails.
 		 */
-		if ((qc->flags & QUIC_FL_CONN_TX_TP_RECEIVED) && !qc_conn_finalize(qc, 1)) {
+		if ((qc->flags & QUIC_FL_CONN_TX_TP_RECEIVED) &&
+		    !qc_conn_finalize(qc, qc_is_listener(qc))) {
 			TRACE_ERROR("connection finalization failed", QUIC_EV_CONN_IO_CB, qc, &state);
 			goto leave;
 		}
@@ -598,6 +893,33 @@ static int qc_ssl_provide_quic_data(struct ncbuf *ncbuf,
 
 		TRACE_PROTO("SSL handshake OK", QUIC_EV_CONN_IO_CB, qc, &state);
 
+		if (!qc_is_listener(qc)) {
+			const unsigned char *alpn;
+			unsigned int alpn_len;
+
+#ifndef USE_QUIC_OPENSSL_COMPAT
+			const uint8_t *tps;
+			size_t tps_len;
+
+			SSL_get_peer_quic_transport_params(ctx->ssl, &tps, &tps_len);
+			if (!tps_len || !quic_transport_params_store(qc, 1, tps, tps + tps_len)) {
+				TRACE_ERROR("invalid server transport parameters", QUIC_EV_CONN_IO_CB, qc, &state);
+				quic_set_connection_close(qc, quic_err_transport(QC_ERR_TRANSPORT_PARAMETER_ERROR));
+				goto leave;
+			}
+
+			qc->flags |= QUIC_FL_CONN_TX_TP_RECEIVED;
+			if (!qc_conn_finalize(qc, 0)) {
+				TRACE_ERROR("connection finalization failed", QUIC_EV_CONN_IO_CB, qc, &state);
+				goto leave;
+			}
+#endif
+			/* The application protocol is selected by the server. */
+			SSL_get0_alpn_selected(ctx->ssl, &alpn, &alpn_len);
+			if (alpn_len)
+				quic_set_app_ops(qc, alpn, alpn_len);
+		}
+
 		/* Check the alpn could be negotiated */
 		if (!qc->app_ops) {
 			TRACE_ERROR("No negotiated ALPN", QUIC_EV_CONN_IO_CB, qc, &state);
@@ -605,9 +927,9 @@ static int qc_ssl_provide_quic_data(struct ncbuf *ncbuf,
 			goto leave;
 		}
 
-		/* I/O callback switch */
-		qc->wait_event.tasklet->process = quic_conn_app_io_cb;
 		if (qc_is_listener(ctx->qc)) {
+			/* I/O callback switch */
+			qc->wait_event.tasklet->process = quic_conn_app_io_cb;
 			qc->flags |= QUIC_FL_CONN_NEED_POST_HANDSHAKE_FRMS;
 			qc->state = QUIC_HS_ST_CONFIRMED;
 
@@ -626,6 +948,10 @@ static int qc_ssl_provide_quic_data(struct ncbuf *ncbuf,
 			HA_ATOMIC_DEC(&qc->li->rx.quic_curr_handshake);
 		}
 		else {
+			/* The client waits for the handshake confirmation
+			 * (HANDSHAKE_DONE) before switching to its
+			 * application I/O callback.
+			 */
 			qc->state = QUIC_HS_ST_COMPLETE;
 		}
 
@@ -634,6 +960,10 @@ static int qc_ssl_provide_quic_data(struct ncbuf *ncbuf,
 			TRACE_ERROR("quic_tls_key_update() failed", QUIC_EV_CONN_IO_CB, qc);
 			goto leave;
 		}
+
+		/* The client connection may now be used by the upper layers. */
+		if (!qc_is_listener(qc))
+			qc_notify_hs_done(qc);
 	} else {
 		ssl_err = SSL_process_quic_post_handshake(ctx->ssl);
 		if (ssl_err != 1) {
@@ -676,6 +1006,36 @@ static int qc_ssl_provide_quic_data(struct ncbuf *ncbuf,
 	return ret;
 }
 
+/* Start the TLS handshake for <qc> client connection to a server: this makes
+ * the TLS stack build the ClientHello message which is stored as CRYPTO data
+ * for the Initial encryption level.
+ * Return 1 if succeeded, 0 if not.
+ */
+int qc_ssl_start_handshake(struct quic_conn *qc)
+{
+	struct ssl_sock_ctx *ctx = qc->xprt_ctx;
+	int ssl_err, ret = 0;
+
+	TRACE_ENTER(QUIC_EV_CONN_SSLDATA, qc);
+
+	ssl_err = SSL_do_handshake(ctx->ssl);
+	if (ssl_err != 1) {
+		ssl_err = SSL_get_error(ctx->ssl, ssl_err);
+		if (ssl_err != SSL_ERROR_WANT_READ && ssl_err != SSL_ERROR_WANT_WRITE) {
+			TRACE_ERROR("SSL handshake error", QUIC_EV_CONN_SSLDATA, qc);
+			HA_ATOMIC_INC(&qc->prx_counters->hdshk_fail);
+			qc_ssl_dump_errors(ctx->conn);
+			ERR_clear_error();
+			goto leave;
+		}
+	}
+
+	ret = 1;
+ leave:
+	TRACE_LEAVE(QUIC_EV_CONN_SSLDATA, qc);
+	return ret;
+}
+
 /* Provide all the stored in order CRYPTO data received from the peer to the TLS.
  * Return 1 if succeeded, 0 if not.
  */
@@ -801,6 +1161,41 @@ static int qc_set_quic_early_data_enabled(struct quic_conn *qc, SSL *ssl)
 }
 #endif // HAVE_SSL_0RTT_QUIC
 
+/* Try to resume on <ssl> the last TLS session stored by the current thread for
+ * <srv> QUIC server, as done by ssl_sock_init() for TLS over TCP.
+ */
+static void qc_ssl_srv_reuse_sess(SSL *ssl, struct server *srv)
+{
+	const unsigned char *ptr;
+	SSL_SESSION *sess;
+
+	HA_RWLOCK_RDLOCK(SSL_SERVER_LOCK, &srv->ssl_ctx.lock);
+	if (!srv->ssl_ctx.reused_sess[tid].ptr)
+		goto out;
+
+	ptr = srv->ssl_ctx.reused_sess[tid].ptr;
+	sess = d2i_SSL_SESSION(NULL, &ptr, srv->ssl_ctx.reused_sess[tid].size);
+	if (!sess)
+		goto out;
+
+	if (!SSL_set_session(ssl, sess)) {
+		SSL_SESSION_free(sess);
+		HA_RWLOCK_WRLOCK(SSL_SERVER_LOCK, &srv->ssl_ctx.reused_sess[tid].sess_lock);
+		ha_free(&srv->ssl_ctx.reused_sess[tid].ptr);
+		HA_RWLOCK_WRUNLOCK(SSL_SERVER_LOCK, &srv->ssl_ctx.reused_sess[tid].sess_lock);
+		goto out;
+	}
+
+	/* already assigned, not needed anymore */
+	SSL_SESSION_free(sess);
+	HA_RWLOCK_RDLOCK(SSL_SERVER_LOCK, &srv->ssl_ctx.reused_sess[tid].sess_lock);
+	if (srv->ssl_ctx.reused_sess[tid].sni)
+		SSL_set_tlsext_host_name(ssl, srv->ssl_ctx.reused_sess[tid].sni);
+	HA_RWLOCK_RDUNLOCK(SSL_SERVER_LOCK, &srv->ssl_ctx.reused_sess[tid].sess_lock);
+ out:
+	HA_RWLOCK_RDUNLOCK(SSL_SERVER_LOCK, &srv->ssl_ctx.lock);
+}
+
 /* Allocate the ssl_sock_ctx from connection <qc>. This creates the tasklet
  * used to process <qc> received packets. The allocated context is stored in
  * <qc.xprt_ctx>.
@@ -810,7 +1205,7 @@ static int qc_set_quic_early_data_enabled(struct quic_conn *qc, SSL *ssl)
 int qc_alloc_ssl_sock_ctx(struct quic_conn *qc)
 {
 	int ret = 0;
-	struct bind_conf *bc = qc->li->bind_conf;
+	struct bind_conf *bc = qc_is_listener(qc) ? qc->li->bind_conf : NULL;
 	struct ssl_sock_ctx *ctx = NULL;
 
 	TRACE_ENTER(QUIC_EV_CONN_NEW, qc);
@@ -821,6 +1216,7 @@ int qc_alloc_ssl_sock_ctx(struct quic_conn *qc)
 		goto err;
 	}
 
+	ctx->ssl = NULL;
 	ctx->conn = NULL;
 	ctx->bio = NULL;
 	ctx->xprt = NULL;
@@ -844,12 +1240,33 @@ int qc_alloc_ssl_sock_ctx(struct quic_conn *qc)
 
 		SSL_set_accept_state(ctx->ssl);
 	}
+	else {
+		struct server *srv = __objt_server(qc->conn->target);
+
+		if (qc_ssl_sess_init(qc, srv->ssl_ctx.ctx, &ctx->ssl) == -1)
+			goto err;
+
+		/* Required by the server side TLS callbacks. */
+		ctx->conn = qc->conn;
+		SSL_set_ex_data(ctx->ssl, ssl_app_data_index, qc->conn);
+		/* RFC 9001 8.4. Prohibit TLS Middlebox Compatibility Mode */
+		SSL_clear_options(ctx->ssl, SSL_OP_ENABLE_MIDDLEBOX_COMPAT);
+		SSL_set_connect_state(ctx->ssl);
+		qc_ssl_srv_reuse_sess(ctx->ssl, srv);
+	}
 
 	ctx->xprt = xprt_get(XPRT_QUIC);
 
 	/* Store the allocated context in <qc>. */
 	qc->xprt_ctx = ctx;
 
+	/* A client sends its transport parameters with its first flight. */
+	if (!qc_is_listener(qc) &&
+	    !qc_ssl_set_quic_transport_params(qc, qc->original_version, 0)) {
+		qc->xprt_ctx = NULL;
+		goto err;
+	}
+
 	/* global.sslconns is already incremented on INITIAL packet parsing. */
 	_HA_ATOMIC_INC(&global.totalsslconns);
 
@@ -859,6 +1276,8 @@ int qc_alloc_ssl_sock_ctx(struct quic_conn *qc)
 	return !ret;
 
  err:
+	if (ctx)
+		SSL_free(ctx->ssl);
 	pool_free(pool_head_quic_ssl_sock_ctx, ctx);
 	goto leave;
 }
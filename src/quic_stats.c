@@ -35,6 +35,8 @@ static struct stat_col quic_stats[] = {
 	                                  .desc = "Total number of handshake failures" },
 	[QUIC_ST_STATELESS_RESET_SENT] = { .name = "quic_stless_rst_sent",
 	                                  .desc = "Total number of stateless reset packet sent" },
+	[QUIC_ST_ZERO_RTT_REPLAYED]   = { .name = "quic_0rtt_replayed",
+	                                  .desc = "Total number of 0-RTT refused as possible replays" },
 	/* Special events of interest */
 	[QUIC_ST_CONN_MIGRATION_DONE] = { .name = "quic_conn_migration_done",
 	                                  .desc = "Total number of connection migration proceeded" },
@@ -147,6 +149,9 @@ static int quic_fill_stats(void *data, struct field *stats, unsigned int *select
 		case QUIC_ST_STATELESS_RESET_SENT:
 			metric = mkf_u64(FN_COUNTER, counters->stateless_reset_sent);
 			break;
+		case QUIC_ST_ZERO_RTT_REPLAYED:
+			metric = mkf_u64(FN_COUNTER, counters->zero_rtt_replayed);
+			break;
 
 		/* Special events of interest */
 		case QUIC_ST_CONN_MIGRATION_DONE:
@@ -247,7 +252,7 @@ struct stats_module quic_stats_module = {
 	.stats_count   = QUIC_STATS_COUNT,
 	.counters      = &quic_counters,
 	.counters_size = sizeof(quic_counters),
-	.domain_flags  = MK_STATS_PROXY_DOMAIN(STATS_PX_CAP_FE),
+	.domain_flags  = MK_STATS_PROXY_DOMAIN(STATS_PX_CAP_FE|STATS_PX_CAP_BE),
 	.clearable     = 1,
 };
 
@@ -614,6 +614,27 @@ int quic_tls_rx_ctx_init(QUIC_AEAD_CTX **rx_ctx,
 	return 0;
 }
 
+/* XOR <out> with the <outlen> first bytes of the header protection mask
+ * computed from <in> sample with <ctx> AES-ECB cipher context, without any
+ * context reinitialization.
+ * Return 1 if succeeded, 0 if not.
+ */
+static int quic_tls_hp_ecb(unsigned char *out, const unsigned char *in, size_t outlen,
+                           EVP_CIPHER_CTX *ctx)
+{
+	unsigned char mask[QUIC_TLS_HP_SAMPLE_LEN];
+	int i, ret;
+
+	if (outlen > sizeof(mask) ||
+	    !EVP_EncryptUpdate(ctx, mask, &ret, in, sizeof(mask)))
+		return 0;
+
+	for (i = 0; i < outlen; i++)
+		out[i] ^= mask[i];
+
+	return 1;
+}
+
 /* Initialize <*hp_ctx> cipher context with <key> as key for header protection encryption */
 int quic_tls_enc_hp_ctx_init(EVP_CIPHER_CTX **hp_ctx,
                               const EVP_CIPHER *hp, unsigned char *key)
@@ -632,7 +653,8 @@ int quic_tls_enc_hp_ctx_init(EVP_CIPHER_CTX **hp_ctx,
 	if (!ctx)
 		return 0;
 
-	if (!EVP_EncryptInit_ex(ctx, hp, NULL, key, NULL))
+	if (!EVP_EncryptInit_ex(ctx, hp, NULL, key, NULL) ||
+	    !EVP_CIPHER_CTX_set_padding(ctx, 0))
 		goto err;
 
 	*hp_ctx = ctx;
@@ -673,6 +695,9 @@ int quic_tls_hp_encrypt(unsigned char *out,
 
 #endif
 
+	if (EVP_CIPHER_CTX_mode(ctx) == EVP_CIPH_ECB_MODE)
+		return quic_tls_hp_ecb(out, in, inlen, ctx);
+
 	if (!EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, in) ||
 	    !EVP_EncryptUpdate(ctx, out, &ret, out, inlen) ||
 	    !EVP_EncryptFinal_ex(ctx, out, &ret))
@@ -699,7 +724,9 @@ int quic_tls_dec_hp_ctx_init(EVP_CIPHER_CTX **hp_ctx,
 	if (!ctx)
 		return 0;
 
-	if (!EVP_DecryptInit_ex(ctx, hp, NULL, key, NULL))
+	/* Header protection masks are always produced by encryption. */
+	if (!EVP_EncryptInit_ex(ctx, hp, NULL, key, NULL) ||
+	    !EVP_CIPHER_CTX_set_padding(ctx, 0))
 		goto err;
 
 	*hp_ctx = ctx;
@@ -740,14 +767,43 @@ int quic_tls_hp_decrypt(unsigned char *out,
 
 #endif
 
-	if (!EVP_DecryptInit_ex(ctx, NULL, NULL, NULL, in) ||
-	    !EVP_DecryptUpdate(ctx, out, &ret, out, inlen) ||
-	    !EVP_DecryptFinal_ex(ctx, out, &ret))
+	if (EVP_CIPHER_CTX_mode(ctx) == EVP_CIPH_ECB_MODE)
+		return quic_tls_hp_ecb(out, in, inlen, ctx);
+
+	if (!EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, in) ||
+	    !EVP_EncryptUpdate(ctx, out, &ret, out, inlen) ||
+	    !EVP_EncryptFinal_ex(ctx, out, &ret))
 		return 0;
 
 	return 1;
 }
 
+/* Compute into <masks> the header protection masks of <count> packets from
+ * their samples stored contiguously at <samples>, each mask being as long as a
+ * sample. <masks> and <samples> may point to the same buffer. This is only
+ * supported by AES-ECB <ctx> contexts which are processed at once, letting the
+ * cipher implementation interleave the blocks of several packets.
+ *
+ * Return 1 if succeeded, 0 if not, notably if <ctx> is not supported.
+ */
+int quic_tls_hp_masks(unsigned char *masks, const unsigned char *samples,
+                      int count, EVP_CIPHER_CTX *ctx)
+{
+	int ret;
+
+#ifdef QUIC_AEAD_API
+	if (ctx == EVP_CIPHER_CTX_CHACHA20)
+		return 0;
+#endif
+
+	if (EVP_CIPHER_CTX_mode(ctx) != EVP_CIPH_ECB_MODE)
+		return 0;
+
+	return EVP_EncryptUpdate(ctx, masks, &ret, samples,
+	                         count * QUIC_TLS_HP_SAMPLE_LEN) &&
+		ret == count * QUIC_TLS_HP_SAMPLE_LEN;
+}
+
 /* Initialize the cipher context for TX part of <tls_ctx> QUIC TLS context.
  * Return 1 if succeeded, 0 if not.
  */
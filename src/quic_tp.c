@@ -191,9 +191,11 @@ static int quic_transport_param_dec_version_info(struct tp_version_information *
 			return 0;
 	}
 
+	/* Server version information : compatible version negotiation is not
+	 * supported by clients which keep using their chosen version.
+	 */
 	if (server)
-		/* TODO: not supported */
-		return 0;
+		goto out;
 
 	for (ver = others; ver < end; ver += 4) {
 		if (!tp->negotiated_version) {
@@ -428,7 +430,11 @@ static int quic_transport_param_enc_version_info(unsigned char **buf,
 	uint64_t tp_len;
 	uint32_t ver;
 
-	tp_len = sizeof chosen_version->num + quic_versions_nb * sizeof(uint32_t);
+	/* Compatible version negotiation is not supported by clients which
+	 * only announce their chosen version.
+	 */
+	tp_len = sizeof chosen_version->num +
+		(server ? quic_versions_nb : 1) * sizeof(uint32_t);
 	if (!quic_transport_param_encode_type_len(buf, end,
 	                                          QUIC_TP_VERSION_INFORMATION,
 	                                          tp_len))
@@ -443,6 +449,9 @@ static int quic_transport_param_enc_version_info(unsigned char **buf,
 	*buf += sizeof ver;
 	/* For servers: all supported version, chosen included */
 	for (i = 0; i < quic_versions_nb; i++) {
+		if (!server && &quic_versions[i] != chosen_version)
+			continue;
+
 		ver = htonl(quic_versions[i].num);
 		memcpy(*buf, &ver, sizeof ver);
 		*buf += sizeof ver;
@@ -666,6 +675,20 @@ int quic_transport_params_store(struct quic_conn *qc, int server,
 		qc_kill_conn(qc);
 	}
 
+	/* A client must also check that the "original_destination_connection_id"
+	 * transport parameter matches the DCID of its first Initial packet.
+	 */
+	if (server) {
+		struct tp_cid *odcid = &tx_params->original_destination_connection_id;
+
+		if (qc->odcid.len != odcid->len ||
+		    (qc->odcid.len && memcmp(qc->odcid.data, odcid->data, qc->odcid.len))) {
+			TRACE_PROTO("original_destination_connection_id transport parameter mismatch",
+			            QUIC_EV_TRANSP_PARAMS, qc);
+			qc_kill_conn(qc);
+		}
+	}
+
 	return 1;
 }
 
@@ -35,8 +35,11 @@ static struct quic_tx_packet *qc_build_pkt(unsigned char **pos, const unsigned c
                                            struct list *frms, struct quic_conn *qc,
                                            const struct quic_version *ver, size_t dglen, int pkt_type,
                                            int must_ack, int padding, int probe, int cc,
+                                           struct quic_hp_batch *hpb,
                                            enum qc_build_pkt_err *err);
 
+static int quic_hp_batch_flush(struct quic_conn *qc, struct quic_hp_batch *hpb);
+
 static void quic_packet_encrypt(unsigned char *payload, size_t payload_len,
                                 unsigned char *aad, size_t aad_len, uint64_t pn,
                                 struct quic_tls_ctx *tls_ctx, struct quic_conn *qc,
@@ -267,7 +270,9 @@ static void qc_purge_tx_buf(struct quic_conn *qc, struct buffer *buf)
 	BUG_ON(b_data(buf));
 }
 
-/* Send datagrams stored in <buf>.
+/* Send datagrams stored in <buf>. If <pacing> is set to a QUIC_PACING_* mode,
+ * emitted datagrams are accounted on the path pacing schedule and stamped with
+ * their departure time for QUIC_PACING_TXTIME.
  *
  * This function returns 1 for success. On error, there is several behavior
  * depending on underlying sendto() error :
@@ -278,7 +283,7 @@ static void qc_purge_tx_buf(struct quic_conn *qc, struct buffer *buf)
  *   Remaining data are purged from the buffer and will eventually be detected
  *   as lost which gives the opportunity to retry sending.
  */
-static int qc_send_ppkts(struct buffer *buf, struct ssl_sock_ctx *ctx)
+static int qc_send_ppkts(struct buffer *buf, struct ssl_sock_ctx *ctx, int pacing)
 {
 	int ret = 0;
 	struct quic_conn *qc;
@@ -318,7 +323,14 @@ static int qc_send_ppkts(struct buffer *buf, struct ssl_sock_ctx *ctx)
 
 		TRACE_PROTO("TX dgram", QUIC_EV_CONN_SPPKTS, qc);
 		if (!skip_sendto) {
-			int ret = qc_snd_buf(qc, &tmpbuf, tmpbuf.data, 0, gso);
+			uint64_t now = pacing ? now_mono_time() : 0;
+			uint64_t txtime = 0;
+			int ret;
+
+			if (pacing == QUIC_PACING_TXTIME && now)
+				txtime = MAX(qc->path->pacing_next, now);
+
+			ret = qc_snd_buf(qc, &tmpbuf, tmpbuf.data, 0, gso, txtime);
 			if (ret < 0) {
 				if (gso && ret == -EIO) {
 					/* Disable permanently UDP GSO for this listener.
@@ -351,6 +363,8 @@ static int qc_send_ppkts(struct buffer *buf, struct ssl_sock_ctx *ctx)
 				qc->cntrs.sent_bytes += ret;
 				if (gso && ret > gso)
 					qc->cntrs.sent_bytes_gso += ret;
+				if (pacing)
+					quic_pacing_sent(qc->path, ret, now);
 			}
 		}
 
@@ -414,6 +428,8 @@ static int qc_send_ppkts(struct buffer *buf, struct ssl_sock_ctx *ctx)
 					qc->timer_task = NULL;
 				}
 			}
+			if (pkt->in_flight_len)
+				quic_cc_drs_on_pkt_sent(qc->path, pkt);
 			qc->path->in_flight += pkt->in_flight_len;
 			pkt->pktns->tx.in_flight += pkt->in_flight_len;
 			if ((global.tune.options & GTUNE_QUIC_CC_HYSTART) && pkt->pktns == qc->apktns)
@@ -451,7 +467,7 @@ int qc_purge_txbuf(struct quic_conn *qc, struct buffer *buf)
 	 */
 	BUG_ON(!qc_test_fd(qc));
 
-	if (b_data(buf) && !qc_send_ppkts(buf, qc->xprt_ctx)) {
+	if (b_data(buf) && !qc_send_ppkts(buf, qc->xprt_ctx, QUIC_PACING_OFF)) {
 		if (qc->flags & QUIC_FL_CONN_TO_KILL)
 			qc_txb_release(qc);
 		TRACE_DEVEL("leaving in error", QUIC_EV_CONN_TXPKT, qc);
@@ -495,6 +511,10 @@ int qc_send_mux(struct quic_conn *qc, struct list *frms)
 	ret = qc_send(qc, 0, &send_list);
 	qc->flags &= ~QUIC_FL_CONN_TX_MUX_CONTEXT;
 
+	/* All the MUX data were sent without filling the congestion window. */
+	if (ret && LIST_ISEMPTY(frms) && qc->path->in_flight < qc->path->cwnd)
+		quic_cc_drs_on_app_limited(qc->path);
+
 	TRACE_LEAVE(QUIC_EV_CONN_TXPKT, qc);
 	return ret;
 }
@@ -527,11 +547,14 @@ static inline void qc_select_tls_ver(struct quic_conn *qc,
  * Each datagram is prepended by a two fields header : the datagram length and
  * the address of first packet in the datagram.
  *
+ * If <max_dgrams> is not null, preparation is interrupted once this number of
+ * full datagrams has been built. This is used to limit the bursts when pacing.
+ *
  * Returns the number of bytes prepared in datragrams/packets if succeeded
  * (may be 0), or -1 if something wrong happened.
  */
 static int qc_prep_pkts(struct quic_conn *qc, struct buffer *buf,
-                         struct list *qels)
+                         struct list *qels, int max_dgrams)
 {
 	int ret, cc, padding;
 	struct quic_tx_packet *first_pkt, *prv_pkt;
@@ -541,6 +564,8 @@ static int qc_prep_pkts(struct quic_conn *qc, struct buffer *buf,
 	size_t total;
 	struct quic_enc_level *qel, *tmp_qel;
 	uchar gso_dgram_cnt = 0;
+	int dgram_cnt = 0;
+	struct quic_hp_batch hpb = { .count = 0 };
 
 	TRACE_ENTER(QUIC_EV_CONN_IO_CB, qc);
 	/* Currently qc_prep_pkts() does not handle buffer wrapping so the
@@ -614,8 +639,12 @@ static int qc_prep_pkts(struct quic_conn *qc, struct buffer *buf,
 			 * Similarly, a server MUST expand the payload of all UDP
 			 * datagrams carrying ack-eliciting Initial packets to at least the
 			 * smallest allowed maximum datagram size of 1200 bytes.
+			 *
+			 * This is also the case for all the datagrams carrying
+			 * Initial packets sent by a client.
 			 */
-			if (qel == qc->iel && (!LIST_ISEMPTY(frms) || probe)) {
+			if (qel == qc->iel &&
+			    (!LIST_ISEMPTY(frms) || probe || !qc_is_listener(qc))) {
 				 /* Ensure that no ack-eliciting packets are sent into too small datagrams */
 				if (end - pos < QUIC_INITIAL_PACKET_MINLEN) {
 					TRACE_PROTO("No more enough room to build an Initial packet",
@@ -631,11 +660,12 @@ static int qc_prep_pkts(struct quic_conn *qc, struct buffer *buf,
 			cur_pkt = qc_build_pkt(&pos, end, qel, tls_ctx, frms,
 			                       qc, ver, dglen, pkt_type,
 			                       must_ack, padding && !next_qel,
-			                       probe, cc, &err);
+			                       probe, cc, &hpb, &err);
 			if (!cur_pkt) {
 				switch (err) {
 				case QC_BUILD_PKT_ERR_ALLOC:
 					qc_purge_tx_buf(qc, buf);
+					hpb.count = 0;
 					break;
 
 				case QC_BUILD_PKT_ERR_ENCRYPT:
@@ -707,6 +737,8 @@ static int qc_prep_pkts(struct quic_conn *qc, struct buffer *buf,
 				prv_pkt = cur_pkt;
 			}
 			else if (!(global.tune.options & GTUNE_QUIC_NO_UDP_GSO) &&
+			         /* GSO support is only tracked for listeners */
+			         qc_is_listener(qc) &&
 			         !(HA_ATOMIC_LOAD(&qc->li->flags) & LI_F_UDP_GSO_NOTSUPP) &&
 			         dglen == qc->path->mtu &&
 			         (char *)end < b_wrap(buf) &&
@@ -734,6 +766,16 @@ static int qc_prep_pkts(struct quic_conn *qc, struct buffer *buf,
 				gso_dgram_cnt = 0;
 			}
 
+			/* Stop once the burst limit is reached. A datagram has
+			 * been completed above if frames are still to be sent.
+			 */
+			if (max_dgrams && !LIST_ISEMPTY(frms) && ++dgram_cnt >= max_dgrams) {
+				TRACE_PROTO("burst limit reached", QUIC_EV_CONN_PHPKTS, qc, qel);
+				if (first_pkt)
+					qc_txb_store(buf, wrlen, first_pkt);
+				goto out;
+			}
+
 			/* qc_do_build_pkt() is responsible to decrement probe
 			 * value. Required to break loop on qc_may_build_pkt().
 			 */
@@ -755,6 +797,11 @@ static int qc_prep_pkts(struct quic_conn *qc, struct buffer *buf,
 
 	ret = total;
  leave:
+	/* Datagrams are not emitted before all their packets are protected. */
+	if (hpb.count && !quic_hp_batch_flush(qc, &hpb)) {
+		qc_purge_tx_buf(qc, buf);
+		ret = -1;
+	}
 	TRACE_LEAVE(QUIC_EV_CONN_PHPKTS, qc);
 	return ret;
 }
@@ -770,6 +817,7 @@ int qc_send(struct quic_conn *qc, int old_data, struct list *send_list)
 {
 	struct quic_enc_level *qel, *tmp_qel;
 	int ret = 0, status = 0;
+	int pacing = QUIC_PACING_OFF, max_dgrams = 0;
 	struct buffer *buf;
 
 	TRACE_ENTER(QUIC_EV_CONN_TXPKT, qc);
@@ -790,6 +838,15 @@ int qc_send(struct quic_conn *qc, int old_data, struct list *send_list)
 		qc->flags |= QUIC_FL_CONN_RETRANS_OLD_DATA;
 	}
 
+	/* Only the application data emitted by the MUX are paced. Handshake,
+	 * probing and closing emissions are never delayed.
+	 */
+	if (global.tune.quic_pacing && (qc->flags & QUIC_FL_CONN_TX_MUX_CONTEXT) &&
+	    !(qc->flags & QUIC_FL_CONN_IMMEDIATE_CLOSE) && !old_data) {
+		pacing = global.tune.quic_pacing;
+		max_dgrams = global.tune.quic_pacing_burst;
+	}
+
 	/* Prepare and send packets until we could not further prepare packets.
 	 * Sending must be interrupted if a CONNECTION_CLOSE was already sent
 	 * previously and is currently not needed.
@@ -797,15 +854,28 @@ int qc_send(struct quic_conn *qc, int old_data, struct list *send_list)
 	while (!LIST_ISEMPTY(send_list) &&
 	       (!(qc->flags & (QUIC_FL_CONN_CLOSING|QUIC_FL_CONN_DRAINING)) ||
 	        (qc->flags & QUIC_FL_CONN_IMMEDIATE_CLOSE))) {
+		/* Wait for the next departure time when holding paced
+		 * emission. The MUX will be woken up by the pacing timer.
+		 */
+		if (pacing == QUIC_PACING_TIMER) {
+			uint64_t delay = quic_pacing_delay(qc->path, now_mono_time());
+
+			if (delay) {
+				TRACE_STATE("emission paced", QUIC_EV_CONN_TXPKT, qc);
+				qc_pacing_timer_arm(qc, delay);
+				break;
+			}
+		}
+
 		/* Buffer must always be empty before qc_prep_pkts() usage.
 		 * qc_send_ppkts() ensures it is cleared on success.
 		 */
 		BUG_ON_HOT(b_data(buf));
 		b_reset(buf);
 
-		ret = qc_prep_pkts(qc, buf, send_list);
+		ret = qc_prep_pkts(qc, buf, send_list, max_dgrams);
 
-		if (b_data(buf) && !qc_send_ppkts(buf, qc->xprt_ctx)) {
+		if (b_data(buf) && !qc_send_ppkts(buf, qc->xprt_ctx, pacing)) {
 			if (qc->flags & QUIC_FL_CONN_TO_KILL)
 				qc_txb_release(qc);
 			goto out;
@@ -903,7 +973,10 @@ int qc_dgrams_retransmit(struct quic_conn *qc)
 					hpktns->tx.pto_probe = 1;
 
 				qel_register_send(&send_list, qc->iel, &ifrms);
-				if (qc->hel)
+				/* A client may not have derived its Handshake
+				 * secrets for emission yet.
+				 */
+				if (qc->hel && quic_tls_has_tx_sec(qc->hel))
 					qel_register_send(&send_list, qc->hel, &hfrms);
 
 				sret = qc_send(qc, 1, &send_list);
@@ -1495,6 +1568,83 @@ void quic_apply_header_protection(struct quic_conn *qc, unsigned char *pos,
 	TRACE_LEAVE(QUIC_EV_CONN_TXPKT, qc);
 }
 
+/* Apply the header protection to all the packets pending in <hpb> batch for
+ * <qc> connection, computing all their masks at once.
+ *
+ * Returns 1 on success else 0.
+ */
+static int quic_hp_batch_flush(struct quic_conn *qc, struct quic_hp_batch *hpb)
+{
+	unsigned char *pos, *pn, *mask;
+	int i, j, ret = 0;
+
+	TRACE_ENTER(QUIC_EV_CONN_TXPKT, qc);
+
+	if (!quic_tls_hp_masks(hpb->masks, hpb->masks, hpb->count, hpb->tls_ctx->tx.hp_ctx)) {
+		TRACE_ERROR("could not apply header protection", QUIC_EV_CONN_TXPKT, qc);
+		goto out;
+	}
+
+	for (i = 0; i < hpb->count; i++) {
+		pos = hpb->pkts[i].first_byte;
+		pn = hpb->pkts[i].pn;
+		mask = &hpb->masks[i * QUIC_TLS_HP_SAMPLE_LEN];
+
+		*pos ^= mask[0] & (*pos & QUIC_PACKET_LONG_HEADER_BIT ? 0xf : 0x1f);
+		for (j = 0; j < hpb->pkts[i].pn_len; j++)
+			pn[j] ^= mask[j + 1];
+	}
+	ret = 1;
+
+ out:
+	hpb->count = 0;
+	TRACE_LEAVE(QUIC_EV_CONN_TXPKT, qc);
+	return ret;
+}
+
+/* Register the packet with <pos> as first byte address, <pn> as address of the
+ * Packet number field, <pnlen> being this field length, into <hpb> batch so
+ * that its header protection is applied with those of the next packets using
+ * <tls_ctx> keys. The protection is immediately applied when it cannot be
+ * batched. The batch is flushed first if it is full or if it contains packets
+ * protected with other keys. <fail> will be set to true if an error is
+ * detected.
+ */
+static void quic_hp_batch_add(struct quic_conn *qc, struct quic_hp_batch *hpb,
+                              unsigned char *pos, unsigned char *pn, size_t pnlen,
+                              struct quic_tls_ctx *tls_ctx, int *fail)
+{
+	EVP_CIPHER_CTX *hp_ctx = tls_ctx->tx.hp_ctx;
+
+	*fail = 0;
+
+#ifdef QUIC_AEAD_API
+	if (hp_ctx == EVP_CIPHER_CTX_CHACHA20)
+		goto no_batch;
+#endif
+	if (EVP_CIPHER_CTX_mode(hp_ctx) != EVP_CIPH_ECB_MODE)
+		goto no_batch;
+
+	if (hpb->count &&
+	    (hpb->tls_ctx != tls_ctx || hpb->count == QUIC_HP_BATCH_MAX) &&
+	    !quic_hp_batch_flush(qc, hpb)) {
+		*fail = 1;
+		return;
+	}
+
+	hpb->tls_ctx = tls_ctx;
+	hpb->pkts[hpb->count].first_byte = pos;
+	hpb->pkts[hpb->count].pn = pn;
+	hpb->pkts[hpb->count].pn_len = pnlen;
+	memcpy(&hpb->masks[hpb->count * QUIC_TLS_HP_SAMPLE_LEN],
+	       pn + QUIC_PACKET_PN_MAXLEN, QUIC_TLS_HP_SAMPLE_LEN);
+	hpb->count++;
+	return;
+
+ no_batch:
+	quic_apply_header_protection(qc, pos, pn, pnlen, tls_ctx, fail);
+}
+
 /* Prepare into <outlist> as most as possible ack-eliciting frame from their
  * <inlist> prebuilt frames for <qel> encryption level to be encoded in a buffer
  * with <room> as available room, and <*len> the packet Length field initialized
@@ -2129,6 +2279,7 @@ static struct quic_tx_packet *qc_build_pkt(unsigned char **pos,
                                            struct quic_conn *qc, const struct quic_version *ver,
                                            size_t dglen, int pkt_type, int must_ack,
                                            int padding, int probe, int cc,
+                                           struct quic_hp_batch *hpb,
                                            enum qc_build_pkt_err *err)
 {
 	/* The pointer to the packet number field. */
@@ -2177,7 +2328,7 @@ static struct quic_tx_packet *qc_build_pkt(unsigned char **pos,
 
 	last_byte += QUIC_TLS_TAG_LEN;
 	pkt->len += QUIC_TLS_TAG_LEN;
-	quic_apply_header_protection(qc, first_byte, buf_pn, pn_len, tls_ctx, &encrypt_failure);
+	quic_hp_batch_add(qc, hpb, first_byte, buf_pn, pn_len, tls_ctx, &encrypt_failure);
 	if (encrypt_failure) {
 		/* TODO Unrecoverable failure, unencrypted data should be returned to the caller. */
 		WARN_ON("quic_apply_header_protection failure");
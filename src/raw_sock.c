@@ -19,18 +19,280 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <netinet/tcp.h>
 
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <linux/errqueue.h>
+#include <linux/sockios.h>
+#endif
+
 #include <haproxy/api.h>
 #include <haproxy/buf.h>
+#include <haproxy/cfgparse.h>
 #include <haproxy/connection.h>
+#include <haproxy/dynbuf.h>
 #include <haproxy/errors.h>
 #include <haproxy/fd.h>
 #include <haproxy/global.h>
 #include <haproxy/pipe.h>
+#include <haproxy/pool.h>
 #include <haproxy/proxy.h>
+#include <haproxy/task.h>
 #include <haproxy/tools.h>
 
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY) && defined(SIOCOUTQ)
+#define RAW_SOCK_ZEROCOPY
+#endif
+
+#if defined(RAW_SOCK_ZEROCOPY)
+
+/* max number of buffers a connection may have pinned by zero-copy sends */
+#define RAW_SOCK_ZC_MAX_PINS     32
+
+/* max number of closed connections whose socket is kept open until the kernel
+ * releases the buffers they still have pinned. Each of them holds one FD.
+ */
+#define RAW_SOCK_ZC_MAX_ORPHANS  256
+
+/* interval between two checks of the orphaned sockets */
+#define RAW_SOCK_ZC_ORPHAN_CHECK 100
+
+/* max time an orphaned socket may wait for its buffers to be released, after
+ * which the connection is reset (ms).
+ */
+#define RAW_SOCK_ZC_ORPHAN_TIMEOUT 10000
+
+/* A buffer whose contents were passed to the kernel with MSG_ZEROCOPY, and
+ * which must not be modified nor released until the kernel reports that it
+ * doesn't use it anymore.
+ */
+struct raw_sock_zc_pin {
+	struct list list;     /* entry in the connection's pins list */
+	struct buffer buf;    /* the pinned buffer */
+	uint32_t id;          /* zero-copy send counter value for this buffer */
+};
+
+/* Per-connection zero-copy context, allocated on first use and attached as
+ * the transport layer's context. When the connection is closed while some
+ * buffers are still pinned, the context is orphaned: it then keeps its own
+ * duplicate of the socket in <fd> so that the completions can still be read.
+ */
+struct raw_sock_zc_ctx {
+	struct list pins;     /* pinned buffers, in sending order */
+	struct list list;     /* entry in the orphans list once orphaned */
+	uint32_t next_id;     /* counter value for the next zero-copy send */
+	uint nb_pins;         /* number of pinned buffers */
+	int disabled;         /* non-zero if zero-copy may not be used anymore */
+	int fd;               /* socket duplicate once orphaned, otherwise -1 */
+	int expire;           /* date at which an orphaned socket is reset */
+};
+
+/* minimum amount of data to send at once to use MSG_ZEROCOPY, 0=disabled */
+static uint raw_sock_zc_min = 0;
+
+static struct list raw_sock_zc_orphans = LIST_HEAD_INIT(raw_sock_zc_orphans);
+static uint raw_sock_zc_nb_orphans = 0;
+static struct task *raw_sock_zc_gc = NULL;
+__decl_thread(static HA_SPINLOCK_T raw_sock_zc_lock);
+
+DECLARE_STATIC_POOL(pool_head_raw_sock_zc_ctx, "raw_zc_ctx", sizeof(struct raw_sock_zc_ctx));
+DECLARE_STATIC_POOL(pool_head_raw_sock_zc_pin, "raw_zc_pin", sizeof(struct raw_sock_zc_pin));
+
+/* releases pinned buffer <pin> */
+static void raw_sock_zc_free_pin(struct raw_sock_zc_pin *pin)
+{
+	b_free(&pin->buf);
+	offer_buffers(NULL, 1);
+	pool_free(pool_head_raw_sock_zc_pin, pin);
+}
+
+/* releases all the buffers still pinned in <ctx>. This must only be called
+ * once the kernel is known not to reference them anymore.
+ */
+static void raw_sock_zc_free_pins(struct raw_sock_zc_ctx *ctx)
+{
+	struct raw_sock_zc_pin *pin, *back;
+
+	list_for_each_entry_safe(pin, back, &ctx->pins, list) {
+		LIST_DELETE(&pin->list);
+		raw_sock_zc_free_pin(pin);
+	}
+	ctx->nb_pins = 0;
+}
+
+/* Reads all zero-copy completion notifications from the error queue of socket
+ * <fd>, and releases the buffers of <ctx> they cover. The queue is always
+ * emptied, even once all buffers were released, since the notifications left
+ * there would otherwise keep reporting an error on the socket.
+ */
+static void raw_sock_zc_drain(int fd, struct raw_sock_zc_ctx *ctx)
+{
+	struct raw_sock_zc_pin *pin, *back;
+	struct sock_extended_err *serr;
+	struct cmsghdr *cm;
+	struct msghdr msg;
+	char control[128];
+
+	while (1) {
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		for (cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+			if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+			    !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+				continue;
+
+			serr = (struct sock_extended_err *)CMSG_DATA(cm);
+			if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+				continue;
+
+			/* the range [ee_info, ee_data] of sends is complete */
+			list_for_each_entry_safe(pin, back, &ctx->pins, list) {
+				if ((int32_t)(pin->id - serr->ee_info) < 0 ||
+				    (int32_t)(serr->ee_data - pin->id) < 0)
+					continue;
+				LIST_DELETE(&pin->list);
+				raw_sock_zc_free_pin(pin);
+				ctx->nb_pins--;
+			}
+		}
+	}
+
+	/* Nothing left in the socket's send queue means that all the data were
+	 * acknowledged and that the kernel dropped its references to them, even
+	 * if the last completions were not reported yet.
+	 */
+	if (ctx->nb_pins) {
+		int unsent;
+
+		if (ioctl(fd, SIOCOUTQ, &unsent) == 0 && unsent == 0)
+			raw_sock_zc_free_pins(ctx);
+	}
+}
+
+/* Called when an error is reported by the poller on the FD of connection
+ * <conn> which uses zero-copy sends. The kernel signals zero-copy completions
+ * through the socket's error queue, which pollers report as an error. The
+ * queue is drained, then if no real error is pending on the socket, the FD's
+ * error flag is cleared. Returns non-zero if the error was cleared.
+ */
+static int raw_sock_zc_clear_err(struct connection *conn, struct raw_sock_zc_ctx *ctx)
+{
+	socklen_t len = sizeof(int);
+	int err = 0;
+
+	raw_sock_zc_drain(conn->handle.fd, ctx);
+	if (getsockopt(conn->handle.fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+		return 0;
+
+	if (err) {
+		errno = err;
+		return 0;
+	}
+
+	_HA_ATOMIC_AND(&fdtab[conn->handle.fd].state, ~FD_POLL_ERR);
+	return 1;
+}
+
+/* Reads the completions pending on orphaned sockets, and closes those which
+ * do not have any pinned buffer anymore. The kernel releases its references
+ * once the data are acknowledged. Sockets which are still waiting for this
+ * after their deadline, typically because the peer doesn't read anymore, are
+ * reset, which makes the kernel purge the data and release the buffers.
+ */
+static struct task *raw_sock_zc_gc_task(struct task *t, void *context, unsigned int state)
+{
+	struct raw_sock_zc_ctx *ctx, *back;
+
+	HA_SPIN_LOCK(OTHER_LOCK, &raw_sock_zc_lock);
+	list_for_each_entry_safe(ctx, back, &raw_sock_zc_orphans, list) {
+		raw_sock_zc_drain(ctx->fd, ctx);
+		if (ctx->nb_pins) {
+			if (!tick_is_expired(ctx->expire, now_ms))
+				continue;
+			setsockopt(ctx->fd, SOL_SOCKET, SO_LINGER, &nolinger, sizeof(struct linger));
+			close(ctx->fd);
+			raw_sock_zc_free_pins(ctx);
+		}
+		else
+			close(ctx->fd);
+		LIST_DELETE(&ctx->list);
+		raw_sock_zc_nb_orphans--;
+		pool_free(pool_head_raw_sock_zc_ctx, ctx);
+	}
+	t->expire = LIST_ISEMPTY(&raw_sock_zc_orphans) ? TICK_ETERNITY : tick_add(now_ms, MS_TO_TICKS(RAW_SOCK_ZC_ORPHAN_CHECK));
+	HA_SPIN_UNLOCK(OTHER_LOCK, &raw_sock_zc_lock);
+	return t;
+}
+
+/* Releases the zero-copy context <ctx> of connection <conn>, whose socket is
+ * about to be closed. Once the socket is closed, the kernel doesn't report
+ * completions anymore, so if some buffers are still in use by the kernel,
+ * the socket is duplicated and the context orphaned until they are released,
+ * for at most RAW_SOCK_ZC_ORPHAN_TIMEOUT. The duplicate is shut down for
+ * writes so that the peer still sees the end of the data as it would after
+ * the close, unless the connection is meant to be reset on close (e.g.
+ * "option nolinger"), in which case this is done at once.
+ */
+static void raw_sock_zc_release(struct connection *conn, struct raw_sock_zc_ctx *ctx)
+{
+	int fd;
+
+	if (!ctx->nb_pins)
+		goto free_ctx;
+
+	fd = -1;
+	if (conn_ctrl_ready(conn)) {
+		raw_sock_zc_drain(conn->handle.fd, ctx);
+		if (!ctx->nb_pins)
+			goto free_ctx;
+		fd = dup(conn->handle.fd);
+	}
+
+	if (fd < 0) {
+		/* The buffers can neither be tracked nor released safely, so
+		 * they are leaked. This is not expected to happen since the
+		 * socket is still open here and the orphans are accounted in
+		 * maxsock.
+		 */
+		LIST_INIT(&ctx->pins);
+		ctx->nb_pins = 0;
+		goto free_ctx;
+	}
+
+	ctx->fd = fd;
+	if (fdtab[conn->handle.fd].state & FD_LINGER_RISK)
+		ctx->expire = now_ms;
+	else {
+		shutdown(fd, SHUT_WR);
+		ctx->expire = tick_add(now_ms, MS_TO_TICKS(RAW_SOCK_ZC_ORPHAN_TIMEOUT));
+	}
+
+	HA_SPIN_LOCK(OTHER_LOCK, &raw_sock_zc_lock);
+	LIST_APPEND(&raw_sock_zc_orphans, &ctx->list);
+	raw_sock_zc_nb_orphans++;
+	if (!tick_isset(raw_sock_zc_gc->expire)) {
+		raw_sock_zc_gc->expire = tick_add(now_ms, MS_TO_TICKS(RAW_SOCK_ZC_ORPHAN_CHECK));
+		task_queue(raw_sock_zc_gc);
+	}
+	HA_SPIN_UNLOCK(OTHER_LOCK, &raw_sock_zc_lock);
+	return;
+
+ free_ctx:
+	pool_free(pool_head_raw_sock_zc_ctx, ctx);
+}
+
+#endif /* RAW_SOCK_ZEROCOPY */
+
 
 #if defined(USE_LINUX_SPLICE)
 
@@ -66,6 +328,12 @@ int raw_sock_to_pipe(struct connection *conn, void *xprt_ctx, struct pipe *pipe,
 	conn->flags &= ~CO_FL_WAIT_ROOM;
 	errno = 0;
 
+#if defined(RAW_SOCK_ZEROCOPY)
+	/* zero-copy completions are reported as errors, and must be consumed */
+	if (unlikely(xprt_ctx && (fdtab[conn->handle.fd].state & FD_POLL_ERR)))
+		raw_sock_zc_clear_err(conn, xprt_ctx);
+#endif
+
 	/* Under Linux, if FD_POLL_HUP is set, we have reached the end.
 	 * Since older splice() implementations were buggy and returned
 	 * EAGAIN on end of read, let's bypass the call to splice() now.
@@ -327,29 +595,22 @@ static size_t raw_sock_to_buf(struct connection *conn, void *xprt_ctx, struct bu
 	 * of recv()'s return value 0, so we have no way to tell there was
 	 * an error without checking.
 	 */
-	if (unlikely(!done && fdtab[conn->handle.fd].state & FD_POLL_ERR))
+	if (unlikely(!done && fdtab[conn->handle.fd].state & FD_POLL_ERR)
+#if defined(RAW_SOCK_ZEROCOPY)
+	    && !(xprt_ctx && raw_sock_zc_clear_err(conn, xprt_ctx))
+#endif
+	    )
 		conn->flags |= CO_FL_ERROR | CO_FL_SOCK_RD_SH | CO_FL_SOCK_WR_SH;
 	goto leave;
 }
 
 
-/* Send up to <count> pending bytes from buffer <buf> to connection <conn>'s
- * socket. <flags> may contain some CO_SFL_* flags to hint the system about
- * other pending data for example, but this flag is ignored at the moment.
- * Only one call to send() is performed, unless the buffer wraps, in which case
- * a second call may be performed. The connection's flags are updated with
- * whatever special event is detected (error, empty). The caller is responsible
- * for taking care of those events and avoiding the call if inappropriate. The
- * function does not call the connection's polling update function, so the caller
- * is responsible for this. It's up to the caller to update the buffer's contents
- * based on the return value.
+/* Checks that connection <conn> may be used to send data. Returns non-zero if
+ * so, otherwise zero, possibly with CO_FL_ERROR set on the connection and
+ * errno set to EPIPE if the socket cannot be used anymore.
  */
-static size_t raw_sock_from_buf(struct connection *conn, void *xprt_ctx, const struct buffer *buf, size_t count, int flags)
+static inline int raw_sock_snd_ready(struct connection *conn, void *xprt_ctx)
 {
-	ssize_t ret;
-	size_t try, done;
-	int send_flag;
-
 	if (!conn_ctrl_ready(conn))
 		return 0;
 
@@ -358,7 +619,11 @@ static size_t raw_sock_from_buf(struct connection *conn, void *xprt_ctx, const s
 	if (!fd_send_ready(conn->handle.fd))
 		return 0;
 
-	if (unlikely(fdtab[conn->handle.fd].state & FD_POLL_ERR)) {
+	if (unlikely(fdtab[conn->handle.fd].state & FD_POLL_ERR)
+#if defined(RAW_SOCK_ZEROCOPY)
+	    && !(xprt_ctx && raw_sock_zc_clear_err(conn, xprt_ctx))
+#endif
+	    ) {
 		/* an error was reported on the FD, we can't send anymore */
 		conn->flags |= CO_FL_ERROR | CO_FL_SOCK_WR_SH | CO_FL_SOCK_RD_SH;
 		errno = EPIPE;
@@ -371,55 +636,236 @@ static size_t raw_sock_from_buf(struct connection *conn, void *xprt_ctx, const s
 		errno = EPIPE;
 		return 0;
 	}
+	return 1;
+}
 
-	done = 0;
-	/* send the largest possible block. For this we perform only one call
-	 * to send() unless the buffer wraps and we exactly fill the first hunk,
-	 * in which case we accept to do it once again.
-	 */
-	while (count) {
-		try = b_contig_data(buf, done);
-		if (try > count)
-			try = count;
+/* Sends <count> bytes spread over the <iovcnt> blocks of <iov> using a single
+ * sendmsg() call, and updates the FD's polling status accordingly. Returns the
+ * number of bytes sent. <count> must be the sum of the blocks' lengths, and
+ * <send_flag> may contain extra MSG_* flags to pass to sendmsg(). With
+ * MSG_ZEROCOPY, ENOBUFS is not an error: zero is returned with errno set.
+ */
+static size_t raw_sock_send_iov(struct connection *conn, const struct iovec *iov, int iovcnt, size_t count, int flags, int send_flag)
+{
+	struct msghdr msg = { };
+	ssize_t ret;
 
-		send_flag = MSG_DONTWAIT | MSG_NOSIGNAL;
-		if (try < count || flags & CO_SFL_MSG_MORE)
-			send_flag |= MSG_MORE;
+	msg.msg_iov = (struct iovec *)iov;
+	msg.msg_iovlen = iovcnt;
 
-		ret = send(conn->handle.fd, b_peek(buf, done), try, send_flag);
+	send_flag |= MSG_DONTWAIT | MSG_NOSIGNAL;
+	if (flags & CO_SFL_MSG_MORE)
+		send_flag |= MSG_MORE;
 
-		if (ret > 0) {
-			count -= ret;
-			done += ret;
+	do {
+		ret = sendmsg(conn->handle.fd, &msg, send_flag);
+	} while (ret < 0 && errno == EINTR);
 
-			/* if the system buffer is full, don't insist */
-			if (ret < try) {
-				fd_cant_send(conn->handle.fd);
-				break;
-			}
-			if (!count)
-				fd_stop_send(conn->handle.fd);
-		}
-		else if (ret == 0 || errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOTCONN || errno == EINPROGRESS) {
-			/* nothing written, we need to poll for write first */
+	if (ret > 0) {
+		/* if the system buffer is full, don't insist */
+		if (ret < count)
 			fd_cant_send(conn->handle.fd);
-			break;
-		}
-		else if (errno != EINTR) {
-			conn->flags |= CO_FL_ERROR | CO_FL_SOCK_RD_SH | CO_FL_SOCK_WR_SH;
-			break;
-		}
+		else
+			fd_stop_send(conn->handle.fd);
 	}
-	if (unlikely(conn->flags & CO_FL_WAIT_L4_CONN) && done) {
+	else if (ret == 0 || errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOTCONN || errno == EINPROGRESS) {
+		/* nothing written, we need to poll for write first */
+		fd_cant_send(conn->handle.fd);
+		ret = 0;
+	}
+	else if (errno == ENOBUFS && (send_flag & MSG_ZEROCOPY)) {
+		/* the kernel refuses to pin more pages (optmem or locked
+		 * memory limits), the caller has to retry with a copy.
+		 */
+		ret = 0;
+	}
+	else {
+		conn->flags |= CO_FL_ERROR | CO_FL_SOCK_RD_SH | CO_FL_SOCK_WR_SH;
+		ret = 0;
+	}
+
+	if (unlikely(conn->flags & CO_FL_WAIT_L4_CONN) && ret)
 		conn->flags &= ~CO_FL_WAIT_L4_CONN;
+
+	if (ret > 0)
+		increment_send_rate(ret, 0);
+
+	return ret;
+}
+
+/* Fills <iov> with the one or two blocks holding the first <count> bytes of
+ * buffer <buf>, and returns the number of blocks.
+ */
+static inline int raw_sock_buf_iov(const struct buffer *buf, size_t count, struct iovec *iov)
+{
+	const char *blk1, *blk2;
+	size_t len1, len2;
+	int iovcnt;
+
+	iovcnt = b_getblk_nc(buf, &blk1, &len1, &blk2, &len2, 0, count);
+	iov[0].iov_base = (void *)blk1;
+	iov[0].iov_len  = len1;
+	if (iovcnt > 1) {
+		iov[1].iov_base = (void *)blk2;
+		iov[1].iov_len  = len2;
 	}
+	return iovcnt;
+}
+
+/* Send up to <count> pending bytes from buffer <buf> to connection <conn>'s
+ * socket. <flags> may contain some CO_SFL_* flags to hint the system about
+ * other pending data for example, but this flag is ignored at the moment.
+ * Only one call to sendmsg() is performed, covering both parts of the buffer
+ * when it wraps. The connection's flags are updated with
+ * whatever special event is detected (error, empty). The caller is responsible
+ * for taking care of those events and avoiding the call if inappropriate. The
+ * function does not call the connection's polling update function, so the caller
+ * is responsible for this. It's up to the caller to update the buffer's contents
+ * based on the return value.
+ */
+static size_t raw_sock_from_buf(struct connection *conn, void *xprt_ctx, const struct buffer *buf, size_t count, int flags)
+{
+	struct iovec iov[2];
+	int iovcnt;
+
+	if (!raw_sock_snd_ready(conn, xprt_ctx))
+		return 0;
 
-	if (done > 0)
-		increment_send_rate(done, 0);
+	if (!count)
+		return 0;
 
-	return done;
+	/* send the largest possible block at once, even if the buffer wraps */
+	iovcnt = raw_sock_buf_iov(buf, count, iov);
+	return raw_sock_send_iov(conn, iov, iovcnt, count, flags, 0);
 }
 
+/* Send the <iovcnt> blocks described by <iov> to connection <conn>'s socket
+ * using a single sendmsg() call. This allows upper layers to emit data spread
+ * over multiple buffers without first having to copy them. It has the same
+ * constraints as raw_sock_from_buf() and returns the number of bytes sent,
+ * which may be lower than the blocks' total length when the system buffers
+ * are full. It's up to the caller to consume the data that were sent.
+ */
+static size_t raw_sock_from_iov(struct connection *conn, void *xprt_ctx, const struct iovec *iov, int iovcnt, int flags)
+{
+	size_t count = 0;
+	int i;
+
+	if (!raw_sock_snd_ready(conn, xprt_ctx))
+		return 0;
+
+	for (i = 0; i < iovcnt; i++)
+		count += iov[i].iov_len;
+
+	if (!count)
+		return 0;
+
+	return raw_sock_send_iov(conn, iov, iovcnt, count, flags, 0);
+}
+
+#if defined(RAW_SOCK_ZEROCOPY)
+/* Send up to <count> pending bytes from buffer <buf> to connection <conn>'s
+ * socket like raw_sock_from_buf(), except that large sends avoid the copy to
+ * the kernel by using MSG_ZEROCOPY. Since the kernel then keeps references to
+ * the data until they are acknowledged, the sent data are consumed from <buf>
+ * by this function, which may also replace <buf>'s storage with a new buffer
+ * holding the unsent data. The previous storage is then released once the
+ * kernel reports it's not used anymore. Sends smaller than the configured
+ * threshold or for which no buffer is available use regular sends.
+ */
+static size_t raw_sock_from_buf_zc(struct connection *conn, void *xprt_ctx, struct buffer *buf, size_t count, int flags)
+{
+	struct raw_sock_zc_ctx *ctx = xprt_ctx;
+	struct raw_sock_zc_pin *pin = NULL;
+	struct buffer spare = BUF_NULL;
+	struct iovec iov[2];
+	size_t ret;
+	int iovcnt, one = 1;
+
+	if (!raw_sock_zc_min || count < raw_sock_zc_min || count != b_data(buf) ||
+	    (ctx && ctx->disabled) || conn->xprt_ctx != xprt_ctx)
+		goto no_zc;
+
+	/* too many closed connections are already waiting for their buffers
+	 * to be released, don't pin new ones.
+	 */
+	if (HA_ATOMIC_LOAD(&raw_sock_zc_nb_orphans) >= RAW_SOCK_ZC_MAX_ORPHANS)
+		goto no_zc;
+
+	if (!ctx) {
+		/* first zero-copy send on this connection */
+		ctx = pool_alloc(pool_head_raw_sock_zc_ctx);
+		if (!ctx)
+			goto no_zc;
+		LIST_INIT(&ctx->pins);
+		ctx->next_id = 0;
+		ctx->nb_pins = 0;
+		ctx->disabled = 0;
+		ctx->fd = -1;
+		conn->xprt_ctx = xprt_ctx = ctx;
+		if (!conn_ctrl_ready(conn) ||
+		    setsockopt(conn->handle.fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) < 0) {
+			ctx->disabled = 1;
+			goto no_zc;
+		}
+	}
+
+	if (!raw_sock_snd_ready(conn, xprt_ctx))
+		return 0;
+
+	if (ctx->nb_pins >= RAW_SOCK_ZC_MAX_PINS)
+		raw_sock_zc_drain(conn->handle.fd, ctx);
+
+	if (ctx->nb_pins >= RAW_SOCK_ZC_MAX_PINS)
+		goto no_zc;
+
+	pin = pool_alloc(pool_head_raw_sock_zc_pin);
+	if (!pin || !b_alloc(&spare, DB_MUX_TX))
+		goto fail;
+
+	iovcnt = raw_sock_buf_iov(buf, count, iov);
+	ret = raw_sock_send_iov(conn, iov, iovcnt, count, flags, MSG_ZEROCOPY);
+	if (!ret) {
+		if (errno != ENOBUFS || (conn->flags & CO_FL_ERROR))
+			goto fail;
+		/* the kernel cannot pin the data, stop using zero-copy on
+		 * this connection and send them the regular way.
+		 */
+		ctx->disabled = 1;
+		b_free(&spare);
+		offer_buffers(NULL, 1);
+		pool_free(pool_head_raw_sock_zc_pin, pin);
+		goto no_zc;
+	}
+
+	/* the kernel now references the buffer, which is replaced with the
+	 * spare one, only receiving what could not be sent.
+	 */
+	pin->buf = *buf;
+	pin->id = ctx->next_id++;
+	LIST_APPEND(&ctx->pins, &pin->list);
+	ctx->nb_pins++;
+
+	b_del(&pin->buf, ret);
+	b_ncat(&spare, &pin->buf, b_data(&pin->buf));
+	*buf = spare;
+	return ret;
+
+ fail:
+	if (b_size(&spare)) {
+		b_free(&spare);
+		offer_buffers(NULL, 1);
+	}
+	pool_free(pool_head_raw_sock_zc_pin, pin);
+	return 0;
+
+ no_zc:
+	ret = raw_sock_from_buf(conn, xprt_ctx, buf, count, flags);
+	b_del(buf, ret);
+	return ret;
+}
+#endif
+
 /* Called from the upper layer, to subscribe <es> to events <event_type>. The
  * event subscriber <es> is not allowed to change from a previous call as long
  * as at least one event is still subscribed. The <event_type> must only be a
@@ -444,6 +890,10 @@ static void raw_sock_close(struct connection *conn, void *xprt_ctx)
 	if (conn->subs != NULL) {
 		conn_unsubscribe(conn, NULL, conn->subs->events, conn->subs);
 	}
+#if defined(RAW_SOCK_ZEROCOPY)
+	if (xprt_ctx)
+		raw_sock_zc_release(conn, xprt_ctx);
+#endif
 }
 
 /* We can't have an underlying XPRT, so just return -1 to signify failure */
@@ -459,6 +909,10 @@ static int raw_sock_remove_xprt(struct connection *conn, void *xprt_ctx, void *t
 /* transport-layer operations for RAW sockets */
 static struct xprt_ops raw_sock = {
 	.snd_buf  = raw_sock_from_buf,
+	.snd_iov  = raw_sock_from_iov,
+#if defined(RAW_SOCK_ZEROCOPY)
+	.snd_buf_zc = raw_sock_from_buf_zc,
+#endif
 	.rcv_buf  = raw_sock_to_buf,
 	.subscribe = raw_sock_subscribe,
 	.unsubscribe = raw_sock_unsubscribe,
@@ -481,6 +935,62 @@ static void __raw_sock_init(void)
 
 INITCALL0(STG_REGISTER, __raw_sock_init);
 
+/* config parser for global "tune.zerocopy-send" */
+static int raw_sock_parse_zerocopy_send(char **args, int section_type, struct proxy *curpx,
+                                        const struct proxy *defpx, const char *file, int line,
+                                        char **err)
+{
+#if defined(RAW_SOCK_ZEROCOPY)
+	const char *res;
+	uint size;
+
+	if (too_many_args(1, args, err, NULL))
+		return -1;
+
+	res = parse_size_err(args[1], &size);
+	if (res != NULL) {
+		memprintf(err, "unexpected '%s' after size passed to '%s'", res, args[0]);
+		return -1;
+	}
+
+	raw_sock_zc_min = size;
+	return 0;
+#else
+	memprintf(err, "'%s' is not supported on this platform.", args[0]);
+	return -1;
+#endif
+}
+
+#if defined(RAW_SOCK_ZEROCOPY)
+/* creates the task releasing orphaned zero-copy buffers when needed, and
+ * reserves the FDs of the orphaned sockets.
+ */
+static int raw_sock_zc_init(void)
+{
+	if (!raw_sock_zc_min)
+		return ERR_NONE;
+
+	global.maxsock += RAW_SOCK_ZC_MAX_ORPHANS;
+
+	raw_sock_zc_gc = task_new_anywhere();
+	if (!raw_sock_zc_gc) {
+		ha_alert("Failed to allocate the zero-copy release task.\n");
+		return ERR_ALERT | ERR_FATAL;
+	}
+	raw_sock_zc_gc->process = raw_sock_zc_gc_task;
+	return ERR_NONE;
+}
+
+REGISTER_POST_CHECK(raw_sock_zc_init);
+#endif
+
+static struct cfg_kw_list cfg_kws = {ILH, {
+	{ CFG_GLOBAL, "tune.zerocopy-send", raw_sock_parse_zerocopy_send },
+	{ 0, NULL, NULL }
+}};
+
+INITCALL1(STG_REGISTER, cfg_register_keywords, &cfg_kws);
+
 /*
  * Local variables:
  *  c-indent-level: 8
@@ -2648,7 +2648,7 @@ void srv_set_ssl(struct server *s, int use_ssl)
 
 	s->use_ssl = use_ssl;
 	if (s->use_ssl)
-		s->xprt = xprt_get(XPRT_SSL);
+		s->xprt = srv_is_quic(s) ? xprt_get(XPRT_QUIC) : xprt_get(XPRT_SSL);
 	else
 		s->xprt = xprt_get(XPRT_RAW);
 }
@@ -3594,6 +3594,39 @@ static int _srv_parse_finalize(char **args, int cur_arg,
 		return ret;
 	}
 
+#ifdef USE_QUIC
+	if (srv_is_quic(srv)) {
+		/* QUIC cannot work without TLS : enable it implicitly */
+		if (srv->use_ssl != 1) {
+			ha_warning("QUIC server '%s' : enabling 'ssl' which is mandatory for QUIC.\n",
+			           srv->id);
+			srv->use_ssl = 1;
+		}
+
+		/* HTTP/3 is the only application protocol supported over QUIC
+		 * on the server side.
+		 */
+		if (!srv->ssl_ctx.alpn_str) {
+			srv->ssl_ctx.alpn_str = strdup("\002h3");
+			if (!srv->ssl_ctx.alpn_str) {
+				ha_alert("out of memory\n");
+				return ERR_ALERT | ERR_FATAL;
+			}
+			srv->ssl_ctx.alpn_len = 3;
+		}
+
+		if (!srv->mux_proto)
+			srv->mux_proto = get_mux_proto(ist("quic"));
+
+		/* early data are not supported on the client side of QUIC */
+		if (srv->ssl_ctx.options & SRV_SSL_O_EARLY_DATA) {
+			ha_warning("QUIC server '%s' : ignoring 'allow-0rtt' which is not supported for QUIC.\n",
+			           srv->id);
+			srv->ssl_ctx.options &= ~SRV_SSL_O_EARLY_DATA;
+		}
+	}
+#endif
+
 	/* Use sni as fallback if pool_conn_name isn't set */
 	if (!srv->pool_conn_name && srv->sni_expr) {
 		srv->pool_conn_name = strdup(srv->sni_expr);
@@ -5287,6 +5320,11 @@ static int cli_parse_set_server(char **args, char *payload, struct appctx *appct
 			goto out;
 		}
 
+		if (srv_is_quic(sv)) {
+			cli_err(appctx, "'set server <srv> ssl' not supported on QUIC servers\n");
+			goto out;
+		}
+
 		if (sv->ssl_ctx.ctx == NULL) {
 			cli_err(appctx, "'set server <srv> ssl' cannot be set. "
 					" default-server should define ssl settings\n");
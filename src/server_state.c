@@ -445,7 +445,7 @@ static void srv_state_srv_update(struct server *srv, int version, char **params)
 		use_ssl = strtol(params[16], &p, 10);
 
 		/* configure ssl if connection has been initiated at startup */
-		if (srv->ssl_ctx.ctx != NULL)
+		if (srv->ssl_ctx.ctx != NULL && !srv_is_quic(srv))
 			srv_set_ssl(srv, use_ssl);
 #endif
 	}
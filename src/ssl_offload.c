@@ -0,0 +1,596 @@
+/*
+ * Private key operations offloading to a pool of crypto threads.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ *
+ * Full TLS handshakes are dominated by the server's private key operation
+ * (RSA decryption/signature or ECDSA signature). Instead of performing it on
+ * the thread owning the connection, the key is wrapped into an RSA_METHOD or
+ * EC_KEY_METHOD whose private operations, when called from within an OpenSSL
+ * async job (SSL_MODE_ASYNC), are queued to a pool of dedicated threads while
+ * the job is paused. The job registers an eventfd in its wait context, which
+ * is then handled by the regular async fd machinery in ssl_sock.c: the crypto
+ * thread signals it once done, which wakes the connection's tasklet up, and
+ * the handshake resumes with the result.
+ *
+ * All the data the crypto threads touch are owned by a refcounted slot which
+ * is attached to the job's wait context, so that a connection closed while
+ * its operation is still pending never leaves a dangling reference behind.
+ */
+
+/* the legacy key methods are deprecated in OpenSSL 3.0 but are the only
+ * portable way to intercept private key operations.
+ */
+#define OPENSSL_SUPPRESS_DEPRECATED
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <haproxy/api.h>
+#include <haproxy/applet.h>
+#include <haproxy/cfgparse.h>
+#include <haproxy/cli.h>
+#include <haproxy/errors.h>
+#include <haproxy/global.h>
+#include <haproxy/openssl-compat.h>
+#include <haproxy/ssl_offload.h>
+#include <haproxy/ssl_sock.h>
+#include <haproxy/thread.h>
+#include <haproxy/tools.h>
+
+#ifdef HAVE_SSL_OFFLOAD
+
+#include <sys/eventfd.h>
+
+/* largest RSA modulus handled by the crypto threads (16384 bits) */
+#define SSL_OFFLOAD_MAXLEN 2048
+
+/* type of private key operation */
+enum ssl_offload_op {
+	SSL_OFFLOAD_RSA_ENC = 0,   /* RSA private encryption (signature) */
+	SSL_OFFLOAD_RSA_DEC,       /* RSA private decryption (key exchange) */
+	SSL_OFFLOAD_ECDSA,         /* ECDSA signature */
+};
+
+/* One slot per async wait context, reused for all the operations of the same
+ * SSL session. It is referenced by the wait context and by the crypto thread
+ * while an operation is pending, the last one to release it frees it.
+ */
+struct ssl_offload_slot {
+	struct ssl_offload_slot *next;  /* next pending slot in the queue */
+	int fd;                         /* eventfd signaled upon completion */
+	uint refcount;                  /* wait ctx + pending operation */
+	uint done;                      /* set by the crypto thread once done */
+	enum ssl_offload_op op;         /* operation to perform */
+	int padding;                    /* RSA padding */
+	int len;                        /* input length */
+	int ret;                        /* RSA result */
+	void *key;                      /* referenced RSA or EC_KEY */
+	ECDSA_SIG *sig;                 /* ECDSA result */
+	unsigned char in[SSL_OFFLOAD_MAXLEN];
+	unsigned char out[SSL_OFFLOAD_MAXLEN];
+};
+
+int ssl_offload_nbthread = 0;              /* number of crypto threads, 0=off */
+static uint ssl_offload_maxqueue = 0;      /* max pending ops, 0=unlimited */
+
+static RSA_METHOD *ssl_offload_rsa_meth = NULL;
+static EC_KEY_METHOD *ssl_offload_ec_meth = NULL;
+
+/* default implementations called by the crypto threads */
+static int (*ssl_offload_rsa_priv_enc)(int, const unsigned char *, unsigned char *, RSA *, int);
+static int (*ssl_offload_rsa_priv_dec)(int, const unsigned char *, unsigned char *, RSA *, int);
+static ECDSA_SIG *(*ssl_offload_ecdsa_sign_sig)(const unsigned char *, int, const BIGNUM *, const BIGNUM *, EC_KEY *);
+
+/* the pending operations queue and the crypto threads */
+static pthread_mutex_t ssl_offload_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ssl_offload_cond = PTHREAD_COND_INITIALIZER;
+static struct ssl_offload_slot *ssl_offload_head = NULL;
+static struct ssl_offload_slot *ssl_offload_tail = NULL;
+static pthread_t *ssl_offload_threads = NULL;
+static int ssl_offload_started = 0;
+static int ssl_offload_stopping = 0;
+
+/* statistics reported by "show ssl offload" */
+static uint ssl_offload_queued;            /* current queue depth */
+static uint ssl_offload_queued_max;        /* highest queue depth seen */
+static ullong ssl_offload_submitted;       /* operations sent to the pool */
+static ullong ssl_offload_completed;       /* operations completed by the pool */
+static ullong ssl_offload_inline;          /* operations performed inline */
+
+/* unique key identifying our fd in the async wait contexts */
+static const char ssl_offload_wait_key = 0;
+
+/* Releases a reference to slot <slot>, closing its fd and freeing it when it
+ * was the last one.
+ */
+static void ssl_offload_slot_release(struct ssl_offload_slot *slot)
+{
+	if (HA_ATOMIC_SUB_FETCH(&slot->refcount, 1))
+		return;
+
+	close(slot->fd);
+	ECDSA_SIG_free(slot->sig);
+	free(slot);
+}
+
+/* async wait context cleanup callback, called when the SSL session is freed */
+static void ssl_offload_wait_cleanup(ASYNC_WAIT_CTX *wctx, const void *key, OSSL_ASYNC_FD fd, void *custom)
+{
+	ssl_offload_slot_release(custom);
+}
+
+/* Performs the operation of slot <slot> using the default implementations.
+ * Runs in a crypto thread.
+ */
+static void ssl_offload_run(struct ssl_offload_slot *slot)
+{
+	switch (slot->op) {
+	case SSL_OFFLOAD_RSA_ENC:
+		slot->ret = ssl_offload_rsa_priv_enc(slot->len, slot->in, slot->out, slot->key, slot->padding);
+		RSA_free(slot->key);
+		break;
+	case SSL_OFFLOAD_RSA_DEC:
+		slot->ret = ssl_offload_rsa_priv_dec(slot->len, slot->in, slot->out, slot->key, slot->padding);
+		RSA_free(slot->key);
+		break;
+	case SSL_OFFLOAD_ECDSA:
+		slot->sig = ssl_offload_ecdsa_sign_sig(slot->in, slot->len, NULL, NULL, slot->key);
+		EC_KEY_free(slot->key);
+		break;
+	}
+	slot->key = NULL;
+	/* errors are reported in the crypto thread's error queue which is of
+	 * no use to anyone.
+	 */
+	ERR_clear_error();
+}
+
+/* crypto thread main loop */
+static void *ssl_offload_thread(void *arg)
+{
+	struct ssl_offload_slot *slot;
+	uint64_t one = 1;
+
+	pthread_mutex_lock(&ssl_offload_lock);
+	while (1) {
+		while (!ssl_offload_head && !ssl_offload_stopping)
+			pthread_cond_wait(&ssl_offload_cond, &ssl_offload_lock);
+
+		if (ssl_offload_stopping)
+			break;
+
+		slot = ssl_offload_head;
+		ssl_offload_head = slot->next;
+		if (!ssl_offload_head)
+			ssl_offload_tail = NULL;
+		pthread_mutex_unlock(&ssl_offload_lock);
+
+		HA_ATOMIC_DEC(&ssl_offload_queued);
+		ssl_offload_run(slot);
+		HA_ATOMIC_INC(&ssl_offload_completed);
+
+		/* the fd is signaled before marking the slot done so that the
+		 * job may never complete without its fd being readable, then
+		 * the slot is released since the job may vanish at any time.
+		 */
+		if (write(slot->fd, &one, sizeof(one)) < 0) {
+			/* cannot fail on a valid eventfd */
+		}
+		HA_ATOMIC_STORE(&slot->done, 1);
+		ssl_offload_slot_release(slot);
+
+		pthread_mutex_lock(&ssl_offload_lock);
+	}
+	pthread_mutex_unlock(&ssl_offload_lock);
+	return NULL;
+}
+
+/* Tries to queue private key operation <op> to the crypto threads from within
+ * the current async job, and pauses the job until it's completed. On success
+ * the slot holding the result is returned. NULL is returned if the operation
+ * must be performed inline by the caller (no job, pool disabled or full, or
+ * lack of resources). <in> of length <len> is copied, and <key> is referenced
+ * for the duration of the operation, so that the job may safely be destroyed
+ * while the operation is pending.
+ */
+static struct ssl_offload_slot *ssl_offload_submit(enum ssl_offload_op op, const unsigned char *in, int len,
+                                                   void *key, int padding)
+{
+	struct ssl_offload_slot *slot;
+	ASYNC_WAIT_CTX *wctx;
+	ASYNC_JOB *job;
+	OSSL_ASYNC_FD fd;
+	void *custom;
+	uint64_t val;
+	uint queued;
+
+	if (!ssl_offload_started || len < 0 || len > SSL_OFFLOAD_MAXLEN)
+		goto run_inline;
+
+	job = ASYNC_get_current_job();
+	if (!job)
+		goto run_inline;
+
+	if (ssl_offload_maxqueue && HA_ATOMIC_LOAD(&ssl_offload_queued) >= ssl_offload_maxqueue)
+		goto run_inline;
+
+	wctx = ASYNC_get_wait_ctx(job);
+	if (!wctx)
+		goto run_inline;
+
+	if (ASYNC_WAIT_CTX_get_fd(wctx, &ssl_offload_wait_key, &fd, &custom)) {
+		slot = custom;
+	}
+	else {
+		slot = calloc(1, sizeof(*slot));
+		if (!slot)
+			goto run_inline;
+
+		slot->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (slot->fd < 0) {
+			free(slot);
+			goto run_inline;
+		}
+
+		slot->refcount = 1;
+		if (!ASYNC_WAIT_CTX_set_wait_fd(wctx, &ssl_offload_wait_key, slot->fd, slot, ssl_offload_wait_cleanup)) {
+			close(slot->fd);
+			free(slot);
+			goto run_inline;
+		}
+	}
+
+	/* a previous operation may still be finishing to release the slot */
+	if (HA_ATOMIC_LOAD(&slot->refcount) > 1)
+		goto run_inline;
+
+	slot->op = op;
+	slot->len = len;
+	slot->padding = padding;
+	slot->key = key;
+	slot->done = 0;
+	ECDSA_SIG_free(slot->sig);
+	slot->sig = NULL;
+	memcpy(slot->in, in, len);
+
+	if (op == SSL_OFFLOAD_ECDSA)
+		EC_KEY_up_ref(key);
+	else
+		RSA_up_ref(key);
+
+	HA_ATOMIC_INC(&slot->refcount);
+	queued = HA_ATOMIC_ADD_FETCH(&ssl_offload_queued, 1);
+	HA_ATOMIC_UPDATE_MAX(&ssl_offload_queued_max, queued);
+	HA_ATOMIC_INC(&ssl_offload_submitted);
+
+	pthread_mutex_lock(&ssl_offload_lock);
+	slot->next = NULL;
+	if (ssl_offload_tail)
+		ssl_offload_tail->next = slot;
+	else
+		ssl_offload_head = slot;
+	ssl_offload_tail = slot;
+	pthread_cond_signal(&ssl_offload_cond);
+	pthread_mutex_unlock(&ssl_offload_lock);
+
+	/* the job may be resumed for other reasons (e.g. I/O events on the
+	 * connection), in which case we just have to wait again.
+	 */
+	do {
+		ASYNC_pause_job();
+	} while (!HA_ATOMIC_LOAD(&slot->done));
+
+	if (read(slot->fd, &val, sizeof(val)) < 0) {
+		/* the counter was already drained */
+	}
+	return slot;
+
+ run_inline:
+	HA_ATOMIC_INC(&ssl_offload_inline);
+	return NULL;
+}
+
+/* RSA_METHOD private encryption callback */
+static int ssl_offload_rsa_enc(int flen, const unsigned char *from, unsigned char *to, RSA *rsa, int padding)
+{
+	struct ssl_offload_slot *slot;
+
+	if (RSA_size(rsa) > SSL_OFFLOAD_MAXLEN)
+		return ssl_offload_rsa_priv_enc(flen, from, to, rsa, padding);
+
+	slot = ssl_offload_submit(SSL_OFFLOAD_RSA_ENC, from, flen, rsa, padding);
+	if (!slot)
+		return ssl_offload_rsa_priv_enc(flen, from, to, rsa, padding);
+
+	if (slot->ret > 0)
+		memcpy(to, slot->out, slot->ret);
+	return slot->ret;
+}
+
+/* RSA_METHOD private decryption callback */
+static int ssl_offload_rsa_dec(int flen, const unsigned char *from, unsigned char *to, RSA *rsa, int padding)
+{
+	struct ssl_offload_slot *slot;
+
+	if (RSA_size(rsa) > SSL_OFFLOAD_MAXLEN)
+		return ssl_offload_rsa_priv_dec(flen, from, to, rsa, padding);
+
+	slot = ssl_offload_submit(SSL_OFFLOAD_RSA_DEC, from, flen, rsa, padding);
+	if (!slot)
+		return ssl_offload_rsa_priv_dec(flen, from, to, rsa, padding);
+
+	if (slot->ret > 0)
+		memcpy(to, slot->out, slot->ret);
+	return slot->ret;
+}
+
+/* EC_KEY_METHOD sign_sig callback. Precomputed values are only used by the
+ * legacy ECDSA_sign_setup() API, these calls are performed inline.
+ */
+static ECDSA_SIG *ssl_offload_ecdsa(const unsigned char *dgst, int dgst_len,
+                                    const BIGNUM *kinv, const BIGNUM *r, EC_KEY *eckey)
+{
+	struct ssl_offload_slot *slot;
+	ECDSA_SIG *sig;
+
+	if (kinv || r)
+		return ssl_offload_ecdsa_sign_sig(dgst, dgst_len, kinv, r, eckey);
+
+	slot = ssl_offload_submit(SSL_OFFLOAD_ECDSA, dgst, dgst_len, eckey, 0);
+	if (!slot)
+		return ssl_offload_ecdsa_sign_sig(dgst, dgst_len, kinv, r, eckey);
+
+	sig = slot->sig;
+	slot->sig = NULL;
+	return sig;
+}
+
+/* Creates the RSA and EC key methods. Returns 0 on failure. */
+static int ssl_offload_init_methods()
+{
+	const EC_KEY_METHOD *ec_def;
+	int (*sign)(int, const unsigned char *, int, unsigned char *, unsigned int *,
+	            const BIGNUM *, const BIGNUM *, EC_KEY *);
+	int (*sign_setup)(EC_KEY *, BN_CTX *, BIGNUM **, BIGNUM **);
+
+	if (ssl_offload_rsa_meth)
+		return 1;
+
+	ssl_offload_rsa_priv_enc = RSA_meth_get_priv_enc(RSA_PKCS1_OpenSSL());
+	ssl_offload_rsa_priv_dec = RSA_meth_get_priv_dec(RSA_PKCS1_OpenSSL());
+	ssl_offload_rsa_meth = RSA_meth_dup(RSA_PKCS1_OpenSSL());
+	if (!ssl_offload_rsa_meth ||
+	    !RSA_meth_set1_name(ssl_offload_rsa_meth, "haproxy offloaded RSA") ||
+	    !RSA_meth_set_priv_enc(ssl_offload_rsa_meth, ssl_offload_rsa_enc) ||
+	    !RSA_meth_set_priv_dec(ssl_offload_rsa_meth, ssl_offload_rsa_dec))
+		return 0;
+
+	ec_def = EC_KEY_OpenSSL();
+	EC_KEY_METHOD_get_sign(ec_def, &sign, &sign_setup, &ssl_offload_ecdsa_sign_sig);
+	ssl_offload_ec_meth = EC_KEY_METHOD_new(ec_def);
+	if (!ssl_offload_ec_meth)
+		return 0;
+	EC_KEY_METHOD_set_sign(ssl_offload_ec_meth, sign, sign_setup, ssl_offload_ecdsa);
+	return 1;
+}
+
+/* Returns a copy of private key <pkey> using the offloading methods, or NULL
+ * if the key type is not supported or on allocation failure.
+ */
+static EVP_PKEY *ssl_offload_wrap_pkey(EVP_PKEY *pkey)
+{
+	EVP_PKEY *new = NULL;
+	RSA *rsa, *rsa_dup = NULL;
+	EC_KEY *ec, *ec_dup = NULL;
+
+	switch (EVP_PKEY_base_id(pkey)) {
+	case EVP_PKEY_RSA:
+		rsa = EVP_PKEY_get1_RSA(pkey);
+		if (!rsa)
+			break;
+		/* work on a copy, the key may be shared with other contexts */
+		rsa_dup = RSAPrivateKey_dup(rsa);
+		RSA_free(rsa);
+		if (!rsa_dup || !RSA_set_method(rsa_dup, ssl_offload_rsa_meth))
+			goto fail;
+		new = EVP_PKEY_new();
+		if (!new || !EVP_PKEY_assign_RSA(new, rsa_dup))
+			goto fail;
+		break;
+	case EVP_PKEY_EC:
+		ec = EVP_PKEY_get1_EC_KEY(pkey);
+		if (!ec)
+			break;
+		ec_dup = EC_KEY_dup(ec);
+		EC_KEY_free(ec);
+		if (!ec_dup || !EC_KEY_set_method(ec_dup, ssl_offload_ec_meth))
+			goto fail;
+		new = EVP_PKEY_new();
+		if (!new || !EVP_PKEY_assign_EC_KEY(new, ec_dup))
+			goto fail;
+		break;
+	}
+	return new;
+
+ fail:
+	EVP_PKEY_free(new);
+	RSA_free(rsa_dup);
+	EC_KEY_free(ec_dup);
+	ERR_clear_error();
+	return NULL;
+}
+
+/* Loads private key <pkey> into <ctx>, using a copy of it relying on the
+ * crypto threads for private operations when they are enabled and the key
+ * type is supported. Returns the SSL_CTX_use_PrivateKey() result.
+ */
+int ssl_offload_use_pkey(SSL_CTX *ctx, EVP_PKEY *pkey)
+{
+	EVP_PKEY *new;
+	int ret;
+
+	if (!ssl_offload_nbthread || !pkey)
+		return SSL_CTX_use_PrivateKey(ctx, pkey);
+
+	new = ssl_offload_wrap_pkey(pkey);
+	if (!new)
+		return SSL_CTX_use_PrivateKey(ctx, pkey);
+
+	ret = SSL_CTX_use_PrivateKey(ctx, new);
+	EVP_PKEY_free(new);
+	return ret;
+}
+
+/* Starts the crypto threads from the first thread once the process is fully
+ * initialized (i.e. after a possible fork). Signals are blocked in these
+ * threads so that they are always delivered to the regular ones.
+ */
+static int ssl_offload_start_threads()
+{
+	sigset_t all, old;
+	int i;
+
+	if (!ssl_offload_nbthread || tid != 0 || ssl_offload_started)
+		return 1;
+
+	ssl_offload_threads = calloc(ssl_offload_nbthread, sizeof(*ssl_offload_threads));
+	if (!ssl_offload_threads) {
+		ha_alert("ssl-offload-threads: out of memory.\n");
+		return 0;
+	}
+
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	for (i = 0; i < ssl_offload_nbthread; i++) {
+		if (pthread_create(&ssl_offload_threads[i], NULL, ssl_offload_thread, NULL) != 0) {
+			pthread_sigmask(SIG_SETMASK, &old, NULL);
+			ha_alert("ssl-offload-threads: failed to create crypto thread %d: %s.\n", i, strerror(errno));
+			return 0;
+		}
+		ssl_offload_started++;
+	}
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	return 1;
+}
+
+/* stops the crypto threads and releases the key methods */
+static void ssl_offload_deinit()
+{
+	int i;
+
+	if (ssl_offload_started) {
+		pthread_mutex_lock(&ssl_offload_lock);
+		ssl_offload_stopping = 1;
+		pthread_cond_broadcast(&ssl_offload_cond);
+		pthread_mutex_unlock(&ssl_offload_lock);
+
+		for (i = 0; i < ssl_offload_started; i++)
+			pthread_join(ssl_offload_threads[i], NULL);
+		ssl_offload_started = 0;
+	}
+	ha_free(&ssl_offload_threads);
+
+	/* keys still referencing the methods were released with their contexts */
+	RSA_meth_free(ssl_offload_rsa_meth);
+	ssl_offload_rsa_meth = NULL;
+	/* EC_KEY_METHOD_free() doesn't accept NULL */
+	if (ssl_offload_ec_meth)
+		EC_KEY_METHOD_free(ssl_offload_ec_meth);
+	ssl_offload_ec_meth = NULL;
+}
+
+REGISTER_PER_THREAD_INIT(ssl_offload_start_threads);
+REGISTER_POST_DEINIT(ssl_offload_deinit);
+
+/* parse the "ssl-offload-threads" keyword in global section.
+ * Returns <0 on alert, >0 on warning, 0 on success.
+ */
+static int ssl_offload_parse_threads(char **args, int section_type, struct proxy *curpx,
+                                     const struct proxy *defpx, const char *file, int line,
+                                     char **err)
+{
+	if (too_many_args(1, args, err, NULL))
+		return -1;
+
+	ssl_offload_nbthread = atoi(args[1]);
+	if (*args[1] == 0 || ssl_offload_nbthread < 0 || ssl_offload_nbthread > MAX_THREADS) {
+		memprintf(err, "'%s' expects a number of threads between 0 and %d.", args[0], MAX_THREADS);
+		return -1;
+	}
+
+	if (!ssl_offload_nbthread)
+		return 0;
+
+	if (!ssl_offload_init_methods()) {
+		memprintf(err, "'%s': unable to create the private key methods.", args[0]);
+		return -1;
+	}
+
+	/* operations are resumed using the async mode, which also accounts
+	 * for the eventfd needed by each connection.
+	 */
+	global_ssl.async = 1;
+	global.ssl_used_async_engines = nb_engines + 1;
+	return 0;
+}
+
+/* parse the "tune.ssl.offload-maxqueue" keyword in global section.
+ * Returns <0 on alert, >0 on warning, 0 on success.
+ */
+static int ssl_offload_parse_maxqueue(char **args, int section_type, struct proxy *curpx,
+                                      const struct proxy *defpx, const char *file, int line,
+                                      char **err)
+{
+	if (too_many_args(1, args, err, NULL))
+		return -1;
+
+	if (*args[1] == 0 || *args[1] == '-') {
+		memprintf(err, "'%s' expects a positive numeric value.", args[0]);
+		return -1;
+	}
+	ssl_offload_maxqueue = atoi(args[1]);
+	return 0;
+}
+
+static struct cfg_kw_list cfg_kws = {ILH, {
+	{ CFG_GLOBAL, "ssl-offload-threads",       ssl_offload_parse_threads },
+	{ CFG_GLOBAL, "tune.ssl.offload-maxqueue", ssl_offload_parse_maxqueue },
+	{ 0, NULL, NULL },
+}};
+
+INITCALL1(STG_REGISTER, cfg_register_keywords, &cfg_kws);
+
+/* I/O handler for "show ssl offload" */
+static int cli_io_handler_show_offload(struct appctx *appctx)
+{
+	struct buffer *trash = get_trash_chunk();
+
+	chunk_appendf(trash, "threads: %d\n", ssl_offload_started);
+	chunk_appendf(trash, "maxqueue: %u\n", ssl_offload_maxqueue);
+	chunk_appendf(trash, "queued: %u\n", HA_ATOMIC_LOAD(&ssl_offload_queued));
+	chunk_appendf(trash, "queued_max: %u\n", HA_ATOMIC_LOAD(&ssl_offload_queued_max));
+	chunk_appendf(trash, "submitted: %llu\n", HA_ATOMIC_LOAD(&ssl_offload_submitted));
+	chunk_appendf(trash, "completed: %llu\n", HA_ATOMIC_LOAD(&ssl_offload_completed));
+	chunk_appendf(trash, "inline: %llu\n", HA_ATOMIC_LOAD(&ssl_offload_inline));
+
+	if (applet_putchk(appctx, trash) == -1)
+		return 0;
+	return 1;
+}
+
+static struct cli_kw_list cli_kws = {{ },{
+	{ { "show", "ssl", "offload", NULL }, "show ssl offload                        : show the private key offloading thread pool's state", NULL, cli_io_handler_show_offload },
+	{ { NULL }, NULL, NULL, NULL }
+}};
+
+INITCALL1(STG_REGISTER, cli_register_kw, &cli_kws);
+
+#endif /* HAVE_SSL_OFFLOAD */
@@ -65,6 +65,7 @@
 #include <haproxy/proxy.h>
 #include <haproxy/quic_conn.h>
 #include <haproxy/quic_openssl_compat.h>
+#include <haproxy/quic_ssl.h>
 #include <haproxy/quic_tp.h>
 #include <haproxy/sample.h>
 #include <haproxy/sc_strm.h>
@@ -86,6 +87,11 @@
 #include <haproxy/xxhash.h>
 #include <haproxy/istbuf.h>
 #include <haproxy/ssl_ocsp.h>
+#include <haproxy/ssl_offload.h>
+
+#ifdef HAVE_SSL_KTLS
+#include <linux/tls.h>
+#endif
 
 
 /* ***** READ THIS before adding code here! *****
@@ -156,6 +162,8 @@ enum {
 	SSL_ST_SESS,
 	SSL_ST_REUSED_SESS,
 	SSL_ST_FAILED_HANDSHAKE,
+	SSL_ST_CACHE_HITS,
+	SSL_ST_CACHE_MISSES,
 
 	SSL_ST_STATS_COUNT /* must be the last member of the enum */
 };
@@ -167,12 +175,18 @@ static struct stat_col ssl_stats[] = {
 	                              .desc = "Total number of ssl sessions reused" },
 	[SSL_ST_FAILED_HANDSHAKE] = { .name = "ssl_failed_handshake",
 	                              .desc = "Total number of failed handshake" },
+	[SSL_ST_CACHE_HITS]       = { .name = "ssl_cache_hits",
+	                              .desc = "Total number of sessions found in the shared session cache" },
+	[SSL_ST_CACHE_MISSES]     = { .name = "ssl_cache_misses",
+	                              .desc = "Total number of sessions not found in the shared session cache" },
 };
 
 static struct ssl_counters {
 	long long sess;
 	long long reused_sess;
 	long long failed_handshake;
+	long long cache_hits;
+	long long cache_misses;
 } ssl_counters;
 
 static int ssl_fill_stats(void *data, struct field *stats, unsigned int *selected_field)
@@ -193,6 +207,12 @@ static int ssl_fill_stats(void *data, struct field *stats, unsigned int *selecte
 		case SSL_ST_FAILED_HANDSHAKE:
 			metric = mkf_u64(FN_COUNTER, counters->failed_handshake);
 			break;
+		case SSL_ST_CACHE_HITS:
+			metric = mkf_u64(FN_COUNTER, counters->cache_hits);
+			break;
+		case SSL_ST_CACHE_MISSES:
+			metric = mkf_u64(FN_COUNTER, counters->cache_misses);
+			break;
 		default:
 			/* not used for frontends. If a specific metric
 			 * is requested, return an error. Otherwise continue.
@@ -238,6 +258,180 @@ struct show_keys_ctx {
 struct task *ssl_sock_io_cb(struct task *, void *, unsigned int);
 static int ssl_sock_handshake(struct connection *conn, unsigned int flag);
 
+#ifdef HAVE_SSL_KTLS
+/* same as ssl_sock but with kernel splicing support, for kTLS connections */
+static struct xprt_ops ssl_sock_ktls;
+
+/* Called by OpenSSL when the keys for direction <is_tx> were negotiated, to
+ * pass them to the kernel so that it takes over records processing for the
+ * socket. <crypto_info> is one of the kernel's tls12_crypto_info_* structs,
+ * whose header indicates the cipher. Returns 1 on success, or 0 if kTLS cannot
+ * be used (unsupported cipher or kernel), in which case OpenSSL silently
+ * continues to process the records itself.
+ */
+static int ssl_sock_ktls_start(struct ssl_sock_ctx *ctx, const void *crypto_info, int is_tx)
+{
+	const struct tls_crypto_info *info = crypto_info;
+	struct connection *conn;
+	socklen_t len;
+
+	if (!ctx || !info || ctx->xprt != xprt_get(XPRT_RAW))
+		return 0;
+
+	conn = ctx->conn;
+	if ((conn->flags & CO_FL_FDLESS) || !conn_ctrl_ready(conn))
+		return 0;
+
+	switch (info->cipher_type) {
+	case TLS_CIPHER_AES_GCM_128:
+		len = sizeof(struct tls12_crypto_info_aes_gcm_128);
+		break;
+	case TLS_CIPHER_AES_GCM_256:
+		len = sizeof(struct tls12_crypto_info_aes_gcm_256);
+		break;
+#ifdef TLS_CIPHER_AES_CCM_128
+	case TLS_CIPHER_AES_CCM_128:
+		len = sizeof(struct tls12_crypto_info_aes_ccm_128);
+		break;
+#endif
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+	case TLS_CIPHER_CHACHA20_POLY1305:
+		len = sizeof(struct tls12_crypto_info_chacha20_poly1305);
+		break;
+#endif
+	default:
+		return 0;
+	}
+
+	/* the TLS upper layer protocol is attached once for both directions */
+	if (setsockopt(conn->handle.fd, IPPROTO_TCP, TCP_ULP, "tls", sizeof("tls")) != 0 && errno != EEXIST)
+		return 0;
+
+	/* If this fails, the ULP remains attached but without keys for this
+	 * direction, in which case the kernel passes the data through as-is.
+	 * The direction is not flagged, so OpenSSL keeps processing its
+	 * records and the regular xprt remains in use.
+	 */
+	if (setsockopt(conn->handle.fd, SOL_TLS, is_tx ? TLS_TX : TLS_RX, crypto_info, len) != 0)
+		return 0;
+
+	ctx->xprt_st |= is_tx ? SSL_SOCK_KTLS_TX : SSL_SOCK_KTLS_RX;
+	return 1;
+}
+
+/* Sends the <num> bytes from <buf> as a single TLS record of type <type> over
+ * a kTLS socket, which is how OpenSSL emits non-application records (alerts,
+ * session tickets, key updates) once the kernel encrypts the records. Just
+ * like OpenSSL's socket BIO, the record is considered fully sent on success.
+ * Returns <num> on success, otherwise 0 with the connection flags updated.
+ */
+static int ssl_sock_ktls_send_ctrl(struct ssl_sock_ctx *ctx, unsigned char type, const char *buf, int num)
+{
+	union {
+		struct cmsghdr hdr;
+		char buf[CMSG_SPACE(sizeof(unsigned char))];
+	} cmsgbuf;
+	struct connection *conn = ctx->conn;
+	struct msghdr msg = { };
+	struct cmsghdr *cmsg;
+	struct iovec iov;
+
+	if (!fd_send_ready(conn->handle.fd))
+		return 0;
+
+	msg.msg_control = cmsgbuf.buf;
+	msg.msg_controllen = sizeof(cmsgbuf.buf);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_TLS;
+	cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(type));
+	*(unsigned char *)CMSG_DATA(cmsg) = type;
+	msg.msg_controllen = cmsg->cmsg_len;
+
+	iov.iov_base = (void *)buf;
+	iov.iov_len = num;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	if (sendmsg(conn->handle.fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) >= 0) {
+		ctx->xprt_st &= ~SSL_SOCK_KTLS_CTRL_MSG;
+		return num;
+	}
+
+	if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOTCONN)
+		fd_cant_send(conn->handle.fd);
+	else if (errno != EINTR)
+		conn->flags |= CO_FL_ERROR | CO_FL_SOCK_RD_SH | CO_FL_SOCK_WR_SH;
+	return 0;
+}
+
+/* Receives one or several TLS records of the same type decrypted by the kernel
+ * into <buf> of size <size>, and rebuilds a record header in front of them so
+ * that OpenSSL knows their type. This is the format OpenSSL expects from a
+ * kTLS-enabled BIO. Returns the number of bytes placed into <buf>, otherwise 0
+ * with the connection flags updated. Data received without their record type
+ * are reported as a connection error.
+ */
+static int ssl_sock_ktls_recv(struct ssl_sock_ctx *ctx, char *buf, int size)
+{
+	union {
+		struct cmsghdr hdr;
+		char buf[CMSG_SPACE(sizeof(unsigned char))];
+	} cmsgbuf;
+	struct connection *conn = ctx->conn;
+	struct msghdr msg = { };
+	struct cmsghdr *cmsg;
+	struct iovec iov;
+	int ret;
+
+	if (!fd_recv_ready(conn->handle.fd))
+		return 0;
+
+	if (size < SSL3_RT_HEADER_LENGTH + EVP_GCM_TLS_TAG_LEN) {
+		conn->flags |= CO_FL_ERROR | CO_FL_SOCK_RD_SH | CO_FL_SOCK_WR_SH;
+		return 0;
+	}
+
+	msg.msg_control = cmsgbuf.buf;
+	msg.msg_controllen = sizeof(cmsgbuf.buf);
+	iov.iov_base = buf + SSL3_RT_HEADER_LENGTH;
+	iov.iov_len = size - SSL3_RT_HEADER_LENGTH - EVP_GCM_TLS_TAG_LEN;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	do {
+		ret = recvmsg(conn->handle.fd, &msg, 0);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret > 0) {
+		/* the data were placed after the header, which cannot be built
+		 * without the record type.
+		 */
+		cmsg = CMSG_FIRSTHDR(&msg);
+		if ((msg.msg_flags & MSG_CTRUNC) || !cmsg ||
+		    cmsg->cmsg_level != SOL_TLS || cmsg->cmsg_type != TLS_GET_RECORD_TYPE) {
+			conn->flags |= CO_FL_ERROR | CO_FL_SOCK_RD_SH | CO_FL_SOCK_WR_SH;
+			return 0;
+		}
+
+		buf[0] = *(unsigned char *)CMSG_DATA(cmsg);
+		buf[1] = TLS1_2_VERSION_MAJOR;
+		buf[2] = TLS1_2_VERSION_MINOR;
+		buf[3] = (ret >> 8) & 0xff;
+		buf[4] = ret & 0xff;
+		return ret + SSL3_RT_HEADER_LENGTH;
+	}
+
+	if (ret == 0)
+		conn_sock_read0(conn);
+	else if (errno == EAGAIN || errno == EWOULDBLOCK)
+		fd_cant_recv(conn->handle.fd);
+	else
+		conn->flags |= CO_FL_ERROR | CO_FL_SOCK_RD_SH | CO_FL_SOCK_WR_SH;
+	return 0;
+}
+#endif /* HAVE_SSL_KTLS */
+
 /* Methods to implement OpenSSL BIO */
 static int ha_ssl_write(BIO *h, const char *buf, int num)
 {
@@ -247,12 +441,21 @@ static int ha_ssl_write(BIO *h, const char *buf, int num)
 	int ret;
 
 	ctx = BIO_get_data(h);
+#ifdef HAVE_SSL_KTLS
+	if (ctx->xprt_st & SSL_SOCK_KTLS_CTRL_MSG) {
+		ret = ssl_sock_ktls_send_ctrl(ctx, ctx->ktls_rec_type, buf, num);
+		goto done;
+	}
+#endif
 	tmpbuf.size = num;
 	tmpbuf.area = (void *)(uintptr_t)buf;
 	tmpbuf.data = num;
 	tmpbuf.head = 0;
 	flags = (ctx->xprt_st & SSL_SOCK_SEND_MORE) ? CO_SFL_MSG_MORE : 0;
 	ret = ctx->xprt->snd_buf(ctx->conn, ctx->xprt_ctx, &tmpbuf, num, flags);
+#ifdef HAVE_SSL_KTLS
+ done:
+#endif
 	BIO_clear_retry_flags(h);
 	if (ret == 0 && !(ctx->conn->flags & (CO_FL_ERROR | CO_FL_SOCK_WR_SH))) {
 		BIO_set_retry_write(h);
@@ -280,11 +483,20 @@ static int ha_ssl_read(BIO *h, char *buf, int size)
 	int ret;
 
 	ctx = BIO_get_data(h);
+#ifdef HAVE_SSL_KTLS
+	if (ctx->xprt_st & SSL_SOCK_KTLS_RX) {
+		ret = ssl_sock_ktls_recv(ctx, buf, size);
+		goto done;
+	}
+#endif
 	tmpbuf.size = size;
 	tmpbuf.area = buf;
 	tmpbuf.data = 0;
 	tmpbuf.head = 0;
 	ret = ctx->xprt->rcv_buf(ctx->conn, ctx->xprt_ctx, &tmpbuf, size, 0);
+#ifdef HAVE_SSL_KTLS
+ done:
+#endif
 	BIO_clear_retry_flags(h);
 	if (ret == 0 && !(ctx->conn->flags & (CO_FL_ERROR | CO_FL_SOCK_RD_SH))) {
 		BIO_set_retry_read(h);
@@ -296,12 +508,36 @@ static int ha_ssl_read(BIO *h, char *buf, int size)
 
 static long ha_ssl_ctrl(BIO *h, int cmd, long arg1, void *arg2)
 {
+#ifdef HAVE_SSL_KTLS
+	struct ssl_sock_ctx *ctx = BIO_get_data(h);
+#endif
 	int ret = 0;
 	switch (cmd) {
 	case BIO_CTRL_DUP:
 	case BIO_CTRL_FLUSH:
 		ret = 1;
 		break;
+#ifdef HAVE_SSL_KTLS
+	case BIO_CTRL_SET_KTLS:
+		ret = ssl_sock_ktls_start(ctx, arg2, arg1);
+		break;
+	case BIO_CTRL_GET_KTLS_SEND:
+		ret = ctx && (ctx->xprt_st & SSL_SOCK_KTLS_TX);
+		break;
+	case BIO_CTRL_GET_KTLS_RECV:
+		ret = ctx && (ctx->xprt_st & SSL_SOCK_KTLS_RX);
+		break;
+	case BIO_CTRL_SET_KTLS_SEND_CTRL_MSG:
+		if (ctx) {
+			ctx->xprt_st |= SSL_SOCK_KTLS_CTRL_MSG;
+			ctx->ktls_rec_type = arg1;
+		}
+		break;
+	case BIO_CTRL_CLEAR_KTLS_CTRL_MSG:
+		if (ctx)
+			ctx->xprt_st &= ~SSL_SOCK_KTLS_CTRL_MSG;
+		break;
+#endif
 	}
 	return ret;
 }
@@ -543,8 +779,8 @@ const char *SSL_SOCK_KEYTYPE_NAMES[] = {
 	"rsa"
 };
 
-static struct shared_context *ssl_shctx = NULL; /* ssl shared session cache */
-static struct eb_root *sh_ssl_sess_tree; /* ssl shared session tree */
+static struct shared_context **ssl_shctx = NULL; /* ssl shared session cache shards */
+static uint ssl_shctx_shards = 0;                /* number of session cache shards */
 
 /* Dedicated callback functions for heartbeat and clienthello.
  */
@@ -631,7 +867,7 @@ static void ssl_sock_unregister_msg_callbacks(void)
 
 static struct ssl_sock_ctx *ssl_sock_get_ctx(struct connection *conn)
 {
-	if (!conn || conn->xprt != xprt_get(XPRT_SSL) || !conn->xprt_ctx)
+	if (!conn || !conn->xprt || conn->xprt->get_ssl_sock_ctx != ssl_sock_get_ctx || !conn->xprt_ctx)
 		return NULL;
 
 	return (struct ssl_sock_ctx *)conn->xprt_ctx;
@@ -710,7 +946,7 @@ int ssl_init_single_engine(const char *engine_id, const char *def_algorithms)
 	LIST_INSERT(&openssl_engines, &el->list);
 	nb_engines++;
 	if (global_ssl.async)
-		global.ssl_used_async_engines = nb_engines;
+		global.ssl_used_async_engines = nb_engines + !!ssl_offload_nbthread;
 	return 0;
 
 fail_alloc:
@@ -2677,7 +2913,7 @@ static int ssl_sock_put_ckch_into_ctx(const char *path, struct ckch_store *store
 
 	ERR_clear_error();
 
-	if (SSL_CTX_use_PrivateKey(ctx, data->key) <= 0) {
+	if (ssl_offload_use_pkey(ctx, data->key) <= 0) {
 		int ret;
 
 		ret = ERR_get_error();
@@ -2757,7 +2993,7 @@ static int ssl_sock_put_srv_ckch_into_ctx(const char *path, const struct ckch_da
 	STACK_OF(X509) *find_chain = NULL;
 
 	/* Load the private key */
-	if (SSL_CTX_use_PrivateKey(ctx, data->key) <= 0) {
+	if (ssl_offload_use_pkey(ctx, data->key) <= 0) {
 		memprintf(err, "%sunable to load SSL private key into SSL Context '%s'.\n",
 				err && *err ? *err : "", path);
 		errcode |= ERR_ALERT | ERR_FATAL;
@@ -3476,6 +3712,48 @@ static inline struct shared_block *sh_ssl_sess_first_block(struct sh_ssl_sess_hd
 
 }
 
+/* return the session tree of cache shard <shctx>, stored in its extra space */
+static inline struct eb_root *sh_ssl_sess_root(struct shared_context *shctx)
+{
+	return (struct eb_root *)((unsigned char *)shctx + sizeof(struct shared_context));
+}
+
+/* return the cache shard in charge of session id <key>, zero-padded to
+ * SSL_MAX_SSL_SESSION_ID_LENGTH. Session ids are random so that any hash
+ * spreads them evenly.
+ */
+static inline struct shared_context *sh_ssl_sess_shard(const unsigned char *key)
+{
+	if (ssl_shctx_shards == 1)
+		return ssl_shctx[0];
+	return ssl_shctx[XXH32(key, SSL_MAX_SSL_SESSION_ID_LENGTH, 0) % ssl_shctx_shards];
+}
+
+/* account for a session cache lookup on the listener of <ssl>'s connection,
+ * if any. <hit> indicates whether the session was found.
+ */
+static inline void sh_ssl_sess_count_lookup(SSL *ssl, int hit)
+{
+	struct connection *conn = SSL_get_ex_data(ssl, ssl_app_data_index);
+	struct ssl_counters *counters, *counters_px;
+	struct listener *li;
+
+	if (!conn || !(li = objt_listener(conn->target)))
+		return;
+
+	counters = EXTRA_COUNTERS_GET(li->extra_counters, &ssl_stats_module);
+	counters_px = EXTRA_COUNTERS_GET(li->bind_conf->frontend->extra_counters_fe,
+	                                 &ssl_stats_module);
+	if (hit) {
+		HA_ATOMIC_INC(&counters->cache_hits);
+		HA_ATOMIC_INC(&counters_px->cache_hits);
+	}
+	else {
+		HA_ATOMIC_INC(&counters->cache_misses);
+		HA_ATOMIC_INC(&counters_px->cache_misses);
+	}
+}
+
 /* store a session into the cache
  * s_id : session id padded with zero to SSL_MAX_SSL_SESSION_ID_LENGTH
  * data: asn1 encoded session
@@ -3484,16 +3762,17 @@ static inline struct shared_block *sh_ssl_sess_first_block(struct sh_ssl_sess_hd
  */
 static int sh_ssl_sess_store(unsigned char *s_id, unsigned char *data, int data_len)
 {
+	struct shared_context *shctx = sh_ssl_sess_shard(s_id);
 	struct shared_block *first;
 	struct sh_ssl_sess_hdr *sh_ssl_sess, *oldsh_ssl_sess;
 
-	first = shctx_row_reserve_hot(ssl_shctx, NULL, data_len + sizeof(struct sh_ssl_sess_hdr));
+	first = shctx_row_reserve_hot(shctx, NULL, data_len + sizeof(struct sh_ssl_sess_hdr));
 	if (!first) {
 		/* Could not retrieve enough free blocks to store that session */
 		return 0;
 	}
 
-	shctx_wrlock(ssl_shctx);
+	shctx_wrlock(shctx);
 
 	/* STORE the key in the first elem */
 	sh_ssl_sess = (struct sh_ssl_sess_hdr *)first->data;
@@ -3502,28 +3781,29 @@ static int sh_ssl_sess_store(unsigned char *s_id, unsigned char *data, int data_
 
 	/* it returns the already existing node
            or current node if none, never returns null */
-	oldsh_ssl_sess = sh_ssl_sess_tree_insert(sh_ssl_sess);
+	oldsh_ssl_sess = sh_ssl_sess_tree_insert(sh_ssl_sess_root(shctx), sh_ssl_sess);
 	if (oldsh_ssl_sess != sh_ssl_sess) {
 		 /* NOTE: Row couldn't be in use because we lock read & write function */
 		/* release the reserved row */
 		first->len = 0; /* the len must be liberated in order not to call the release callback on it */
-		shctx_row_reattach(ssl_shctx, first);
+		shctx_row_reattach(shctx, first);
 		/* replace the previous session already in the tree */
 		sh_ssl_sess = oldsh_ssl_sess;
 		/* ignore the previous session data, only use the header */
 		first = sh_ssl_sess_first_block(sh_ssl_sess);
-		shctx_row_detach(ssl_shctx, first);
+		shctx_row_detach(shctx, first);
 		first->len = sizeof(struct sh_ssl_sess_hdr);
 	}
 
-	if (shctx_row_data_append(ssl_shctx, first, data, data_len) < 0) {
-		shctx_row_reattach(ssl_shctx, first);
+	if (shctx_row_data_append(shctx, first, data, data_len) < 0) {
+		shctx_row_reattach(shctx, first);
+		shctx_wrunlock(shctx);
 		return 0;
 	}
 
-	shctx_row_reattach(ssl_shctx, first);
+	shctx_row_reattach(shctx, first);
 
-	shctx_wrunlock(ssl_shctx);
+	shctx_wrunlock(shctx);
 
 	return 1;
 }
@@ -3679,11 +3959,13 @@ int sh_ssl_sess_new_cb(SSL *ssl, SSL_SESSION *sess)
 /* SSL callback used on lookup an existing session cause none found in internal cache */
 SSL_SESSION *sh_ssl_sess_get_cb(SSL *ssl, __OPENSSL_110_CONST__ unsigned char *key, int key_len, int *do_copy)
 {
+	struct shared_context *shctx;
 	struct sh_ssl_sess_hdr *sh_ssl_sess;
 	unsigned char data[SHSESS_MAX_DATA_LEN], *p;
 	unsigned char tmpkey[SSL_MAX_SSL_SESSION_ID_LENGTH];
 	SSL_SESSION *sess;
 	struct shared_block *first;
+	int data_len;
 
 	_HA_ATOMIC_INC(&global.shctx_lookups);
 
@@ -3697,28 +3979,51 @@ SSL_SESSION *sh_ssl_sess_get_cb(SSL *ssl, __OPENSSL_110_CONST__ unsigned char *k
 		key = tmpkey;
 	}
 
-	/* lock cache */
-	shctx_wrlock(ssl_shctx);
+	shctx = sh_ssl_sess_shard(key);
+
+	/* lock the shard: lookups only need to exclude writers, unless the
+	 * entry has to be refreshed in the eviction list.
+	 */
+	if (global_ssl.cache_lru)
+		shctx_wrlock(shctx);
+	else
+		shctx_rdlock(shctx);
 
 	/* lookup for session */
-	sh_ssl_sess = sh_ssl_sess_tree_lookup(key);
+	sh_ssl_sess = sh_ssl_sess_tree_lookup(sh_ssl_sess_root(shctx), key);
 	if (!sh_ssl_sess) {
 		/* no session found: unlock cache and exit */
-		shctx_wrunlock(ssl_shctx);
+		if (global_ssl.cache_lru)
+			shctx_wrunlock(shctx);
+		else
+			shctx_rdunlock(shctx);
 		_HA_ATOMIC_INC(&global.shctx_misses);
+		sh_ssl_sess_count_lookup(ssl, 0);
 		return NULL;
 	}
 
 	/* sh_ssl_sess (shared_block->data) is at the end of shared_block */
 	first = sh_ssl_sess_first_block(sh_ssl_sess);
+	data_len = first->len - sizeof(struct sh_ssl_sess_hdr);
+
+	shctx_row_data_get(shctx, first, data, sizeof(struct sh_ssl_sess_hdr), data_len);
 
-	shctx_row_data_get(ssl_shctx, first, data, sizeof(struct sh_ssl_sess_hdr), first->len-sizeof(struct sh_ssl_sess_hdr));
+	if (global_ssl.cache_lru) {
+		/* move the row to the end of the avail list so that it's the
+		 * last one to be evicted.
+		 */
+		shctx_row_detach(shctx, first);
+		shctx_row_reattach(shctx, first);
+		shctx_wrunlock(shctx);
+	}
+	else
+		shctx_rdunlock(shctx);
 
-	shctx_wrunlock(ssl_shctx);
+	sh_ssl_sess_count_lookup(ssl, 1);
 
 	/* decode ASN1 session */
 	p = data;
-	sess = d2i_SSL_SESSION(NULL, (const unsigned char **)&p, first->len-sizeof(struct sh_ssl_sess_hdr));
+	sess = d2i_SSL_SESSION(NULL, (const unsigned char **)&p, data_len);
 	/* Reset session id and session id contenxt */
 	if (sess) {
 		SSL_SESSION_set1_id(sess, key, key_len);
@@ -3732,6 +4037,7 @@ SSL_SESSION *sh_ssl_sess_get_cb(SSL *ssl, __OPENSSL_110_CONST__ unsigned char *k
 /* SSL callback used to signal session is no more used in internal cache */
 void sh_ssl_sess_remove_cb(SSL_CTX *ctx, SSL_SESSION *sess)
 {
+	struct shared_context *shctx;
 	struct sh_ssl_sess_hdr *sh_ssl_sess;
 	unsigned char tmpkey[SSL_MAX_SSL_SESSION_ID_LENGTH];
 	unsigned int sid_length;
@@ -3746,17 +4052,18 @@ void sh_ssl_sess_remove_cb(SSL_CTX *ctx, SSL_SESSION *sess)
 		sid_data = tmpkey;
 	}
 
-	shctx_wrlock(ssl_shctx);
+	shctx = sh_ssl_sess_shard(sid_data);
+	shctx_wrlock(shctx);
 
 	/* lookup for session */
-	sh_ssl_sess = sh_ssl_sess_tree_lookup(sid_data);
+	sh_ssl_sess = sh_ssl_sess_tree_lookup(sh_ssl_sess_root(shctx), sid_data);
 	if (sh_ssl_sess) {
 		/* free session */
 		sh_ssl_sess_tree_delete(sh_ssl_sess);
 	}
 
 	/* unlock cache */
-	shctx_wrunlock(ssl_shctx);
+	shctx_wrunlock(shctx);
 }
 
 /* Set session cache mode to server and disable openssl internal cache.
@@ -4304,7 +4611,7 @@ int ssl_sock_prepare_srv_ctx(struct server *srv)
 		}
 	}
 	if (srv->use_ssl == 1)
-		srv->xprt = &ssl_sock;
+		srv->xprt = srv_is_quic(srv) ? xprt_get(XPRT_QUIC) : &ssl_sock;
 
 	if (srv->ssl_ctx.client_crt) {
 		const int create_if_none = srv->flags & SRV_F_DYNAMIC ? 0 : 1;
@@ -4556,6 +4863,11 @@ static int ssl_sock_prepare_srv_ssl_ctx(const struct server *srv, SSL_CTX *ctx)
 	}
 #endif /* defined(SSL_CTX_set1_curves_list) */
 
+#ifdef USE_QUIC
+	if (srv_is_quic(srv))
+		cfgerr += ssl_quic_srv_ctx_init(srv, ctx);
+#endif
+
 	return cfgerr;
 }
 
@@ -4702,21 +5014,37 @@ int ssl_sock_prepare_bind_conf(struct bind_conf *bind_conf)
 	}
 
 	if (!ssl_shctx && global.tune.sslcachesize) {
-		alloc_ctx = shctx_init(&ssl_shctx, global.tune.sslcachesize,
-		                       sizeof(struct sh_ssl_sess_hdr) + SHSESS_BLOCK_MIN_SIZE, -1,
-		                       sizeof(*sh_ssl_sess_tree), "ssl cache");
-		if (alloc_ctx <= 0) {
-			if (alloc_ctx == SHCTX_E_INIT_LOCK)
-				ha_alert("Unable to initialize the lock for the shared SSL session cache. You can retry using the global statement 'tune.ssl.force-private-cache' but it could increase CPU usage due to renegotiations if nbproc > 1.\n");
-			else
-				ha_alert("Unable to allocate SSL session cache.\n");
+		uint shard;
+
+		/* by default the cache is split into one shard per thread
+		 * group, each shard having its own lock and tree.
+		 */
+		ssl_shctx_shards = global_ssl.cache_shards ? global_ssl.cache_shards : MAX(global.nbtgroups, 1);
+		if (ssl_shctx_shards > global.tune.sslcachesize)
+			ssl_shctx_shards = global.tune.sslcachesize;
+
+		ssl_shctx = calloc(ssl_shctx_shards, sizeof(*ssl_shctx));
+		if (!ssl_shctx) {
+			ha_alert("Unable to allocate SSL session cache.\n");
 			return -1;
 		}
-		/* free block callback */
-		ssl_shctx->free_block = sh_ssl_sess_free_blocks;
-		/* init the root tree within the extra space */
-		sh_ssl_sess_tree = (void *)ssl_shctx + sizeof(struct shared_context);
-		*sh_ssl_sess_tree = EB_ROOT_UNIQUE;
+
+		for (shard = 0; shard < ssl_shctx_shards; shard++) {
+			alloc_ctx = shctx_init(&ssl_shctx[shard], global.tune.sslcachesize / ssl_shctx_shards,
+			                       sizeof(struct sh_ssl_sess_hdr) + SHSESS_BLOCK_MIN_SIZE, -1,
+			                       sizeof(struct eb_root), "ssl cache");
+			if (alloc_ctx <= 0) {
+				if (alloc_ctx == SHCTX_E_INIT_LOCK)
+					ha_alert("Unable to initialize the lock for the shared SSL session cache. You can retry using the global statement 'tune.ssl.force-private-cache' but it could increase CPU usage due to renegotiations if nbproc > 1.\n");
+				else
+					ha_alert("Unable to allocate SSL session cache.\n");
+				return -1;
+			}
+			/* free block callback */
+			ssl_shctx[shard]->free_block = sh_ssl_sess_free_blocks;
+			/* init the root tree within the extra space */
+			*sh_ssl_sess_root(ssl_shctx[shard]) = EB_ROOT_UNIQUE;
+		}
 	}
 	err = 0;
 	/* initialize all certificate contexts */
@@ -4992,6 +5320,10 @@ static int ssl_sock_init(struct connection *conn, void **xprt_ctx)
 			goto err;
 
 		SSL_set_connect_state(ctx->ssl);
+#ifdef HAVE_SSL_KTLS
+		if (srv->ssl_ctx.options & SRV_SSL_O_KTLS)
+			SSL_set_options(ctx->ssl, SSL_OP_ENABLE_KTLS);
+#endif
 		HA_RWLOCK_RDLOCK(SSL_SERVER_LOCK, &srv->ssl_ctx.lock);
 		if (srv->ssl_ctx.reused_sess[tid].ptr) {
 			/* let's recreate a session from (ptr,size) and assign
@@ -5081,6 +5413,10 @@ static int ssl_sock_init(struct connection *conn, void **xprt_ctx)
 #endif
 
 		SSL_set_accept_state(ctx->ssl);
+#ifdef HAVE_SSL_KTLS
+		if (bc->ssl_options & BC_SSL_O_KTLS)
+			SSL_set_options(ctx->ssl, SSL_OP_ENABLE_KTLS);
+#endif
 
 		/* leave init state and start handshake */
 		conn->flags |= CO_FL_SSL_WAIT_HS | CO_FL_WAIT_L6_CONN;
@@ -5434,6 +5770,14 @@ static int ssl_sock_handshake(struct connection *conn, unsigned int flag)
 		HA_ATOMIC_INC(&counters_px->reused_sess);
 	}
 
+#ifdef HAVE_SSL_KTLS
+	/* once the kernel encrypts the records, the data may be spliced to
+	 * the socket, which is only offered when ssl_sock is the top layer.
+	 */
+	if ((ctx->xprt_st & SSL_SOCK_KTLS_TX) && conn->xprt == &ssl_sock)
+		conn->xprt = &ssl_sock_ktls;
+#endif
+
 	/* The connection is now established at both layers, it's time to leave */
 	conn->flags &= ~(flag | CO_FL_WAIT_L4_CONN | CO_FL_WAIT_L6_CONN);
 	return 1;
@@ -6756,6 +7100,20 @@ static struct cli_kw_list cli_kws = {{ },{
 
 INITCALL1(STG_REGISTER, cli_register_kw, &cli_kws);
 
+#if defined(HAVE_SSL_KTLS) && defined(USE_LINUX_SPLICE)
+/* Sends as many bytes as possible from the pipe to the connection's socket,
+ * which may only be done when the kernel encrypts the records (kTLS).
+ */
+static int ssl_sock_from_pipe(struct connection *conn, void *xprt_ctx, struct pipe *pipe, unsigned int count)
+{
+	struct ssl_sock_ctx *ctx = xprt_ctx;
+
+	if (!ctx->xprt->snd_pipe)
+		return 0;
+	return ctx->xprt->snd_pipe(conn, ctx->xprt_ctx, pipe, count);
+}
+#endif
+
 /* transport-layer operations for SSL sockets */
 struct xprt_ops ssl_sock = {
 	.snd_buf  = ssl_sock_from_buf,
@@ -6888,6 +7246,12 @@ static void __ssl_sock_init(void)
 #endif
 
 	xprt_register(XPRT_SSL, &ssl_sock);
+#ifdef HAVE_SSL_KTLS
+	ssl_sock_ktls = ssl_sock;
+#ifdef USE_LINUX_SPLICE
+	ssl_sock_ktls.snd_pipe = ssl_sock_from_pipe;
+#endif
+#endif
 #if HA_OPENSSL_VERSION_NUMBER < 0x10100000L
 	SSL_library_init();
 #elif HA_OPENSSL_VERSION_NUMBER >= 0x10100000L
@@ -18,6 +18,7 @@
 #include <haproxy/activity.h>
 #include <haproxy/cfgparse.h>
 #include <haproxy/clock.h>
+#include <haproxy/errors.h>
 #include <haproxy/fd.h>
 #include <haproxy/list.h>
 #include <haproxy/pool.h>
@@ -42,6 +43,35 @@ DECLARE_POOL(pool_head_notification, "notification", sizeof(struct notification)
  */
 __decl_aligned_rwlock(wq_lock);
 
+/* Relative weights of each tasklet class, used to share the run queue budget
+ * between the classes on each scheduler round. They may be changed using the
+ * "tune.sched.class" global keyword.
+ */
+static uint sched_weights[TL_CLASSES] = {
+	[TL_URGENT] = 64, // ~50% of CPU bandwidth for I/O
+	[TL_NORMAL] = 48, // ~37% of CPU bandwidth for tasks
+	[TL_BULK]   = 16, // ~13% of CPU bandwidth for self-wakers
+	[TL_HEAVY]  = 1,  // never more than 1 heavy task at once
+};
+
+/* Per-class target for the average wakeup latency, in microseconds. A class
+ * whose measured latency exceeds its target has its weight doubled until it
+ * gets back below. Zero means no target. Latencies are only measured when
+ * task profiling is enabled.
+ */
+static uint sched_max_lat[TL_CLASSES];
+
+/* set by "tune.sched.timer-wheel" to use per-thread timer wheels */
+static int sched_timer_wheel;
+
+/* names of the tasklet classes as used in the configuration */
+static const char *sched_class_names[TL_CLASSES] = {
+	[TL_URGENT] = "urgent",
+	[TL_NORMAL] = "normal",
+	[TL_BULK]   = "bulk",
+	[TL_HEAVY]  = "heavy",
+};
+
 /* Flags the task <t> for immediate destruction and puts it into its first
  * thread's shared tasklet list if not yet queued/running. This will bypass
  * the priority scheduling and make the task show up as fast as possible in
@@ -257,6 +287,113 @@ void __task_wakeup(struct task *t)
 	return;
 }
 
+/* Tries to insert task <task> into timer wheel <tw> at the position given by
+ * its wq.key. Returns non-zero on success, or zero if the date is already
+ * reached by the wheel's clock or too far ahead, in which case the task must
+ * go to the tree instead. The task must not be queued.
+ */
+static inline int task_wheel_insert(struct timer_wheel *tw, struct task *task)
+{
+	uint delta = task->wq.key - tw->clk;
+	uint lvl, slot;
+
+	if ((int)delta <= 0)
+		return 0;
+
+	for (lvl = 0; delta >> (TW_BITS * (lvl + 1)); lvl++) {
+		if (lvl == TW_LEVELS - 1)
+			return 0;
+	}
+
+	slot = (task->wq.key >> (TW_BITS * lvl)) & (TW_SLOTS - 1);
+	LIST_APPEND(&tw->slots[lvl][slot], &task->wq_list);
+	tw->map[lvl] |= 1ULL << slot;
+	task->wq.node.bit = lvl;
+	task->wq.node.pfx = slot;
+	task->wq.node.leaf_p = TASK_WQ_WHEEL;
+	return 1;
+}
+
+/* Returns in <next> the first tick of the earliest non-empty slot of timer
+ * wheel <tw>. This is the exact expiration date for level 0 and a lower bound
+ * for the other levels. Returns zero if the wheel is empty, otherwise non-zero.
+ */
+static inline int task_wheel_next(const struct timer_wheel *tw, uint *next)
+{
+	uint lvl, shift, cur, rot, start;
+	uint64_t map;
+	int found = 0;
+
+	for (lvl = 0; lvl < TW_LEVELS; lvl++) {
+		map = tw->map[lvl];
+		if (!map)
+			continue;
+
+		/* slots are looked up in time order, starting from the one
+		 * following the current clock's slot.
+		 */
+		shift = TW_BITS * lvl;
+		cur = tw->clk >> shift;
+		rot = (cur + 1) & (TW_SLOTS - 1);
+		if (rot)
+			map = (map >> rot) | (map << (TW_SLOTS - rot));
+		start = (cur + 1 + __builtin_ctzll(map)) << shift;
+
+		if (!found || start - tw->clk < *next - tw->clk)
+			*next = start;
+		found = 1;
+	}
+	return found;
+}
+
+/* Processes the slots of the current thread's timer wheel <tw> which are
+ * reached by <now_ms>, waking up expired tasks and moving the other ones to
+ * their new place. At most <budget> tasks are visited, the remaining budget is
+ * returned. The clock is only advanced past a tick once all of its slots were
+ * processed.
+ */
+static int task_wheel_expire(struct timer_wheel *tw, int budget)
+{
+	struct list *head;
+	struct task *task;
+	uint next = 0, lvl, slot;
+
+	while (1) {
+		if (!task_wheel_next(tw, &next) || tick_is_lt(now_ms, next)) {
+			/* nothing left to process up to now */
+			tw->clk = now_ms;
+			break;
+		}
+
+		/* process tick <next>, starting with the coarsest slots so that
+		 * the tasks they hold which expire on this tick are still placed
+		 * before the finest slot gets processed.
+		 */
+		tw->clk = next - 1;
+		for (lvl = TW_LEVELS; lvl-- > 0;) {
+			if (next & ((1U << (TW_BITS * lvl)) - 1))
+				continue;
+
+			slot = (next >> (TW_BITS * lvl)) & (TW_SLOTS - 1);
+			head = &tw->slots[lvl][slot];
+			while (!LIST_ISEMPTY(head)) {
+				if (budget-- <= 0)
+					goto leave;
+
+				task = LIST_ELEM(head->n, struct task *, wq_list);
+				__task_unlink_wq(task);
+				if (tick_is_expired(task->expire, now_ms))
+					_task_wakeup(task, TASK_WOKEN_TIMER, 0);
+				else if (tick_isset(task->expire))
+					__task_queue(task, &th_ctx->timers);
+			}
+		}
+		tw->clk = next;
+	}
+ leave:
+	return budget;
+}
+
 /*
  * __task_queue()
  *
@@ -295,6 +432,10 @@ void __task_queue(struct task *task, struct eb_root *wq)
 		return;
 #endif
 
+	if (wq == &th_ctx->timers && th_ctx->wheel &&
+	    task_wheel_insert(th_ctx->wheel, task))
+		return;
+
 	eb32_insert(wq, &task->wq);
 }
 
@@ -310,6 +451,9 @@ void wake_expired_tasks()
 	struct eb32_node *eb;
 	__decl_thread(int key);
 
+	if (tt->wheel)
+		max_processed = task_wheel_expire(tt->wheel, max_processed);
+
 	while (1) {
 		if (max_processed-- <= 0)
 			goto leave;
@@ -469,6 +613,7 @@ int next_timer_expiry()
 	struct thread_ctx * const tt = th_ctx; // thread's tasks
 	struct eb32_node *eb;
 	int ret = TICK_ETERNITY;
+	uint wkey = 0;
 	__decl_thread(int key = TICK_ETERNITY);
 
 	/* first check in the thread-local timers */
@@ -484,6 +629,10 @@ int next_timer_expiry()
 	if (eb)
 		ret = eb->key;
 
+	/* then in the thread's timer wheel */
+	if (tt->wheel && task_wheel_next(tt->wheel, &wkey))
+		ret = tick_first(ret, wkey ? wkey : 1);
+
 #ifdef USE_THREAD
 	if (!eb_is_empty(&tg_ctx->timers)) {
 		HA_RWLOCK_RDLOCK(TASK_WQ_LOCK, &wq_lock);
@@ -577,6 +726,7 @@ unsigned int run_tasks_from_lists(unsigned int budgets[])
 			th_ctx->sched_profile_entry = profile_entry;
 			HA_ATOMIC_ADD(&profile_entry->lat_time, lat);
 			HA_ATOMIC_INC(&profile_entry->calls);
+			swrate_add_opportunistic(&activity[tid].tl_lat_us[queue], SCHED_LAT_SAMPLES, lat / 1000);
 		}
 		__ha_barrier_store();
 
@@ -692,12 +842,7 @@ void process_runnable_tasks()
 	struct eb32_node *lrq; // next local run queue entry
 	struct eb32_node *grq; // next global run queue entry
 	struct task *t;
-	const unsigned int default_weights[TL_CLASSES] = {
-		[TL_URGENT] = 64, // ~50% of CPU bandwidth for I/O
-		[TL_NORMAL] = 48, // ~37% of CPU bandwidth for tasks
-		[TL_BULK]   = 16, // ~13% of CPU bandwidth for self-wakers
-		[TL_HEAVY]  = 1,  // never more than 1 heavy task at once
-	};
+	unsigned int weights[TL_CLASSES]; // weights of each class for this call
 	unsigned int max[TL_CLASSES]; // max to be run per class
 	unsigned int max_total;       // sum of max above
 	struct mt_list *tmp_list;
@@ -726,22 +871,34 @@ void process_runnable_tasks()
 		max_processed = th_ctx->rq_total / 2;
 	}
 
+	/* classes that run late compared to their latency target get a doubled
+	 * weight. The latency is only measured when profiling is enabled, which
+	 * is automatically the case when the thread is overloaded.
+	 */
+	for (queue = 0; queue < TL_CLASSES; queue++) {
+		weights[queue] = sched_weights[queue];
+		if (sched_max_lat[queue] &&
+		    (_HA_ATOMIC_LOAD(&th_ctx->flags) & TH_FL_TASK_PROFILING) &&
+		    swrate_avg(activity[tid].tl_lat_us[queue], SCHED_LAT_SAMPLES) > sched_max_lat[queue])
+			weights[queue] *= 2;
+	}
+
  not_done_yet:
 	max[TL_URGENT] = max[TL_NORMAL] = max[TL_BULK] = 0;
 
 	/* urgent tasklets list gets a default weight of ~50% */
 	if ((tt->tl_class_mask & (1 << TL_URGENT)) ||
 	    !MT_LIST_ISEMPTY(&tt->shared_tasklet_list))
-		max[TL_URGENT] = default_weights[TL_URGENT];
+		max[TL_URGENT] = weights[TL_URGENT];
 
 	/* normal tasklets list gets a default weight of ~37% */
 	if ((tt->tl_class_mask & (1 << TL_NORMAL)) ||
 	    !eb_is_empty(&th_ctx->rqueue) || !eb_is_empty(&th_ctx->rqueue_shared))
-		max[TL_NORMAL] = default_weights[TL_NORMAL];
+		max[TL_NORMAL] = weights[TL_NORMAL];
 
 	/* bulk tasklets list gets a default weight of ~13% */
 	if ((tt->tl_class_mask & (1 << TL_BULK)))
-		max[TL_BULK] = default_weights[TL_BULK];
+		max[TL_BULK] = weights[TL_BULK];
 
 	/* heavy tasks are processed only once and never refilled in a
 	 * call round. That budget is not lost either as we don't reset
@@ -749,7 +906,7 @@ void process_runnable_tasks()
 	 */
 	if (!heavy_queued) {
 		if ((tt->tl_class_mask & (1 << TL_HEAVY)))
-			max[TL_HEAVY] = default_weights[TL_HEAVY];
+			max[TL_HEAVY] = weights[TL_HEAVY];
 		else
 			max[TL_HEAVY] = 0;
 		heavy_queued = 1;
@@ -925,6 +1082,20 @@ void mworker_cleantasks()
 			tmp_wq = eb32_next(tmp_wq);
 			task_destroy(t);
 		}
+		/* and the per thread timer wheel */
+		if (ha_thread_ctx[i].wheel) {
+			struct timer_wheel *tw = ha_thread_ctx[i].wheel;
+			int lvl, slot;
+
+			for (lvl = 0; lvl < TW_LEVELS; lvl++) {
+				for (slot = 0; slot < TW_SLOTS; slot++) {
+					while (!LIST_ISEMPTY(&tw->slots[lvl][slot])) {
+						t = LIST_ELEM(tw->slots[lvl][slot].n, struct task *, wq_list);
+						task_destroy(t);
+					}
+				}
+			}
+		}
 	}
 }
 
@@ -943,6 +1114,42 @@ static void init_task()
 	}
 }
 
+/* allocates the current thread's timer wheel if enabled */
+static int alloc_timer_wheel_per_thread()
+{
+	struct timer_wheel *tw;
+	int lvl, slot;
+
+	if (!sched_timer_wheel)
+		return 1;
+
+	tw = malloc(sizeof(*tw));
+	if (!tw) {
+		ha_alert("Failed to allocate the timer wheel for thread %u.\n", tid + 1);
+		return 0;
+	}
+
+	for (lvl = 0; lvl < TW_LEVELS; lvl++) {
+		tw->map[lvl] = 0;
+		for (slot = 0; slot < TW_SLOTS; slot++)
+			LIST_INIT(&tw->slots[lvl][slot]);
+	}
+	tw->clk = now_ms;
+	th_ctx->wheel = tw;
+	return 1;
+}
+
+/* releases all threads' timer wheels. This is only done after deinit since
+ * tasks may still be unlinked from them until then.
+ */
+static void free_timer_wheels()
+{
+	int i;
+
+	for (i = 0; i < MAX_THREADS; i++)
+		ha_free(&ha_thread_ctx[i].wheel);
+}
+
 /* config parser for global "tune.sched.low-latency", accepts "on" or "off" */
 static int cfg_parse_tune_sched_low_latency(char **args, int section_type, struct proxy *curpx,
                                       const struct proxy *defpx, const char *file, int line,
@@ -962,14 +1169,102 @@ static int cfg_parse_tune_sched_low_latency(char **args, int section_type, struc
 	return 0;
 }
 
+/* config parser for global "tune.sched.timer-wheel", accepts "on" or "off" */
+static int cfg_parse_tune_sched_timer_wheel(char **args, int section_type, struct proxy *curpx,
+                                            const struct proxy *defpx, const char *file, int line,
+                                            char **err)
+{
+	if (too_many_args(1, args, err, NULL))
+		return -1;
+
+	if (strcmp(args[1], "on") == 0)
+		sched_timer_wheel = 1;
+	else if (strcmp(args[1], "off") == 0)
+		sched_timer_wheel = 0;
+	else {
+		memprintf(err, "'%s' expects either 'on' or 'off' but got '%s'.", args[0], args[1]);
+		return -1;
+	}
+	return 0;
+}
+
+/* config parser for global "tune.sched.class", takes a class name followed by
+ * "weight" and/or "max-latency" settings.
+ */
+static int cfg_parse_tune_sched_class(char **args, int section_type, struct proxy *curpx,
+                                      const struct proxy *defpx, const char *file, int line,
+                                      char **err)
+{
+	const char *res;
+	uint queue, val;
+	int cur_arg;
+
+	for (queue = 0; queue < TL_CLASSES; queue++) {
+		if (strcmp(args[1], sched_class_names[queue]) == 0)
+			break;
+	}
+
+	if (queue == TL_CLASSES) {
+		memprintf(err, "'%s' expects a class name among 'urgent', 'normal', 'bulk' and 'heavy' but got '%s'.",
+		          args[0], *args[1] ? args[1] : "(none)");
+		return -1;
+	}
+
+	if (!*args[2]) {
+		memprintf(err, "'%s %s' expects at least one of 'weight' or 'max-latency'.", args[0], args[1]);
+		return -1;
+	}
+
+	for (cur_arg = 2; *args[cur_arg]; cur_arg += 2) {
+		if (!*args[cur_arg + 1]) {
+			memprintf(err, "'%s %s %s' expects a value.", args[0], args[1], args[cur_arg]);
+			return -1;
+		}
+
+		if (strcmp(args[cur_arg], "weight") == 0) {
+			val = atoi(args[cur_arg + 1]);
+			if (val < 1 || val > 1024) {
+				memprintf(err, "'%s %s %s' expects an integer value between 1 and 1024.",
+				          args[0], args[1], args[cur_arg]);
+				return -1;
+			}
+			sched_weights[queue] = val;
+		}
+		else if (strcmp(args[cur_arg], "max-latency") == 0) {
+			res = parse_time_err(args[cur_arg + 1], &val, TIME_UNIT_US);
+			if (res == PARSE_TIME_OVER) {
+				memprintf(err, "timer overflow in argument '%s' to '%s %s %s' (maximum value is 2147483647 us or ~35 minutes).",
+				          args[cur_arg + 1], args[0], args[1], args[cur_arg]);
+				return -1;
+			}
+			else if (res) {
+				memprintf(err, "unexpected character '%c' in argument to '%s %s %s'.",
+				          *res, args[0], args[1], args[cur_arg]);
+				return -1;
+			}
+			sched_max_lat[queue] = val;
+		}
+		else {
+			memprintf(err, "'%s %s' only supports 'weight' and 'max-latency' but got '%s'.",
+			          args[0], args[1], args[cur_arg]);
+			return -1;
+		}
+	}
+	return 0;
+}
+
 /* config keyword parsers */
 static struct cfg_kw_list cfg_kws = {ILH, {
+	{ CFG_GLOBAL, "tune.sched.class", cfg_parse_tune_sched_class },
 	{ CFG_GLOBAL, "tune.sched.low-latency", cfg_parse_tune_sched_low_latency },
+	{ CFG_GLOBAL, "tune.sched.timer-wheel", cfg_parse_tune_sched_timer_wheel },
 	{ 0, NULL, NULL }
 }};
 
 INITCALL1(STG_REGISTER, cfg_register_keywords, &cfg_kws);
 INITCALL0(STG_PREPARE, init_task);
+REGISTER_PER_THREAD_ALLOC(alloc_timer_wheel_per_thread);
+REGISTER_POST_DEINIT(free_timer_wheels);
 
 /*
  * Local variables:
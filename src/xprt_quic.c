@@ -21,8 +21,13 @@
 static void quic_close(struct connection *conn, void *xprt_ctx)
 {
 	struct ssl_sock_ctx *conn_ctx = xprt_ctx;
-	struct quic_conn *qc = conn_ctx->qc;
+	struct quic_conn *qc;
+
+	/* Backend connection closed before its quic-conn allocation. */
+	if (!conn_ctx)
+		return;
 
+	qc = conn_ctx->qc;
 	TRACE_ENTER(QUIC_EV_CONN_CLOSE, qc);
 
 	/* Next application data can be dropped. */
@@ -109,8 +114,13 @@ static int quic_conn_unsubscribe(struct connection *conn, void *xprt_ctx, int ev
  */
 static int qc_conn_init(struct connection *conn, void **xprt_ctx)
 {
-	struct quic_conn *qc = conn->handle.qc;
+	struct quic_conn *qc;
 
+	/* On the backend side, the quic-conn is only allocated on connect. */
+	if (!(conn->flags & CO_FL_FDLESS))
+		return 0;
+
+	qc = conn->handle.qc;
 	TRACE_ENTER(QUIC_EV_CONN_NEW, qc);
 
 	/* Ensure thread connection migration is finalized ASAP. */
@@ -138,8 +148,11 @@ static int qc_xprt_start(struct connection *conn, void *ctx)
 	qc = conn->handle.qc;
 	TRACE_ENTER(QUIC_EV_CONN_NEW, qc);
 
-	/* mux-quic can now be considered ready. */
-	qc->mux_state = QC_MUX_READY;
+	/* mux-quic can now be considered ready. On the backend side, this is
+	 * done on handshake completion by qc_notify_hs_done().
+	 */
+	if (qc_is_listener(qc))
+		qc->mux_state = QC_MUX_READY;
 
 	/* Schedule quic-conn to ensure post handshake frames are emitted. This
 	 * is not done for 0-RTT as xprt->start happens before handshake
@@ -0,0 +1,242 @@
+/*
+ * HPACK dynamic table encoder tests: indexing policy, references to the static
+ * and dynamic tables, eviction and dynamic table size updates. Each header
+ * block is decoded back to make sure the decoder agrees.
+ *
+ * Build and run from the tests/unit directory:
+ *   cc -O2 -o test-hpack-enc test-hpack-enc.c -I../../include -pthread && ./test-hpack-enc
+ */
+
+#define HPACK_STANDALONE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <haproxy/buf.h>
+#include <haproxy/chunk.h>
+#include <haproxy/hpack-dec.h>
+#include <haproxy/hpack-enc.h>
+#include <haproxy/hpack-tbl.h>
+
+#include "../../src/hpack-huff.c"
+#include "../../src/hpack-tbl.c"
+#include "../../src/hpack-enc.c"
+#include "../../src/hpack-dec.c"
+
+#define TBL_SIZE 4096
+
+static struct pool_head tbl_pool = { .size = TBL_SIZE };
+
+static int failed;
+
+#define CHECK(cond) do {						\
+		if (!(cond)) {						\
+			printf("FAIL at line %d: %s\n", __LINE__, #cond); \
+			failed++;					\
+		}							\
+	} while (0)
+
+/* Encodes the NULL-terminated name/value pairs <hdrs> into <out> with encoder
+ * table <edht>, after <out>'s current contents (e.g. table size updates), then
+ * decodes the whole block with decoder table <ddht> and checks that the same
+ * fields are found. Returns the size of the block, or 0 if a field could not
+ * be encoded.
+ */
+static int roundtrip(struct hpack_dht *edht, struct hpack_dht *ddht, struct buffer *out,
+                     const char *const *hdrs)
+{
+	static char tmp_area[4096];
+	struct buffer tmp = b_make(tmp_area, sizeof(tmp_area), 0, 0);
+	struct http_hdr list[16];
+	int i, ret;
+
+	for (i = 0; hdrs[i]; i += 2) {
+		if (!hpack_encode_header_dht(edht, out, ist(hdrs[i]), ist(hdrs[i + 1])))
+			return 0;
+	}
+
+	ret = hpack_decode_frame(ddht, (const uint8_t *)b_orig(out), b_data(out), list, 16, &tmp);
+	/* the end marker is counted */
+	CHECK(ret == i / 2 + 1);
+	for (i = 0; i < ret && hdrs[2 * i]; i++) {
+		CHECK(isteq(list[i].n, ist(hdrs[2 * i])));
+		CHECK(isteq(list[i].v, ist(hdrs[2 * i + 1])));
+	}
+
+	CHECK(edht->used <= ddht->used);
+	return b_data(out);
+}
+
+/* indexing policy and references */
+static void test_indexing(void)
+{
+	static const char *const hs[] = { "accept-encoding", "gzip, deflate", NULL };
+	static const char *const h1[] = { "x-hdr", "value-1", NULL };
+	static const char *const h2[] = { "x-hdr", "value-2", NULL };
+	static const char *const h3[] = { "x-other", "value-3", NULL };
+	static const char *const hcred[] = { "authorization", "Basic Zm9vOmJhcg==",
+	                                     "cookie", "id=1", NULL };
+	static const char *const hcook[] = { "cookie", "session=0123456789abcdef", NULL };
+	static const char *const hvol[] = { "content-length", "12", "etag", "\"abc\"", NULL };
+	struct hpack_dht *edht, *ddht;
+	char area[256];
+	struct buffer out = b_make(area, sizeof(area), 0, 0);
+
+	edht = hpack_dht_alloc();
+	ddht = hpack_dht_alloc();
+
+	/* static table: a single index */
+	CHECK(roundtrip(edht, ddht, &out, hs) == 1);
+	CHECK((unsigned char)area[0] == 0x90);
+	CHECK(edht->used == 0);
+
+	/* new field: literal with incremental indexing and a new name */
+	b_reset(&out);
+	CHECK(roundtrip(edht, ddht, &out, h1) == 1 + 1 + 5 + 1 + 7);
+	CHECK((unsigned char)area[0] == 0x40);
+	CHECK(edht->used == 1);
+
+	/* then a single index to the dynamic table */
+	b_reset(&out);
+	CHECK(roundtrip(edht, ddht, &out, h1) == 1);
+	CHECK((unsigned char)area[0] == 0x80 + HPACK_SHT_SIZE);
+
+	/* same name, new value: name reference, inserted */
+	b_reset(&out);
+	CHECK(roundtrip(edht, ddht, &out, h2) == 1 + 1 + 7);
+	CHECK((unsigned char)area[0] == 0x40 + HPACK_SHT_SIZE);
+	CHECK(edht->used == 2);
+
+	/* both are in the table now, the most recent first */
+	b_reset(&out);
+	CHECK(roundtrip(edht, ddht, &out, h1) == 1);
+	CHECK((unsigned char)area[0] == 0x80 + HPACK_SHT_SIZE + 1);
+
+	/* credentials and short cookies are never indexed */
+	b_reset(&out);
+	CHECK(roundtrip(edht, ddht, &out, hcred) > 0);
+	CHECK((area[0] & 0xf0) == 0x10);
+	CHECK(edht->used == 2);
+
+	/* longer cookies are */
+	b_reset(&out);
+	CHECK(roundtrip(edht, ddht, &out, hcook) > 0);
+	CHECK((area[0] & 0xc0) == 0x40);
+	CHECK(edht->used == 3);
+
+	/* volatile fields are sent without indexing */
+	b_reset(&out);
+	CHECK(roundtrip(edht, ddht, &out, hvol) > 0);
+	CHECK((area[0] & 0xf0) == 0x00);
+	CHECK(edht->used == 3);
+
+	/* buffer full */
+	out = b_make(area, 4, 0, 0);
+	CHECK(roundtrip(edht, ddht, &out, h3) == 0);
+
+	hpack_dht_free(edht);
+	hpack_dht_free(ddht);
+}
+
+/* eviction of the oldest entries */
+static void test_eviction(void)
+{
+	static const char *const h[][3] = {
+		{ "x-hdr-1", "value-1", NULL }, { "x-hdr-2", "value-2", NULL },
+		{ "x-hdr-3", "value-3", NULL }, { "x-hdr-4", "value-4", NULL },
+		{ "x-hdr-5", "value-5", NULL }, { "x-hdr-6", "value-6", NULL },
+	};
+	struct hpack_dht *edht, *ddht;
+	char area[256];
+	struct buffer out = b_make(area, sizeof(area), 0, 0);
+	int i;
+
+	edht = hpack_dht_alloc();
+	ddht = hpack_dht_alloc();
+	hpack_dht_init(edht, 256);
+	hpack_dht_init(ddht, 256);
+
+	/* 46 bytes per entry, 5 fit */
+	for (i = 0; i < 6; i++) {
+		b_reset(&out);
+		CHECK(roundtrip(edht, ddht, &out, h[i]) > 1);
+	}
+	CHECK(edht->used == 5 && ddht->used == 5);
+
+	/* x-hdr-1 was evicted, x-hdr-2 is still there */
+	b_reset(&out);
+	CHECK(roundtrip(edht, ddht, &out, h[1]) == 1);
+	CHECK((unsigned char)area[0] == 0x80 + HPACK_SHT_SIZE + 4);
+
+	b_reset(&out);
+	CHECK(roundtrip(edht, ddht, &out, h[0]) > 1);
+	CHECK((unsigned char)area[0] == 0x40);
+	CHECK(edht->used == 5 && ddht->used == 5);
+
+	hpack_dht_free(edht);
+	hpack_dht_free(ddht);
+}
+
+/* dynamic table size updates after a SETTINGS_HEADER_TABLE_SIZE change */
+static void test_dtsu(void)
+{
+	static const char *const h1[] = { "x-hdr", "value-1", NULL };
+	struct hpack_dht *edht, *ddht;
+	struct http_hdr list[16];
+	char area[256], tmp_area[256];
+	struct buffer tmp = b_make(tmp_area, sizeof(tmp_area), 0, 0);
+	struct buffer out = b_make(area, sizeof(area), 0, 0);
+
+	edht = hpack_dht_alloc();
+	ddht = hpack_dht_alloc();
+
+	CHECK(roundtrip(edht, ddht, &out, h1) > 1);
+	CHECK(edht->used == 1);
+
+	/* not enough room: nothing emitted, table unchanged */
+	out = b_make(area, 1, 0, 0);
+	CHECK(hpack_encode_dtsu(edht, &out, 512) == 0);
+	CHECK(b_data(&out) == 0);
+	CHECK(edht->used == 1 && edht->size == TBL_SIZE);
+
+	/* flush then resize, the field must be inserted again */
+	out = b_make(area, sizeof(area), 0, 0);
+	CHECK(hpack_encode_dtsu(edht, &out, 512) == 1);
+	CHECK(b_data(&out) == 4 && memcmp(area, "\x20\x3f\xe1\x03", 4) == 0);
+	CHECK(edht->used == 0 && edht->size == 512);
+
+	CHECK(roundtrip(edht, ddht, &out, h1) > 5);
+	CHECK((unsigned char)area[4] == 0x40);
+	CHECK(edht->used == 1);
+
+	/* a size update must start the block */
+	CHECK(hpack_encode_dtsu(edht, &out, 512) == 1);
+	CHECK(hpack_decode_frame(ddht, (const uint8_t *)area, b_data(&out), list, 16, &tmp) < 0);
+
+	/* zero size: flush only, nothing can be indexed anymore */
+	b_reset(&out);
+	CHECK(hpack_encode_dtsu(edht, &out, 0) == 1);
+	CHECK(b_data(&out) == 1 && (unsigned char)area[0] == 0x20);
+	CHECK(roundtrip(edht, ddht, &out, h1) > 1);
+	CHECK((unsigned char)area[1] == 0x00);
+	CHECK(edht->used == 0);
+
+	hpack_dht_free(edht);
+	hpack_dht_free(ddht);
+}
+
+int main(int argc, char **argv)
+{
+	pool_head_hpack_tbl = &tbl_pool;
+
+	test_indexing();
+	test_eviction();
+	test_dtsu();
+
+	if (failed) {
+		printf("%d check(s) failed\n", failed);
+		return 1;
+	}
+	printf("all checks passed\n");
+	return 0;
+}
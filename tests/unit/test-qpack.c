@@ -0,0 +1,501 @@
+/*
+ * QPACK dynamic table tests: encoder and decoder stream instructions, blocked
+ * streams, eviction of referenced entries and capacity errors. The encoder's
+ * output is always decoded back to make sure both sides agree.
+ *
+ * Build and run from the tests/unit directory:
+ *   cc -O2 -o test-qpack test-qpack.c -I../../include -pthread && ./test-qpack
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define QPACK_STANDALONE
+
+#define USE_OPENSSL
+#define USE_QUIC
+
+#include <haproxy/buf-t.h>
+#include <haproxy/http-hdr-t.h>
+#include <haproxy/qpack-dec.h>
+#include <haproxy/qpack-enc.h>
+#include <haproxy/qpack-tbl.h>
+
+#include "../../src/hpack-huff.c"
+#include "../../src/qpack-tbl.c"
+#include "../../src/qpack-enc.c"
+#include "../../src/qpack-dec.c"
+
+#define TBL_SIZE 256
+
+static struct pool_head tbl_pool = { .size = TBL_SIZE };
+static struct pool_head fs_pool  = { .size = sizeof(struct qpack_enc_fs) };
+
+static struct qcc qcc;
+static struct qcs qcs = { .qcc = &qcc };
+static int last_err;
+
+static int failed;
+
+#define CHECK(cond) do {						\
+		if (!(cond)) {						\
+			printf("FAIL at line %d: %s\n", __LINE__, #cond); \
+			failed++;					\
+		}							\
+	} while (0)
+
+/* stubs for the few haproxy functions used by the code above */
+void ha_backtrace_to_stderr(void)
+{
+}
+
+void complain(int *counter, const char *msg, int taint)
+{
+	fputs(msg, stderr);
+}
+
+/* initcalls are not processed here, pools are set up by main() */
+void create_pool_callback(struct pool_head **ptr, char *name, unsigned int size)
+{
+}
+
+void *__pool_alloc(struct pool_head *pool, unsigned int flags)
+{
+	return calloc(1, pool->size);
+}
+
+void __pool_free(struct pool_head *pool, void *ptr)
+{
+	free(ptr);
+}
+
+void qcc_set_error(struct qcc *qcc, int err, int app)
+{
+	last_err = err;
+}
+
+/* like in haproxy, two alternating trash buffers */
+struct buffer *get_trash_chunk(void)
+{
+	static char area[2][4096];
+	static struct buffer trash[2];
+	static int idx;
+
+	idx ^= 1;
+	trash[idx] = b_make(area[idx], sizeof(area[idx]), 0, 0);
+	return &trash[idx];
+}
+
+/* Feeds <len> bytes of encoder stream <raw> to <dec> at once and returns
+ * qpack_decode_enc()'s result. <last_err> is reset first.
+ */
+static ssize_t feed_enc(struct qpack_dec *dec, const char *raw, size_t len, int fin)
+{
+	char area[1024];
+	struct buffer buf = b_make(area, sizeof(area), 0, 0);
+
+	memcpy(area, raw, len);
+	buf.data = len;
+	last_err = 0;
+	return qpack_decode_enc(dec, &buf, fin, &qcs);
+}
+
+/* same for decoder stream <raw> applied to <enc> */
+static ssize_t feed_dec(struct qpack_enc *enc, const char *raw, size_t len, int fin)
+{
+	char area[1024];
+	struct buffer buf = b_make(area, sizeof(area), 0, 0);
+
+	memcpy(area, raw, len);
+	buf.data = len;
+	last_err = 0;
+	return qpack_decode_dec(enc, &buf, fin, &qcs);
+}
+
+/* instruction builders for the encoder stream */
+static void ins_sdtc(struct buffer *b, uint64_t cap)
+{
+	qpack_encode_prefix_integer(b, cap, 5, 0x20);
+}
+
+static void ins_iwnr(struct buffer *b, int stat, uint64_t idx, const char *v)
+{
+	qpack_encode_prefix_integer(b, idx, 6, stat ? 0xc0 : 0x80);
+	qpack_encode_prefix_integer(b, strlen(v), 7, 0x00);
+	b_putist(b, ist(v));
+}
+
+static void ins_iwln(struct buffer *b, const char *n, const char *v)
+{
+	qpack_encode_prefix_integer(b, strlen(n), 5, 0x40);
+	b_putist(b, ist(n));
+	qpack_encode_prefix_integer(b, strlen(v), 7, 0x00);
+	b_putist(b, ist(v));
+}
+
+static void ins_dup(struct buffer *b, uint64_t idx)
+{
+	qpack_encode_prefix_integer(b, idx, 5, 0x00);
+}
+
+/* Decodes field section <fs> with <dec> into <list>. Returns the number of
+ * headers or a negative QPACK_RET_* code.
+ */
+static int decode(struct qpack_dec *dec, const struct buffer *fs,
+                  struct http_hdr *list, int size, uint64_t *ric)
+{
+	static char area[4096];
+	struct buffer tmp = b_make(area, sizeof(area), 0, 0);
+
+	return qpack_decode_fs(dec, (const unsigned char *)b_orig(fs), b_data(fs),
+	                       &tmp, list, size, ric);
+}
+
+static int hdr_is(const struct http_hdr *hdr, const char *n, const char *v)
+{
+	return isteq(hdr->n, ist(n)) && isteq(hdr->v, ist(v));
+}
+
+/* all the encoder stream instructions, possibly split */
+static void test_enc_stream(void)
+{
+	struct qpack_dec dec;
+	struct http_hdr list[8];
+	char area[256], fsa[16];
+	struct buffer b = b_make(area, sizeof(area), 0, 0);
+	struct buffer fs = b_make(fsa, sizeof(fsa), 0, 0);
+	uint64_t ric;
+	size_t split;
+
+	qpack_dec_init(&dec, TBL_SIZE, 1);
+
+	ins_sdtc(&b, TBL_SIZE);
+	ins_iwnr(&b, 1, 0, "example.com");  /* :authority */
+	split = b_data(&b);
+	ins_iwln(&b, "x-a", "1");
+	CHECK(feed_enc(&dec, b_orig(&b), b_data(&b) - 1, 0) == split);
+	CHECK(dec.ic == 1);
+
+	b_del(&b, split);
+	ins_iwnr(&b, 0, 0, "2");            /* x-a: 2 */
+	ins_dup(&b, 2);                     /* :authority: example.com */
+	CHECK(feed_enc(&dec, b_head(&b), b_data(&b), 0) == b_data(&b));
+	CHECK(dec.ic == 4);
+
+	/* Required Insert Count 4, Base 4, three relative indexes */
+	qpack_encode_prefix_integer(&fs, 4 % (2 * (TBL_SIZE / 32)) + 1, 8, 0x00);
+	qpack_encode_prefix_integer(&fs, 0, 7, 0x00);
+	qpack_encode_prefix_integer(&fs, 0, 6, 0x80);
+	qpack_encode_prefix_integer(&fs, 1, 6, 0x80);
+	qpack_encode_prefix_integer(&fs, 2, 6, 0x80);
+	CHECK(decode(&dec, &fs, list, 8, &ric) == 3);
+	CHECK(ric == 4);
+	CHECK(hdr_is(&list[0], ":authority", "example.com"));
+	CHECK(hdr_is(&list[1], "x-a", "2"));
+	CHECK(hdr_is(&list[2], "x-a", "1"));
+
+	/* a field section can only reference acknowledged entries after the
+	 * Insert Count Increment was sent.
+	 */
+	b_reset(&b);
+	CHECK(qpack_dec_ack_inserts(&dec, &b) == 0);
+	CHECK(dec.krc == 4);
+	CHECK(b_data(&b) == 1 && (unsigned char)*b_orig(&b) == 0x04);
+
+	qpack_dec_release(&dec);
+}
+
+/* field sections referencing entries not received yet */
+static void test_blocked(void)
+{
+	struct qpack_dec dec;
+	struct http_hdr list[8];
+	char area[64], fsa[16];
+	struct buffer b = b_make(area, sizeof(area), 0, 0);
+	struct buffer fs = b_make(fsa, sizeof(fsa), 0, 0);
+	uint64_t ric;
+
+	qpack_dec_init(&dec, TBL_SIZE, 1);
+	ins_sdtc(&b, TBL_SIZE);
+	CHECK(feed_enc(&dec, b_orig(&b), b_data(&b), 0) == b_data(&b));
+
+	/* Required Insert Count 1, Base 0, one post-base index */
+	qpack_encode_prefix_integer(&fs, 1 + 1, 8, 0x00);
+	qpack_encode_prefix_integer(&fs, 0, 7, 0x80);
+	qpack_encode_prefix_integer(&fs, 0, 4, 0x10);
+	CHECK(decode(&dec, &fs, list, 8, &ric) == -QPACK_RET_BLOCKED);
+	CHECK(ric == 1);
+
+	b_reset(&b);
+	ins_iwln(&b, "x-b", "late");
+	CHECK(feed_enc(&dec, b_orig(&b), b_data(&b), 0) == b_data(&b));
+	CHECK(decode(&dec, &fs, list, 8, &ric) == 1);
+	CHECK(hdr_is(&list[0], "x-b", "late"));
+
+	/* the section acknowledgment also acknowledges the insertion */
+	b_reset(&b);
+	CHECK(qpack_dec_ack_section(&dec, &b, 4, ric) == 0);
+	CHECK(dec.krc == 1);
+	CHECK(b_data(&b) == 1 && (unsigned char)*b_orig(&b) == 0x84);
+	b_reset(&b);
+	CHECK(qpack_dec_ack_inserts(&dec, &b) == 0);
+	CHECK(b_data(&b) == 0);
+
+	qpack_dec_release(&dec);
+}
+
+/* invalid encoder stream instructions */
+static void test_enc_stream_errors(void)
+{
+	struct qpack_dec dec;
+	struct http_hdr list[8];
+	char area[256], fsa[16];
+	struct buffer b = b_make(area, sizeof(area), 0, 0);
+	struct buffer fs = b_make(fsa, sizeof(fsa), 0, 0);
+	uint64_t ric;
+
+	qpack_dec_init(&dec, TBL_SIZE, 1);
+
+	/* insertion without capacity */
+	ins_iwln(&b, "x-a", "1");
+	CHECK(feed_enc(&dec, b_orig(&b), b_data(&b), 0) == -1);
+	CHECK(last_err == QPACK_ERR_ENCODER_STREAM_ERROR);
+
+	/* capacity above SETTINGS_QPACK_MAX_TABLE_CAPACITY */
+	b_reset(&b);
+	ins_sdtc(&b, TBL_SIZE + 1);
+	CHECK(feed_enc(&dec, b_orig(&b), b_data(&b), 0) == -1);
+	CHECK(last_err == QPACK_ERR_ENCODER_STREAM_ERROR);
+
+	/* entry larger than the capacity */
+	b_reset(&b);
+	ins_sdtc(&b, 64);
+	ins_iwln(&b, "x-long", "0123456789012345678901234567");
+	CHECK(feed_enc(&dec, b_orig(&b), b_data(&b), 0) == -1);
+	CHECK(last_err == QPACK_ERR_ENCODER_STREAM_ERROR);
+	CHECK(dec.ic == 0);
+
+	/* references to missing entries */
+	b_reset(&b);
+	ins_iwln(&b, "x-a", "1");
+	ins_dup(&b, 1);
+	CHECK(feed_enc(&dec, b_orig(&b), b_data(&b), 0) == -1);
+	CHECK(last_err == QPACK_ERR_ENCODER_STREAM_ERROR);
+	CHECK(dec.ic == 1);
+
+	b_reset(&b);
+	ins_iwnr(&b, 0, 1, "2");
+	CHECK(feed_enc(&dec, b_orig(&b), b_data(&b), 0) == -1);
+	CHECK(last_err == QPACK_ERR_ENCODER_STREAM_ERROR);
+
+	b_reset(&b);
+	ins_iwnr(&b, 1, QPACK_SHT_SIZE, "2");
+	CHECK(feed_enc(&dec, b_orig(&b), b_data(&b), 0) == -1);
+	CHECK(last_err == QPACK_ERR_ENCODER_STREAM_ERROR);
+
+	/* reducing the capacity evicts "x-a: 1", which cannot be referenced
+	 * anymore.
+	 */
+	b_reset(&b);
+	ins_sdtc(&b, 32);
+	CHECK(feed_enc(&dec, b_orig(&b), b_data(&b), 0) == b_data(&b));
+	CHECK(dec.dht->used == 0);
+
+	qpack_encode_prefix_integer(&fs, 1 + 1, 8, 0x00);
+	qpack_encode_prefix_integer(&fs, 0, 7, 0x00);
+	qpack_encode_prefix_integer(&fs, 0, 6, 0x80);
+	CHECK(decode(&dec, &fs, list, 8, &ric) == -QPACK_RET_DECOMP);
+
+	/* closing the encoder stream */
+	CHECK(feed_enc(&dec, "", 0, 1) == -1);
+	CHECK(last_err == H3_ERR_CLOSED_CRITICAL_STREAM);
+
+	qpack_dec_release(&dec);
+}
+
+/* Encodes fields <hdrs> as a field section for stream <id> with <enc>,
+ * forwards the encoder stream to <dec> and checks that <dec> decodes the
+ * same fields. The section is acknowledged if <ack> is set. Returns the size
+ * of the field section.
+ */
+static size_t roundtrip(struct qpack_enc *enc, struct qpack_dec *dec, uint64_t id,
+                        const char *const *hdrs, int ack)
+{
+	struct http_hdr list[8];
+	char ia[512], fsa[512], da[16];
+	struct buffer ins = b_make(ia, sizeof(ia), 0, 0);
+	struct buffer fs = b_make(fsa, sizeof(fsa), 0, 0);
+	struct buffer out = b_make(fsa + 64, sizeof(fsa) - 64, 0, 0);
+	struct buffer dins = b_make(da, sizeof(da), 0, 0);
+	uint64_t ric;
+	int i, ret;
+
+	qpack_enc_fs_start(enc);
+	for (i = 0; hdrs[i]; i += 2)
+		CHECK(qpack_encode_header_dht(enc, &ins, &out, ist(hdrs[i]), ist(hdrs[i + 1])) == 0);
+	CHECK(qpack_enc_fs_prefix(enc, &fs) == 0);
+	qpack_enc_fs_commit(enc, id);
+
+	/* move the field lines right after the prefix */
+	memmove(b_tail(&fs), b_orig(&out), b_data(&out));
+	fs.data += b_data(&out);
+
+	if (b_data(&ins))
+		CHECK(feed_enc(dec, b_orig(&ins), b_data(&ins), 0) == b_data(&ins));
+
+	ret = decode(dec, &fs, list, 8, &ric);
+	CHECK(ret == i / 2);
+	for (i = 0; i < ret && hdrs[2 * i]; i++)
+		CHECK(hdr_is(&list[i], hdrs[2 * i], hdrs[2 * i + 1]));
+
+	if (ack && ric) {
+		CHECK(qpack_dec_ack_section(dec, &dins, id, ric) == 0);
+		CHECK(feed_dec(enc, b_orig(&dins), b_data(&dins), 0) == b_data(&dins));
+	}
+
+	b_reset(&dins);
+	CHECK(qpack_dec_ack_inserts(dec, &dins) == 0);
+	if (b_data(&dins))
+		CHECK(feed_dec(enc, b_orig(&dins), b_data(&dins), 0) == b_data(&dins));
+
+	return b_data(&fs);
+}
+
+/* encoder: indexing, references, and eviction of referenced entries */
+static void test_encoder(void)
+{
+	static const char *const h1[] = { "x-hdr-01", "value-01", NULL };
+	static const char *const h11[] = { "x-hdr-01", "value-01", "x-hdr-01", "value-01", NULL };
+	static const char *const h2[] = { "x-hdr-02", "value-02", "x-hdr-03", "value-03",
+	                                  "x-hdr-04", "value-04", "x-hdr-05", "value-05", NULL };
+	static const char *const h6[] = { "x-hdr-06", "value-06", NULL };
+	static const char *const hc[] = { "authorization", "Basic Zm9vOmJhcg==",
+	                                  "cookie", "a=1", "content-length", "12", NULL };
+	struct qpack_enc enc;
+	struct qpack_dec dec;
+	char ia[64], fsa[64];
+	struct buffer ins = b_make(ia, sizeof(ia), 0, 0);
+	struct buffer out = b_make(fsa, sizeof(fsa), 0, 0);
+	size_t sz;
+
+	qpack_enc_init(&enc);
+	qpack_dec_init(&dec, TBL_SIZE, 0);
+
+	CHECK(qpack_enc_set_capacity(&enc, &ins, TBL_SIZE, TBL_SIZE) == 0);
+	CHECK(feed_enc(&dec, b_orig(&ins), b_data(&ins), 0) == b_data(&ins));
+	CHECK(dec.dht && dec.dht->size == TBL_SIZE);
+
+	/* first uses: inserted but sent as literals since the decoder did
+	 * not acknowledge the insertion yet, so the stream is never blocked.
+	 */
+	sz = roundtrip(&enc, &dec, 0, h11, 0) / 2;
+	CHECK(enc.ic == 1 && enc.krc == 1);
+	CHECK(enc.fs_count == 0);
+
+	/* second use: a single index, the section is tracked until acked */
+	CHECK(roundtrip(&enc, &dec, 4, h1, 0) < sz);
+	CHECK(enc.fs_count == 1);
+
+	/* fill the table: 5 entries of 48 bytes */
+	roundtrip(&enc, &dec, 8, h2, 1);
+	CHECK(enc.ic == 5 && enc.krc == 5);
+	CHECK(enc.dht->used == 5);
+
+	/* evicting x-hdr-01 is not permitted while stream 4 references it */
+	roundtrip(&enc, &dec, 12, h6, 1);
+	CHECK(enc.ic == 5);
+	CHECK(dec.ic == 5);
+
+	/* neither is it while the section being encoded references it */
+	b_reset(&ins);
+	qpack_enc_fs_start(&enc);
+	CHECK(qpack_encode_header_dht(&enc, &ins, &out, ist("x-hdr-01"), ist("value-01")) == 0);
+	CHECK(enc.fs_cur->min_ref == 0);
+	qpack_enc_cancel_stream(&enc, 4);
+	CHECK(enc.fs_count == 0);
+	CHECK(qpack_encode_header_dht(&enc, &ins, &out, ist("x-hdr-06"), ist("value-06")) == 0);
+	CHECK(b_data(&ins) == 0 && enc.ic == 5);
+	qpack_enc_fs_commit(&enc, 16);
+	CHECK(feed_dec(&enc, "\x90", 1, 0) == 1);
+	CHECK(enc.fs_count == 0);
+
+	/* once released, the oldest entry is evicted on both sides */
+	roundtrip(&enc, &dec, 20, h6, 1);
+	CHECK(enc.ic == 6 && dec.ic == 6);
+	CHECK(enc.dht->used == 5 && dec.dht->used == 5);
+	CHECK(isteq(qpack_idx_to_name(dec.dht, 4), ist("x-hdr-02")));
+
+	/* credentials, short cookies and volatile fields are never inserted */
+	roundtrip(&enc, &dec, 24, hc, 1);
+	CHECK(enc.ic == 6);
+
+	qpack_enc_release(&enc);
+	qpack_dec_release(&dec);
+}
+
+/* invalid decoder stream instructions */
+static void test_dec_stream_errors(void)
+{
+	static const char *const h1[] = { "x-hdr-01", "value-01", NULL };
+	struct qpack_enc enc;
+	struct qpack_dec dec;
+	char ia[16];
+	struct buffer ins = b_make(ia, sizeof(ia), 0, 0);
+
+	qpack_enc_init(&enc);
+	qpack_dec_init(&dec, TBL_SIZE, 0);
+	CHECK(qpack_enc_set_capacity(&enc, &ins, TBL_SIZE, TBL_SIZE) == 0);
+	CHECK(feed_enc(&dec, b_orig(&ins), b_data(&ins), 0) == b_data(&ins));
+
+	/* insertion not sent yet */
+	CHECK(feed_dec(&enc, "\x01", 1, 0) == -1);
+	CHECK(last_err == QPACK_ERR_DECODER_STREAM_ERROR);
+
+	roundtrip(&enc, &dec, 0, h1, 1);
+	roundtrip(&enc, &dec, 4, h1, 0);
+	CHECK(enc.fs_count == 1);
+
+	/* zero increment */
+	CHECK(feed_dec(&enc, "\x00", 1, 0) == -1);
+	CHECK(last_err == QPACK_ERR_DECODER_STREAM_ERROR);
+
+	/* acknowledgment for a stream without pending section */
+	CHECK(feed_dec(&enc, "\x88", 1, 0) == -1);
+	CHECK(last_err == QPACK_ERR_DECODER_STREAM_ERROR);
+
+	/* valid acknowledgment, then a second one for the same stream */
+	CHECK(feed_dec(&enc, "\x84", 1, 0) == 1);
+	CHECK(enc.fs_count == 0);
+	CHECK(feed_dec(&enc, "\x84", 1, 0) == -1);
+	CHECK(last_err == QPACK_ERR_DECODER_STREAM_ERROR);
+
+	/* incomplete instruction */
+	CHECK(feed_dec(&enc, "\x48\xff", 2, 0) == 1);
+
+	/* closing the decoder stream */
+	CHECK(feed_dec(&enc, "", 0, 1) == -1);
+	CHECK(last_err == H3_ERR_CLOSED_CRITICAL_STREAM);
+
+	qpack_enc_release(&enc);
+	qpack_dec_release(&dec);
+}
+
+int main(int argc, char **argv)
+{
+	pool_head_qpack_tbl = &tbl_pool;
+	pool_head_qpack_enc_fs = &fs_pool;
+
+	test_enc_stream();
+	test_blocked();
+	test_enc_stream_errors();
+	test_encoder();
+	test_dec_stream_errors();
+
+	if (failed) {
+		printf("%d check(s) failed\n", failed);
+		return 1;
+	}
+	printf("all checks passed\n");
+	return 0;
+}